@@ -3,6 +3,7 @@
 
 //#define DETERMINISTIC
 #include "CombBLAS/CombBLAS.h"
+#include "CombBLAS/MIS.h"
 #ifdef THREADED
 	#ifndef _OPENMP
 	#define _OPENMP
@@ -117,79 +118,13 @@ struct MIS2verifySR // identical to Select2ndMinSR except for the printout in ad
 template <typename ONT, typename IT, typename INT, typename DER>
 FullyDistSpVec<IT, ONT> MIS2(SpParMat < IT, INT, DER> A)
 {
-    IT nvert = A.getncol();
-    
+    uint64_t seed = GlobalMT.randInt();
+    MPI_Bcast(&seed, 1, MPIType<uint64_t>(), 0, A.getcommgrid()->GetWorld());   // priorities must agree on all processes
+    MISEngine<IT, INT, DER> engine(A, seed);
+    FullyDistSpVec<IT, IT> members = engine.MIS2();
     //# the final result set. S[i] exists and is 1 if vertex i is in the MIS
-    FullyDistSpVec<IT, ONT> mis ( A.getcommgrid(), nvert);
-    
-
-    //# the candidate set. initially all vertices are candidates.
-    //# If cand[i] exists, then i is a candidate. The value cand[i] is i's random number for this iteration.
-    FullyDistSpVec<IT, double> cand(A.getcommgrid());
-    cand.iota(nvert, 1.0); // any value is fine since we randomize it later
-    FullyDistSpVec<IT, double> min_neighbor_r ( A.getcommgrid(), nvert);
-    FullyDistSpVec<IT, double> min_neighbor2_r ( A.getcommgrid(), nvert);
-    
-    
-    FullyDistSpVec<IT, ONT> new_S_members ( A.getcommgrid(), nvert);
-    FullyDistSpVec<IT, ONT> new_S_neighbors ( A.getcommgrid(), nvert);
-    FullyDistSpVec<IT, ONT> new_S_neighbors2 ( A.getcommgrid(), nvert);
-    
-    
-    while (cand.getnnz() > 0)
-    {
-        
-        //# label each vertex in cand with a random value (in what range, [0,1])
-        cand.Apply([](const double & ignore){return (double) GlobalMT.rand();});
-        
-        //# find the smallest random value among a vertex's 1 and 2-hop neighbors
-        SpMV<Select2ndMinSR<INT, double>>(A, cand, min_neighbor_r, false);
-        SpMV<Select2ndMinSR<INT, double>>(A, min_neighbor_r, min_neighbor2_r, false);
-        
-        FullyDistSpVec<IT, double> min_neighbor_r_union = EWiseApply<double>(min_neighbor2_r, min_neighbor_r,
-                                        [](double x, double y){return std::min(x,y);},
-                                        [](double x, double y){return true;},   // do_op is totalogy
-                                        true, true, 2.0,  2.0, true);   // we allow nulls for both V and W
-        
-        
-        //# The vertices to be added to S this iteration are those whose random value is
-        //# smaller than those of all its 1-hop and 2-hop neighbors:
-        // **** if cand has isolated vertices, they will be included in new_S_members ******
-        new_S_members = EWiseApply<ONT>(min_neighbor_r_union, cand,
-                                        [](double x, double y){return (ONT)1;},
-                                        [](double x, double y){return y<=x;}, // equality is for back edges since we are operating on A^2
-                                        true, false, 2.0,  2.0, true);
-        
-        //# new_S_members are no longer candidates, so remove them from cand
-        cand = EWiseApply<double>(cand, new_S_members,
-                                  [](double x, ONT y){return x;},
-                                  [](double x, ONT y){return true;},
-                                  false, true, 0.0, (ONT) 0, false);
-        
-        //# find 1-hop and 2-hop neighbors of new_S_members
-        SpMV<Select2ndMinSR<INT, ONT>>(A, new_S_members, new_S_neighbors, false);
-        SpMV<Select2ndMinSR<INT, ONT>>(A, new_S_neighbors, new_S_neighbors2, false);
-        
-        FullyDistSpVec<IT, ONT> new_S_neighbors_union = EWiseApply<ONT>(new_S_neighbors, new_S_neighbors2,
-                                                                          [](ONT x, ONT y){return x;},  // in case of intersection, doesn't matter which one to propagate
-                                                                          [](ONT x, ONT y){return true;},
-                                                                          true, true, (ONT) 1, (ONT) 1, true);
-
-        
-        //# remove 1-hop and 2-hop neighbors of new_S_members from cand, because they cannot be part of the MIS anymore
-        cand = EWiseApply<double>(cand, new_S_neighbors_union,
-                                  [](double x, ONT y){return x;},
-                                  [](double x, ONT y){return true;},
-                                  false, true, 0.0, (ONT) 0, false);
-        
-        //# add new_S_members to mis
-        mis = EWiseApply<ONT>(mis, new_S_members,
-                              [](ONT x, ONT y){return x;},
-                              [](ONT x, ONT y){return true;},
-                              true, true, (ONT) 1, (ONT) 1, true);
-    }
-    
-    return mis;
+    std::vector<IT> lind = members.GetLocalInd();
+    return FullyDistSpVec<IT, ONT>(A.getcommgrid(), A.getncol(), lind, std::vector<ONT>(lind.size(), (ONT) 1), false, true);
 }
 
 
@@ -20,9 +20,9 @@ int cblas_splits = 1;
 #include <limits>
 
 
-#include "BPMaximalMatching.h"
-#include "BPMaximumMatching.h"
-#include "ApproxWeightPerfectMatching.h"
+#include "CombBLAS/BipartiteMatchings/BPMaximalMatching.h"
+#include "CombBLAS/BipartiteMatchings/BPMaximumMatching.h"
+#include "CombBLAS/BipartiteMatchings/ApproxWeightPerfectMatching.h"
 
 using namespace std;
 using namespace combblas;
@@ -150,7 +150,7 @@ int main(int argc, char* argv[])
                 randp.iota(AWeighted->getnrow(), 0);
                 randp.RandPerm();
 		double oldbalance = AWeighted->LoadImbalance();
-                (*AWeighted)(randp,randp,true);
+                AWeighted->Permute(randp,randp,true);
  		double newbalance = AWeighted->LoadImbalance();
                 SpParHelper::Print("Matrix is randomly permuted for load balance.\n");
 		stringstream s;
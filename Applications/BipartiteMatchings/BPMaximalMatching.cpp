@@ -7,7 +7,7 @@
 #include <vector>
 #include <string>
 #include <sstream>
-#include "BPMaximalMatching.h"
+#include "CombBLAS/BipartiteMatchings/BPMaximalMatching.h"
 
 
 #ifdef THREADED
@@ -19,8 +19,8 @@ int cblas_splits = 1;
 #include <sstream>
 
 
-#include "BPMaximalMatching.h"
-#include "BPMaximumMatching.h"
+#include "CombBLAS/BipartiteMatchings/BPMaximalMatching.h"
+#include "CombBLAS/BipartiteMatchings/BPMaximumMatching.h"
 
 using namespace std;
 using namespace combblas;
@@ -480,7 +480,7 @@ int main(int argc, char* argv[])
             pcol.iota(ABool->getncol(), 0);
             prow.RandPerm();
             pcol.RandPerm();
-            (*ABool)(prow, pcol, true);
+            ABool->Permute(prow, pcol, true);
             SpParHelper::Print("Performed random permutation of matrix.\n");
         }
         
@@ -166,7 +166,7 @@ int main(int argc, char* argv[])
                 FullyDistVec<int64_t, int64_t> p( A.getcommgrid());
                 p.iota(A.getnrow(), 0);
                 p.RandPerm();
-                (A)(p,p,true);// in-place permute to save memory
+                A.Permute(p,p,true);// in-place permute to save memory
                 SpParHelper::Print("Applied symmetric permutation.\n");
             }
             else
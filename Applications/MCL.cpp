@@ -438,10 +438,9 @@ void RandPermute(SpParMat<IT,NT,DER> & A, HipMCLParam & param)
     // randomly permute for load balance
     if(A.getnrow() == A.getncol())
     {
-        FullyDistVec<IT, IT> p( A.getcommgrid());
-        p.iota(A.getnrow(), 0);
-        p.RandPerm();
-        (A)(p,p,true);// in-place permute to save memory
+        uint64_t seed = time(NULL);
+        MPI_Bcast(&seed, 1, MPIType<uint64_t>(), 0, A.getcommgrid()->GetWorld());
+        A.RandomRelabel(seed);  // A(p,p) with p.randperm(n,seed), single redistribution and no SpGEMM
         SpParHelper::Print("Applied symmetric permutation.\n");
     }
     else
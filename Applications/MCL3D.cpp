@@ -404,11 +404,9 @@ void MakeColStochastic(SpParMat<IT,NT,DER> & A)
 template <typename IT, typename NT, typename DER>
 void MakeColStochastic3D(SpParMat3D<IT,NT,DER> & A3D)
 {
-    //SpParMat<IT, NT, DER> * ALayer = A3D.GetLayerMat();
-    std::shared_ptr< SpParMat<IT, NT, DER> > ALayer = A3D.GetLayerMat();
-    FullyDistVec<IT, NT> colsums = ALayer->Reduce(Column, plus<NT>(), 0.0);
+    FullyDistVec<IT, NT> colsums = A3D.Reduce(Column, plus<NT>(), 0.0);
     colsums.Apply(safemultinv<NT>());
-    ALayer->DimApply(Column, colsums, multiplies<NT>());	// scale each "Column" with the given vector
+    A3D.DimApply(Column, colsums, multiplies<NT>());	// scale each "Column" with the given vector
 }
 
 template <typename IT, typename NT, typename DER>
@@ -430,17 +428,14 @@ NT Chaos(SpParMat<IT,NT,DER> & A)
 template <typename IT, typename NT, typename DER>
 NT Chaos3D(SpParMat3D<IT,NT,DER> & A3D)
 {
-    //SpParMat<IT, NT, DER> * ALayer = A3D.GetLayerMat();
-    std::shared_ptr< SpParMat<IT, NT, DER> > ALayer = A3D.GetLayerMat();
-
     // sums of squares of columns
-    FullyDistVec<IT, NT> colssqs = ALayer->Reduce(Column, plus<NT>(), 0.0, bind2nd(exponentiate(), 2));
+    FullyDistVec<IT, NT> colssqs = A3D.Reduce(Column, plus<NT>(), 0.0, bind2nd(exponentiate(), 2));
     // Matrix entries are non-negative, so max() can use zero as identity
-    FullyDistVec<IT, NT> colmaxs = ALayer->Reduce(Column, maximum<NT>(), 0.0);
+    FullyDistVec<IT, NT> colmaxs = A3D.Reduce(Column, maximum<NT>(), 0.0);
     colmaxs -= colssqs;
 
     // multiply by number of nonzeros in each column
-    FullyDistVec<IT, NT> nnzPerColumn = ALayer->Reduce(Column, plus<NT>(), 0.0, [](NT val){return 1.0;});
+    FullyDistVec<IT, NT> nnzPerColumn = A3D.Reduce(Column, plus<NT>(), 0.0, [](NT val){return 1.0;});
     colmaxs.EWiseApply(nnzPerColumn, multiplies<NT>());
     
     NT layerChaos = colmaxs.Reduce(maximum<NT>(), 0.0);
@@ -459,9 +454,7 @@ void Inflate(SpParMat<IT,NT,DER> & A, double power)
 template <typename IT, typename NT, typename DER>
 void Inflate3D(SpParMat3D<IT,NT,DER> & A3D, double power)
 {
-    //SpParMat<IT, NT, DER> * ALayer = A3D.GetLayerMat();
-    std::shared_ptr< SpParMat<IT, NT, DER> > ALayer = A3D.GetLayerMat();
-    ALayer->Apply(bind2nd(exponentiate(), power));
+    A3D.Apply(bind2nd(exponentiate(), power));
 }
 
 // default adjustloop setting
@@ -506,10 +499,9 @@ void RandPermute(SpParMat<IT,NT,DER> & A, HipMCLParam & param)
     // randomly permute for load balance
     if(A.getnrow() == A.getncol())
     {
-        FullyDistVec<IT, IT> p( A.getcommgrid());
-        p.iota(A.getnrow(), 0);
-        p.RandPerm();
-        (A)(p,p,true);// in-place permute to save memory
+        uint64_t seed = time(NULL);
+        MPI_Bcast(&seed, 1, MPIType<uint64_t>(), 0, A.getcommgrid()->GetWorld());
+        A.RandomRelabel(seed);  // A(p,p) with p.randperm(n,seed), single redistribution and no SpGEMM
         SpParHelper::Print("Applied symmetric permutation.\n");
     }
     else
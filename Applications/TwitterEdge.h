@@ -201,11 +201,6 @@ ParentType operator+( const IT & left, const ParentType & right)
 	return ParentType(left+right.id);
 }
 
-// forward declaration
-template <typename SR, typename T>
-void select2nd(void * invec, void * inoutvec, int * len, MPI_Datatype *datatype);
-
-
 template <typename SR, typename VECTYPE>
 static VECTYPE filtered_select2nd(const TwitterEdge & arg1, const VECTYPE & arg2, time_t & sincedate)  
 {
@@ -252,7 +247,6 @@ static VECTYPE filtered_select2nd(const TwitterEdge & arg1, const VECTYPE & arg2
 //! Here we emulate this filtered traversal approach.
 struct LatestRetwitterBFS
 {
-	static MPI_Op MPI_BFSADD;
 	static ParentType id() { return ParentType(); }	// additive identity
 
 	// the default argument means that this function can be used like this:
@@ -272,11 +266,6 @@ struct LatestRetwitterBFS
 		return ((arg2 == ParentType()) ? arg1: arg2);
 	}
 
-	static MPI_Op mpi_op() 
-	{ 
-		MPI_Op_create(select2nd<LatestRetwitterBFS,ParentType>, false, &MPI_BFSADD);	// \todo {do this once only, by greating a MPI_Op buffer}
-		return MPI_BFSADD;
-	}
 	static time_t sincedate;
 	static ParentType multiply(const TwitterEdge & arg1, const ParentType & arg2)
 	{
@@ -290,20 +279,6 @@ struct LatestRetwitterBFS
 
 time_t LatestRetwitterBFS::sincedate = -1;
 
-// select2nd for doubles
-template <typename SR, typename T>
-void select2nd(void * invec, void * inoutvec, int * len, MPI_Datatype *datatype)
-{
-	T * pinvec = static_cast<T*>(invec);
-	T * pinoutvec = static_cast<T*>(inoutvec);
-	for (int i = 0; i < *len; i++)
-	{
-		pinoutvec[i] = SR::add(pinvec[i], pinoutvec[i]);
-	}
-}
-
-
-MPI_Op LatestRetwitterBFS::MPI_BFSADD;
 
 struct getfringe: public std::binary_function<ParentType, ParentType, ParentType>
 {
@@ -418,7 +393,6 @@ struct LatestRetwitterMIS
 // Vector type: double
 struct LatestRetwitterSelect2nd // also used for finding neighbors of the candidate set in MIS
 {
-	static MPI_Op MPI_SEL2NDADD;
 	static double id() { return 0.0; }	// additive identity
 	
 	// the default argument means that this function can be used like this:
@@ -438,11 +412,6 @@ struct LatestRetwitterSelect2nd // also used for finding neighbors of the candid
 		return arg2;
 	}
 	
-	static MPI_Op mpi_op() 
-	{ 
-		MPI_Op_create(select2nd<LatestRetwitterSelect2nd,double>, false, &MPI_SEL2NDADD);	// \todo {do this once only, by greating a MPI_Op buffer}
-		return MPI_SEL2NDADD;
-	}
 	static time_t sincedate;
 	static double multiply(const TwitterEdge & arg1, const double & arg2)  // filtered select2nd
 	{
@@ -456,7 +425,12 @@ struct LatestRetwitterSelect2nd // also used for finding neighbors of the candid
 
 time_t LatestRetwitterMIS::sincedate = -1;
 time_t LatestRetwitterSelect2nd::sincedate = -1;
-MPI_Op LatestRetwitterSelect2nd::MPI_SEL2NDADD;
+
+// the additions above keep their second operand, so the MPI_Op that CombBLAS builds from them must not reorder
+namespace combblas {
+template <> struct SRingAddCommutes<LatestRetwitterBFS> : std::false_type {};
+template <> struct SRingAddCommutes<LatestRetwitterSelect2nd> : std::false_type {};
+}
 
 
 
@@ -0,0 +1,113 @@
+/****************************************************************/
+/* Parallel Combinatorial BLAS Library (for Graph Computations) */
+/* version 1.6 -------------------------------------------------*/
+/* date: 6/15/2017 ---------------------------------------------*/
+/* authors: Ariful Azad, Aydin Buluc  --------------------------*/
+/****************************************************************/
+/*
+ Copyright (c) 2010-2017, The Regents of the University of California
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+#include "CombBLAS/CombBLAS.h"
+#include <mpi.h>
+#include <iostream>
+#include <vector>
+#include <random>
+
+using namespace std;
+using namespace combblas;
+
+typedef PlusTimesSRing<double, double> PTDD;
+typedef SpDCCols<int64_t,double> DCCols;
+typedef SpParMat < int64_t, double, DCCols > PSpMat;
+typedef AdaptiveSpParMat < int64_t, double > APSpMat;
+
+bool Report(bool passed, const string & what)
+{
+	int ok = passed, allok;
+	MPI_Allreduce(&ok, &allok, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+	if(allok)
+		SpParHelper::Print(what + " working correctly\n");
+	else
+		SpParHelper::Print("ERROR in " + what + ", go fix it!\n");
+	return allok;
+}
+
+int main(int argc, char* argv[])
+{
+	int nprocs, myrank;
+	MPI_Init(&argc, &argv);
+	MPI_Comm_size(MPI_COMM_WORLD,&nprocs);
+	MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
+	if(argc < 2)
+	{
+		if(myrank == 0)
+		{
+			cout << "Usage: ./AdaptiveSpParMatTest <Scale>" << endl;
+			cout << "Example: mpirun -np 4 ./AdaptiveSpParMatTest 12" << endl;
+		}
+		MPI_Finalize();
+		return -1;
+	}
+	bool allpassed = true;
+	{
+		int64_t n = ((int64_t) 1) << atoi(argv[1]);
+		shared_ptr<CommGrid> fullWorld(new CommGrid(MPI_COMM_WORLD, 0, 0));
+
+		// small positive integers keep every sum exact
+		mt19937_64 gen(43 + myrank);
+		vector<int64_t> rows, cols;
+		vector<double> vals;
+		for(int64_t k=0; k < 8*n / nprocs; ++k)
+		{
+			rows.push_back(gen() % n);
+			cols.push_back(gen() % n);
+			vals.push_back((double) (gen() % 4) + 1.0);
+		}
+		FullyDistVec<int64_t,int64_t> ri(rows, fullWorld), ci(cols, fullWorld);
+		FullyDistVec<int64_t,double> vi(vals, fullWorld);
+
+		PSpMat Wide(n, n, ri, ci, vi, true);
+		APSpMat A(n, n, ri, ci, vi, true);
+		allpassed &= Report(A.isNarrow() && A.getnnz() == Wide.getnnz() && A.Widen() == Wide, "AdaptiveSpParMat from triples");
+
+		APSpMat Kept(Wide, false);
+		APSpMat Narrowed(Wide);
+		allpassed &= Report(!Kept.isNarrow() && Narrowed.isNarrow() && Narrowed.Widen() == Wide, "AdaptiveSpParMat from a wide matrix");
+
+		PSpMat WideCopy(Wide);	// the operands of a product can not alias
+		APSpMat Copy(A);
+		PSpMat Square = Mult_AnXBn_Synch<PTDD, double, DCCols>(Wide, WideCopy);
+		APSpMat C = Mult_AnXBn_Adaptive<PTDD, double>(A, Copy);
+		bool same = C.isNarrow() && C.Widen() == Square;
+		C = Mult_AnXBn_Adaptive<PTDD, double>(A, Kept);	// a wide operand takes the wide product
+		same &= C.isNarrow() && C.Widen() == Square;
+		allpassed &= Report(same, "Mult_AnXBn_Adaptive");
+
+		Wide.Apply([](double x) { return 2.0*x; });
+		A.Visit([](auto & M) { M.Apply([](double x) { return 2.0*x; }); });
+		int64_t visited = A.Visit([](auto & M) { return M.getnnz(); });
+		allpassed &= Report(A.Widen() == Wide && visited == Wide.getnnz(), "AdaptiveSpParMat::Visit");
+	}
+	MPI_Finalize();
+	return allpassed ? 0 : 1;
+}
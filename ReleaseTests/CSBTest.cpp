@@ -0,0 +1,141 @@
+/****************************************************************/
+/* Parallel Combinatorial BLAS Library (for Graph Computations) */
+/* version 1.6 -------------------------------------------------*/
+/* date: 6/15/2017 ---------------------------------------------*/
+/* authors: Ariful Azad, Aydin Buluc  --------------------------*/
+/****************************************************************/
+/*
+ Copyright (c) 2010-2017, The Regents of the University of California
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+
+#include "CombBLAS/CombBLAS.h"
+#include <mpi.h>
+#include <iostream>
+#include <vector>
+#include <random>
+
+using namespace std;
+using namespace combblas;
+
+typedef PlusTimesSRing<double, double> PTDD;
+typedef SpParMat < int64_t, double, SpDCCols<int64_t,double> > PSpMat_DCSC;
+typedef SpParMat < int64_t, double, SpCSB<int64_t,double> > PSpMat_CSB;
+
+bool Report(bool passed, const string & what)
+{
+	int ok = passed, allok;
+	MPI_Allreduce(&ok, &allok, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+	if(allok)
+		SpParHelper::Print(what + " working correctly\n");
+	else
+		SpParHelper::Print("ERROR in " + what + ", go fix it!\n");
+	return allok;
+}
+
+// integral values keep every sum exact, whatever the order of additions
+FullyDistVec<int64_t,double> Vector(shared_ptr<CommGrid> grid, int64_t len, int64_t seed)
+{
+	FullyDistVec<int64_t,double> v(grid, len, 0.0);
+	v.ApplyInd([seed](double, int64_t i){ return (double) ((i * 7919 + seed) % 13) - 6.0; });
+	return v;
+}
+
+int main(int argc, char* argv[])
+{
+	int nprocs, myrank;
+	MPI_Init(&argc, &argv);
+	MPI_Comm_size(MPI_COMM_WORLD,&nprocs);
+	MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
+	if(argc < 2)
+	{
+		if(myrank == 0)
+		{
+			cout << "Usage: ./CSBTest <Scale>" << endl;
+			cout << "Example: mpirun -np 4 ./CSBTest 14" << endl;
+		}
+		MPI_Finalize();
+		return -1;
+	}
+	bool allpassed = true;
+	{
+		int64_t n = ((int64_t) 1) << atoi(argv[1]);
+		int64_t m = n + n/3 + 5;	// rectangular, with partial blocks
+		shared_ptr<CommGrid> fullWorld;
+		fullWorld.reset( new CommGrid(MPI_COMM_WORLD, 0, 0) );
+
+		mt19937_64 gen(11 + myrank);
+		vector<int64_t> rows, cols;
+		vector<double> vals;
+		for(int64_t k=0; k < 8*n / nprocs; ++k)
+		{
+			rows.push_back(gen() % m);
+			cols.push_back((k % 10 == 0) ? (gen() % 8) : (gen() % n));	// a few dense columns
+			vals.push_back((double) (gen() % 9) - 4.0);
+		}
+		FullyDistVec<int64_t,int64_t> ri(rows, fullWorld), ci(cols, fullWorld);
+		FullyDistVec<int64_t,double> vi(vals, fullWorld);
+		PSpMat_DCSC A(m, n, ri, ci, vi, true);
+
+		PSpMat_CSB C = A;
+		PSpMat_DCSC back = C;
+		allpassed &= Report(C.getnnz() == A.getnnz() && back == A, "Conversion between DCSC and CSB");
+
+		FullyDistVec<int64_t,double> x = Vector(fullWorld, n, 3);
+		FullyDistVec<int64_t,double> y = Vector(fullWorld, m, 5);
+		FullyDistVec<int64_t,double> Ax = SpMV<PTDD>(A, x);
+		FullyDistVec<int64_t,double> Cx = SpMV<PTDD>(C, x);
+		allpassed &= Report(Ax == Cx, "CSB SpMV");
+
+		PSpMat_DCSC At = A;
+		At.Transpose();
+		FullyDistVec<int64_t,double> Aty = SpMV<PTDD>(At, y);
+		FullyDistVec<int64_t,double> Cty = SpMVTranspose<PTDD>(C, y);
+		FullyDistVec<int64_t,double> DCty = SpMVTranspose<PTDD>(A, y);
+		allpassed &= Report(Aty == Cty && Aty == DCty, "SpMV with the transpose");
+
+		// local SpMM with k right hand sides against k SpMVs
+		SpCSB<int64_t,double> & local = C.seq();
+		int k = 3;
+		int64_t lm = local.getnrow(), ln = local.getncol();
+		vector<double> X(ln * k), Z(lm * k);
+		for(size_t i=0; i<X.size(); ++i) X[i] = (double) ((i * 31) % 7) - 3.0;
+		for(size_t i=0; i<Z.size(); ++i) Z[i] = (double) ((i * 17) % 5) - 2.0;
+		vector<double> Y(lm * k, 0.0), W(ln * k, 0.0);
+		csb_gespmm<PTDD>(local, X.data(), Y.data(), k);
+		csb_gespmm_transpose<PTDD>(local, Z.data(), W.data(), k);
+		bool spmm = true;
+		for(int t=0; t<k; ++t)
+		{
+			vector<double> xt(ln), yt(lm, 0.0), zt(lm), wt(ln, 0.0);
+			for(int64_t i=0; i<ln; ++i) xt[i] = X[i*k+t];
+			for(int64_t i=0; i<lm; ++i) zt[i] = Z[i*k+t];
+			csb_gespmv<PTDD>(local, xt.data(), yt.data());
+			csb_gespmv_transpose<PTDD>(local, zt.data(), wt.data());
+			for(int64_t i=0; i<lm; ++i) spmm &= (yt[i] == Y[i*k+t]);
+			for(int64_t i=0; i<ln; ++i) spmm &= (wt[i] == W[i*k+t]);
+		}
+		allpassed &= Report(spmm, "CSB SpMM");
+	}
+	MPI_Finalize();
+	return allpassed ? 0 : 1;
+}
@@ -0,0 +1,153 @@
+/****************************************************************/
+/* Parallel Combinatorial BLAS Library (for Graph Computations) */
+/* version 1.6 -------------------------------------------------*/
+/* date: 6/15/2017 ---------------------------------------------*/
+/* authors: Ariful Azad, Aydin Buluc  --------------------------*/
+/****************************************************************/
+/*
+ Copyright (c) 2010-2017, The Regents of the University of California
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+
+#include "CombBLAS/CombBLAS.h"
+#include "CombBLAS/DynamicSpParMat.h"
+#include <mpi.h>
+#include <iostream>
+#include <vector>
+#include <map>
+#include <tuple>
+#include <random>
+
+using namespace std;
+using namespace combblas;
+
+typedef SpParMat < int64_t, double, SpDCCols<int64_t,double> > PSpMat_Double;
+typedef map< pair<int64_t,int64_t>, double > Reference;
+
+// builds the reference matrix, every process contributes a strided share of the (replicated) entries
+PSpMat_Double Build(const Reference & ref, int64_t n, shared_ptr<CommGrid> grid)
+{
+	vector<int64_t> rows, cols;
+	vector<double> vals;
+	int64_t k = 0;
+	for(auto & entry : ref)
+	{
+		if(k++ % grid->GetSize() != grid->GetRank()) continue;
+		rows.push_back(entry.first.first);
+		cols.push_back(entry.first.second);
+		vals.push_back(entry.second);
+	}
+	FullyDistVec<int64_t,int64_t> ri(rows, grid), ci(cols, grid);
+	FullyDistVec<int64_t,double> vi(vals, grid);
+	return PSpMat_Double(n, n, ri, ci, vi);
+}
+
+void Apply(Reference & ref, const tuple<int64_t,int64_t,double,EdgeOp> & u)
+{
+	pair<int64_t,int64_t> key(get<0>(u), get<1>(u));
+	auto found = ref.find(key);
+	switch(get<3>(u))
+	{
+		case EdgeSet: ref[key] = get<2>(u); break;
+		case EdgeAccumulate:
+			if(found == ref.end()) ref[key] = get<2>(u);
+			else found->second += get<2>(u);
+			break;
+		case EdgeDelete: if(found != ref.end()) ref.erase(found); break;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	int nprocs, myrank;
+	MPI_Init(&argc, &argv);
+	MPI_Comm_size(MPI_COMM_WORLD,&nprocs);
+	MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
+	if(argc < 2)
+	{
+		if(myrank == 0)
+		{
+			cout << "Usage: ./DynamicUpdateTest <Scale>" << endl;
+			cout << "Example: mpirun -np 4 ./DynamicUpdateTest 12" << endl;
+		}
+		MPI_Finalize();
+		return -1;
+	}
+	bool allpassed = true;
+	{
+		int64_t n = ((int64_t) 1) << atoi(argv[1]);
+		shared_ptr<CommGrid> fullWorld;
+		fullWorld.reset( new CommGrid(MPI_COMM_WORLD, 0, 0) );
+
+		// every process draws the same edges and updates, and keeps the reference matrix
+		mt19937_64 gen(2024);
+		uniform_int_distribution<int64_t> vertex(0, n-1);
+		Reference ref;
+		vector< pair<int64_t,int64_t> > initial;
+		for(int64_t k=0; k<8*n; ++k)
+		{
+			initial.push_back(make_pair(vertex(gen), vertex(gen)));
+			ref[initial.back()] = (double) (1 + k % 9);
+		}
+		PSpMat_Double A = Build(ref, n, fullWorld);
+		bool passed = true;
+		{
+			DynamicSpParMat<int64_t, double, SpDCCols<int64_t,double> > dynamic(A);
+			// the fourth batch is large enough to fold on its own, the last one is left for the destructor
+			vector<int64_t> batchsizes = {n, n/2, 1, (EDGEDELTAMIN + 1) * (int64_t) nprocs * 2, 3*n};
+			for(size_t b=0; b<batchsizes.size(); ++b)
+			{
+				vector< tuple<int64_t,int64_t,double,EdgeOp> > batch(batchsizes[b]);
+				for(auto & u : batch)
+				{
+					int64_t kind = gen() % 10;
+					pair<int64_t,int64_t> edge = (gen() % 2) ? initial[gen() % initial.size()] : make_pair(vertex(gen), vertex(gen));
+					EdgeOp op = (kind < 4) ? EdgeSet : ((kind < 7) ? EdgeAccumulate : EdgeDelete);
+					u = make_tuple(edge.first, edge.second, (double) (1 + gen() % 5), op);
+					Apply(ref, u);
+				}
+				// contiguous shares, so the rank order is the batch order
+				vector< tuple<int64_t,int64_t,double,EdgeOp> > mine(batch.begin() + (myrank * batch.size()) / nprocs, batch.begin() + ((myrank + 1) * batch.size()) / nprocs);
+				dynamic.Update(mine);
+				passed &= (dynamic.getpending() <= max<size_t>(EDGEDELTAMIN, A.getlocalnnz() / EDGEDELTADIVISOR));
+				if(b == 0 || b == 2)
+				{
+					PSpMat_Double B = Build(ref, n, fullWorld);
+					passed &= (dynamic.Matrix() == B) && (dynamic.getpending() == 0);
+				}
+			}
+		}
+		PSpMat_Double B = Build(ref, n, fullWorld);
+		passed &= (A == B);	// the destructor folds what was left
+		int ok = passed, allok;
+		MPI_Allreduce(&ok, &allok, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+		if(allok)
+			SpParHelper::Print("DynamicSpParMat updates working correctly\n");
+		else
+		{
+			SpParHelper::Print("ERROR in DynamicSpParMat updates, go fix it!\n");
+			allpassed = false;
+		}
+	}
+	MPI_Finalize();
+	return allpassed ? 0 : 1;
+}
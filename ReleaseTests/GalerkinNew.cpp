@@ -38,6 +38,7 @@
 using namespace std;
 using namespace combblas;
 #define ITERATIONS 10
+#define PHASES 4
 
 // Simple helper class for declarations: Just the numerical type is templated 
 // The index type and the sequential matrix type stays the same for the whole code
@@ -124,6 +125,15 @@ int main(int argc, char* argv[])
 				//SLT.SaveGathered("SLT.txt");
 				//SAT.SaveGathered("SAT.txt");
 			}
+
+			if(fullWorld->GetGridRows() == fullWorld->GetGridCols())
+			{
+				PSpMat<double>::MPI_DCCols RAR = GalerkinProduct<PTDD, double, PSpMat<double>::DCCols>(A, T, PHASES);
+				if(RAR == SAT)
+					SpParHelper::Print("Fused triple product is correct\n");
+				else
+					SpParHelper::Print("Error in fused triple product, go fix it\n");
+			}
 		}	
 		MPI_Barrier(MPI_COMM_WORLD);
 		double t1 = MPI_Wtime(); 	// initilize (wall-clock) timer
@@ -140,6 +150,23 @@ int main(int argc, char* argv[])
 			printf("%.6lf seconds elapsed per iteration\n", (t2-t1)/(double)ITERATIONS);
 		}
 
+		if(fullWorld->GetGridRows() == fullWorld->GetGridCols())
+		{
+			MPI_Barrier(MPI_COMM_WORLD);
+			t1 = MPI_Wtime();
+			for(int i=0; i<ITERATIONS; i++)
+			{
+				PSpMat<double>::MPI_DCCols RAR = GalerkinProduct<PTDD, double, PSpMat<double>::DCCols>(A, T, PHASES);
+			}
+			MPI_Barrier(MPI_COMM_WORLD);
+			t2 = MPI_Wtime();
+			if(myrank == 0)
+			{
+				cout<<"Fused restriction in "<< PHASES <<" phases finished"<<endl;
+				printf("%.6lf seconds elapsed per iteration\n", (t2-t1)/(double)ITERATIONS);
+			}
+		}
+
 		MPI_Barrier(MPI_COMM_WORLD);
 		t1 = MPI_Wtime(); 	// initilize (wall-clock) timer
 		for(int i=0; i<ITERATIONS; i++)
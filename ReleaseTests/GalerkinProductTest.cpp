@@ -0,0 +1,122 @@
+/****************************************************************/
+/* Parallel Combinatorial BLAS Library (for Graph Computations) */
+/* version 1.6 -------------------------------------------------*/
+/* date: 6/15/2017 ---------------------------------------------*/
+/* authors: Ariful Azad, Aydin Buluc  --------------------------*/
+/****************************************************************/
+/*
+ Copyright (c) 2010-2017, The Regents of the University of California
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+#include "CombBLAS/CombBLAS.h"
+#include <mpi.h>
+#include <iostream>
+#include <vector>
+#include <random>
+
+using namespace std;
+using namespace combblas;
+
+typedef PlusTimesSRing<double, double> PTDD;
+typedef SpDCCols<int64_t,double> DCCols;
+typedef SpParMat < int64_t, double, DCCols > PSpMat;
+
+bool Report(bool passed, const string & what)
+{
+	int ok = passed, allok;
+	MPI_Allreduce(&ok, &allok, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+	if(allok)
+		SpParHelper::Print(what + " working correctly\n");
+	else
+		SpParHelper::Print("ERROR in " + what + ", go fix it!\n");
+	return allok;
+}
+
+// small positive integers keep every sum exact and free of cancellations
+PSpMat Random(shared_ptr<CommGrid> grid, int64_t m, int64_t n, int64_t nnz, uint64_t seed)
+{
+	mt19937_64 gen(seed + grid->GetRank());
+	vector<int64_t> rows, cols;
+	vector<double> vals;
+	for(int64_t k=0; k < nnz / grid->GetSize(); ++k)
+	{
+		rows.push_back(gen() % m);
+		cols.push_back(gen() % n);
+		vals.push_back((double) (gen() % 4) + 1.0);
+	}
+	FullyDistVec<int64_t,int64_t> ri(rows, grid), ci(cols, grid);
+	FullyDistVec<int64_t,double> vi(vals, grid);
+	return PSpMat(m, n, ri, ci, vi, true);
+}
+
+int main(int argc, char* argv[])
+{
+	int nprocs, myrank;
+	MPI_Init(&argc, &argv);
+	MPI_Comm_size(MPI_COMM_WORLD,&nprocs);
+	MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
+	if(argc < 2)
+	{
+		if(myrank == 0)
+		{
+			cout << "Usage: ./GalerkinProductTest <Scale>" << endl;
+			cout << "Example: mpirun -np 4 ./GalerkinProductTest 12" << endl;
+		}
+		MPI_Finalize();
+		return -1;
+	}
+	bool allpassed = true;
+	{
+		int64_t n = ((int64_t) 1) << atoi(argv[1]);
+		shared_ptr<CommGrid> fullWorld(new CommGrid(MPI_COMM_WORLD, 0, 0));
+		if(fullWorld->GetGridRows() != fullWorld->GetGridCols())
+		{
+			SpParHelper::Print("GalerkinProduct needs a square processor grid, skipping\n");
+		}
+		else
+		{
+			PSpMat A = Random(fullWorld, n, n, 8*n, 17);
+			PSpMat R = Random(fullWorld, n, n/5 + 3, 2*n, 19);	// restriction to a coarse grid of a fifth of the size
+
+			PSpMat S(A), ST(A);	// the symmetric part of A, doubled
+			ST.Transpose();
+			S += ST;
+
+			PSpMat RT(R);
+			RT.Transpose();
+			for(PSpMat * M : {&A, &S})
+			{
+				bool symmetric = (M == &S);
+				PSpMat MR = Mult_AnXBn_Synch<PTDD, double, DCCols>(*M, R);
+				PSpMat Ref = Mult_AnXBn_Synch<PTDD, double, DCCols>(RT, MR);
+				string which = symmetric ? " with symmetric A" : " with general A";
+				for(int phases : {1, 3})
+				{
+					PSpMat C = GalerkinProduct<PTDD, double, DCCols>(*M, R, phases, symmetric);
+					allpassed &= Report(C == Ref, "GalerkinProduct in " + to_string(phases) + " phases" + which);
+				}
+			}
+		}
+	}
+	MPI_Finalize();
+	return allpassed ? 0 : 1;
+}
@@ -0,0 +1,172 @@
+/****************************************************************/
+/* Parallel Combinatorial BLAS Library (for Graph Computations) */
+/* version 1.6 -------------------------------------------------*/
+/* date: 6/15/2017 ---------------------------------------------*/
+/* authors: Ariful Azad, Aydin Buluc  --------------------------*/
+/****************************************************************/
+/*
+ Copyright (c) 2010-2017, The Regents of the University of California
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+
+#include "CombBLAS/CombBLAS.h"
+#include "CombBLAS/MIS.h"
+#include <mpi.h>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <string>
+
+using namespace std;
+using namespace combblas;
+typedef SpParMat < int64_t, bool, SpDCCols<int64_t,bool> > PARBOOLMAT;
+typedef MISEngine < int64_t, bool, SpDCCols<int64_t,bool> > ENGINE;
+
+// largest id in S among the neighbors of every vertex; S holds the ids as values
+FullyDistSpVec<int64_t, int64_t> MaxNeighbor(PARBOOLMAT & A, const FullyDistSpVec<int64_t, int64_t> & S)
+{
+	FullyDistSpVec<int64_t, int64_t> y(A.getcommgrid(), A.getnrow());
+	SpMV<SelectMaxSRing<bool, int64_t>>(A, S, y, false);
+	return y;
+}
+
+// number of neighbors every vertex has in S
+FullyDistSpVec<int64_t, int64_t> CountNeighbors(PARBOOLMAT & A, const FullyDistSpVec<int64_t, int64_t> & S)
+{
+	FullyDistSpVec<int64_t, int64_t> ones(S);
+	ones.Apply([](int64_t v){ return (int64_t) 1; });
+	FullyDistSpVec<int64_t, int64_t> y(A.getcommgrid(), A.getnrow());
+	SpMV<PlusTimesSRing<bool, int64_t>>(A, ones, y, false);
+	return y;
+}
+
+// 1 for every vertex of the given sets, 0 elsewhere
+FullyDistVec<int64_t, int64_t> Flags(PARBOOLMAT & A, const vector< FullyDistSpVec<int64_t, int64_t> > & sets)
+{
+	FullyDistVec<int64_t, int64_t> flags(A.getcommgrid(), A.getnrow(), (int64_t) 0);
+	for(auto S : sets)
+	{
+		S.Apply([](int64_t v){ return (int64_t) 1; });
+		flags.Set(S);
+	}
+	return flags;
+}
+
+// no two vertices of S are adjacent (distance 1) or share a neighbor (distance 2)
+bool Independent(PARBOOLMAT & A, const FullyDistSpVec<int64_t, int64_t> & S, int hops)
+{
+	FullyDistSpVec<int64_t, int64_t> maxn = MaxNeighbor(A, S);
+	FullyDistVec<int64_t, int64_t> inS = Flags(A, {S});
+	if(EWiseMult(maxn, inS, false, (int64_t) 0).getnnz() != 0) return false;
+	if(hops == 1) return true;
+	FullyDistSpVec<int64_t, int64_t> counts = CountNeighbors(A, S);
+	return counts.Count([](int64_t c){ return c > 1; }) == 0;
+}
+
+// every vertex is in S or within hops of it
+bool Maximal(PARBOOLMAT & A, const FullyDistSpVec<int64_t, int64_t> & S, int hops)
+{
+	vector< FullyDistSpVec<int64_t, int64_t> > covered = {S};
+	for(int h = 0; h < hops; ++h)
+		covered.push_back(MaxNeighbor(A, covered.back()));
+	return Flags(A, covered).Count([](int64_t f){ return f == 0; }) == 0;
+}
+
+bool Report(bool passed, const string & what)
+{
+	if(passed)
+		SpParHelper::Print(what + " working correctly\n");
+	else
+		SpParHelper::Print("ERROR in " + what + ", go fix it!\n");
+	return passed;
+}
+
+int main(int argc, char* argv[])
+{
+	int nprocs, myrank;
+	MPI_Init(&argc, &argv);
+	MPI_Comm_size(MPI_COMM_WORLD,&nprocs);
+	MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
+	if(argc < 2)
+	{
+		if(myrank == 0)
+		{
+			cout << "Usage: ./MISTest <Scale>" << endl;
+			cout << "Example: mpirun -np 4 ./MISTest 12" << endl;
+		}
+		MPI_Finalize();
+		return -1;
+	}
+	bool allpassed = true;
+	{
+		unsigned scale = static_cast<unsigned>(atoi(argv[1]));
+		double initiator[4] = {.57, .19, .19, .05};
+		DistEdgeList<int64_t> * DEL = new DistEdgeList<int64_t>();
+		DEL->GenGraph500Data(initiator, scale, 8, true, true);	// generate packed edges
+		PARBOOLMAT L(*DEL, false);
+		delete DEL;
+		PARBOOLMAT LT(L);
+		LT.Transpose();
+		L += LT;	// symmetric, possibly with self loops
+		PARBOOLMAT A(L);
+		A.RemoveLoops();
+		A.PrintInfo();
+		int64_t n = A.getnrow();
+
+		for(int hops = 1; hops <= 2; ++hops)
+		{
+			string name = (hops == 1) ? "MIS" : "MIS2";
+			ENGINE sparse(A, 7, 0);	// never pull
+			ENGINE pull(A, 7, n+1);	// always pull
+			ENGINE hybrid(A, 7);
+			ENGINE loops(L, 7);
+			FullyDistSpVec<int64_t, int64_t> Ssparse = (hops == 1) ? sparse.MIS() : sparse.MIS2();
+			FullyDistSpVec<int64_t, int64_t> Spull = (hops == 1) ? pull.MIS() : pull.MIS2();
+			FullyDistSpVec<int64_t, int64_t> Shybrid = (hops == 1) ? hybrid.MIS() : hybrid.MIS2();
+			FullyDistSpVec<int64_t, int64_t> Sloops = (hops == 1) ? loops.MIS() : loops.MIS2();
+			ostringstream outs;
+			outs << name << ": " << Shybrid.getnnz() << " vertices in " << hybrid.Rounds() << " rounds (" << hybrid.PullRounds() << " pull)" << endl;
+			SpParHelper::Print(outs.str());
+
+			allpassed &= Report(Independent(A, Shybrid, hops) && Maximal(A, Shybrid, hops), name);
+			allpassed &= Report(Independent(A, Sloops, hops) && Maximal(A, Sloops, hops), name + " with self loops");
+			allpassed &= Report(Ssparse == Spull && Spull == Shybrid && sparse.PullRounds() == 0 && pull.PullRounds() == pull.Rounds(), name + " pull rounds");
+		}
+
+		ENGINE engine(A, 11);
+		int64_t ncolors;
+		FullyDistVec<int64_t, int64_t> colors = engine.Color(ncolors);
+		bool proper = (colors.Count([](int64_t c){ return c < 0; }) == 0);
+		for(int64_t c = 0; c < ncolors && proper; ++c)
+		{
+			FullyDistSpVec<int64_t, int64_t> cls(colors, [c](int64_t col){ return col == c; });
+			cls.setNumToInd();
+			proper &= (cls.getnnz() > 0) && Independent(A, cls, 1);
+		}
+		ostringstream outs;
+		outs << "Color: " << ncolors << " colors" << endl;
+		SpParHelper::Print(outs.str());
+		allpassed &= Report(proper, "Color");
+	}
+	MPI_Finalize();
+	return allpassed ? 0 : 1;
+}
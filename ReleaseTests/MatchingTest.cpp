@@ -0,0 +1,141 @@
+/****************************************************************/
+/* Parallel Combinatorial BLAS Library (for Graph Computations) */
+/* version 1.6 -------------------------------------------------*/
+/* date: 6/15/2017 ---------------------------------------------*/
+/* authors: Ariful Azad, Aydin Buluc  --------------------------*/
+/****************************************************************/
+/*
+ Copyright (c) 2010-2017, The Regents of the University of California
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+
+#include "CombBLAS/CombBLAS.h"
+#include "CombBLAS/BipartiteMatchings/ApproxWeightPerfectMatching.h"
+#include <mpi.h>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <string>
+
+using namespace std;
+using namespace combblas;
+typedef SpParMat < int64_t, double, SpDCCols<int64_t,double> > PARDBMAT;
+typedef FullyDistVec<int64_t, int64_t> MateVec;
+
+// A matching of A: the mate vectors are inverses of each other and every pair is an edge of A
+bool ValidMatching(PARDBMAT & A, MateVec & mateRow2Col, MateVec & mateCol2Row, int64_t & cardinality)
+{
+	cardinality = mateRow2Col.Count([](int64_t mate){return mate != -1;});
+	MateVec r2c(mateRow2Col), c2r(mateCol2Row);
+	int64_t edges = RestrictMatching(A, r2c, c2r);
+	FullyDistSpVec<int64_t, int64_t> matchedRow(mateRow2Col, [](int64_t mate){return mate != -1;});
+	FullyDistSpVec<int64_t, int64_t> matchedCol(mateCol2Row, [](int64_t mate){return mate != -1;});
+	return (edges == cardinality) && (matchedCol.getnnz() == cardinality) && (matchedRow.Invert(A.getncol()) == matchedCol);
+}
+
+bool Report(bool passed, const string & what)
+{
+	if(passed)
+		SpParHelper::Print(what + " working correctly\n");
+	else
+		SpParHelper::Print("ERROR in " + what + ", go fix it!\n");
+	return passed;
+}
+
+int main(int argc, char* argv[])
+{
+	int nprocs, myrank;
+	int provided;
+	MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);	// lets AugmentPath walk paths on several threads
+	MPI_Comm_size(MPI_COMM_WORLD,&nprocs);
+	MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
+	if(argc < 2)
+	{
+		if(myrank == 0)
+		{
+			cout << "Usage: ./MatchingTest <Scale>" << endl;
+			cout << "Example: mpirun -np 4 ./MatchingTest 12" << endl;
+		}
+		MPI_Finalize();
+		return -1;
+	}
+	bool allpassed = true;
+	{
+		unsigned scale = static_cast<unsigned>(atoi(argv[1]));
+		double initiator[4] = {.57, .19, .19, .05};
+		DistEdgeList<int64_t> * DEL = new DistEdgeList<int64_t>();
+		DEL->GenGraph500Data(initiator, scale, 8, true, true);	// generate packed edges
+		PARDBMAT A(*DEL, false);
+		delete DEL;
+		A.PrintInfo();
+		int64_t n = A.getnrow();
+
+		// cardinality matching from scratch, twice with the same workspace
+		MaximumMatchingWorkspace<int64_t> ws(A);
+		MateVec mateRow2Col(A.getcommgrid(), n, (int64_t) -1);
+		MateVec mateCol2Row(A.getcommgrid(), n, (int64_t) -1);
+		maximumMatching(A, mateRow2Col, mateCol2Row, ws);
+		int64_t cardA;
+		allpassed &= Report(ValidMatching(A, mateRow2Col, mateCol2Row, cardA), "maximumMatching");
+
+		MateVec again2Col(A.getcommgrid(), n, (int64_t) -1);
+		MateVec again2Row(A.getcommgrid(), n, (int64_t) -1);
+		maximumMatching(A, again2Col, again2Row, ws);
+		int64_t cardAgain;
+		allpassed &= Report(ValidMatching(A, again2Col, again2Row, cardAgain) && cardAgain == cardA, "maximumMatching with a reused workspace");
+
+		// drop some edges and warm start from the matching of A
+		PARDBMAT B = A.PruneI([](tuple<int64_t,int64_t,double> t){ return (get<0>(t) + get<1>(t)) % 5 == 0; }, false);
+		MateVec scratch2Col(B.getcommgrid(), n, (int64_t) -1);
+		MateVec scratch2Row(B.getcommgrid(), n, (int64_t) -1);
+		maximumMatching(B, scratch2Col, scratch2Row);
+		int64_t cardB;
+		allpassed &= ValidMatching(B, scratch2Col, scratch2Row, cardB);
+
+		MateVec warm2Col(mateRow2Col), warm2Row(mateCol2Row);
+		int64_t kept = RestrictMatching(B, warm2Col, warm2Row);
+		int64_t cardKept;
+		allpassed &= Report(ValidMatching(B, warm2Col, warm2Row, cardKept) && kept == cardKept && kept <= cardA, "RestrictMatching");
+		maximumMatching(B, warm2Col, warm2Row, ws);
+		int64_t cardWarm;
+		allpassed &= Report(ValidMatching(B, warm2Col, warm2Row, cardWarm) && cardWarm == cardB, "warm started maximumMatching");
+
+		// a full diagonal guarantees a perfect matching for the weighted variant
+		MateVec diag(A.getcommgrid());
+		diag.iota(n, 0);
+		PARDBMAT W(n, n, diag, diag, 1.0);
+		W += B;
+		MateVec awpm2Col(W.getcommgrid(), n, (int64_t) -1);
+		MateVec awpm2Row(W.getcommgrid(), n, (int64_t) -1);
+		MaximumMatchingWorkspace<int64_t> wws;
+		AWPM(W, awpm2Col, awpm2Row, wws);
+		int64_t cardAWPM;
+		allpassed &= Report(ValidMatching(W, awpm2Col, awpm2Row, cardAWPM) && cardAWPM == n, "AWPM");
+
+		PARDBMAT W2 = W.PruneI([](tuple<int64_t,int64_t,double> t){ return get<0>(t) != get<1>(t) && (get<0>(t) * 3 + get<1>(t)) % 4 == 0; }, false);
+		AWPM(W2, awpm2Col, awpm2Row, wws, true, true, true);
+		int64_t cardAWPMWarm;
+		allpassed &= Report(ValidMatching(W2, awpm2Col, awpm2Row, cardAWPMWarm) && cardAWPMWarm == n, "warm started AWPM");
+	}
+	MPI_Finalize();
+	return allpassed ? 0 : 1;
+}
@@ -0,0 +1,119 @@
+/****************************************************************/
+/* Parallel Combinatorial BLAS Library (for Graph Computations) */
+/* version 1.6 -------------------------------------------------*/
+/* date: 6/15/2017 ---------------------------------------------*/
+/* authors: Ariful Azad, Aydin Buluc  --------------------------*/
+/****************************************************************/
+/*
+ Copyright (c) 2010-2017, The Regents of the University of California
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+#include "CombBLAS/CombBLAS.h"
+#include <mpi.h>
+#include <iostream>
+#include <vector>
+#include <random>
+
+using namespace std;
+using namespace combblas;
+
+typedef PlusTimesSRing<double, double> PTDD;
+typedef SpDCCols<int64_t,double> DCCols;
+typedef SpParMat < int64_t, double, DCCols > PSpMat_DCSC;
+
+bool Report(bool passed, const string & what)
+{
+	int ok = passed, allok;
+	MPI_Allreduce(&ok, &allok, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+	if(allok)
+		SpParHelper::Print(what + " working correctly\n");
+	else
+		SpParHelper::Print("ERROR in " + what + ", go fix it!\n");
+	return allok;
+}
+
+// integral values keep every sum exact, whatever the order of additions
+PSpMat_DCSC Random(shared_ptr<CommGrid> grid, int64_t m, int64_t n, int64_t nnz, uint64_t seed)
+{
+	mt19937_64 gen(seed + grid->GetRank());
+	vector<int64_t> rows, cols;
+	vector<double> vals;
+	for(int64_t k=0; k < nnz / grid->GetSize(); ++k)
+	{
+		rows.push_back(gen() % m);
+		cols.push_back((k % 10 == 0) ? (gen() % 8) : (gen() % n));	// a few dense columns
+		vals.push_back((double) (gen() % 9) + 1.0);
+	}
+	FullyDistVec<int64_t,int64_t> ri(rows, grid), ci(cols, grid);
+	FullyDistVec<int64_t,double> vi(vals, grid);
+	return PSpMat_DCSC(m, n, ri, ci, vi, true);
+}
+
+int main(int argc, char* argv[])
+{
+	int nprocs, myrank;
+	MPI_Init(&argc, &argv);
+	MPI_Comm_size(MPI_COMM_WORLD,&nprocs);
+	MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
+	if(argc < 2)
+	{
+		if(myrank == 0)
+		{
+			cout << "Usage: ./NodeSUMMATest <Scale>" << endl;
+			cout << "Example: mpirun -np 4 ./NodeSUMMATest 12" << endl;
+		}
+		MPI_Finalize();
+		return -1;
+	}
+	bool allpassed = true;
+	{
+		int64_t n = ((int64_t) 1) << atoi(argv[1]);
+		shared_ptr<CommGrid> fullWorld(new CommGrid(MPI_COMM_WORLD, 0, 0));
+		PSpMat_DCSC A = Random(fullWorld, n + n/3 + 5, n, 8*n, 11);
+		PSpMat_DCSC B = Random(fullWorld, n, n, 8*n, 13);	// phases split n evenly, as MemEfficientSpGEMM expects
+
+		// the shared panels are used by the square grid SUMMA only, rectangular grids take Mult_AnXBn_RectGrid
+		if(fullWorld->GetGridRows() == fullWorld->GetGridCols())
+		{
+			// Mult_AnXBn_DoubleBuff always broadcasts a private copy to every process
+			PSpMat_DCSC Flat = Mult_AnXBn_DoubleBuff<PTDD, double, DCCols>(A, B);
+			PSpMat_DCSC Shared = Mult_AnXBn_Synch<PTDD, double, DCCols>(A, B);
+			allpassed &= Report(Flat == Shared, "Mult_AnXBn_Synch with node shared panels");
+
+			// no pruning, selection or recovery: the phases only split the columns of B
+			PSpMat_DCSC Phased = MemEfficientSpGEMM<PTDD, double, DCCols>(A, B, 2, -1.0, (int64_t) n, (int64_t) 0, 0.0, 1, (int64_t) 0);
+			allpassed &= Report(Flat == Phased, "MemEfficientSpGEMM with node shared panels");
+		}
+
+		// with the grid rows packed into nodes, the row broadcasts never leave the node
+		shared_ptr<CommGrid> nodeGrid = NodeAwareGrid(MPI_COMM_WORLD);
+		PSpMat_DCSC An = Random(nodeGrid, n, n, 8*n, 17);
+		PSpMat_DCSC Bn = Random(nodeGrid, n, n, 8*n, 19);
+		FullyDistVec<int64_t,double> x(nodeGrid, n, 1.0);
+		PSpMat_DCSC Cn = Mult_AnXBn_Synch<PTDD, double, DCCols>(An, Bn);
+		FullyDistVec<int64_t,double> Cx = SpMV<PTDD>(Cn, x);
+		FullyDistVec<int64_t,double> ABx = SpMV<PTDD>(An, SpMV<PTDD>(Bn, x));
+		allpassed &= Report(Cx == ABx, "Mult_AnXBn_Synch on a node aware grid");
+	}
+	MPI_Finalize();
+	return allpassed ? 0 : 1;
+}
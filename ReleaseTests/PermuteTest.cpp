@@ -0,0 +1,125 @@
+/****************************************************************/
+/* Parallel Combinatorial BLAS Library (for Graph Computations) */
+/* version 1.6 -------------------------------------------------*/
+/* date: 6/15/2017 ---------------------------------------------*/
+/* authors: Ariful Azad, Aydin Buluc  --------------------------*/
+/****************************************************************/
+/*
+ Copyright (c) 2010-2017, The Regents of the University of California
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+#include "CombBLAS/CombBLAS.h"
+#include <mpi.h>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <string>
+
+using namespace std;
+using namespace combblas;
+
+typedef SpParMat < int64_t, double, SpDCCols<int64_t,double> > PARDBMAT;
+
+
+int main(int argc, char* argv[])
+{
+	int nprocs, myrank;
+	MPI_Init(&argc, &argv);
+	MPI_Comm_size(MPI_COMM_WORLD,&nprocs);
+	MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
+	if(argc < 2)
+	{
+		if(myrank == 0)
+		{
+			cout << "Usage: ./PermuteTest <Scale>" << endl;
+			cout << "Example: ./PermuteTest 14" << endl;
+		}
+		MPI_Finalize();
+		return -1;
+	}
+	bool allpassed = true;
+	{
+		unsigned scale = static_cast<unsigned>(atoi(argv[1]));
+		double initiator[4] = {.57, .19, .19, .05};
+		DistEdgeList<int64_t> * DEL = new DistEdgeList<int64_t>();
+		DEL->GenGraph500Data(initiator, scale, 8, true, true);	// generate packed edges
+		PARDBMAT A(*DEL, false);
+		delete DEL;
+		A.PrintInfo();
+		shared_ptr<CommGrid> fullWorld = A.getcommgrid();
+
+		uint64_t seed = 1383098845;
+		int64_t n = A.getnrow();
+
+		FullyDistVec<int64_t,int64_t> p(fullWorld);
+		p.randperm(n, seed);
+		FullyDistVec<int64_t,int64_t> q(fullWorld);
+		q.iota(n, 0);
+		q.RandPerm(seed);
+		if(p == q)
+			SpParHelper::Print("Implicit randperm matches RandPerm\n");
+		else
+		{
+			SpParHelper::Print("ERROR in randperm, go fix it!\n");
+			allpassed = false;
+		}
+
+		FullyDistVec<int64_t,int64_t> sorted = p;
+		sorted.sort();
+		FullyDistVec<int64_t,int64_t> id(fullWorld);
+		id.iota(n, 0);
+		if(sorted == id)
+			SpParHelper::Print("randperm generates a permutation\n");
+		else
+		{
+			SpParHelper::Print("ERROR: randperm output is not a permutation, go fix it!\n");
+			allpassed = false;
+		}
+
+		PARDBMAT B = A;
+		B.RandomRelabel(seed);
+		PARDBMAT C = A(p,p);
+		if(B == C)
+			SpParHelper::Print("RandomRelabel working correctly\n");
+		else
+		{
+			SpParHelper::Print("ERROR in RandomRelabel, go fix it!\n");
+			allpassed = false;
+		}
+
+		FullyDistVec<int64_t,int64_t> r(fullWorld);
+		r.iota(n, 0);
+		r.RandPerm(seed+1);
+		PARDBMAT D = A.Permute(p, r);
+		PARDBMAT E = A(p,r);
+		A.Permute(p, r, true);	// in-place
+		if(D == E && A == E)
+			SpParHelper::Print("Permute working correctly\n");
+		else
+		{
+			SpParHelper::Print("ERROR in Permute, go fix it!\n");
+			allpassed = false;
+		}
+	}
+	MPI_Finalize();
+	return allpassed ? 0 : 1;
+}
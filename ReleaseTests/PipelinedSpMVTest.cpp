@@ -0,0 +1,135 @@
+/****************************************************************/
+/* Parallel Combinatorial BLAS Library (for Graph Computations) */
+/* version 1.6 -------------------------------------------------*/
+/* date: 6/15/2017 ---------------------------------------------*/
+/* authors: Ariful Azad, Aydin Buluc  --------------------------*/
+/****************************************************************/
+/*
+ Copyright (c) 2010-2017, The Regents of the University of California
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+#include "CombBLAS/CombBLAS.h"
+#include <mpi.h>
+#include <iostream>
+#include <vector>
+#include <random>
+
+using namespace std;
+using namespace combblas;
+
+typedef PlusTimesSRing<double, double> PTDD;
+typedef SpDCCols<int64_t,double> DCCols;
+typedef SpParMat < int64_t, double, DCCols > PSpMat_DCSC;
+typedef SpParMat < int64_t, double, SpCSB<int64_t,double> > PSpMat_CSB;
+
+bool Report(bool passed, const string & what)
+{
+	int ok = passed, allok;
+	MPI_Allreduce(&ok, &allok, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+	if(allok)
+		SpParHelper::Print(what + " working correctly\n");
+	else
+		SpParHelper::Print("ERROR in " + what + ", go fix it!\n");
+	return allok;
+}
+
+// integral values keep every sum exact, whatever the order of additions
+FullyDistVec<int64_t,double> Vector(shared_ptr<CommGrid> grid, int64_t len, int64_t seed)
+{
+	FullyDistVec<int64_t,double> v(grid, len, 0.0);
+	v.ApplyInd([seed](double, int64_t i){ return (double) ((i * 7919 + seed) % 13) - 6.0; });
+	return v;
+}
+
+// sums the product over a random tiling of the local matrix and compares it with the untiled kernel
+template <typename MAT>
+bool TilesAddUp(const MAT & A, mt19937_64 & gen)
+{
+	int64_t lm = A.getnrow(), ln = A.getncol();
+	vector<double> x(ln), whole(lm, 0.0), tiled(lm, 0.0);
+	for(int64_t i=0; i<ln; ++i) x[i] = (double) ((i * 31) % 7) - 3.0;
+	gespmv_dense<PTDD>(A, x.data(), whole.data());
+
+	vector<int64_t> rcuts = {0, lm}, ccuts = {0, ln};
+	for(int k=0; k<3; ++k)
+	{
+		rcuts.push_back(gen() % (lm+1));
+		ccuts.push_back(gen() % (ln+1));
+	}
+	sort(rcuts.begin(), rcuts.end());
+	sort(ccuts.begin(), ccuts.end());
+	for(size_t c=0; c+1 < ccuts.size(); ++c)	// the column pieces in any order, as they would arrive
+		for(size_t r=0; r+1 < rcuts.size(); ++r)
+			gespmv_dense_tile<PTDD>(A, x.data(), tiled.data(), rcuts[r], rcuts[r+1], ccuts[ccuts.size()-2-c], ccuts[ccuts.size()-1-c]);
+	return whole == tiled;
+}
+
+int main(int argc, char* argv[])
+{
+	int nprocs, myrank;
+	MPI_Init(&argc, &argv);
+	MPI_Comm_size(MPI_COMM_WORLD,&nprocs);
+	MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
+	if(argc < 2)
+	{
+		if(myrank == 0)
+		{
+			cout << "Usage: ./PipelinedSpMVTest <Scale>" << endl;
+			cout << "Example: mpirun -np 4 ./PipelinedSpMVTest 14" << endl;
+		}
+		MPI_Finalize();
+		return -1;
+	}
+	bool allpassed = true;
+	{
+		int64_t n = ((int64_t) 1) << atoi(argv[1]);
+		int64_t m = n + n/3 + 5;	// rectangular, so that the row and column blocks differ
+		shared_ptr<CommGrid> fullWorld(new CommGrid(MPI_COMM_WORLD, 0, 0));
+
+		mt19937_64 gen(11 + myrank);
+		vector<int64_t> rows, cols;
+		vector<double> vals;
+		for(int64_t k=0; k < 8*n / nprocs; ++k)
+		{
+			rows.push_back(gen() % m);
+			cols.push_back((k % 10 == 0) ? (gen() % 8) : (gen() % n));	// a few dense columns
+			vals.push_back((double) (gen() % 9) - 4.0);
+		}
+		FullyDistVec<int64_t,int64_t> ri(rows, fullWorld), ci(cols, fullWorld);
+		FullyDistVec<int64_t,double> vi(vals, fullWorld);
+		PSpMat_DCSC A(m, n, ri, ci, vi, true);
+		PSpMat_CSB C = A;
+
+		allpassed &= Report(TilesAddUp(A.seq(), gen) && TilesAddUp(C.seq(), gen), "Tiled local SpMV");
+
+		// SpMVTranspose of the explicit transpose does the unpipelined local multiply and reductions
+		PSpMat_DCSC At = A;
+		At.Transpose();
+		FullyDistVec<int64_t,double> x = Vector(fullWorld, n, 3);
+		FullyDistVec<int64_t,double> Ax = SpMV<PTDD>(A, x);
+		FullyDistVec<int64_t,double> Cx = SpMV<PTDD>(C, x);
+		FullyDistVec<int64_t,double> Attx = SpMVTranspose<PTDD>(At, x);
+		allpassed &= Report(Ax == Attx && Cx == Attx, "Pipelined dense SpMV");
+	}
+	MPI_Finalize();
+	return allpassed ? 0 : 1;
+}
@@ -0,0 +1,137 @@
+/****************************************************************/
+/* Parallel Combinatorial BLAS Library (for Graph Computations) */
+/* version 1.6 -------------------------------------------------*/
+/* date: 6/15/2017 ---------------------------------------------*/
+/* authors: Ariful Azad, Aydin Buluc  --------------------------*/
+/****************************************************************/
+/*
+ Copyright (c) 2010-2017, The Regents of the University of California
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+#include "CombBLAS/CombBLAS.h"
+#include "CombBLAS/RCM.h"
+#include <mpi.h>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <string>
+
+using namespace std;
+using namespace combblas;
+typedef SpParMat < int64_t, double, SpDCCols<int64_t,double> > PARDBMAT;
+typedef SpParMat < int64_t, bool, SpCCols<int64_t,bool> > Par_CSC_Bool;
+
+// width x height grid, with the vertical edges between the two halves removed so that it has two components
+PARDBMAT Grid(shared_ptr<CommGrid> fullWorld, int64_t width, int64_t height)
+{
+	int64_t n = width * height;
+	int64_t cut = height/2 - 1;
+	FullyDistVec<int64_t, int64_t> rows(fullWorld);
+	rows.iota(n, 0);
+	FullyDistVec<int64_t, int64_t> hcols(rows);
+	hcols.Apply([width](int64_t v){ return (v % width == width-1) ? v : v+1; });
+	FullyDistVec<int64_t, int64_t> vcols(rows);
+	vcols.Apply([width, n, cut](int64_t v){ return (v + width < n && v / width != cut) ? v+width : v; });
+	FullyDistVec<int64_t, double> vals(fullWorld, n, 1.0);
+
+	PARDBMAT A(n, n, rows, hcols, vals);
+	PARDBMAT V(n, n, rows, vcols, vals);
+	A += V;
+	PARDBMAT AT(A);
+	AT.Transpose();
+	A += AT;
+	A.RemoveLoops();	// non-edges were generated as loops
+	return A;
+}
+
+int main(int argc, char* argv[])
+{
+	int nprocs, myrank;
+	MPI_Init(&argc, &argv);
+	MPI_Comm_size(MPI_COMM_WORLD,&nprocs);
+	MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
+	if(argc < 3)
+	{
+		if(myrank == 0)
+		{
+			cout << "Usage: ./RCMTest <Width> <Height>" << endl;
+			cout << "Example: mpirun -np 4 ./RCMTest 16 2000" << endl;
+		}
+		MPI_Finalize();
+		return -1;
+	}
+	bool allpassed = true;
+	{
+		int64_t width = atoll(argv[1]);
+		int64_t height = atoll(argv[2]);
+		shared_ptr<CommGrid> fullWorld;
+		fullWorld.reset( new CommGrid(MPI_COMM_WORLD, 0, 0) );
+		PARDBMAT G = Grid(fullWorld, width, height);
+
+		// scatter the grid over the processes
+		FullyDistVec<int64_t, int64_t> p(fullWorld);
+		p.iota(G.getnrow(), 0);
+		p.RandPerm(1);
+		G(p, p, true);
+		G.PrintInfo();
+
+		Par_CSC_Bool A = G;
+		FullyDistVec<int64_t, int64_t> degrees(fullWorld);
+		G.Reduce(degrees, Column, plus<int64_t>(), static_cast<int64_t>(0), [](double){ return static_cast<int64_t>(1); });
+		PreAllocatedSPA<int64_t> SPA(A.seq(), 4);
+
+		// the levels of the grid grow up to its width, so that 'width/2' switches between both paths in every component
+		FullyDistVec<int64_t, int64_t> distributed = RCM(A, degrees, SPA, 0);
+		vector<int64_t> limits = {width/2, G.getnrow()};
+		for(int64_t limit : limits)
+		{
+			FullyDistVec<int64_t, int64_t> batched = RCM(A, degrees, SPA, limit);
+			ostringstream what;
+			what << "RCM with local levels of at most " << limit << " vertices";
+			if(batched == distributed)
+				SpParHelper::Print(what.str() + " working correctly\n");
+			else
+			{
+				SpParHelper::Print("ERROR in " + what.str() + ", go fix it!\n");
+				allpassed = false;
+			}
+		}
+
+		FullyDistVec<int64_t, int64_t> reverseOrder(fullWorld, G.getnrow(), G.getnrow());
+		reverseOrder -= RCM(A);
+		FullyDistVec<int64_t, int64_t> perm = reverseOrder.sort();
+		G(perm, perm, true);
+		int64_t bandwidth = G.Bandwidth();
+		ostringstream outs;
+		outs << "Bandwidth after the grid is permuted by RCM: " << bandwidth << endl;
+		SpParHelper::Print(outs.str());
+		if(bandwidth <= 2*width)
+			SpParHelper::Print("RCM bandwidth reduction working correctly\n");
+		else
+		{
+			SpParHelper::Print("ERROR in RCM bandwidth reduction, go fix it!\n");
+			allpassed = false;
+		}
+	}
+	MPI_Finalize();
+	return allpassed ? 0 : 1;
+}
@@ -0,0 +1,135 @@
+/****************************************************************/
+/* Parallel Combinatorial BLAS Library (for Graph Computations) */
+/* version 1.6 -------------------------------------------------*/
+/* date: 6/15/2017 ---------------------------------------------*/
+/* authors: Ariful Azad, Aydin Buluc  --------------------------*/
+/****************************************************************/
+/*
+ Copyright (c) 2010-2017, The Regents of the University of California
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+
+#define DETERMINISTIC	// both generations below must draw the same graph
+#include "CombBLAS/CombBLAS.h"
+#include <mpi.h>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <string>
+#ifdef THREADED
+#include <omp.h>
+#endif
+
+using namespace std;
+using namespace combblas;
+
+typedef SpParMat < int64_t, double, SpDCCols<int64_t,double> > PARDBMAT;
+
+// sorted out-degrees, invariant under a symmetric relabeling of the vertices
+FullyDistVec<int64_t, double> DegreeSequence(PARDBMAT & A)
+{
+	FullyDistVec<int64_t, double> degrees = A.Reduce(Row, plus<double>(), 0.0, [](double){ return 1.0; });
+	degrees.sort();
+	return degrees;
+}
+
+int main(int argc, char* argv[])
+{
+	int nprocs, myrank;
+	MPI_Init(&argc, &argv);
+	MPI_Comm_size(MPI_COMM_WORLD,&nprocs);
+	MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
+	if(argc < 2)
+	{
+		if(myrank == 0)
+		{
+			cout << "Usage: ./RMatOwnerTest <Scale>" << endl;
+			cout << "Example: mpirun -np 4 ./RMatOwnerTest 14" << endl;
+		}
+		MPI_Finalize();
+		return -1;
+	}
+	bool allpassed = true;
+	{
+		int scale = atoi(argv[1]);
+		int edgefactor = 8;
+		double initiator[4] = {.57, .19, .19, .05};
+
+		DistEdgeList<int64_t> * DEL = new DistEdgeList<int64_t>();
+		DEL->GenGraph500DataByOwner(initiator, scale, edgefactor);
+		int64_t localedges = DEL->getNumLocalEdges();
+		int64_t totaledges = 0;
+		MPI_Allreduce(&localedges, &totaledges, 1, MPIType<int64_t>(), MPI_SUM, MPI_COMM_WORLD);
+		if(totaledges == DEL->getGlobalV() * edgefactor)
+			SpParHelper::Print("GenGraph500DataByOwner generates the requested number of edges\n");
+		else
+		{
+			SpParHelper::Print("ERROR in GenGraph500DataByOwner edge count, go fix it!\n");
+			allpassed = false;
+		}
+		PARDBMAT A(*DEL, false);	// no redistribution
+		PermEdges(*DEL);	// scatter the same edges over all processors
+		PARDBMAT B(*DEL, false);	// goes through the regular exchange
+		delete DEL;
+		A.PrintInfo();
+		if(A == B)
+			SpParHelper::Print("Edges are generated on their owners\n");
+		else
+		{
+			SpParHelper::Print("ERROR in owner-local generation, go fix it!\n");
+			allpassed = false;
+		}
+
+#ifdef THREADED
+		int maxthreads = omp_get_max_threads();
+		omp_set_num_threads(1);
+		DEL = new DistEdgeList<int64_t>();
+		DEL->GenGraph500DataByOwner(initiator, scale, edgefactor);
+		PARDBMAT C(*DEL, false);
+		delete DEL;
+		omp_set_num_threads(maxthreads);
+		if(A == C)
+			SpParHelper::Print("Generated graph does not depend on the number of threads\n");
+		else
+		{
+			SpParHelper::Print("ERROR: generated graph depends on the number of threads, go fix it!\n");
+			allpassed = false;
+		}
+#endif
+
+		DEL = new DistEdgeList<int64_t>();
+		DEL->GenGraph500DataByOwner(initiator, scale, edgefactor, true);
+		PARDBMAT S(*DEL, false);
+		delete DEL;
+		FullyDistVec<int64_t, double> degA = DegreeSequence(A);
+		FullyDistVec<int64_t, double> degS = DegreeSequence(S);
+		if(S.getnnz() == A.getnnz() && degS == degA && !(S == A))
+			SpParHelper::Print("Scrambled graph is a relabeling of the unscrambled one\n");
+		else
+		{
+			SpParHelper::Print("ERROR in scrambled GenGraph500DataByOwner, go fix it!\n");
+			allpassed = false;
+		}
+	}
+	MPI_Finalize();
+	return allpassed ? 0 : 1;
+}
@@ -0,0 +1,234 @@
+/****************************************************************/
+/* Parallel Combinatorial BLAS Library (for Graph Computations) */
+/* version 1.6 -------------------------------------------------*/
+/* date: 6/15/2017 ---------------------------------------------*/
+/* authors: Ariful Azad, Aydin Buluc  --------------------------*/
+/****************************************************************/
+/*
+ Copyright (c) 2010-2017, The Regents of the University of California
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+#include "CombBLAS/CombBLAS.h"
+#include <mpi.h>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <random>
+
+using namespace std;
+using namespace combblas;
+
+typedef PlusTimesSRing<double, double> PTDD;
+typedef SpParMat < int64_t, double, SpDCCols<int64_t,double> > PSpMat_DCSC;
+
+struct Triples
+{
+	int64_t m, n;
+	vector<int64_t> rows, cols;
+	vector<double> vals;
+};
+
+bool Report(bool passed, const string & what)
+{
+	int ok = passed, allok;
+	MPI_Allreduce(&ok, &allok, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+	if(allok)
+		SpParHelper::Print(what + " working correctly\n");
+	else
+		SpParHelper::Print("ERROR in " + what + ", go fix it!\n");
+	return allok;
+}
+
+// every process generates the same global triples, with integral values so that every sum is exact
+Triples Generate(int64_t m, int64_t n, int64_t nnz, uint64_t seed)
+{
+	Triples t;
+	t.m = m;
+	t.n = n;
+	mt19937_64 gen(seed);
+	for(int64_t k=0; k < nnz; ++k)
+	{
+		t.rows.push_back(gen() % m);
+		t.cols.push_back((k % 10 == 0) ? (gen() % 8) : (gen() % n));	// a few dense columns
+		t.vals.push_back((double) (gen() % 9) - 4.0);
+	}
+	return t;
+}
+
+PSpMat_DCSC Distribute(const Triples & t, shared_ptr<CommGrid> grid)
+{
+	int nprocs = grid->GetSize();
+	int rank = grid->GetRank();
+	size_t beg = t.rows.size() * rank / nprocs;
+	size_t end = t.rows.size() * (rank+1) / nprocs;
+	vector<int64_t> rows(t.rows.begin()+beg, t.rows.begin()+end), cols(t.cols.begin()+beg, t.cols.begin()+end);
+	vector<double> vals(t.vals.begin()+beg, t.vals.begin()+end);
+	FullyDistVec<int64_t,int64_t> ri(rows, grid), ci(cols, grid);
+	FullyDistVec<int64_t,double> vi(vals, grid);
+	return PSpMat_DCSC(t.m, t.n, ri, ci, vi, true);
+}
+
+double Value(int64_t i, int64_t seed)
+{
+	return (double) ((i * 7919 + seed) % 13) - 6.0;
+}
+
+FullyDistVec<int64_t,double> Vector(shared_ptr<CommGrid> grid, int64_t len, int64_t seed)
+{
+	FullyDistVec<int64_t,double> v(grid, len, 0.0);
+	v.ApplyInd([seed](double, int64_t i){ return Value(i, seed); });
+	return v;
+}
+
+// the whole vector on every process, in the order of the grid's ranks (which is the global order)
+vector<double> Gather(const FullyDistVec<int64_t,double> & v)
+{
+	MPI_Comm world = v.getcommgrid()->GetWorld();
+	int nprocs;
+	MPI_Comm_size(world, &nprocs);
+	int mysize = (int) v.LocArrSize();
+	vector<int> sizes(nprocs), dpls(nprocs, 0);
+	MPI_Allgather(&mysize, 1, MPI_INT, sizes.data(), 1, MPI_INT, world);
+	partial_sum(sizes.begin(), sizes.end()-1, dpls.begin()+1);
+	vector<double> all(v.TotalLength());
+	MPI_Allgatherv(v.GetLocArr(), mysize, MPI_DOUBLE, all.data(), sizes.data(), dpls.data(), MPI_DOUBLE, world);
+	return all;
+}
+
+vector<double> SerialSpMV(const Triples & t, const vector<double> & x, bool transpose)
+{
+	vector<double> y(transpose? t.n : t.m, 0.0);
+	for(size_t k=0; k < t.rows.size(); ++k)
+	{
+		if(transpose)	y[t.cols[k]] += t.vals[k] * x[t.rows[k]];
+		else		y[t.rows[k]] += t.vals[k] * x[t.cols[k]];
+	}
+	return y;
+}
+
+vector<double> DenseValues(int64_t len, int64_t seed)
+{
+	vector<double> v(len);
+	for(int64_t i=0; i< len; ++i)	v[i] = Value(i, seed);
+	return v;
+}
+
+bool TestGrid(shared_ptr<CommGrid> grid, const Triples & A_t, const Triples & B_t, const Triples & S_t, const string & name)
+{
+	bool passed = true;
+	int64_t m = A_t.m, n = A_t.n, q = B_t.n;
+	PSpMat_DCSC A = Distribute(A_t, grid);
+
+	vector<double> xs = DenseValues(n, 3), ys = DenseValues(m, 5), zs = DenseValues(q, 7);
+	FullyDistVec<int64_t,double> x = Vector(grid, n, 3), y = Vector(grid, m, 5), z = Vector(grid, q, 7);
+
+	passed &= Report(Gather(SpMV<PTDD>(A, x)) == SerialSpMV(A_t, xs, false), name + " dense SpMV");
+	passed &= Report(Gather(SpMVTranspose<PTDD>(A, y)) == SerialSpMV(A_t, ys, true), name + " SpMVTranspose");
+
+	FullyDistSpVec<int64_t,double> xsparse(grid, n);
+	vector<double> xsdense(n, 0.0);
+	for(int64_t i=0; i< n; i += 7)
+	{
+		xsparse.SetElement(i, xs[i]);
+		xsdense[i] = xs[i];
+	}
+	FullyDistSpVec<int64_t,double> ysparse(grid, m);
+	SpMV<PTDD>(A, xsparse, ysparse, false);
+	FullyDistVec<int64_t,double> ysp(grid, m, 0.0);
+	ysp.Set(ysparse);
+	passed &= Report(Gather(ysp) == SerialSpMV(A_t, xsdense, false), name + " sparse SpMV");
+
+	vector<double> colsums = SerialSpMV(A_t, vector<double>(m, 1.0), true);
+	vector<double> rowsums = SerialSpMV(A_t, vector<double>(n, 1.0), false);
+	passed &= Report(Gather(A.Reduce(Column, plus<double>(), 0.0)) == colsums && Gather(A.Reduce(Row, plus<double>(), 0.0)) == rowsums, name + " Reduce");
+
+	PSpMat_DCSC As = A;
+	As.DimApply(Column, x, multiplies<double>());
+	vector<double> scaled(n);
+	for(int64_t j=0; j< n; ++j)	scaled[j] = colsums[j] * xs[j];
+	passed &= Report(Gather(As.Reduce(Column, plus<double>(), 0.0)) == scaled, name + " DimApply");
+
+	PSpMat_DCSC At = A;
+	At.Transpose();
+	passed &= Report(At.getnrow() == n && At.getncol() == m && At.getnnz() == A.getnnz() && Gather(SpMV<PTDD>(At, y)) == SerialSpMV(A_t, ys, true), name + " Transpose");
+
+	PSpMat_DCSC B = Distribute(B_t, grid);
+	PSpMat_DCSC C = Mult_AnXBn_Synch<PTDD, double, SpDCCols<int64_t,double> >(A, B);
+	passed &= Report(C.getnrow() == m && C.getncol() == q && Gather(SpMV<PTDD>(C, z)) == SerialSpMV(A_t, SerialSpMV(B_t, zs, false), false), name + " SpGEMM");
+
+	PSpMat_DCSC S = Distribute(S_t, grid);
+	double offdiag = 0;
+	for(size_t k=0; k < S_t.rows.size(); ++k)
+		if(S_t.rows[k] != S_t.cols[k])	offdiag += S_t.vals[k];
+	S.RemoveLoops();
+	vector<double> Ssums = Gather(S.Reduce(Column, plus<double>(), 0.0));
+	passed &= Report(accumulate(Ssums.begin(), Ssums.end(), 0.0) == offdiag, name + " RemoveLoops");
+	return passed;
+}
+
+int main(int argc, char* argv[])
+{
+	int nprocs, myrank;
+	MPI_Init(&argc, &argv);
+	MPI_Comm_size(MPI_COMM_WORLD,&nprocs);
+	MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
+	if(argc < 2)
+	{
+		if(myrank == 0)
+		{
+			cout << "Usage: ./RectGridTest <Scale>" << endl;
+			cout << "Example: mpirun -np 4 ./RectGridTest 10" << endl;
+		}
+		MPI_Finalize();
+		return -1;
+	}
+	bool allpassed = true;
+	{
+		int64_t n = ((int64_t) 1) << atoi(argv[1]);
+		int64_t m = n + n/3 + 5;	// rectangular, with partial blocks
+		int64_t q = n/2 + 3;
+		Triples A_t = Generate(m, n, 8*n, 11);
+		Triples B_t = Generate(n, q, 4*n, 13);
+		Triples S_t = Generate(n, n, 8*n, 17);
+		for(int64_t i=0; i< n; i += 3)	// plenty of loops
+		{
+			S_t.rows.push_back(i);
+			S_t.cols.push_back(i);
+			S_t.vals.push_back(1.0);
+		}
+
+		// every rectangular factorization of nprocs, plus the default and the node aware grids
+		for(int pr = 1; pr <= nprocs; ++pr)
+		{
+			if(nprocs % pr != 0 || pr * pr == nprocs) continue;
+			shared_ptr<CommGrid> grid(new CommGrid(MPI_COMM_WORLD, pr, nprocs/pr));
+			ostringstream name;
+			name << pr << "x" << nprocs/pr;
+			allpassed &= TestGrid(grid, A_t, B_t, S_t, name.str());
+		}
+		shared_ptr<CommGrid> defaultGrid(new CommGrid(MPI_COMM_WORLD, 0, 0));
+		allpassed &= TestGrid(defaultGrid, A_t, B_t, S_t, "Default grid");
+		allpassed &= TestGrid(NodeAwareGrid(MPI_COMM_WORLD), A_t, B_t, S_t, "Node aware grid");
+	}
+	MPI_Finalize();
+	return allpassed ? 0 : 1;
+}
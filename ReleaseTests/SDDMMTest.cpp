@@ -0,0 +1,139 @@
+/****************************************************************/
+/* Parallel Combinatorial BLAS Library (for Graph Computations) */
+/* version 1.6 -------------------------------------------------*/
+/* date: 6/15/2017 ---------------------------------------------*/
+/* authors: Ariful Azad, Aydin Buluc  --------------------------*/
+/****************************************************************/
+/*
+ Copyright (c) 2010-2017, The Regents of the University of California
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+#include "CombBLAS/CombBLAS.h"
+#include <mpi.h>
+#include <iostream>
+#include <vector>
+#include <random>
+
+using namespace std;
+using namespace combblas;
+
+typedef PlusTimesSRing<double, double> PTDD;
+typedef SpParMat < int64_t, double, SpDCCols<int64_t,double> > PSpMat_DCSC;
+typedef SpParMat < int64_t, double, SpCSB<int64_t,double> > PSpMat_CSB;
+
+bool Report(bool passed, const string & what)
+{
+	int ok = passed, allok;
+	MPI_Allreduce(&ok, &allok, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+	if(allok)
+		SpParHelper::Print(what + " working correctly\n");
+	else
+		SpParHelper::Print("ERROR in " + what + ", go fix it!\n");
+	return allok;
+}
+
+// integral values keep every sum exact, whatever the order of additions
+PSpMat_DCSC Random(shared_ptr<CommGrid> grid, int64_t m, int64_t n, int64_t nnz, int64_t colstride, uint64_t seed)
+{
+	mt19937_64 gen(seed + grid->GetRank());
+	vector<int64_t> rows, cols;
+	vector<double> vals;
+	for(int64_t k=0; k < nnz / grid->GetSize(); ++k)
+	{
+		rows.push_back(gen() % m);
+		cols.push_back((gen() % (n / colstride)) * colstride);	// only every colstride-th column is nonempty
+		vals.push_back((double) (gen() % 9) - 4.0);
+	}
+	FullyDistVec<int64_t,int64_t> ri(rows, grid), ci(cols, grid);
+	FullyDistVec<int64_t,double> vi(vals, grid);
+	return PSpMat_DCSC(m, n, ri, ci, vi, true);
+}
+
+DenseMultiVec<int64_t,double> Block(shared_ptr<CommGrid> grid, int64_t len, int k, int64_t salt)
+{
+	vector< FullyDistVec<int64_t,double> > columns;
+	for(int t=0; t< k; ++t)
+	{
+		FullyDistVec<int64_t,double> v(grid, len, 0.0);
+		v.ApplyInd([t,salt](double, int64_t i){ return (double) ((i * 7919 + t * 31 + salt) % 13) - 6.0; });
+		columns.push_back(v);
+	}
+	return DenseMultiVec<int64_t,double>(columns);
+}
+
+// the sampled product built one rank-one term at a time by scaling the rows and columns of the pattern of S
+PSpMat_DCSC Reference(const PSpMat_DCSC & S, const DenseMultiVec<int64_t,double> & U, const DenseMultiVec<int64_t,double> & V)
+{
+	PSpMat_DCSC R(S);
+	R.Apply([](double){ return 0.0; });
+	for(int t=0; t< U.getnvec(); ++t)
+	{
+		PSpMat_DCSC term(S);
+		term.Apply([](double){ return 1.0; });
+		term.DimApply(Row, U.Column(t), multiplies<double>());
+		term.DimApply(Column, V.Column(t), multiplies<double>());
+		R += term;
+	}
+	return R;
+}
+
+int main(int argc, char* argv[])
+{
+	int nprocs, myrank;
+	MPI_Init(&argc, &argv);
+	MPI_Comm_size(MPI_COMM_WORLD,&nprocs);
+	MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
+	if(argc < 2)
+	{
+		if(myrank == 0)
+		{
+			cout << "Usage: ./SDDMMTest <Scale>" << endl;
+			cout << "Example: mpirun -np 4 ./SDDMMTest 12" << endl;
+		}
+		MPI_Finalize();
+		return -1;
+	}
+	bool allpassed = true;
+	{
+		int64_t n = ((int64_t) 1) << atoi(argv[1]);
+		int64_t m = n + n/3 + 5;	// rectangular
+		shared_ptr<CommGrid> fullWorld(new CommGrid(MPI_COMM_WORLD, 0, 0));
+
+		PSpMat_DCSC A = Random(fullWorld, m, n, 8*n, 1, 11);
+		PSpMat_CSB C = A;
+		PSpMat_DCSC H = Random(fullWorld, m, n, n, 64, 13);	// few nonzero columns, the rows of V are fetched selectively
+		for(int k : {1, 2*SPMMPANEL + 3})
+		{
+			DenseMultiVec<int64_t,double> U = Block(fullWorld, m, k, 3);
+			DenseMultiVec<int64_t,double> V = Block(fullWorld, n, k, 5);
+			string width = " with " + to_string(k) + " columns";
+
+			PSpMat_DCSC RA = Reference(A, U, V);
+			PSpMat_DCSC RH = Reference(H, U, V);
+			allpassed &= Report(SDDMM<PTDD>(A, U, V) == RA && SDDMM<PTDD>(H, U, V) == RH, "DCSC SDDMM" + width);
+			allpassed &= Report(PSpMat_DCSC(SDDMM<PTDD>(C, U, V)) == RA, "CSB SDDMM" + width);
+			allpassed &= Report(SDDMM<PTDD>(A, U, V, multiplies<double>()) == EWiseMult(A, RA, false), "Scaled SDDMM" + width);
+		}
+	}
+	MPI_Finalize();
+	return allpassed ? 0 : 1;
+}
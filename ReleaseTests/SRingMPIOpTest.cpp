@@ -0,0 +1,166 @@
+/****************************************************************/
+/* Parallel Combinatorial BLAS Library (for Graph Computations) */
+/* version 1.6 -------------------------------------------------*/
+/* date: 6/15/2017 ---------------------------------------------*/
+/* authors: Ariful Azad, Aydin Buluc  --------------------------*/
+/****************************************************************/
+/*
+ Copyright (c) 2010-2017, The Regents of the University of California
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+#include "CombBLAS/CombBLAS.h"
+#include <mpi.h>
+#include <iostream>
+#include <vector>
+#include <random>
+
+using namespace std;
+using namespace combblas;
+
+typedef SpParMat < int64_t, double, SpDCCols<int64_t,double> > PSpMat_DCSC;
+
+bool Report(bool passed, const string & what)
+{
+	int ok = passed, allok;
+	MPI_Allreduce(&ok, &allok, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+	if(allok)
+		SpParHelper::Print(what + " working correctly\n");
+	else
+		SpParHelper::Print("ERROR in " + what + ", go fix it!\n");
+	return allok;
+}
+
+// a value type that no built-in MPI datatype describes
+struct DistArg
+{
+	double dist;
+	int64_t arg;
+	bool operator==(const DistArg & rhs) const { return dist == rhs.dist && arg == rhs.arg; }
+};
+
+// shortest distance with the smallest argument on ties, and no mpi_op(): the MPI_Op comes from add()
+struct MinArgSRing
+{
+	static DistArg id() { return DistArg{numeric_limits<double>::max(), numeric_limits<int64_t>::max()}; }
+	static bool returnedSAID() { return false; }
+	static DistArg add(const DistArg & arg1, const DistArg & arg2)
+	{
+		if(arg1.dist != arg2.dist)
+			return (arg1.dist < arg2.dist) ? arg1 : arg2;
+		return (arg1.arg < arg2.arg) ? arg1 : arg2;
+	}
+	static DistArg multiply(const double & arg1, const DistArg & arg2)
+	{
+		return (arg2.dist == numeric_limits<double>::max()) ? id() : DistArg{arg1 + arg2.dist, arg2.arg};
+	}
+	static void axpy(double a, const DistArg & x, DistArg & y)
+	{
+		y = add(y, multiply(a, x));
+	}
+};
+
+// keeps the first operand that is not the identity: associative, but not commutative
+struct FirstSRing
+{
+	static double id() { return 0.0; }
+	static bool returnedSAID() { return false; }
+	static double add(const double & arg1, const double & arg2) { return (arg1 != 0.0) ? arg1 : arg2; }
+	static double multiply(const double & arg1, const double & arg2) { return arg2; }
+	static void axpy(double a, const double & x, double & y) { y = add(y, multiply(a, x)); }
+};
+
+// the same product with a built-in MPI operation
+struct MinSRing
+{
+	static double id() { return numeric_limits<double>::max(); }
+	static bool returnedSAID() { return false; }
+	static MPI_Op mpi_op() { return MPI_MIN; }
+	static double add(const double & arg1, const double & arg2) { return std::min(arg1, arg2); }
+	static double multiply(const double & arg1, const double & arg2) { return arg2; }
+	static void axpy(double a, const double & x, double & y) { y = add(y, multiply(a, x)); }
+};
+
+namespace combblas {
+template <> struct SRingAddCommutes<FirstSRing> : std::false_type {};
+template <> struct promote_trait<double, DistArg> { typedef DistArg T_promote; };
+}
+
+int main(int argc, char* argv[])
+{
+	int nprocs, myrank;
+	MPI_Init(&argc, &argv);
+	MPI_Comm_size(MPI_COMM_WORLD,&nprocs);
+	MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
+	if(argc < 2)
+	{
+		if(myrank == 0)
+		{
+			cout << "Usage: ./SRingMPIOpTest <Scale>" << endl;
+			cout << "Example: mpirun -np 4 ./SRingMPIOpTest 12" << endl;
+		}
+		MPI_Finalize();
+		return -1;
+	}
+	bool allpassed = true;
+	{
+		int64_t n = ((int64_t) 1) << atoi(argv[1]);
+		shared_ptr<CommGrid> fullWorld(new CommGrid(MPI_COMM_WORLD, 0, 0));
+
+		mt19937_64 gen(7 + myrank);
+		vector<int64_t> rows, cols;
+		vector<double> vals;
+		for(int64_t k=0; k < 4*n / nprocs; ++k)
+		{
+			rows.push_back(gen() % n);
+			cols.push_back(gen() % n);
+			vals.push_back((double) (gen() % 5) + 1.0);
+		}
+		FullyDistVec<int64_t,int64_t> ri(rows, fullWorld), ci(cols, fullWorld);
+		FullyDistVec<int64_t,double> vi(vals, fullWorld);
+		PSpMat_DCSC A(n, n, ri, ci, vi, true);
+
+		// x(j) = j+1: FirstSRing keeps the leftmost column, as the local products and the rank ordered reduction see it
+		FullyDistVec<int64_t,double> colids(fullWorld, n, 0.0);
+		colids.ApplyInd([](double, int64_t i){ return (double) (i+1); });
+		FullyDistVec<int64_t,double> first = SpMV<FirstSRing>(A, colids);
+		FullyDistVec<int64_t,double> minimum = SpMV<MinSRing>(A, colids);
+		minimum.Apply([](double v){ return (v == numeric_limits<double>::max()) ? 0.0 : v; });
+		allpassed &= Report(first == minimum, "Non commutative semiring SpMV");
+
+		// the distances have to match min-plus with MPI_MIN, the arguments have to survive the transposed reduction
+		FullyDistVec<int64_t,DistArg> x(fullWorld, n, MinArgSRing::id());
+		x.ApplyInd([](DistArg, int64_t i){ return DistArg{(double) (i % 7), i}; });
+		FullyDistVec<int64_t,double> xdist(fullWorld, n, 0.0);
+		xdist.ApplyInd([](double, int64_t i){ return (double) (i % 7); });
+		FullyDistVec<int64_t,DistArg> y = SpMV<MinArgSRing>(A, x);
+		FullyDistVec<int64_t,double> ydist = SpMV< MinPlusSRing<double,double> >(A, xdist);
+		PSpMat_DCSC At = A;
+		At.Transpose();
+		FullyDistVec<int64_t,DistArg> yt = SpMVTranspose<MinArgSRing>(At, x);
+		bool same = (y == yt) && (y.LocArrSize() == ydist.LocArrSize());
+		for(int64_t i=0; same && i < y.LocArrSize(); ++i)
+			same = (y.GetLocArr()[i].dist == ydist.GetLocArr()[i]);
+		allpassed &= Report(same, "Derived type semiring SpMV");
+	}
+	MPI_Finalize();
+	return allpassed ? 0 : 1;
+}
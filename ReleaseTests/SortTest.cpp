@@ -0,0 +1,153 @@
+/****************************************************************/
+/* Parallel Combinatorial BLAS Library (for Graph Computations) */
+/* version 1.6 -------------------------------------------------*/
+/* date: 6/15/2017 ---------------------------------------------*/
+/* authors: Ariful Azad, Aydin Buluc  --------------------------*/
+/****************************************************************/
+/*
+ Copyright (c) 2010-2017, The Regents of the University of California
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+
+#include "CombBLAS/CombBLAS.h"
+#include <mpi.h>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <random>
+
+using namespace std;
+using namespace combblas;
+
+// gathers the pieces to process 0 and compares them with the sequentially sorted input
+template <class E>
+bool Check(vector<E> & local, const string & what)
+{
+	int nprocs, myrank;
+	MPI_Comm_size(MPI_COMM_WORLD,&nprocs);
+	MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
+	MPI_Datatype MPI_elemType;
+	MPI_Type_contiguous(sizeof(E), MPI_CHAR, &MPI_elemType);
+	MPI_Type_commit(&MPI_elemType);
+
+	int mylen = static_cast<int>(local.size());
+	vector<int> lens(nprocs), displs(nprocs, 0);
+	MPI_Allgather(&mylen, 1, MPI_INT, lens.data(), 1, MPI_INT, MPI_COMM_WORLD);
+	partial_sum(lens.begin(), lens.end()-1, displs.begin()+1);
+	vector<E> input(displs.back() + lens.back());
+	MPI_Gatherv(local.data(), mylen, MPI_elemType, input.data(), lens.data(), displs.data(), MPI_elemType, 0, MPI_COMM_WORLD);
+
+	vector<int64_t> dist(lens.begin(), lens.end());
+	SpParHelper::MemoryEfficientPSort(local.data(), (int64_t) mylen, dist.data(), MPI_COMM_WORLD);
+	vector<E> output(input.size());
+	MPI_Gatherv(local.data(), mylen, MPI_elemType, output.data(), lens.data(), displs.data(), MPI_elemType, 0, MPI_COMM_WORLD);
+	MPI_Type_free(&MPI_elemType);
+
+	int passed = 1;
+	if(myrank == 0)
+	{
+		sort(input.begin(), input.end());
+		for(size_t i=0; i<input.size(); ++i)
+			passed &= !(input[i] < output[i]) && !(output[i] < input[i]);
+	}
+	MPI_Bcast(&passed, 1, MPI_INT, 0, MPI_COMM_WORLD);
+	if(passed)
+		SpParHelper::Print(what + " working correctly\n");
+	else
+		SpParHelper::Print("ERROR in " + what + ", go fix it!\n");
+	return passed;
+}
+
+int main(int argc, char* argv[])
+{
+	int nprocs, myrank;
+	MPI_Init(&argc, &argv);
+	MPI_Comm_size(MPI_COMM_WORLD,&nprocs);
+	MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
+	if(argc < 2)
+	{
+		if(myrank == 0)
+		{
+			cout << "Usage: ./SortTest <Scale>" << endl;
+			cout << "Example: mpirun -np 4 ./SortTest 18" << endl;
+		}
+		MPI_Finalize();
+		return -1;
+	}
+	bool allpassed = true;
+	{
+		int64_t n = ((int64_t) 1) << atoi(argv[1]);
+		mt19937_64 gen(1234 + myrank);
+		// uneven pieces and an empty process
+		int64_t mylen = (myrank == 1) ? 0 : (2 * n * (myrank + 1)) / (nprocs * (nprocs + 1));
+
+		vector< pair<int64_t,int64_t> > skewed(mylen);
+		uniform_int_distribution<int64_t> keys(-1000, 1000);
+		for(int64_t i=0; i<mylen; ++i)
+			skewed[i] = make_pair((i % 3 == 0) ? 42 : keys(gen), (int64_t) (gen() % 7));	// heavy duplicates
+		allpassed &= Check(skewed, "Sort of integer pairs with duplicates");
+
+		vector< pair<double,uint32_t> > reals(mylen);
+		normal_distribution<double> normal(0.0, 10.0);
+		for(int64_t i=0; i<mylen; ++i)
+			reals[i] = make_pair((i % 5 == 0) ? ((i % 2) ? -0.0 : 0.0) : normal(gen), (uint32_t) gen());
+		allpassed &= Check(reals, "Sort of floating point keys");
+
+		vector< pair<pair<int,int>,int64_t> > tuples(mylen / 4);	// comparison sorted
+		for(size_t i=0; i<tuples.size(); ++i)
+			tuples[i] = make_pair(make_pair((int) (gen() % 100), (int) (gen() % 100)), (int64_t) i);
+		allpassed &= Check(tuples, "Sort of non-arithmetic keys");
+
+		shared_ptr<CommGrid> fullWorld;
+		fullWorld.reset( new CommGrid(MPI_COMM_WORLD, 0, 0) );
+		FullyDistVec<int64_t, double> x(fullWorld, n, 0.0);
+		x.ApplyInd([](double v, int64_t i){ return (double) ((i * 2654435761LL) % 100); });	// many ties
+		FullyDistVec<int64_t, double> sorted(x);
+		FullyDistVec<int64_t, int64_t> perm = sorted.sort();
+		FullyDistVec<int64_t, double> permuted = x(perm);
+		bool ordered = (permuted == sorted);
+		const double * arr = sorted.GetLocArr();
+		int64_t len = sorted.LocArrSize();
+		for(int64_t i=1; i<len; ++i)
+			ordered &= (arr[i-1] <= arr[i]);
+		double mine[2] = {(len == 0) ? -1.0 : arr[0], (len == 0) ? -1.0 : arr[len-1]};
+		vector<double> ends(2*nprocs);
+		MPI_Allgather(mine, 2, MPI_DOUBLE, ends.data(), 2, MPI_DOUBLE, MPI_COMM_WORLD);
+		double last = -1.0;
+		for(int i=0; i<nprocs; ++i)
+		{
+			if(ends[2*i] < 0) continue;
+			ordered &= (last <= ends[2*i]);
+			last = ends[2*i+1];
+		}
+		if(ordered)
+			SpParHelper::Print("FullyDistVec::sort working correctly\n");
+		else
+		{
+			SpParHelper::Print("ERROR in FullyDistVec::sort, go fix it!\n");
+			allpassed = false;
+		}
+	}
+	MPI_Finalize();
+	return allpassed ? 0 : 1;
+}
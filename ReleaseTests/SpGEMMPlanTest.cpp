@@ -0,0 +1,139 @@
+/****************************************************************/
+/* Parallel Combinatorial BLAS Library (for Graph Computations) */
+/* version 1.6 -------------------------------------------------*/
+/* date: 6/15/2017 ---------------------------------------------*/
+/* authors: Ariful Azad, Aydin Buluc  --------------------------*/
+/****************************************************************/
+/*
+ Copyright (c) 2010-2017, The Regents of the University of California
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+#include "CombBLAS/CombBLAS.h"
+#include <mpi.h>
+#include <iostream>
+#include <vector>
+#include <random>
+
+using namespace std;
+using namespace combblas;
+
+typedef PlusTimesSRing<double, double> PTDD;
+typedef SpDCCols<int64_t,double> DCCols;
+typedef SpParMat < int64_t, double, DCCols > PSpMat;
+
+bool Report(bool passed, const string & what)
+{
+	int ok = passed, allok;
+	MPI_Allreduce(&ok, &allok, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+	if(allok)
+		SpParHelper::Print(what + " working correctly\n");
+	else
+		SpParHelper::Print("ERROR in " + what + ", go fix it!\n");
+	return allok;
+}
+
+// small positive integers keep every sum exact
+PSpMat Random(shared_ptr<CommGrid> grid, int64_t n, int64_t nnz, uint64_t seed)
+{
+	mt19937_64 gen(seed + grid->GetRank());
+	vector<int64_t> rows, cols;
+	vector<double> vals;
+	for(int64_t k=0; k < nnz / grid->GetSize(); ++k)
+	{
+		rows.push_back(gen() % n);
+		cols.push_back(gen() % n);
+		vals.push_back((double) (gen() % 4) + 1.0);
+	}
+	FullyDistVec<int64_t,int64_t> ri(rows, grid), ci(cols, grid);
+	FullyDistVec<int64_t,double> vi(vals, grid);
+	return PSpMat(n, n, ri, ci, vi, true);
+}
+
+int64_t Reuses(const SpGEMMPlan<int64_t> & plan)
+{
+	int64_t mine = plan.Reuses(), all;
+	MPI_Allreduce(&mine, &all, 1, MPIType<int64_t>(), MPI_SUM, MPI_COMM_WORLD);
+	return all;
+}
+
+int main(int argc, char* argv[])
+{
+	int nprocs, myrank;
+	MPI_Init(&argc, &argv);
+	MPI_Comm_size(MPI_COMM_WORLD,&nprocs);
+	MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
+	if(argc < 2)
+	{
+		if(myrank == 0)
+		{
+			cout << "Usage: ./SpGEMMPlanTest <Scale>" << endl;
+			cout << "Example: mpirun -np 4 ./SpGEMMPlanTest 12" << endl;
+		}
+		MPI_Finalize();
+		return -1;
+	}
+	bool allpassed = true;
+	{
+		int64_t n = ((int64_t) 1) << atoi(argv[1]);
+		shared_ptr<CommGrid> fullWorld(new CommGrid(MPI_COMM_WORLD, 0, 0));
+		PSpMat A = Random(fullWorld, n, 8*n, 31);
+		PSpMat B = Random(fullWorld, n, 8*n, 37);
+		PSpMat Scaled(A);	// same pattern, new values
+		Scaled.Apply([](double x) { return 2.0*x + 1.0; });
+		PSpMat Other = Random(fullWorld, n, 8*n, 41);
+		bool square = (fullWorld->GetGridRows() == fullWorld->GetGridCols());
+
+		SpGEMMPlan<int64_t> plan;
+		PSpMat C = Mult_AnXBn_Synch<PTDD, double, DCCols>(A, B);
+		PSpMat Planned = Mult_AnXBn_Synch<PTDD, double, DCCols>(A, B, false, false, &plan);
+		bool same = (Planned == C) && Reuses(plan) == 0;
+		allpassed &= Report(same, "Mult_AnXBn_Synch building a plan");
+
+		C = Mult_AnXBn_Synch<PTDD, double, DCCols>(Scaled, B);
+		Planned = Mult_AnXBn_Synch<PTDD, double, DCCols>(Scaled, B, false, false, &plan);
+		int64_t reused = Reuses(plan);
+		same = (Planned == C) && (square ? reused > 0 : reused == 0);	// rectangular grids ignore the plan
+		allpassed &= Report(same, "Mult_AnXBn_Synch reusing a plan for new values");
+
+		C = Mult_AnXBn_Synch<PTDD, double, DCCols>(A, Other);
+		Planned = Mult_AnXBn_Synch<PTDD, double, DCCols>(A, Other, false, false, &plan);
+		same = (Planned == C) && Reuses(plan) == reused;
+		allpassed &= Report(same, "Mult_AnXBn_Synch rebuilding a plan for a new pattern");
+
+		if(square)
+		{
+			SpGEMMPlan<int64_t> memplan;
+			PSpMat M = MemEfficientSpGEMM<PTDD, double, DCCols>(A, B, 2, -1.0, (int64_t) n, (int64_t) 0, 0.0, 1, (int64_t) 0, &memplan);
+			same = (memplan.phases == 2) && Reuses(memplan) == 0;
+			M = MemEfficientSpGEMM<PTDD, double, DCCols>(Scaled, B, 2, -1.0, (int64_t) n, (int64_t) 0, 0.0, 1, (int64_t) 0, &memplan);
+			PSpMat Expected = MemEfficientSpGEMM<PTDD, double, DCCols>(Scaled, B, 2, -1.0, (int64_t) n, (int64_t) 0, 0.0, 1, (int64_t) 0);
+			same &= (M == Expected) && Reuses(memplan) > 0;
+			allpassed &= Report(same, "MemEfficientSpGEMM reusing a plan");
+		}
+		else
+		{
+			SpParHelper::Print("MemEfficientSpGEMM needs a square processor grid, skipping\n");
+		}
+	}
+	MPI_Finalize();
+	return allpassed ? 0 : 1;
+}
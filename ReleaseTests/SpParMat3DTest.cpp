@@ -0,0 +1,155 @@
+/****************************************************************/
+/* Parallel Combinatorial BLAS Library (for Graph Computations) */
+/* version 1.6 -------------------------------------------------*/
+/* date: 6/15/2017 ---------------------------------------------*/
+/* authors: Ariful Azad, Aydin Buluc  --------------------------*/
+/****************************************************************/
+/*
+ Copyright (c) 2010-2017, The Regents of the University of California
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+#include "CombBLAS/CombBLAS.h"
+#include <mpi.h>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <string>
+
+using namespace std;
+using namespace combblas;
+typedef SpParMat < int64_t, double, SpDCCols<int64_t,double> > PARDBMAT;
+typedef SpParMat3D < int64_t, double, SpDCCols<int64_t,double> > PARDBMAT3D;
+typedef PlusTimesSRing<double, double> PTDD;
+
+// Checks the native 3D operations against the same operations on the 2D matrix
+bool Check(PARDBMAT3D & B3D, PARDBMAT & B2D, const string & what)
+{
+	PARDBMAT C2D = B3D.Convert2D();
+	if(C2D == B2D)
+	{
+		SpParHelper::Print(what + " working correctly\n");
+		return true;
+	}
+	SpParHelper::Print("ERROR in " + what + ", go fix it!\n");
+	return false;
+}
+
+int main(int argc, char* argv[])
+{
+	int nprocs, myrank;
+	MPI_Init(&argc, &argv);
+	MPI_Comm_size(MPI_COMM_WORLD,&nprocs);
+	MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
+	if(argc < 3)
+	{
+		if(myrank == 0)
+		{
+			cout << "Usage: ./SpParMat3DTest <Scale> <Layers>" << endl;
+			cout << "Example: mpirun -np 4 ./SpParMat3DTest 12 4" << endl;
+		}
+		MPI_Finalize();
+		return -1;
+	}
+	bool allpassed = true;
+	{
+		unsigned scale = static_cast<unsigned>(atoi(argv[1]));
+		int nlayers = atoi(argv[2]);
+		double initiator[4] = {.57, .19, .19, .05};
+		DistEdgeList<int64_t> * DEL = new DistEdgeList<int64_t>();
+		DEL->GenGraph500Data(initiator, scale, 8, true, true);	// generate packed edges
+		PARDBMAT G(*DEL, false);
+		delete DEL;
+		// path counts give integral but varied values, so that reductions are exact in any order
+		PARDBMAT GT(G);
+		PARDBMAT A = Mult_AnXBn_Synch<PTDD, double, SpDCCols<int64_t,double> >(G, GT);
+		A.PrintInfo();
+
+		for(int split = 0; split < 2; ++split)
+		{
+			bool colsplit = (split == 1);
+			string layout = colsplit ? "[column split] " : "[row split] ";
+			PARDBMAT3D A3D(A, nlayers, colsplit, false);
+
+			for(int d = 0; d < 2; ++d)
+			{
+				Dim dim = (d == 0) ? Row : Column;
+				PARDBMAT3D B3D(A3D, colsplit);
+				FullyDistVec<int64_t, double> sums3d = B3D.Reduce(dim, plus<double>(), 0.0);
+				sums3d.Apply(safemultinv<double>());
+				B3D.DimApply(dim, sums3d, multiplies<double>());
+
+				PARDBMAT B2D(A);
+				FullyDistVec<int64_t, double> sums2d = B2D.Reduce(dim, plus<double>(), 0.0);
+				sums2d.Apply(safemultinv<double>());
+				B2D.DimApply(dim, sums2d, multiplies<double>());
+				allpassed &= Check(B3D, B2D, layout + ((dim == Row) ? "Reduce/DimApply(Row)" : "Reduce/DimApply(Column)"));
+			}
+
+			PARDBMAT3D P3D(A3D, colsplit);
+			P3D.Apply([](double val){ return val + 1.0; });
+			P3D.Prune([](double val){ return val < 4.0; });
+			PARDBMAT P2D(A);
+			P2D.Apply([](double val){ return val + 1.0; });
+			P2D.Prune([](double val){ return val < 4.0; });
+			allpassed &= Check(P3D, P2D, layout + "Apply/Prune");
+
+			if(colsplit)
+			{
+				PARDBMAT3D K3D(A3D, colsplit);
+				FullyDistVec<int64_t, double> kth3d(K3D.GetLayerMat()->getcommgrid());
+				K3D.Kselect(kth3d, 10, 1);
+				K3D.PruneColumn(kth3d, less<double>());
+				PARDBMAT K2D(A);
+				FullyDistVec<int64_t, double> kth2d(K2D.getcommgrid());
+				K2D.Kselect(kth2d, 10, 1);
+				K2D.PruneColumn(kth2d, less<double>());
+				allpassed &= Check(K3D, K2D, layout + "Kselect/PruneColumn");
+			}
+
+			string filename = "SpParMat3DTest.mtx";
+			A3D.ParallelWriteMM(filename, true);
+			PARDBMAT R2D(A.getcommgrid());
+			R2D.ParallelReadMM(filename, true, maximum<double>());
+			PARDBMAT3D R3D(A3D.getcommgrid3D(), colsplit);
+			R3D.ParallelReadMM(filename, true, maximum<double>());
+			if(R2D == A)
+				SpParHelper::Print(layout + "ParallelWriteMM working correctly\n");
+			else
+			{
+				SpParHelper::Print(layout + "ERROR in ParallelWriteMM, go fix it!\n");
+				allpassed = false;
+			}
+			allpassed &= Check(R3D, A, layout + "ParallelReadMM");
+		}
+
+		// the product exercises the sparse fiber reduction
+		PARDBMAT A2(A), B2(A);
+		PARDBMAT3D A3D(A2, nlayers, true, false);
+		PARDBMAT3D B3D(B2, nlayers, false, false);
+		PARDBMAT3D C3D = Mult_AnXBn_SUMMA3D<PTDD, double, SpDCCols<int64_t,double> >(A3D, B3D);
+		PARDBMAT AT(A);
+		PARDBMAT C2D = Mult_AnXBn_Synch<PTDD, double, SpDCCols<int64_t,double> >(A, AT);
+		allpassed &= Check(C3D, C2D, "Mult_AnXBn_SUMMA3D");
+	}
+	MPI_Finalize();
+	return allpassed ? 0 : 1;
+}
@@ -0,0 +1,175 @@
+/****************************************************************/
+/* Parallel Combinatorial BLAS Library (for Graph Computations) */
+/* version 1.6 -------------------------------------------------*/
+/* date: 6/15/2017 ---------------------------------------------*/
+/* authors: Ariful Azad, Aydin Buluc  --------------------------*/
+/****************************************************************/
+/*
+ Copyright (c) 2010-2017, The Regents of the University of California
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+
+#include "CombBLAS/CombBLAS.h"
+#include <mpi.h>
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <set>
+
+using namespace std;
+using namespace combblas;
+
+typedef SpParMat < int64_t, double, SpDCCols<int64_t,double> > PSpMat_Double;
+
+// some labels are longer than MAXVERTNAME
+string Label(int64_t i)
+{
+	string label = "vertex_" + to_string(i);
+	if(i % 5 == 0) label += string(MAXVERTNAME + i % 13, 'a' + i % 26);
+	return label;
+}
+
+bool Report(bool passed, const string & what)
+{
+	if(passed)
+		SpParHelper::Print(what + " working correctly\n");
+	else
+		SpParHelper::Print("ERROR in " + what + ", go fix it!\n");
+	return passed;
+}
+
+// true on all processes iff ids is a permutation of [begin,end) that is the same everywhere
+bool SameIds(const vector<int64_t> & ids, int64_t begin, int64_t end)
+{
+	vector<int64_t> sorted(ids);
+	sort(sorted.begin(), sorted.end());
+	int ok = (sorted.size() == (size_t) (end - begin));
+	for(size_t k=0; ok && k<sorted.size(); ++k)
+		ok &= (sorted[k] == begin + (int64_t) k);
+	vector<int64_t> root(ids);
+	MPI_Bcast(root.data(), (int) root.size(), MPIType<int64_t>(), 0, MPI_COMM_WORLD);
+	ok &= (root == ids);
+	int allok;
+	MPI_Allreduce(&ok, &allok, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+	return allok;
+}
+
+bool AllTrue(bool mine)
+{
+	int ok = mine, allok;
+	MPI_Allreduce(&ok, &allok, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+	return allok;
+}
+
+int main(int argc, char* argv[])
+{
+	int nprocs, myrank;
+	MPI_Init(&argc, &argv);
+	MPI_Comm_size(MPI_COMM_WORLD,&nprocs);
+	MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
+	if(argc < 2)
+	{
+		if(myrank == 0)
+		{
+			cout << "Usage: ./VertexDictionaryTest <Scale>" << endl;
+			cout << "Example: mpirun -np 4 ./VertexDictionaryTest 12" << endl;
+		}
+		MPI_Finalize();
+		return -1;
+	}
+	bool allpassed = true;
+	{
+		int64_t n = ((int64_t) 1) << atoi(argv[1]);
+		int64_t m = n / 4;
+		shared_ptr<CommGrid> fullWorld;
+		fullWorld.reset( new CommGrid(MPI_COMM_WORLD, 0, 0) );
+
+		vector<string> all(n), added(m);
+		for(int64_t i=0; i<n; ++i) all[i] = Label(i);
+		for(int64_t i=0; i<m; ++i) added[i] = Label(n+i);
+
+		// every process brings its share plus labels that others bring as well
+		VertexDictionary<int64_t> dict(fullWorld);
+		vector<string> mine;
+		for(int64_t i=myrank; i<n; i+=nprocs) mine.push_back(all[i]);
+		for(int64_t i=0; i<n; i+=7) mine.push_back(all[(i + myrank) % n]);
+		dict.Insert(mine);
+		vector<int64_t> ids = dict.Find(all);
+		allpassed &= Report(dict.getnvert() == n && SameIds(ids, 0, n), "VertexDictionary::Insert");
+
+		vector<string> labels = dict.Labels(ids);
+		vector<int64_t> unknown = dict.Find(vector<string>{"no such vertex", ""});
+		allpassed &= Report(AllTrue(labels == all && unknown[0] == -1 && unknown[1] == -1), "VertexDictionary::Labels");
+
+		// an incremental batch keeps the old ids and numbers only the new labels
+		vector<string> batch(added.begin() + (myrank * m) / nprocs, added.begin() + ((myrank + 1) * m) / nprocs);
+		batch.insert(batch.end(), all.begin(), all.begin() + n / 8);
+		dict.Insert(batch);
+		vector<int64_t> newids = dict.Find(added);
+		allpassed &= Report(dict.getnvert() == n + m && AllTrue(dict.Find(all) == ids) && SameIds(newids, n, n + m), "Incremental VertexDictionary::Insert");
+
+		dict.Save("vertexdict.bin");
+		VertexDictionary<int64_t> reloaded(fullWorld);
+		reloaded.Load("vertexdict.bin");
+		bool same = (reloaded.getnvert() == n + m) && (reloaded.Find(all) == ids) && (reloaded.Find(added) == newids);
+		same &= (reloaded.Labels(newids) == added);
+		allpassed &= Report(AllTrue(same), "VertexDictionary::Save and Load");
+
+		// the same edges as labeled tuples and as a matrix market file with the dictionary's ids
+		int64_t total = n + m;
+		vector<int64_t> everyid(ids);
+		everyid.insert(everyid.end(), newids.begin(), newids.end());
+		if(myrank == 0)
+		{
+			ofstream labeled("labeled_edges.txt"), numbered("numbered_edges.mtx");
+			numbered << "%%MatrixMarket matrix coordinate real general\n" << total << " " << total << " " << total << "\n";
+			for(int64_t i=0; i<total; ++i)
+			{
+				int64_t j = (3*i + 1) % total;
+				double v = 1 + i % 4;
+				labeled << Label(i) << ((i % 2) ? "\t" : "  ") << Label(j);
+				if(v != 1) labeled << " " << v;
+				labeled << "\n";
+				numbered << everyid[i] + 1 << " " << everyid[j] + 1 << " " << v << "\n";
+			}
+		}
+		MPI_Barrier(MPI_COMM_WORLD);
+		PSpMat_Double A(fullWorld), B(fullWorld), C(fullWorld);
+		A.ParallelReadMM("numbered_edges.mtx", true, maximum<double>());
+		B.ReadGeneralizedTuples("labeled_edges.txt", maximum<double>(), reloaded);
+		allpassed &= Report(reloaded.getnvert() == total && A == B, "ReadGeneralizedTuples with a VertexDictionary");
+
+		FullyDistVec<int64_t, array<char, MAXVERTNAME> > mapper = C.ReadGeneralizedTuples("labeled_edges.txt", maximum<double>());
+		bool legacy = (mapper.TotalLength() == total) && (C.getnrow() == total) && (C.getnnz() == total);
+		set<string> truncated;	// labels as the legacy mapper keeps them
+		for(int64_t i=0; i<total; ++i) truncated.insert(Label(i).substr(0, MAXVERTNAME));
+		for(int64_t k=0; k<total; k+=total/64)
+		{
+			array<char, MAXVERTNAME> entry = mapper[k];
+			legacy &= (truncated.count(string(entry.begin(), find(entry.begin(), entry.end(), '\0'))) == 1);
+		}
+		allpassed &= Report(AllTrue(legacy), "ReadGeneralizedTuples");
+	}
+	MPI_Finalize();
+	return allpassed ? 0 : 1;
+}
@@ -0,0 +1,194 @@
+/****************************************************************/
+/* Parallel Combinatorial BLAS Library (for Graph Computations) */
+/* version 1.6 -------------------------------------------------*/
+/* date: 6/15/2017 ---------------------------------------------*/
+/* authors: Ariful Azad, Aydin Buluc  --------------------------*/
+/****************************************************************/
+/*
+ Copyright (c) 2010-2017, The Regents of the University of California
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+
+#ifndef _ADAPTIVE_SP_PAR_MAT_H_
+#define _ADAPTIVE_SP_PAR_MAT_H_
+
+#include <limits>
+#include <memory>
+#include "CombBLAS.h"
+
+namespace combblas {
+
+/**
+ * True if the rows, columns and nonzeros of every local block of A can be counted by LIT (collective)
+ **/
+template <typename LIT, typename IT, typename NT, typename DER>
+bool LocalIndexFits(const SpParMat<IT,NT,DER> & A)
+{
+	int64_t mine = std::max( { static_cast<int64_t>(A.getlocalrows()), static_cast<int64_t>(A.getlocalcols()), static_cast<int64_t>(A.getlocalnnz()) } );
+	int64_t largest;
+	MPI_Allreduce(&mine, &largest, 1, MPIType<int64_t>(), MPI_MAX, A.getcommgrid()->GetWorld());
+	return largest <= static_cast<int64_t>(std::numeric_limits<LIT>::max());
+}
+
+/**
+ * Upper bound on the multiplications, hence on the unmerged output, of any process in a SUMMA product A*B:
+ * the densest column among the blocks of A in its processor row times the nonzeros of the blocks of B in its
+ * processor column. Holds on rectangular grids too and moves no matrix, only three reductions
+ **/
+template <typename IT, typename NU1, typename NU2, typename LIA, typename LIB>
+int64_t PerProcessFlopBound(SpParMat< IT,NU1,SpDCCols<LIA,NU1> > & A, SpParMat< IT,NU2,SpDCCols<LIB,NU2> > & B)
+{
+	int64_t densest = 0;
+	Dcsc<LIA,NU1> * Adcsc = A.seq().GetDCSC();
+	if(A.getlocalnnz() > 0 && Adcsc != NULL)
+	{
+		for(LIA i = 0; i < Adcsc->nzc; ++i)
+			densest = std::max(densest, static_cast<int64_t>(Adcsc->cp[i+1] - Adcsc->cp[i]));
+	}
+	MPI_Allreduce(MPI_IN_PLACE, &densest, 1, MPIType<int64_t>(), MPI_MAX, A.getcommgrid()->GetRowWorld());
+	int64_t bnnz = B.getlocalnnz();
+	MPI_Allreduce(MPI_IN_PLACE, &bnnz, 1, MPIType<int64_t>(), MPI_SUM, B.getcommgrid()->GetColWorld());
+
+	int64_t bound = (densest > 0 && bnnz > std::numeric_limits<int64_t>::max() / densest) ? std::numeric_limits<int64_t>::max() : densest * bnnz;
+	MPI_Allreduce(MPI_IN_PLACE, &bound, 1, MPIType<int64_t>(), MPI_MAX, A.getcommgrid()->GetWorld());
+	return bound;
+}
+
+/**
+ * A distributed sparse matrix whose local blocks use 32-bit indices whenever they fit and IT otherwise,
+ * decided at runtime, while the global API stays in IT. Narrow blocks take less memory and SUMMA moves less data.
+ * The matrix is reached through Visit, which calls a generic functor on the SpParMat that is held:
+ *	A.Visit([](auto & M) { M.Apply([](double x) { return 2*x; }); });
+ * Operations that grow the local blocks of a narrow matrix should go through Widen() and back
+ **/
+template <class IT, class NT>
+class AdaptiveSpParMat
+{
+public:
+	typedef SpParMat< IT, NT, SpDCCols<int32_t,NT> > NarrowMat;
+	typedef SpParMat< IT, NT, SpDCCols<IT,NT> > WideMat;
+
+	AdaptiveSpParMat(const NarrowMat & A): narrow(new NarrowMat(A)) {}
+
+	//! narrowIfFits = false keeps the IT indices regardless
+	AdaptiveSpParMat(const WideMat & A, bool narrowIfFits = true)
+	{
+		Adopt(A, narrowIfFits);
+	}
+
+	/**
+	 * From global triples, distributed like the matlab-style SpParMat constructor.
+	 * The local blocks are built narrow right away if their dimensions and the number of triples fit 32 bits,
+	 * otherwise they are built wide and narrowed if the summed blocks turn out to fit
+	 **/
+	AdaptiveSpParMat(IT total_m, IT total_n, const FullyDistVec<IT,IT> & rows, const FullyDistVec<IT,IT> & cols, const FullyDistVec<IT,NT> & vals, bool SumDuplicates = false)
+	{
+		std::shared_ptr<CommGrid> grid = rows.getcommgrid();
+		int64_t blockdim = std::max(total_m / grid->GetGridRows() + grid->GetGridRows(), total_n / grid->GetGridCols() + grid->GetGridCols());	// the last block takes the remainder
+		int64_t limit = static_cast<int64_t>(std::numeric_limits<int32_t>::max());
+		if(blockdim <= limit && static_cast<int64_t>(rows.TotalLength()) <= limit)
+		{
+			narrow.reset(new NarrowMat(total_m, total_n, rows, cols, vals, SumDuplicates));
+		}
+		else
+		{
+			WideMat A(total_m, total_n, rows, cols, vals, SumDuplicates);
+			Adopt(A, true);
+		}
+	}
+
+	AdaptiveSpParMat(const AdaptiveSpParMat<IT,NT> & rhs)
+	{
+		if(rhs.narrow)	narrow.reset(new NarrowMat(*(rhs.narrow)));
+		if(rhs.wide)	wide.reset(new WideMat(*(rhs.wide)));
+	}
+
+	AdaptiveSpParMat<IT,NT> & operator=(const AdaptiveSpParMat<IT,NT> & rhs)
+	{
+		if(this != &rhs)
+		{
+			narrow.reset(rhs.narrow ? new NarrowMat(*(rhs.narrow)) : NULL);
+			wide.reset(rhs.wide ? new WideMat(*(rhs.wide)) : NULL);
+		}
+		return *this;
+	}
+
+	bool isNarrow() const { return narrow != nullptr; }
+	NarrowMat & Narrow() { return *narrow; }	//!< only if isNarrow()
+	WideMat & Wide() { return *wide; }		//!< only if !isNarrow()
+
+	//! A copy with IT local indices
+	WideMat Widen() const
+	{
+		if(narrow)
+			return WideMat(new SpDCCols<IT,NT>(narrow->seq()), narrow->getcommgrid());
+		return *wide;
+	}
+
+	template <typename F>
+	auto Visit(F f) -> decltype(f(std::declval<WideMat &>()))
+	{
+		if(narrow)
+			return f(*narrow);
+		return f(*wide);
+	}
+
+	IT getnrow() const { return narrow ? narrow->getnrow() : wide->getnrow(); }
+	IT getncol() const { return narrow ? narrow->getncol() : wide->getncol(); }
+	IT getnnz() const { return narrow ? narrow->getnnz() : wide->getnnz(); }
+	std::shared_ptr<CommGrid> getcommgrid() const { return narrow ? narrow->getcommgrid() : wide->getcommgrid(); }
+
+private:
+	void Adopt(const WideMat & A, bool narrowIfFits)
+	{
+		if(narrowIfFits && LocalIndexFits<int32_t>(A))
+			narrow.reset(new NarrowMat(new SpDCCols<int32_t,NT>(const_cast<WideMat &>(A).seq()), A.getcommgrid()));
+		else
+			wide.reset(new WideMat(A));
+	}
+
+	std::unique_ptr<NarrowMat> narrow;
+	std::unique_ptr<WideMat> wide;
+};
+
+/**
+ * C = A*B with Mult_AnXBn_Synch on adaptive matrices. Two narrow operands are multiplied as they are if the
+ * flop bound of every process fits 32 bits, because the local kernel counts flops and unmerged nonzeros in the
+ * local index type; otherwise the narrow operands are widened for the product. The product is narrowed if it fits
+ **/
+template <typename SR, typename NUO, typename IT, typename NU1, typename NU2>
+AdaptiveSpParMat<IT,NUO> Mult_AnXBn_Adaptive(AdaptiveSpParMat<IT,NU1> & A, AdaptiveSpParMat<IT,NU2> & B)
+{
+	if(A.isNarrow() && B.isNarrow() && PerProcessFlopBound(A.Narrow(), B.Narrow()) <= static_cast<int64_t>(std::numeric_limits<int32_t>::max()))
+	{
+		return AdaptiveSpParMat<IT,NUO>(Mult_AnXBn_Synch<SR, NUO, SpDCCols<int32_t,NUO> >(A.Narrow(), B.Narrow()));
+	}
+	std::unique_ptr< typename AdaptiveSpParMat<IT,NU1>::WideMat > Awidened;
+	std::unique_ptr< typename AdaptiveSpParMat<IT,NU2>::WideMat > Bwidened;
+	if(A.isNarrow())	Awidened.reset(new typename AdaptiveSpParMat<IT,NU1>::WideMat(A.Widen()));
+	if(B.isNarrow())	Bwidened.reset(new typename AdaptiveSpParMat<IT,NU2>::WideMat(B.Widen()));
+	return AdaptiveSpParMat<IT,NUO>(Mult_AnXBn_Synch<SR, NUO, SpDCCols<IT,NUO> >(Awidened ? *Awidened : A.Wide(), Bwidened ? *Bwidened : B.Wide()));
+}
+
+}
+
+#endif
@@ -18,8 +18,6 @@
 #include <limits>
 
 
-using namespace std;
-
 namespace combblas {
 
 
@@ -788,6 +786,11 @@ std::vector<std::vector<std::tuple<IT,IT, IT, NT>>> Phase2_old(const AWPM_param<
     return tempTuples1;
 }
 
+/**
+ * Increases the weight of a perfect matching by repeatedly applying weight
+ * increasing 4-cycles (2/3-approximation of the maximum weight perfect matching).
+ * The input matching must be perfect; it is updated in place.
+ */
 template <class IT, class NT, class DER>
 void TwoThirdApprox(SpParMat < IT, NT, DER > & A, FullyDistVec<IT, IT>& mateRow2Col, FullyDistVec<IT, IT>& mateCol2Row)
 {
@@ -1140,8 +1143,21 @@ void TwoThirdApprox(SpParMat < IT, NT, DER > & A, FullyDistVec<IT, IT>& mateRow2
         
     }
     
+    /**
+     * Approximate weight perfect matching (AWPM) of a square matrix, used for static
+     * pivoting before a sparse factorization. A maximal matching is extended to a
+     * perfect one by maximumMatching and its weight is then improved by TwoThirdApprox.
+     * @param[in] optimizeProd maximize the product of the matched entries (otherwise the sum)
+     * @param[in] weightedCard prefer heavy edges in the cardinality matching phases
+     * @param[in] warmStart start from the matching passed in mateRow2Col/mateCol2Row
+     *            (e.g. the one of the previous factorization) instead of a greedy one.
+     *            Pairs that are not edges of A1 are dropped, and the cardinality phases
+     *            are skipped altogether if the remaining matching is still perfect.
+     * @param[in,out] ws maximumMatching scratch space kept across calls
+     */
     template <class IT, class NT>
-    void AWPM(SpParMat < IT, NT, SpDCCols<IT, NT> > & A1, FullyDistVec<IT, IT>& mateRow2Col, FullyDistVec<IT, IT>& mateCol2Row, bool optimizeProd=true, bool weightedCard=true)
+    void AWPM(SpParMat < IT, NT, SpDCCols<IT, NT> > & A1, FullyDistVec<IT, IT>& mateRow2Col, FullyDistVec<IT, IT>& mateCol2Row,
+              MaximumMatchingWorkspace<IT> & ws, bool optimizeProd=true, bool weightedCard=true, bool warmStart=false)
     {
         SpParMat < IT, NT, SpDCCols<IT, NT> > A(A1); // creating a copy because it is being transformed
         
@@ -1155,8 +1171,6 @@ void TwoThirdApprox(SpParMat < IT, NT, DER > & A, FullyDistVec<IT, IT>& mateRow2
         if(weightedCard)
             ABoolCSC = A;
         
-        FullyDistVec<IT, IT> degCol(A.getcommgrid());
-        Abool.Reduce(degCol, Column, plus<IT>(), static_cast<IT>(0));
         double ts;
         
         // Compute the initial trace
@@ -1164,16 +1178,33 @@ void TwoThirdApprox(SpParMat < IT, NT, DER > & A, FullyDistVec<IT, IT>& mateRow2
         double origWeight = Trace(A, diagnnz);
         bool isOriginalPerfect = diagnnz==A.getnrow();
         
-        //--------------------------------------------------------
-        // Compute the maximal cardinality matching
-        //--------------------------------------------------------
-        if(weightedCard)
-            WeightedGreedy(Acsc, mateRow2Col, mateCol2Row, degCol);
+        double mclWeight;
+        bool isPerfectMCL;
+        if(warmStart)
+        {
+            //--------------------------------------------------------
+            // Reuse the valid part of the given matching
+            //--------------------------------------------------------
+            RestrictMatching(A, mateRow2Col, mateCol2Row);
+            mclWeight = MatchingWeight( A, mateRow2Col, mateCol2Row);
+            isPerfectMCL = CheckMatching(mateRow2Col,mateCol2Row);
+        }
         else
-            WeightedGreedy(ABoolCSC, mateRow2Col, mateCol2Row, degCol);
-        
-        double mclWeight = MatchingWeight( A, mateRow2Col, mateCol2Row);
-        bool isPerfectMCL = CheckMatching(mateRow2Col,mateCol2Row);
+        {
+            FullyDistVec<IT, IT> degCol(A.getcommgrid());
+            Abool.Reduce(degCol, Column, std::plus<IT>(), static_cast<IT>(0));
+            
+            //--------------------------------------------------------
+            // Compute the maximal cardinality matching
+            //--------------------------------------------------------
+            if(weightedCard)
+                WeightedGreedy(Acsc, mateRow2Col, mateCol2Row, degCol);
+            else
+                WeightedGreedy(ABoolCSC, mateRow2Col, mateCol2Row, degCol);
+            
+            mclWeight = MatchingWeight( A, mateRow2Col, mateCol2Row);
+            isPerfectMCL = CheckMatching(mateRow2Col,mateCol2Row);
+        }
         
         // if the original matrix has a perfect matching and better weight
         if(isOriginalPerfect && mclWeight<=origWeight)
@@ -1199,9 +1230,9 @@ void TwoThirdApprox(SpParMat < IT, NT, DER > & A, FullyDistVec<IT, IT>& mateRow2
         {
             ts = MPI_Wtime();
             if(weightedCard)
-                maximumMatching(Acsc, mateRow2Col, mateCol2Row, true, false, true);
+                maximumMatching(Acsc, mateRow2Col, mateCol2Row, ws, true, false, true);
             else
-                maximumMatching(ABoolCSC, mateRow2Col, mateCol2Row, true, false, false);
+                maximumMatching(ABoolCSC, mateRow2Col, mateCol2Row, ws, true, false, false);
             
             
             tmcm = MPI_Wtime() - ts;
@@ -1236,6 +1267,14 @@ void TwoThirdApprox(SpParMat < IT, NT, DER > & A, FullyDistVec<IT, IT>& mateRow2
         }
     }
 
+    
+    template <class IT, class NT>
+    void AWPM(SpParMat < IT, NT, SpDCCols<IT, NT> > & A1, FullyDistVec<IT, IT>& mateRow2Col, FullyDistVec<IT, IT>& mateCol2Row, bool optimizeProd=true, bool weightedCard=true, bool warmStart=false)
+    {
+        MaximumMatchingWorkspace<IT> ws;
+        AWPM(A1, mateRow2Col, mateCol2Row, ws, optimizeProd, weightedCard, warmStart);
+    }
+
 }
 
 #endif /* ApproxWeightPerfectMatching_h */
@@ -14,10 +14,15 @@
 #define GREEDY 1
 #define KARP_SIPSER 2
 #define DMD 3
-MTRand GlobalMT(123); // for reproducible result
 
 namespace combblas {
 
+/**
+ * Maximal cardinality matching of the bipartite graph A (AT is its transpose).
+ * type selects the initialization heuristic: GREEDY, KARP_SIPSER or DMD (dynamic
+ * mindegree); rand breaks ties randomly. The matching is grown from the one given
+ * in mateRow2Col/mateCol2Row and degColRecv holds the column degrees of A.
+ */
 // This is not tested with CSC yet
 // TODO: test with CSC and Setting SPA (similar to Weighted Greedy)
 template <typename Par_DCSC_Bool, typename IT>
@@ -91,7 +96,7 @@ void MaximalMatching(Par_DCSC_Bool & A, Par_DCSC_Bool & AT, FullyDistVec<IT, IT>
         }
         else if(rand)
         {
-            unmatchedCol.Apply([](VertexType vtx){return VertexType(vtx.parent, static_cast<IT>((GlobalMT.rand() * 9999999)+1));});
+            unmatchedCol.Apply([](VertexType vtx){return VertexType(vtx.parent, static_cast<IT>((MatchingMT().rand() * 9999999)+1));});
         }
         
         // ======================== step1: One step of BFS =========================
@@ -10,6 +10,8 @@
 #include <vector>
 #include <string>
 #include <sstream>
+#include <memory>
+#include <numeric>
 #include "MatchingDefs.h"
 
 namespace combblas {
@@ -161,7 +163,8 @@ void AugmentLevel(FullyDistVec<IT, IT>& mateRow2Col, FullyDistVec<IT, IT>& mateC
 // An MPI processor is responsible for a complete path.
 // This approach is more effecient when we have few long augmenting paths
 // We used one-sided MPI. Any PGAS language should be fine as well.
-// This function is not thread safe, hence multithreading is not used here
+// The paths are vertex-disjoint, hence the local leaves are walked by
+// multiple threads when the MPI library provides MPI_THREAD_MULTIPLE
  ***************************************************************************/
 
 template <typename IT>
@@ -172,48 +175,45 @@ void AugmentPath(FullyDistVec<IT, IT>& mateRow2Col, FullyDistVec<IT, IT>& mateCo
     MPI_Win_create((IT*)mateCol2Row.GetLocArr(), mateCol2Row.LocArrSize() * sizeof(IT), sizeof(IT), MPI_INFO_NULL, mateCol2Row.commGrid->GetWorld(), &win_mateCol2Row);
     MPI_Win_create((IT*)parentsRow.GetLocArr(), parentsRow.LocArrSize() * sizeof(IT), sizeof(IT), MPI_INFO_NULL, parentsRow.commGrid->GetWorld(), &win_parentsRow);
     
+    // one passive epoch per window; individual accesses are completed with flushes
+    MPI_Win_lock_all(0, win_mateRow2Col);
+    MPI_Win_lock_all(0, win_mateCol2Row);
+    MPI_Win_lock_all(0, win_parentsRow);
     
-    IT* leaves_ptr = (IT*) leaves.GetLocArr();
-    //MPI_Win_fence(0, win_mateRow2Col);
-    //MPI_Win_fence(0, win_mateCol2Row);
-    //MPI_Win_fence(0, win_parentsRow);
+    const IT* leaves_ptr = leaves.GetLocArr();
+    IT nleaves = leaves.LocArrSize();
     
-    IT row, col=100, nextrow;
-    int owner_row, owner_col;
-    IT locind_row, locind_col;
-    int myrank;
+    int provided = MPI_THREAD_SINGLE;
+    MPI_Query_thread(&provided);
+    bool threadedRMA = (provided == MPI_THREAD_MULTIPLE);
     
-    MPI_Comm_rank(MPI_COMM_WORLD, &myrank);
-    
-    
-    for(IT i=0; i<leaves.LocArrSize(); i++)
+#ifdef THREADED
+#pragma omp parallel for schedule(dynamic, 16) if(threadedRMA)
+#endif
+    for(IT i=0; i<nleaves; i++)
     {
-        int depth=0;
-        row = *(leaves_ptr+i);
+        IT row = leaves_ptr[i];
+        IT col, nextrow;
+        IT locind_row, locind_col;
         while(row != - 1)
         {
-            
-            owner_row = mateRow2Col.Owner(row, locind_row);
-            MPI_Win_lock(MPI_LOCK_SHARED, owner_row, 0, win_parentsRow);
+            int owner_row = mateRow2Col.Owner(row, locind_row);
             MPI_Get(&col, 1, MPIType<IT>(), owner_row, locind_row, 1, MPIType<IT>(), win_parentsRow);
-            MPI_Win_unlock(owner_row, win_parentsRow);
+            MPI_Win_flush(owner_row, win_parentsRow);
             
-            owner_col = mateCol2Row.Owner(col, locind_col);
-            MPI_Win_lock(MPI_LOCK_SHARED, owner_col, 0, win_mateCol2Row);
+            int owner_col = mateCol2Row.Owner(col, locind_col);
             MPI_Fetch_and_op(&row, &nextrow, MPIType<IT>(), owner_col, locind_col, MPI_REPLACE, win_mateCol2Row);
-            MPI_Win_unlock(owner_col, win_mateCol2Row);
+            MPI_Win_flush(owner_col, win_mateCol2Row);
             
-            MPI_Win_lock(MPI_LOCK_SHARED, owner_row, 0, win_mateRow2Col);
             MPI_Put(&col, 1, MPIType<IT>(), owner_row, locind_row, 1, MPIType<IT>(), win_mateRow2Col);
-            MPI_Win_unlock(owner_row, win_mateRow2Col); // we need this otherwise col might get overwritten before communication!
+            MPI_Win_flush(owner_row, win_mateRow2Col); // we need this otherwise col might get overwritten before communication!
             row = nextrow;
-            
         }
     }
     
-    //MPI_Win_fence(0, win_mateRow2Col);
-    //MPI_Win_fence(0, win_mateCol2Row);
-    //MPI_Win_fence(0, win_parentsRow);
+    MPI_Win_unlock_all(win_mateRow2Col);
+    MPI_Win_unlock_all(win_mateCol2Row);
+    MPI_Win_unlock_all(win_parentsRow);
     
     MPI_Win_free(&win_mateRow2Col);
     MPI_Win_free(&win_mateCol2Row);
@@ -222,25 +222,167 @@ void AugmentPath(FullyDistVec<IT, IT>& mateRow2Col, FullyDistVec<IT, IT>& mateCo
 
 
 
+/**
+ * Scratch space of maximumMatching that can be kept alive across calls, e.g. when
+ * the matching of a fixed sparsity pattern is recomputed for every factorization.
+ * It holds the SpMV accumulator and the distributed leaf and parent vectors.
+ * Prepare() rebuilds it only when the dimensions or the local nonzero count of the
+ * matrix change; call Clear() if the pattern changes while those stay the same.
+ */
+template <typename IT>
+class MaximumMatchingWorkspace
+{
+public:
+    MaximumMatchingWorkspace(): nrow(-1), ncol(-1), localnnz(-1) {};
+    
+    template <typename NT, typename DER>
+    MaximumMatchingWorkspace(SpParMat < IT, NT, DER > & A): nrow(-1), ncol(-1), localnnz(-1)
+    {
+        Prepare(A);
+    }
+    
+    template <typename NT, typename DER>
+    void Prepare(SpParMat < IT, NT, DER > & A)
+    {
+        IT lnnz = A.seq().getnnz();
+        if(SPA && commGrid == A.getcommgrid() && nrow == A.getnrow() && ncol == A.getncol() && localnnz == lnnz)
+            return;
+        
+        int nthreads=1;
+#ifdef THREADED
+#pragma omp parallel
+        {
+            nthreads = omp_get_num_threads();
+        }
+#endif
+        SPA.reset(new PreAllocatedSPA< VertexTypeMM<IT> >(A.seq(), nthreads*4));
+        leaves.reset(new FullyDistVec<IT, IT>(A.getcommgrid(), A.getncol(), (IT) -1));
+        parentsRow.reset(new FullyDistVec<IT, IT>(A.getcommgrid(), A.getnrow(), (IT) -1));
+        commGrid = A.getcommgrid();
+        nrow = A.getnrow();
+        ncol = A.getncol();
+        localnnz = lnnz;
+    }
+    
+    void Clear()
+    {
+        SPA.reset();
+        leaves.reset();
+        parentsRow.reset();
+        commGrid.reset();
+    }
+    
+    std::unique_ptr< PreAllocatedSPA< VertexTypeMM<IT> > > SPA;
+    std::unique_ptr< FullyDistVec<IT, IT> > leaves;
+    std::unique_ptr< FullyDistVec<IT, IT> > parentsRow;
+    
+private:
+    std::shared_ptr<CommGrid> commGrid;
+    IT nrow;
+    IT ncol;
+    IT localnnz;
+};
+
+
+
+/**
+ * Drops the pairs of an existing matching that are no longer edges of A, so that the
+ * matching of a previous factorization can be used to warm start the next one.
+ * Both mate vectors are updated in place and the surviving cardinality is returned.
+ * Same communication pattern as MatchingWeight: mateCol2Row is replicated along
+ * processor columns and each process checks the mate pairs of its local submatrix.
+ */
+template <typename IT, typename NT, typename DER>
+IT RestrictMatching(SpParMat < IT, NT, DER > & A, FullyDistVec<IT, IT>& mateRow2Col, FullyDistVec<IT, IT>& mateCol2Row)
+{
+    auto commGrid = A.getcommgrid();
+    MPI_Comm World = commGrid->GetWorld();
+    MPI_Comm ColWorld = commGrid->GetColWorld();
+    int pr = commGrid->GetGridRows();
+    int colrank = commGrid->GetRankInProcCol();
+    int diagneigh = commGrid->GetComplementRank();
+    
+    DER* spSeq = A.seqptr();
+    IT lnrow = spSeq->getnrow();
+    IT localRowStart = colrank * (A.getnrow() / pr);
+    
+    // replicate mateCol2Row along the processor column
+    int xsize = (int) mateCol2Row.LocArrSize();
+    int trxsize = 0;
+    MPI_Status status;
+    MPI_Sendrecv(&xsize, 1, MPI_INT, diagneigh, TRX, &trxsize, 1, MPI_INT, diagneigh, TRX, World, &status);
+    std::vector<IT> trxnums(trxsize);
+    MPI_Sendrecv(mateCol2Row.GetLocArr(), xsize, MPIType<IT>(), diagneigh, TRX, trxnums.data(), trxsize, MPIType<IT>(), diagneigh, TRX, World, &status);
+    
+    std::vector<int> colsize(pr);
+    colsize[colrank] = trxsize;
+    MPI_Allgather(MPI_IN_PLACE, 1, MPI_INT, colsize.data(), 1, MPI_INT, ColWorld);
+    std::vector<int> dpls(pr,0);
+    std::partial_sum(colsize.data(), colsize.data()+pr-1, dpls.data()+1);
+    int accsize = std::accumulate(colsize.data(), colsize.data()+pr, 0);
+    std::vector<IT> RepMateC2R(accsize);
+    MPI_Allgatherv(trxnums.data(), trxsize, MPIType<IT>(), RepMateC2R.data(), colsize.data(), dpls.data(), MPIType<IT>(), ColWorld);
+    
+    // exactly one process of the processor column stores the mate row of a column
+    std::vector<int> keep(accsize, 0);
+    for(auto colit = spSeq->begcol(); colit != spSeq->endcol(); ++colit)
+    {
+        IT lj = colit.colid();
+        IT mj = RepMateC2R[lj];
+        if(mj >= localRowStart && mj < (localRowStart+lnrow))
+        {
+            for(auto nzit = spSeq->begnz(colit); nzit < spSeq->endnz(colit); ++nzit)
+            {
+                if(nzit.rowid() + localRowStart == mj)
+                {
+                    keep[lj] = 1;
+                    break;
+                }
+            }
+        }
+    }
+    MPI_Allreduce(MPI_IN_PLACE, keep.data(), accsize, MPI_INT, MPI_MAX, ColWorld);
+    
+    // send the verdict on the diagonal neighbor's piece back to it
+    std::vector<int> mykeep(xsize);
+    MPI_Sendrecv(keep.data()+dpls[colrank], trxsize, MPI_INT, diagneigh, TRX, mykeep.data(), xsize, MPI_INT, diagneigh, TRX, World, &status);
+    
+    IT* localC2R = (IT*) mateCol2Row.GetLocArr();
+    for(int i=0; i<xsize; ++i)
+    {
+        if(!mykeep[i]) localC2R[i] = -1;
+    }
+    
+    FullyDistSpVec<IT, IT> matchedCol(mateCol2Row, [](IT mate){return mate!=-1;});
+    FullyDistSpVec<IT, IT> matchedRow = matchedCol.Invert(A.getnrow());
+    mateRow2Col.Apply([](IT val){return (IT) -1;});
+    mateRow2Col.Set(matchedRow);
+    return matchedCol.getnnz();
+}
+
+
 
 
-// Maximum cardinality matching
-// Output: mateRow2Col and mateRow2Col
+/**
+ * Maximum cardinality matching of the bipartite graph A, augmenting the matching
+ * given in mateRow2Col/mateCol2Row (-1 marks an unmatched vertex). Starting from an
+ * existing matching (e.g. a maximal matching, or the result of RestrictMatching on a
+ * previous matching) only the missing augmentations are searched.
+ * @param[in,out] ws scratch space reused across calls, see MaximumMatchingWorkspace
+ * @param[in] prune drop the search trees that already reached an unmatched row
+ * @param[in] randMM visit the unmatched columns in random order
+ * @param[in] maximizeWeight prefer heavier edges when growing the search trees
+ */
 template <typename IT, typename NT,typename DER>
 void maximumMatching(SpParMat < IT, NT, DER > & A, FullyDistVec<IT, IT>& mateRow2Col,
-                     FullyDistVec<IT, IT>& mateCol2Row, bool prune=true, bool randMM = false, bool maximizeWeight = false)
+                     FullyDistVec<IT, IT>& mateCol2Row, MaximumMatchingWorkspace<IT> & ws,
+                     bool prune=true, bool randMM = false, bool maximizeWeight = false)
 {
 	
 	typedef VertexTypeMM <IT> VertexType;
 	
-    int nthreads=1;
-#ifdef THREADED
-#pragma omp parallel
-    {
-        nthreads = omp_get_num_threads();
-    }
-#endif
-    PreAllocatedSPA<VertexType> SPA(A.seq(), nthreads*4);
+    ws.Prepare(A);
+    PreAllocatedSPA<VertexType> & SPA = *ws.SPA;
     
     double tstart = MPI_Wtime();
     int nprocs, myrank;
@@ -252,7 +394,8 @@ void maximumMatching(SpParMat < IT, NT, DER > & A, FullyDistVec<IT, IT>& mateRow
     
     FullyDistSpVec<IT, VertexType> fringeRow(A.getcommgrid(), nrow);
     FullyDistSpVec<IT, IT> umFringeRow(A.getcommgrid(), nrow);
-    FullyDistVec<IT, IT> leaves ( A.getcommgrid(), ncol, (IT) -1);
+    FullyDistVec<IT, IT> & leaves = *ws.leaves;
+    FullyDistVec<IT, IT> & parentsRow = *ws.parentsRow;
     
     std::vector<std::vector<double> > timing;
     std::vector<int> layers;
@@ -265,17 +408,13 @@ void maximumMatching(SpParMat < IT, NT, DER > & A, FullyDistVec<IT, IT>& mateRow
     IT numUnmatchedCol;
     
     
-    MPI_Win winLeaves;
-    MPI_Win_create((IT*)leaves.GetLocArr(), leaves.LocArrSize() * sizeof(IT), sizeof(IT), MPI_INFO_NULL, A.getcommgrid()->GetWorld(), &winLeaves);
-    
-    
     while(matched)
     {
         time_phase = MPI_Wtime();
   
         std::vector<double> phase_timing(8,0);
         leaves.Apply ( [](IT val){return (IT) -1;});
-        FullyDistVec<IT, IT> parentsRow ( A.getcommgrid(), nrow, (IT) -1);
+        parentsRow.Apply ( [](IT val){return (IT) -1;});
         FullyDistSpVec<IT, VertexType> fringeCol(A.getcommgrid(), ncol);
         fringeCol  = EWiseApply<VertexType>(fringeCol, mateCol2Row,
                                             [](VertexType vtx, IT mate){return vtx;},
@@ -285,7 +424,7 @@ void maximumMatching(SpParMat < IT, NT, DER > & A, FullyDistVec<IT, IT>& mateRow
         
         if(randMM) //select rand
         {
-            fringeCol.ApplyInd([](VertexType vtx, IT idx){return VertexType(idx,idx,GlobalMT.rand());});
+            fringeCol.ApplyInd([](VertexType vtx, IT idx){return VertexType(idx,idx,MatchingMT().rand());});
         }
         else
         {
@@ -417,7 +556,6 @@ void maximumMatching(SpParMat < IT, NT, DER > & A, FullyDistVec<IT, IT>& mateRow
     }
     
     
-    MPI_Win_free(&winLeaves);
     //isMaximalmatching(A, mateRow2Col, mateCol2Row, unmatchedRow, unmatchedCol);
     //isMatching(mateCol2Row, mateRow2Col); //todo there is a better way to check this
     
@@ -480,6 +618,16 @@ void maximumMatching(SpParMat < IT, NT, DER > & A, FullyDistVec<IT, IT>& mateRow
     
 }
 
+
+// Maximum cardinality matching with a workspace that lives for this call only
+template <typename IT, typename NT,typename DER>
+void maximumMatching(SpParMat < IT, NT, DER > & A, FullyDistVec<IT, IT>& mateRow2Col,
+                     FullyDistVec<IT, IT>& mateCol2Row, bool prune=true, bool randMM = false, bool maximizeWeight = false)
+{
+    MaximumMatchingWorkspace<IT> ws(A);
+    maximumMatching(A, mateRow2Col, mateCol2Row, ws, prune, randMM, maximizeWeight);
+}
+
 }
 
 #endif
@@ -14,6 +14,14 @@
 
 namespace combblas {
 
+// Random stream shared by the randomized matching heuristics.
+// It is seeded once per process so that repeated runs give reproducible matchings.
+inline MTRand & MatchingMT()
+{
+	static MTRand mt(123);
+	return mt;
+}
+
 // Vertex data structure for maximal cardinality matching
 template <typename T1, typename T2>
 struct VertexTypeML
@@ -121,14 +121,17 @@ class EWiseExtToPlainAdapter
 #include "SpTuples.h"
 #include "SpDCCols.h"
 #include "SpCCols.h"
+#include "SpCSB.h"
 #include "SpParMat.h"
 #include "SpParMat3D.h"
 #include "FullyDistVec.h"
 #include "FullyDistSpVec.h"
+#include "DenseMultiVec.h"
 #include "VecIterator.h"
 #include "PreAllocatedSPA.h"
 #include "ParFriends.h"
 #include "BlockSpGEMM.h"
+#include "AdaptiveSpParMat.h"
 #include "BFSFriends.h"
 #include "DistEdgeList.h"
 #include "Semirings.h"
@@ -37,6 +37,7 @@
 #include <string>
 #include <fstream>
 #include <stdint.h>
+#include <memory>
 #include "MPIType.h"
 
 namespace combblas {
@@ -119,10 +120,7 @@ public:
 	int GetDiagOfProcRow();
 	int GetDiagOfProcCol();
 
-	int GetComplementRank()	// For P(i,j), get rank of P(j,i)
-	{
-		return ((grcols * myproccol) + myprocrow);
-	}
+	int GetComplementRank();	// For P(i,j), get rank of P(j,i), square grids only
 	
 	MPI_Comm & GetWorld() { return commWorld; }
 	MPI_Comm & GetRowWorld() { return rowWorld; }
@@ -163,6 +161,14 @@ private:
 	friend class FullyDistSpVec;
 };
 
+/**
+ * A grid whose processor rows lie within shared-memory nodes where possible, so that the row-wise communication 
+ * (the broadcast of A in SUMMA, the fold of SpMV) stays on node. Ranks of world are renumbered node by node. 
+ * With nrowproc = ncolproc = 0, the number of processor columns is the divisor of the node size that gives 
+ * the most square grid; if nodes differ in size, or no such divisor exists, it is the default most square grid
+ **/
+std::shared_ptr<CommGrid> NodeAwareGrid(MPI_Comm world, int nrowproc = 0, int ncolproc = 0);
+
 }
 
 #endif
@@ -0,0 +1,101 @@
+/****************************************************************/
+/* Parallel Combinatorial BLAS Library (for Graph Computations) */
+/* version 1.6 -------------------------------------------------*/
+/* date: 6/15/2017 ---------------------------------------------*/
+/* authors: Ariful Azad, Aydin Buluc  --------------------------*/
+/****************************************************************/
+/*
+ Copyright (c) 2010-2017, The Regents of the University of California
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+
+#ifndef _DENSE_MULTI_VEC_H_
+#define _DENSE_MULTI_VEC_H_
+
+#include <vector>
+#include <algorithm>
+#include "CombBLAS.h"
+#include "FullyDistVec.h"
+
+namespace combblas {
+
+/**
+ * A block of k dense vectors of the same length (a tall-skinny dense matrix), distributed like a FullyDistVec
+ * Each process stores the rows it owns as one row-major array, so that the k entries of a row are consecutive
+ * and the whole block moves with the message counts of a single vector (see SpMM)
+ **/
+template <class IT, class NT>
+class DenseMultiVec: public FullyDist<IT,NT, typename combblas::disable_if< combblas::is_boolean<NT>::value, NT >::type >
+{
+public:
+	DenseMultiVec ( std::shared_ptr<CommGrid> grid, IT globallen, int nvecs, NT initval)
+	: FullyDist<IT,NT,typename combblas::disable_if< combblas::is_boolean<NT>::value, NT >::type>(grid, globallen), k(nvecs)
+	{
+		arr.resize(this->MyLocLength() * k, initval);
+	}
+
+	//! stacks the vectors side by side, they all need the same grid and length
+	DenseMultiVec ( const std::vector< FullyDistVec<IT,NT> > & columns)
+	: FullyDist<IT,NT,typename combblas::disable_if< combblas::is_boolean<NT>::value, NT >::type>(columns[0].getcommgrid(), columns[0].TotalLength()), k((int) columns.size())
+	{
+		IT locrows = this->MyLocLength();
+		arr.resize(locrows * k);
+		for(int t=0; t< k; ++t)
+		{
+			const NT * col = columns[t].GetLocArr();
+			for(IT i=0; i< locrows; ++i)
+				arr[i*k+t] = col[i];
+		}
+	}
+
+	//! the t-th vector of the block
+	FullyDistVec<IT,NT> Column(int t) const
+	{
+		FullyDistVec<IT,NT> col(this->commGrid, this->glen, NT());
+		IT locrows = this->MyLocLength();
+		for(IT i=0; i< locrows; ++i)
+			col.SetLocalElement(i, arr[i*k+t]);
+		return col;
+	}
+
+	bool operator== (const DenseMultiVec<IT,NT> & rhs) const
+	{
+		int local = (k == rhs.k && this->glen == rhs.glen && arr == rhs.arr);
+		int whole;
+		MPI_Allreduce(&local, &whole, 1, MPI_INT, MPI_LAND, this->commGrid->GetWorld());
+		return whole;
+	}
+
+	int getnvec() const { return k; }
+	std::shared_ptr<CommGrid> getcommgrid() const { return this->commGrid; }
+	IT LocArrSize() const { return arr.size() / std::max(k, 1); }	// local rows
+	NT * GetLocArr() { return arr.data(); }	// LocArrSize() rows of getnvec() entries each
+	const NT * GetLocArr() const { return arr.data(); }
+
+private:
+	int k;		// number of vectors
+	std::vector<NT> arr;
+};
+
+}
+
+#endif
@@ -39,26 +39,34 @@
 #include "graph500/generator/graph_generator.h"
 #include "graph500/generator/utils.h"
 #include "RefGen21.h"
+#include "RandPermutation.h"
 
 #include <fstream>
 #include <algorithm>
+#include <numeric>
+#include <random>
 
 namespace combblas {
 
+static inline double RMatUniform(uint64_t key, uint64_t counter)
+{
+	return (SplitMix64(key + counter * 0x9E3779B97F4A7C15ULL) >> 11) * (1.0 / 9007199254740992.0);	// 53 random bits in [0,1)
+}
+
 template <typename IT>
-DistEdgeList<IT>::DistEdgeList(): edges(NULL), pedges(NULL), nedges(0), globalV(0)
+DistEdgeList<IT>::DistEdgeList(): edges(NULL), pedges(NULL), nedges(0), globalV(0), ownerlocal(false)
 {
 	commGrid.reset(new CommGrid(MPI_COMM_WORLD, 0, 0));
 }
 
 template <typename IT>
-DistEdgeList<IT>::DistEdgeList(MPI_Comm & myWorld): edges(NULL), pedges(NULL), nedges(0), globalV(0)
+DistEdgeList<IT>::DistEdgeList(MPI_Comm & myWorld): edges(NULL), pedges(NULL), nedges(0), globalV(0), ownerlocal(false)
 {
     commGrid.reset(new CommGrid(myWorld, 0, 0));
 }
 
 template <typename IT>
-DistEdgeList<IT>::DistEdgeList(const char * filename, IT globaln, IT globalm): edges(NULL), pedges(NULL), globalV(globaln)
+DistEdgeList<IT>::DistEdgeList(const char * filename, IT globaln, IT globalm): edges(NULL), pedges(NULL), globalV(globaln), ownerlocal(false)
 {
 	commGrid.reset(new CommGrid(MPI_COMM_WORLD, 0, 0));
 
@@ -222,6 +230,7 @@ void DistEdgeList<IT>::CleanupEmpties()
 template <typename IT>
 void DistEdgeList<IT>::GenGraph500Data(double initiator[4], int log_numverts, int edgefactor, bool scramble, bool packed)
 {
+	ownerlocal = false;
 	if(packed && (!scramble))
 	{
 		SpParHelper::Print("WARNING: Packed version does always generate scrambled vertex identifiers\n");
@@ -280,6 +289,119 @@ void DistEdgeList<IT>::GenGraph500Data(double initiator[4], int log_numverts, in
 }
 
 
+/**
+ * Generates the R-MAT matrix of GenGraph500Data, but every rank only generates the edges that fall into
+ * its own block of the 2D processor grid, so that SpParMat(const DistEdgeList&) needs no redistribution.
+ * The top log2(gridrows) levels of the recursion select the block: all ranks draw the same multinomial
+ * split of the edges among blocks from a shared seed, and each rank recurses only inside its own block.
+ * Edges come from a counter-based generator indexed by (seed, block, edge, level) and are divided among
+ * threads, so the graph does not depend on the number of threads.
+ * With scramble, vertices are relabeled by a random permutation of the block ids followed by a common
+ * random permutation of the offsets within a block. Unlike the Graph500 scramble this maps blocks to
+ * blocks; rank (I,J) generates the R-MAT block that the relabeling sends to (I,J).
+ * \pre {the grid is square with a power-of-two side; otherwise this falls back to the unpacked GenGraph500Data}
+ */
+template <typename IT>
+void DistEdgeList<IT>::GenGraph500DataByOwner(double initiator[4], int log_numverts, int edgefactor, bool scramble)
+{
+	int gridrows = commGrid->GetGridRows();
+	int gridcols = commGrid->GetGridCols();
+	int levels = 0;		// log2(gridrows)
+	while((1 << levels) < gridrows)	++levels;
+	if(gridrows != gridcols || (1 << levels) != gridrows || levels > log_numverts)
+	{
+		SpParHelper::Print("WARNING: GenGraph500DataByOwner needs a square grid with a power-of-two side, calling GenGraph500Data\n");
+		GenGraph500Data(initiator, log_numverts, edgefactor, scramble, false);
+		return;
+	}
+
+	globalV = ((int64_t)1)<< log_numverts;
+	int64_t globaledges = globalV * static_cast<int64_t>(edgefactor);
+#ifdef DETERMINISTIC
+	uint64_t seed = 2;
+#else
+	uint64_t seed = time(NULL);
+	MPI_Bcast(&seed, 1, MPIType<uint64_t>(), 0, commGrid->GetWorld());
+#endif
+
+	// everything drawn from gen and permgen is identical on all ranks
+	std::mt19937_64 gen(seed);
+	std::mt19937_64 permgen(SplitMix64(seed));		// separate stream, so that scrambling only relabels the same graph
+	std::vector<int> blockperm(gridrows);	// block i is relabeled as block blockperm[i]
+	std::iota(blockperm.begin(), blockperm.end(), 0);
+	if(scramble)
+		std::shuffle(blockperm.begin(), blockperm.end(), permgen);
+	std::vector<int> invperm(gridrows);
+	for(int i=0; i< gridrows; ++i)
+		invperm[blockperm[i]] = i;
+	int myrow = commGrid->GetRankInProcCol();
+	int mycol = commGrid->GetRankInProcRow();
+	int64_t myblock = static_cast<int64_t>(invperm[myrow]) * gridcols + invperm[mycol];
+
+	double total = initiator[0] + initiator[1] + initiator[2] + initiator[3];
+	double prob[4];
+	for(int q=0; q< 4; ++q)
+		prob[q] = initiator[q] / total;
+
+	// multinomial split of the edges among blocks, as a chain of conditional binomials
+	int64_t remaining = globaledges;
+	double mass = 1.0;
+	IT mycount = 0;
+	for(int64_t b = 0; b < static_cast<int64_t>(gridrows) * gridcols; ++b)
+	{
+		int bi = static_cast<int>(b / gridcols);
+		int bj = static_cast<int>(b % gridcols);
+		double p = 1.0;
+		for(int l = levels-1; l >= 0; --l)
+			p *= prob[2*((bi >> l) & 1) + ((bj >> l) & 1)];
+
+		int64_t count = remaining;
+		if(b != static_cast<int64_t>(gridrows) * gridcols - 1 && remaining > 0)
+		{
+			std::binomial_distribution<int64_t> binom(remaining, std::min(1.0, std::max(0.0, p / mass)));
+			count = binom(gen);
+		}
+		if(b == myblock)
+			mycount = static_cast<IT>(count);
+		remaining -= count;
+		mass -= p;
+	}
+
+	int sublevels = log_numverts - levels;
+	int64_t blocksize = globalV >> levels;
+	FeistelPermutation<int64_t> offperm(blocksize, SplitMix64(seed + 1));
+	int64_t rowbase = static_cast<int64_t>(myrow) * blocksize;
+	int64_t colbase = static_cast<int64_t>(mycol) * blocksize;
+	uint64_t key = SplitMix64(seed ^ SplitMix64(static_cast<uint64_t>(myblock) + 1));
+	double cum[3] = {prob[0], prob[0] + prob[1], prob[0] + prob[1] + prob[2]};
+
+	nedges = mycount;
+	SetMemSize(nedges);
+#ifdef THREADED
+#pragma omp parallel for
+#endif
+	for(IT i = 0; i < nedges; ++i)
+	{
+		int64_t r = 0, c = 0;
+		for(int l = 0; l < sublevels; ++l)
+		{
+			double u = RMatUniform(key, static_cast<uint64_t>(i) * sublevels + l);
+			int q = (u < cum[0]) ? 0 : ((u < cum[1]) ? 1 : ((u < cum[2]) ? 2 : 3));
+			r = (r << 1) | (q >> 1);
+			c = (c << 1) | (q & 1);
+		}
+		if(scramble)
+		{
+			r = offperm(r);
+			c = offperm(c);
+		}
+		edges[2*i+0] = static_cast<IT>(rowbase + r);
+		edges[2*i+1] = static_cast<IT>(colbase + c);
+	}
+	ownerlocal = true;
+}
+
+
 /**
  * Randomly permutes the distributed edge list.
  * Once we call Viral's psort on this vector, everything will go to the right place [tuples are
@@ -294,6 +416,7 @@ template <typename IT>
 void PermEdges(DistEdgeList<IT> & DEL)
 {
 	IT maxedges = DEL.memedges;	// this can be optimized by calling the clean-up first
+	DEL.ownerlocal = false;
 	
 	// to lower memory consumption, rename in stages
 	// this is not "identical" to a full randomization; 
@@ -366,6 +489,7 @@ void RenameVertices(DistEdgeList<IU> & DEL)
 	int nprocs = DEL.commGrid->GetSize();
 	int rank = DEL.commGrid->GetRank();
 	MPI_Comm World = DEL.commGrid->GetWorld(); 
+	DEL.ownerlocal = false;
 
 	// create permutation
 	FullyDistVec<IU, IU> globalPerm(DEL.commGrid);
@@ -90,12 +90,14 @@ public:
 	void Dump64bit(std::string filename);
 	void Dump32bit(std::string filename);
 	void GenGraph500Data(double initiator[4], int log_numverts, int edgefactor, bool scramble =false, bool packed=false);
+	void GenGraph500DataByOwner(double initiator[4], int log_numverts, int edgefactor, bool scramble =false);
 	void CleanupEmpties();
 	
 	int64_t getGlobalV() const { return globalV; }
 	IT getNumLocalEdges() const { return nedges; }
     IT* getEdges() const {return edges;}
     packed_edge * getPackedEdges() const { return pedges; }
+	bool isOwnerLocal() const { return ownerlocal; }	// every local edge belongs to this rank's block of the 2D grid
     std::shared_ptr<CommGrid> commGrid;
 	
 private:
@@ -107,6 +109,7 @@ private:
 	IT nedges; 	// number of local edges
 	IT memedges; 	// number of edges for which there is space. nedges <= memedges
 	int64_t globalV;
+	bool ownerlocal;
 	
 	void SetMemSize(IT ne);
 	
@@ -0,0 +1,137 @@
+/****************************************************************/
+/* Parallel Combinatorial BLAS Library (for Graph Computations) */
+/* version 1.6 -------------------------------------------------*/
+/* date: 6/15/2017 ---------------------------------------------*/
+/* authors: Ariful Azad, Aydin Buluc  --------------------------*/
+/****************************************************************/
+/*
+ Copyright (c) 2010-2017, The Regents of the University of California
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+
+#ifndef _DYNAMIC_SP_PAR_MAT_H_
+#define _DYNAMIC_SP_PAR_MAT_H_
+
+#include <mpi.h>
+#include <vector>
+#include <tuple>
+#include <numeric>
+#include <algorithm>
+#include <functional>
+#include "SpDefs.h"
+#include "SpParMat.h"
+#include "MPIType.h"
+#include "SampleSort.h"
+
+namespace combblas {
+
+/**
+ * Streams batches of edge updates into an existing SpParMat.
+ * Update() routes (row, column, value, op) tuples to the processes owning them, where they wait in
+ * a local buffer; the buffer is folded into the local DCSC with a single merge (SpDCCols::MergeUpdates)
+ * once it grows past max(EDGEDELTAMIN, local nnz / EDGEDELTADIVISOR), so the cost of rewriting
+ * the local matrix is amortized over many updates. Matrix() folds whatever is still buffered and
+ * returns the matrix, hence reads through it always see every update applied so far.
+ * Folding needs no communication, so only Update() is collective.
+ * The matrix must not be resized or replaced while it is wrapped. DER has to be SpDCCols.
+ */
+template <class IT, class NT, class DER>
+class DynamicSpParMat
+{
+public:
+	typedef typename DER::LocalIT LIT;
+
+	DynamicSpParMat(SpParMat<IT,NT,DER> & matrix, std::function<NT(NT,NT)> accumulate = std::plus<NT>())
+	: A(matrix), accum(accumulate), total_m(matrix.getnrow()), total_n(matrix.getncol()) {}
+
+	~DynamicSpParMat() { Fold(); }
+
+	/**
+	 * Collective, every process may pass any number of updates (including none) to any entries
+	 * Updates to the same entry apply in the order of (sender rank, position in the sender's batch)
+	 */
+	void Update(const std::vector< std::tuple<IT,IT,NT,EdgeOp> > & batch)
+	{
+		int nprocs = A.getcommgrid()->GetSize();
+		std::vector<int64_t> sendcnt(nprocs, 0), recvcnt(nprocs);
+		std::vector<int> owners(batch.size());
+		std::vector<LIT> lrows(batch.size()), lcols(batch.size());
+		for(size_t k=0; k<batch.size(); ++k)
+		{
+			IT grow = std::get<0>(batch[k]), gcol = std::get<1>(batch[k]);
+			if(grow < 0 || grow >= total_m || gcol < 0 || gcol >= total_n)
+			{
+				std::cout << "Edge update (" << grow << "," << gcol << ") is outside the " << total_m << "-by-" << total_n << " matrix" << std::endl;
+				MPI_Abort(MPI_COMM_WORLD, DIMMISMATCH);
+			}
+			owners[k] = A.Owner(total_m, total_n, grow, gcol, lrows[k], lcols[k]);
+			++sendcnt[owners[k]];
+		}
+		std::vector<int64_t> sdispls(nprocs+1, 0);
+		std::partial_sum(sendcnt.begin(), sendcnt.end(), sdispls.begin()+1);
+		std::vector< std::tuple<LIT,LIT,NT,EdgeOp> > sendbuf(batch.size());
+		for(size_t k=0; k<batch.size(); ++k)	// keeps the batch order within each destination
+			sendbuf[sdispls[owners[k]]++] = std::make_tuple(lrows[k], lcols[k], std::get<2>(batch[k]), std::get<3>(batch[k]));
+
+		MPI_Alltoall(sendcnt.data(), 1, MPIType<int64_t>(), recvcnt.data(), 1, MPIType<int64_t>(), A.getcommgrid()->GetWorld());
+		size_t pending = delta.size();
+		delta.resize(pending + std::accumulate(recvcnt.begin(), recvcnt.end(), static_cast<int64_t>(0)));
+		SampleSortExchange(sendbuf.data(), sendcnt, delta.data() + pending, recvcnt, A.getcommgrid()->GetWorld());
+
+		if(delta.size() > std::max<size_t>(EDGEDELTAMIN, A.seq().getnnz() / EDGEDELTADIVISOR))
+			Fold();
+	}
+
+	//! The matrix with every update so far applied, not collective
+	SpParMat<IT,NT,DER> & Matrix()
+	{
+		Fold();
+		return A;
+	}
+
+	//! Number of updates received by this process that are not yet in its local matrix
+	size_t getpending() const { return delta.size(); }
+
+	//! Merges the buffered updates into the local matrix, not collective
+	void Fold()
+	{
+		if(delta.empty()) return;
+		// stable, so that updates to the same entry keep their arrival order
+		std::stable_sort(delta.begin(), delta.end(), [](const std::tuple<LIT,LIT,NT,EdgeOp> & a, const std::tuple<LIT,LIT,NT,EdgeOp> & b)
+		{
+			return std::get<1>(a) < std::get<1>(b) || (std::get<1>(a) == std::get<1>(b) && std::get<0>(a) < std::get<0>(b));
+		});
+		A.seq().MergeUpdates(delta.data(), static_cast<LIT>(delta.size()), accum);
+		std::vector< std::tuple<LIT,LIT,NT,EdgeOp> >().swap(delta);
+	}
+
+private:
+	SpParMat<IT,NT,DER> & A;
+	std::function<NT(NT,NT)> accum;
+	IT total_m;
+	IT total_n;
+	std::vector< std::tuple<LIT,LIT,NT,EdgeOp> > delta;	// received, in arrival order
+};
+
+}
+
+#endif
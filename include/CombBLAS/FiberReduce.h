@@ -0,0 +1,390 @@
+/****************************************************************/
+/* Parallel Combinatorial BLAS Library (for Graph Computations) */
+/* version 1.6 -------------------------------------------------*/
+/* date: 6/15/2017 ---------------------------------------------*/
+/* authors: Ariful Azad, Aydin Buluc  --------------------------*/
+/****************************************************************/
+/*
+ Copyright (c) 2010-2017, The Regents of the University of California
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+#ifndef _FIBER_REDUCE_H_
+#define _FIBER_REDUCE_H_
+
+#include <mpi.h>
+#include <vector>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include "SpDefs.h"
+#include "MPIType.h"
+#include "SpTuples.h"
+#include "MultiwayMerge.h"
+
+namespace combblas {
+
+/***************************************************************************
+ * Sparse reduction of 3D SpGEMM partial products along the fiber.
+ * Every layer holds a column-sorted partial product of its whole 2D block, whose
+ * columns are split among the layers by "divisions". Each column range is shipped to
+ * its owner as a compressed column chunk and merged with the semiring addition.
+ * Small fibers use a direct exchange that merges chunks as they arrive; fibers of at
+ * least FIBERTREELAYERS layers (a power of two) use recursive halving instead, so that
+ * duplicates are combined before they travel further.
+ ***************************************************************************/
+
+/**
+ * Byte offsets of a compressed column chunk with nnz nonzeros in nzc nonzero columns:
+ * a (nnz,nzc) header, values, nonzero column ids, per-column counts and row ids.
+ * Each array starts at a max_align_t boundary so the receive buffer can be read in place
+ */
+struct FiberChunkLayout
+{
+	size_t num, jc, cnt, ir, bytes;
+
+	template <class IT, class NT>
+	static FiberChunkLayout Make(int64_t nnz, int64_t nzc)
+	{
+		FiberChunkLayout layout;
+		layout.num = Align(2*sizeof(int64_t));
+		layout.jc = Align(layout.num + sizeof(NT)*nnz);
+		layout.cnt = Align(layout.jc + sizeof(IT)*nzc);
+		layout.ir = Align(layout.cnt + sizeof(IT)*nzc);
+		layout.bytes = layout.ir + sizeof(IT)*nnz;
+		return layout;
+	}
+
+	static size_t Align(size_t offset)
+	{
+		const size_t a = alignof(std::max_align_t);
+		return (offset + a - 1) / a * a;
+	}
+};
+
+/**
+ * Serializes the column-sorted tuples [begin,end) into buf, subtracting coloffset from column ids.
+ * One column id per nonzero column instead of one per nonzero makes the chunk about a third
+ * smaller than the raw tuples for (int64_t,double)
+ */
+template <class IT, class NT>
+void PackFiberChunk(const std::tuple<IT,IT,NT> * begin, const std::tuple<IT,IT,NT> * end, IT coloffset, std::vector<char> & buf)
+{
+	int64_t nnz = end - begin;
+	int64_t nzc = 0;
+	for(int64_t i=0; i< nnz; ++i)
+		if(i == 0 || std::get<1>(begin[i]) != std::get<1>(begin[i-1]))	++nzc;
+
+	FiberChunkLayout layout = FiberChunkLayout::Make<IT,NT>(nnz, nzc);
+	buf.resize(layout.bytes);
+	char * base = buf.data();
+	int64_t header[2] = {nnz, nzc};
+	std::memcpy(base, header, sizeof(header));
+	NT * num = reinterpret_cast<NT*>(base + layout.num);
+	IT * jc = reinterpret_cast<IT*>(base + layout.jc);
+	IT * cnt = reinterpret_cast<IT*>(base + layout.cnt);
+	IT * ir = reinterpret_cast<IT*>(base + layout.ir);
+
+	int64_t k = -1;
+	for(int64_t i=0; i< nnz; ++i)
+	{
+		if(i == 0 || std::get<1>(begin[i]) != std::get<1>(begin[i-1]))
+		{
+			jc[++k] = std::get<1>(begin[i]) - coloffset;
+			cnt[k] = 0;
+		}
+		++cnt[k];
+		ir[i] = std::get<0>(begin[i]);
+		num[i] = std::get<2>(begin[i]);
+	}
+}
+
+/**
+ * Inverse of PackFiberChunk; the returned tuples keep the column order of the sender
+ */
+template <class IT, class NT>
+SpTuples<IT,NT> * UnpackFiberChunk(const char * base, IT nrow, IT ncol)
+{
+	int64_t header[2];
+	std::memcpy(header, base, sizeof(header));
+	int64_t nnz = header[0];
+	int64_t nzc = header[1];
+	if(nnz == 0)
+		return new SpTuples<IT,NT>(0, nrow, ncol);
+
+	FiberChunkLayout layout = FiberChunkLayout::Make<IT,NT>(nnz, nzc);
+	const NT * num = reinterpret_cast<const NT*>(base + layout.num);
+	const IT * jc = reinterpret_cast<const IT*>(base + layout.jc);
+	const IT * cnt = reinterpret_cast<const IT*>(base + layout.cnt);
+	const IT * ir = reinterpret_cast<const IT*>(base + layout.ir);
+
+	std::vector<int64_t> colstart(nzc+1, 0);
+	for(int64_t k=0; k< nzc; ++k)
+		colstart[k+1] = colstart[k] + cnt[k];
+
+	std::tuple<IT,IT,NT> * tuples = new std::tuple<IT,IT,NT>[nnz];
+#ifdef THREADED
+#pragma omp parallel for schedule(dynamic, 64)
+#endif
+	for(int64_t k=0; k< nzc; ++k)
+	{
+		for(int64_t i = colstart[k]; i < colstart[k+1]; ++i)
+			tuples[i] = std::make_tuple(ir[i], jc[k], num[i]);
+	}
+	return new SpTuples<IT,NT>(nnz, nrow, ncol, tuples, true, false);
+}
+
+/**
+ * Copies the tuples [begin,end) into a new nrow x ncol SpTuples, subtracting coloffset from column ids
+ */
+template <class IT, class NT>
+SpTuples<IT,NT> * CopyFiberSlice(const std::tuple<IT,IT,NT> * begin, const std::tuple<IT,IT,NT> * end, IT coloffset, IT nrow, IT ncol)
+{
+	int64_t nnz = end - begin;
+	if(nnz == 0)
+		return new SpTuples<IT,NT>(0, nrow, ncol);
+	std::tuple<IT,IT,NT> * tuples = new std::tuple<IT,IT,NT>[nnz];
+#ifdef THREADED
+#pragma omp parallel for
+#endif
+	for(int64_t i=0; i< nnz; ++i)
+		tuples[i] = std::make_tuple(std::get<0>(begin[i]), std::get<1>(begin[i]) - coloffset, std::get<2>(begin[i]));
+	return new SpTuples<IT,NT>(nnz, nrow, ncol, tuples, true, false);
+}
+
+/**
+ * MPI counts are int, so a chunk travels as a train of messages of at most FIBERSEGMENT bytes.
+ * Messages with the same source, tag and communicator do not overtake each other, so the
+ * segments arrive in order
+ */
+inline void IsendFiberChunk(const std::vector<char> & buf, int dest, MPI_Comm comm, std::vector<MPI_Request> & reqs)
+{
+	for(size_t off = 0; off < buf.size(); off += FIBERSEGMENT)
+	{
+		int len = static_cast<int>(std::min<size_t>(FIBERSEGMENT, buf.size() - off));
+		reqs.push_back(MPI_REQUEST_NULL);
+		MPI_Isend(const_cast<char*>(buf.data()) + off, len, MPI_CHAR, dest, FIBERTAG, comm, &reqs.back());
+	}
+}
+
+inline int IrecvFiberChunk(std::vector<char> & buf, int64_t bytes, int source, MPI_Comm comm, std::vector<MPI_Request> & reqs)
+{
+	buf.resize(bytes);
+	int segments = 0;
+	for(int64_t off = 0; off < bytes; off += FIBERSEGMENT, ++segments)
+	{
+		int len = static_cast<int>(std::min<int64_t>(FIBERSEGMENT, bytes - off));
+		reqs.push_back(MPI_REQUEST_NULL);
+		MPI_Irecv(buf.data() + off, len, MPI_CHAR, source, FIBERTAG, comm, &reqs.back());
+	}
+	return segments;
+}
+
+/**
+ * Merges and deletes the runs, hash merge when the rows inside columns need not be sorted
+ */
+template <class SR, class IT, class NT>
+SpTuples<IT,NT> * MergeFiberRuns(std::vector<SpTuples<IT,NT> *> & runs, IT nrow, IT ncol, bool sorted)
+{
+	SpTuples<IT,NT> * merged;
+	if(sorted)
+		merged = MultiwayMerge<SR>(runs, nrow, ncol, true);
+	else
+		merged = MultiwayMergeHash<SR>(runs, nrow, ncol, true, false);
+	runs.clear();
+	return merged;
+}
+
+/**
+ * Streaming merge: a newly received run is merged with the top of the stack for as long as the
+ * top is not more than twice as large, which keeps run sizes geometric and every nonzero in
+ * O(log nlayers) merges while later chunks are still in flight
+ */
+template <class SR, class IT, class NT>
+void PushFiberRun(std::vector<SpTuples<IT,NT> *> & runs, SpTuples<IT,NT> * run, IT nrow, IT ncol, bool sorted)
+{
+	runs.push_back(run);
+	while(runs.size() > 1 && runs[runs.size()-2]->getnnz() <= 2*runs.back()->getnnz())
+	{
+		std::vector<SpTuples<IT,NT> *> pair(runs.end()-2, runs.end());
+		runs.resize(runs.size()-2);
+		runs.push_back(MergeFiberRuns<SR>(pair, nrow, ncol, sorted));
+	}
+}
+
+template <class IT, class NT>
+int64_t FiberColumnBound(const SpTuples<IT,NT> * C, IT col)
+{
+	ColLexiCompare<IT,NT> comp;
+	std::tuple<IT,IT,NT> search_tuple(0, col, NT());
+	return std::lower_bound(C->tuples, C->tuples + C->getnnz(), search_tuple, comp) - C->tuples;
+}
+
+template <class SR, class IT, class NT>
+SpTuples<IT,NT> * FiberReduceDirect(SpTuples<IT,NT> * C, const std::vector<IT> & colprefix, MPI_Comm fiberWorld, bool sorted)
+{
+	int nlayers, myrank;
+	MPI_Comm_size(fiberWorld, &nlayers);
+	MPI_Comm_rank(fiberWorld, &myrank);
+	IT nrow = C->getnrow();
+	IT mycols = colprefix[myrank+1] - colprefix[myrank];
+
+	std::vector<int64_t> bounds(nlayers+1);
+	for(int i=0; i<= nlayers; ++i)
+		bounds[i] = FiberColumnBound(C, colprefix[i]);
+
+	std::vector< std::vector<char> > sendbufs(nlayers);
+#ifdef THREADED
+#pragma omp parallel for schedule(dynamic)
+#endif
+	for(int i=0; i< nlayers; ++i)
+	{
+		if(i != myrank)
+			PackFiberChunk(C->tuples + bounds[i], C->tuples + bounds[i+1], colprefix[i], sendbufs[i]);
+	}
+	std::vector< SpTuples<IT,NT> * > runs;
+	SpTuples<IT,NT> * mine = CopyFiberSlice(C->tuples + bounds[myrank], C->tuples + bounds[myrank+1], colprefix[myrank], nrow, mycols);
+	delete C;
+
+	std::vector<int64_t> sendbytes(nlayers, 0);
+	std::vector<int64_t> recvbytes(nlayers, 0);
+	for(int i=0; i< nlayers; ++i)
+		sendbytes[i] = sendbufs[i].size();
+	MPI_Alltoall(sendbytes.data(), 1, MPIType<int64_t>(), recvbytes.data(), 1, MPIType<int64_t>(), fiberWorld);
+
+	std::vector< std::vector<char> > recvbufs(nlayers);
+	std::vector<MPI_Request> recvreqs;
+	std::vector<int> reqsource;
+	std::vector<int> pending(nlayers, 0);
+	for(int i=0; i< nlayers; ++i)
+	{
+		if(i == myrank) continue;
+		pending[i] = IrecvFiberChunk(recvbufs[i], recvbytes[i], i, fiberWorld, recvreqs);
+		reqsource.resize(recvreqs.size(), i);
+	}
+	std::vector<MPI_Request> sendreqs;
+	for(int i=0; i< nlayers; ++i)
+	{
+		if(i != myrank)
+			IsendFiberChunk(sendbufs[i], i, fiberWorld, sendreqs);
+	}
+
+	PushFiberRun<SR>(runs, mine, nrow, mycols, sorted);
+	for(size_t r=0; r < recvreqs.size(); ++r)
+	{
+		int idx;
+		MPI_Waitany(static_cast<int>(recvreqs.size()), recvreqs.data(), &idx, MPI_STATUS_IGNORE);
+		int source = reqsource[idx];
+		if(--pending[source] == 0)
+		{
+			SpTuples<IT,NT> * run = UnpackFiberChunk<IT,NT>(recvbufs[source].data(), nrow, mycols);
+			std::vector<char>().swap(recvbufs[source]);
+			PushFiberRun<SR>(runs, run, nrow, mycols, sorted);
+		}
+	}
+	MPI_Waitall(static_cast<int>(sendreqs.size()), sendreqs.data(), MPI_STATUSES_IGNORE);
+	return MergeFiberRuns<SR>(runs, nrow, mycols, sorted);
+}
+
+/**
+ * Recursive halving: at every step the fiber splits into two halves, each process swaps the
+ * columns owned by the other half with its partner there and merges what it keeps with what it
+ * receives. Requires a power-of-two number of layers
+ */
+template <class SR, class IT, class NT>
+SpTuples<IT,NT> * FiberReduceTree(SpTuples<IT,NT> * C, const std::vector<IT> & colprefix, MPI_Comm fiberWorld, bool sorted)
+{
+	int nlayers, myrank;
+	MPI_Comm_size(fiberWorld, &nlayers);
+	MPI_Comm_rank(fiberWorld, &myrank);
+	IT nrow = C->getnrow();
+	IT ncol = C->getncol();
+
+	int lo = 0, hi = nlayers;
+	while(hi - lo > 1)
+	{
+		int mid = lo + (hi - lo)/2;
+		bool lower = (myrank < mid);
+		int partner = lower ? myrank + (mid - lo) : myrank - (mid - lo);
+		int keeplo = lower ? lo : mid;
+		int keephi = lower ? mid : hi;
+		int sendlo = lower ? mid : lo;
+		int sendhi = lower ? hi : mid;
+		bool last = (hi - lo == 2);	// after this step each process owns only its own columns
+
+		IT keepoffset = last ? colprefix[myrank] : 0;
+		IT sendoffset = last ? colprefix[partner] : 0;
+		IT outcols = last ? colprefix[myrank+1] - colprefix[myrank] : ncol;
+
+		std::vector<char> sendbuf;
+		PackFiberChunk(C->tuples + FiberColumnBound(C, colprefix[sendlo]), C->tuples + FiberColumnBound(C, colprefix[sendhi]), sendoffset, sendbuf);
+		int64_t sendbytes = sendbuf.size();
+		int64_t recvbytes = 0;
+		MPI_Sendrecv(&sendbytes, 1, MPIType<int64_t>(), partner, FIBERTAG, &recvbytes, 1, MPIType<int64_t>(), partner, FIBERTAG, fiberWorld, MPI_STATUS_IGNORE);
+
+		std::vector<char> recvbuf;
+		std::vector<MPI_Request> reqs;
+		IrecvFiberChunk(recvbuf, recvbytes, partner, fiberWorld, reqs);
+		IsendFiberChunk(sendbuf, partner, fiberWorld, reqs);
+
+		std::vector< SpTuples<IT,NT> * > runs;
+		runs.push_back(CopyFiberSlice(C->tuples + FiberColumnBound(C, colprefix[keeplo]), C->tuples + FiberColumnBound(C, colprefix[keephi]), keepoffset, nrow, outcols));
+		delete C;
+
+		MPI_Waitall(static_cast<int>(reqs.size()), reqs.data(), MPI_STATUSES_IGNORE);
+		std::vector<char>().swap(sendbuf);
+		runs.push_back(UnpackFiberChunk<IT,NT>(recvbuf.data(), nrow, outcols));
+		std::vector<char>().swap(recvbuf);
+		C = MergeFiberRuns<SR>(runs, nrow, outcols, sorted);
+
+		lo = keeplo;
+		hi = keephi;
+	}
+	return C;
+}
+
+/**
+ * Reduces the column-sorted local partial products C of all layers of the fiber (and deletes C).
+ * @param[in] divisions number of columns of C owned by each layer, contiguous and in layer order
+ * @param[in] sorted whether C has sorted row ids inside columns; if false, merges use hashing
+ * \return the reduced nrow x divisions[myrank] block with layer-local column ids
+ **/
+template <class SR, class IT, class NT, class DIT>
+SpTuples<IT,NT> * FiberReduce(SpTuples<IT,NT> * C, const std::vector<DIT> & divisions, MPI_Comm fiberWorld, bool sorted = true)
+{
+	int nlayers;
+	MPI_Comm_size(fiberWorld, &nlayers);
+	if(nlayers == 1)
+		return C;
+
+	std::vector<IT> colprefix(nlayers+1, 0);
+	for(int i=0; i< nlayers; ++i)
+		colprefix[i+1] = colprefix[i] + static_cast<IT>(divisions[i]);
+
+	if(nlayers >= FIBERTREELAYERS && (nlayers & (nlayers-1)) == 0)
+		return FiberReduceTree<SR>(C, colprefix, fiberWorld, sorted);
+	else
+		return FiberReduceDirect<SR>(C, colprefix, fiberWorld, sorted);
+}
+
+}
+
+#endif
@@ -173,6 +173,257 @@ void dcsc_gespmv_threaded_nosplit (const SpDCCols<IU, NU> & A, const RHS * x, LH
         }
     }
 
+/**
+ * SpMV with the transpose of A and a dense vector, y = A'*x, without forming A'
+ * Every nonzero column of A produces one entry of y, so threads need no private copies of y
+ */
+template <typename SR, typename IU, typename NU, typename RHS, typename LHS>
+void dcsc_gespmv_transpose (const SpDCCols<IU, NU> & A, const RHS * x, LHS * y)
+{
+	if(A.nnz > 0)
+	{
+		int splits = A.getnsplit();
+		IU perpiece = (splits > 0) ? A.getnrow() / splits : 0;
+		for(int s=0; s < std::max(splits, 1); ++s)	// row splits share columns, so they go one after the other
+		{
+			Dcsc<IU, NU> * dcsc = (splits > 0) ? A.GetInternal(s) : A.dcsc;
+			IU disp = s * perpiece;
+#ifdef THREADED
+#pragma omp parallel for schedule(dynamic, 256)
+#endif
+			for(IU j =0; j<dcsc->nzc; ++j)	// for all nonzero columns
+			{
+				IU colid = dcsc->jc[j];
+				for(IU i = dcsc->cp[j]; i< dcsc->cp[j+1]; ++i)
+					SR::axpy(dcsc->numx[i], x[dcsc->ir[i] + disp], y[colid]);
+			}
+		}
+	}
+}
+
+/**
+ * One tile of the SpMV with dense vector, y += A(rowlo:rowhi, collo:colhi) * x, with rowhi and colhi excluded
+ * Row indices are sorted within each column, so every column of the tile is entered with a binary search
+ * Threads own disjoint row ranges of the tile, hence disjoint pieces of y
+ */
+template <typename SR, typename IU, typename NU, typename RHS, typename LHS>
+void dcsc_gespmv_tile (const SpDCCols<IU, NU> & A, const RHS * x, LHS * y, IU rowlo, IU rowhi, IU collo, IU colhi)
+{
+	if(A.nnz == 0 || rowlo >= rowhi || collo >= colhi)
+		return;
+
+	int nthreads = 1;
+#ifdef THREADED
+#pragma omp parallel
+	{
+		nthreads = omp_get_num_threads();
+	}
+#endif
+	int splits = A.getnsplit();
+	IU perpiece = (splits > 0) ? A.getnrow() / splits : 0;
+	for(int s=0; s < std::max(splits, 1); ++s)
+	{
+		Dcsc<IU, NU> * dcsc = (splits > 0) ? A.GetInternal(s) : A.dcsc;
+		IU disp = s * perpiece;
+		IU splitend = (splits > 0 && s < splits-1) ? disp + perpiece : A.getnrow();
+		IU lo = std::max(rowlo, disp);
+		IU hi = std::min(rowhi, splitend);
+		if(dcsc == NULL || lo >= hi)
+			continue;
+		lo -= disp;	// row indices inside the split
+		hi -= disp;
+
+		IU jbeg = std::lower_bound(dcsc->jc, dcsc->jc + dcsc->nzc, collo) - dcsc->jc;
+		IU jend = std::lower_bound(dcsc->jc + jbeg, dcsc->jc + dcsc->nzc, colhi) - dcsc->jc;
+		IU perthread = (hi - lo + nthreads - 1) / nthreads;
+#ifdef THREADED
+#pragma omp parallel for
+#endif
+		for(int t=0; t < nthreads; ++t)
+		{
+			IU tlo = std::min(hi, lo + t * perthread);
+			IU thi = std::min(hi, tlo + perthread);
+			for(IU j = jbeg; tlo < thi && j < jend; ++j)
+			{
+				IU colid = dcsc->jc[j];
+				IU i = std::lower_bound(dcsc->ir + dcsc->cp[j], dcsc->ir + dcsc->cp[j+1], tlo) - dcsc->ir;
+				for(; i < dcsc->cp[j+1] && dcsc->ir[i] < thi; ++i)
+					SR::axpy(dcsc->numx[i], x[colid], y[dcsc->ir[i] + disp]);
+			}
+		}
+	}
+}
+
+//! Local step of the parallel dense SpMV, overloaded on the storage format
+template <typename SR, typename IU, typename NU, typename RHS, typename LHS>
+void gespmv_dense (const SpDCCols<IU, NU> & A, const RHS * x, LHS * y)
+{
+#ifdef THREADED
+	dcsc_gespmv_threaded<SR>(A, x, y);
+#else
+	dcsc_gespmv<SR>(A, x, y);
+#endif
+}
+
+//! One tile of the local step of the parallel dense SpMV, overloaded on the storage format
+template <typename SR, typename IU, typename NU, typename RHS, typename LHS>
+void gespmv_dense_tile (const SpDCCols<IU, NU> & A, const RHS * x, LHS * y, IU rowlo, IU rowhi, IU collo, IU colhi)
+{
+	dcsc_gespmv_tile<SR>(A, x, y, rowlo, rowhi, collo, colhi);
+}
+
+//! Local step of the parallel dense SpMV with the transpose, overloaded on the storage format
+template <typename SR, typename IU, typename NU, typename RHS, typename LHS>
+void gespmv_dense_transpose (const SpDCCols<IU, NU> & A, const RHS * x, LHS * y)
+{
+	dcsc_gespmv_transpose<SR>(A, x, y);
+}
+
+
+/**
+ * Y = A*X for k right hand sides, X (ncol-by-k) and Y (nrow-by-k) are dense and row-major, Y has to be initialized
+ * The k columns are handled in panels of SPMMPANEL, whose fixed trip count the compiler unrolls and vectorizes
+ * A column of A scatters into arbitrary rows of Y, so threads own panels (disjoint columns of Y) instead of rows
+ */
+template <typename SR, typename IU, typename NU, typename RHS, typename LHS>
+void dcsc_gespmm (const SpDCCols<IU, NU> & A, const RHS * X, LHS * Y, int k)
+{
+	if(A.nnz == 0)
+		return;
+	int panels = (k + SPMMPANEL - 1) / SPMMPANEL;
+	int splits = A.getnsplit();
+	IU perpiece = (splits > 0) ? A.getnrow() / splits : 0;
+	for(int s=0; s < std::max(splits, 1); ++s)
+	{
+		Dcsc<IU, NU> * dcsc = (splits > 0) ? A.GetInternal(s) : A.dcsc;
+		IU disp = s * perpiece;
+		if(dcsc == NULL)
+			continue;
+#ifdef THREADED
+#pragma omp parallel for schedule(dynamic)
+#endif
+		for(int p=0; p < panels; ++p)
+		{
+			int t0 = p * SPMMPANEL;
+			for(IU j =0; j < dcsc->nzc; ++j)
+			{
+				const RHS * xrow = X + dcsc->jc[j] * k + t0;
+				for(IU i = dcsc->cp[j]; i < dcsc->cp[j+1]; ++i)
+				{
+					LHS * yrow = Y + (dcsc->ir[i] + disp) * k + t0;
+					if(t0 + SPMMPANEL <= k)
+					{
+						for(int t=0; t < SPMMPANEL; ++t)
+							SR::axpy(dcsc->numx[i], xrow[t], yrow[t]);
+					}
+					else
+					{
+						for(int t=0; t < k - t0; ++t)
+							SR::axpy(dcsc->numx[i], xrow[t], yrow[t]);
+					}
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Y = A'*X for k right hand sides, X (nrow-by-k) and Y (ncol-by-k) are dense and row-major, Y has to be initialized
+ * Every nonzero column of A produces one row of Y, which is accumulated in a panel sized local buffer
+ */
+template <typename SR, typename IU, typename NU, typename RHS, typename LHS>
+void dcsc_gespmm_transpose (const SpDCCols<IU, NU> & A, const RHS * X, LHS * Y, int k)
+{
+	if(A.nnz == 0)
+		return;
+	int splits = A.getnsplit();
+	IU perpiece = (splits > 0) ? A.getnrow() / splits : 0;
+	for(int s=0; s < std::max(splits, 1); ++s)	// row splits share columns, so they go one after the other
+	{
+		Dcsc<IU, NU> * dcsc = (splits > 0) ? A.GetInternal(s) : A.dcsc;
+		IU disp = s * perpiece;
+		if(dcsc == NULL)
+			continue;
+#ifdef THREADED
+#pragma omp parallel for schedule(dynamic, 64)
+#endif
+		for(IU j =0; j < dcsc->nzc; ++j)
+		{
+			LHS * yrow = Y + dcsc->jc[j] * k;
+			for(int t0 = 0; t0 < k; t0 += SPMMPANEL)
+			{
+				int width = std::min(SPMMPANEL, k - t0);
+				LHS acc[SPMMPANEL];
+				std::copy(yrow + t0, yrow + t0 + width, acc);
+				for(IU i = dcsc->cp[j]; i < dcsc->cp[j+1]; ++i)
+				{
+					const RHS * xrow = X + (dcsc->ir[i] + disp) * k + t0;
+					for(int t=0; t < width; ++t)
+						SR::axpy(dcsc->numx[i], xrow[t], acc[t]);
+				}
+				std::copy(acc, acc + width, yrow + t0);
+			}
+		}
+	}
+}
+
+//! Local step of the parallel SpMM, overloaded on the storage format
+template <typename SR, typename IU, typename NU, typename RHS, typename LHS>
+void gespmm_dense (const SpDCCols<IU, NU> & A, const RHS * X, LHS * Y, int k)
+{
+	dcsc_gespmm<SR>(A, X, Y, k);
+}
+
+//! Local step of the parallel SpMM with the transpose, overloaded on the storage format
+template <typename SR, typename IU, typename NU, typename RHS, typename LHS>
+void gespmm_dense_transpose (const SpDCCols<IU, NU> & A, const RHS * X, LHS * Y, int k)
+{
+	dcsc_gespmm_transpose<SR>(A, X, Y, k);
+}
+
+/**
+ * Sampled dense-dense product on the nonzeros of A: A(i,j) = __binary_op(A(i,j), U(i,:) . V(j,:)), where the dot product
+ * multiplies with SR::multiply and folds with SR::add; U (nrow-by-k) and V (ncol-by-k) are dense and row-major
+ * Every nonzero only overwrites itself, so threads own columns
+ */
+template <typename SR, typename IU, typename NU, typename UT, typename VT, typename _BinaryOperation>
+void dcsc_sddmm (SpDCCols<IU, NU> & A, const UT * U, const VT * V, int k, _BinaryOperation __binary_op)
+{
+	typedef typename promote_trait<UT,VT>::T_promote T_promote;
+	if(A.nnz == 0)
+		return;
+	int splits = A.getnsplit();
+	IU perpiece = (splits > 0) ? A.getnrow() / splits : 0;
+	for(int s=0; s < std::max(splits, 1); ++s)
+	{
+		Dcsc<IU, NU> * dcsc = (splits > 0) ? A.GetInternal(s) : A.dcsc;
+		IU disp = s * perpiece;
+		if(dcsc == NULL)
+			continue;
+#ifdef THREADED
+#pragma omp parallel for schedule(dynamic, 64)
+#endif
+		for(IU j =0; j < dcsc->nzc; ++j)
+		{
+			const VT * vrow = V + dcsc->jc[j] * k;
+			for(IU i = dcsc->cp[j]; i < dcsc->cp[j+1]; ++i)
+			{
+				const UT * urow = U + (dcsc->ir[i] + disp) * k;
+				T_promote dot = SR::id();
+				for(int t=0; t < k; ++t)
+					dot = SR::add(dot, SR::multiply(urow[t], vrow[t]));
+				dcsc->numx[i] = __binary_op(dcsc->numx[i], dot);
+			}
+		}
+	}
+}
+
+//! Local step of the parallel SDDMM, overloaded on the storage format
+template <typename SR, typename IU, typename NU, typename UT, typename VT, typename _BinaryOperation>
+void sddmm_dense (SpDCCols<IU, NU> & A, const UT * U, const VT * V, int k, _BinaryOperation __binary_op)
+{
+	dcsc_sddmm<SR>(A, U, V, k, __binary_op);
+}
 
 /** 
   * Multithreaded SpMV with sparse vector
@@ -805,14 +805,14 @@ void FullyDistVec<IT,NT>::RandPerm()
 #else
 	uint64_t seed= time(NULL);
 #endif
-    
+
+#ifdef COMBBLAS_LEGACY
 	MTRand M(seed);	// generate random numbers with Mersenne Twister
     MPI_Comm World = commGrid->GetWorld();
 	int nprocs = commGrid->GetSize();
 	int rank = commGrid->GetRank();
     IT size = LocArrSize();
 
-#ifdef COMBBLAS_LEGACY
   std::pair<double,NT> * vecpair = new std::pair<double,NT>[size];
 	IT * dist = new IT[nprocs];
 	dist[rank] = size;
@@ -829,103 +829,94 @@ void FullyDistVec<IT,NT>::RandPerm()
     DeleteAll(vecpair, dist);
 	arr.swap(nnum);
 #else
-    std::vector< std::vector< NT > > data_send(nprocs);
-	for(int i=0; i<size; ++i)
-    {
-		// send each entry to a random process
-		uint32_t dest = M.randInt(nprocs-1);
-		data_send[dest].push_back(arr[i]);
-	}
-    int * sendcnt = new int[nprocs];
-    int * sdispls = new int[nprocs];
-    for(int i=0; i<nprocs; ++i) sendcnt[i] = (int) data_send[i].size();
-    
-    int * rdispls = new int[nprocs];
-    int * recvcnt = new int[nprocs];
-    MPI_Alltoall(sendcnt, 1, MPI_INT, recvcnt, 1, MPI_INT, World);  // share the request counts
-    sdispls[0] = 0;
-    rdispls[0] = 0;
-    for(int i=0; i<nprocs-1; ++i)
-    {
-        sdispls[i+1] = sdispls[i] + sendcnt[i];
-        rdispls[i+1] = rdispls[i] + recvcnt[i];
-    }
-    IT totrecv = std::accumulate(recvcnt,recvcnt+nprocs, static_cast<IT>(0));
-	if(totrecv > std::numeric_limits<int>::max())
+	MPI_Bcast(&seed, 1, MPIType<uint64_t>(), 0, commGrid->GetWorld());	// all processors must agree on the implicit permutation
+	RandPerm(seed);
+#endif
+}
+
+/**
+  * Randomly permutes an already existing vector with a single data exchange
+  * The permutation is the implicit FeistelPermutation(glen, seed): the entry at global index i moves to p(i)
+  * Since every processor can evaluate p and its inverse, the send and the receive counts are computed locally
+  * and the data is routed with one MPI_Alltoallv (the earlier scheme used two Alltoallv rounds plus count exchanges)
+  **/
+template <class IT, class NT>
+void FullyDistVec<IT,NT>::RandPerm(uint64_t seed)
+{
+	MPI_Comm World = commGrid->GetWorld();
+	int nprocs = commGrid->GetSize();
+	IT size = LocArrSize();
+	IT sizeuntil = LengthUntil();
+	FeistelPermutation<IT> perm(glen, seed);
+
+	std::vector<int> owners(size);
+	std::vector< std::pair<IT,IT> > sources(size);	// (old global index, new local index) for entries landing here
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+	for(IT i=0; i<size; ++i)
 	{
-		std::cout << "COMBBLAS_WARNING: total data to receive exceeds max int: " << totrecv << std::endl;
+		IT lind;
+		owners[i] = Owner(perm(i+sizeuntil), lind);
+		sources[i] = std::make_pair(perm.inverse(i+sizeuntil), i);
 	}
-    std::vector<NT>().swap(arr);  // make space for temporaries
-    
-	NT * sendbuf = new NT[size];
-    for(int i=0; i<nprocs; ++i)
-    {
-        std::copy(data_send[i].begin(), data_send[i].end(), sendbuf+sdispls[i]);
-        std::vector<NT>().swap(data_send[i]);	// free memory
-    }
-	NT * recvbuf = new NT[totrecv];
-    MPI_Alltoallv(sendbuf, sendcnt, sdispls, MPIType<NT>(), recvbuf, recvcnt, rdispls, MPIType<NT>(), World);
-	//std::random_shuffle(recvbuf, recvbuf+ totrecv);
-    std::default_random_engine gen(seed);
-    std::shuffle(recvbuf, recvbuf+ totrecv,gen); // locally shuffle data
-    
-	int64_t * localcounts = new int64_t[nprocs];
-	localcounts[rank] = totrecv;
-	MPI_Allgather(MPI_IN_PLACE, 1, MPI_LONG_LONG, localcounts, 1, MPI_LONG_LONG, World);
-	int64_t glenuntil = std::accumulate(localcounts, localcounts+rank, static_cast<int64_t>(0));
-    
-	std::vector< std::vector< IT > > locs_send(nprocs);
-	for(IT i=0; i< totrecv; ++i)    // determine new locations w/ prefix sums
+	// Owner() is monotone in the global index, so sorting by old global index groups the incoming entries
+	// by sender, in the same (increasing index) order that the sender packs them
+	std::sort(sources.begin(), sources.end());
+
+	int * sendcnt = new int[nprocs]();
+	int * recvcnt = new int[nprocs]();
+	int * sdispls = new int[nprocs]();
+	int * rdispls = new int[nprocs]();
+	for(IT i=0; i<size; ++i)
 	{
-		IT remotelocind;
-		int owner = Owner(glenuntil+i, remotelocind);
-		locs_send[owner].push_back(remotelocind);
-		data_send[owner].push_back(recvbuf[i]);
+		++sendcnt[owners[i]];
+		IT lind;
+		++recvcnt[Owner(sources[i].first, lind)];
 	}
-    
-    for(int i=0; i<nprocs; ++i) sendcnt[i] = (int) data_send[i].size(); // = locs_send.size()
-    MPI_Alltoall(sendcnt, 1, MPI_INT, recvcnt, 1, MPI_INT, World);
-    sdispls[0] = 0;
-    rdispls[0] = 0;
-    for(int i=0; i<nprocs-1; ++i)
-    {
-        sdispls[i+1] = sdispls[i] + sendcnt[i];
-        rdispls[i+1] = rdispls[i] + recvcnt[i];
-    }
-    IT newsize = std::accumulate(recvcnt,recvcnt+nprocs, static_cast<IT>(0));
-	if(newsize > std::numeric_limits<int>::max())
+	std::partial_sum(sendcnt, sendcnt+nprocs-1, sdispls+1);
+	std::partial_sum(recvcnt, recvcnt+nprocs-1, rdispls+1);
+	if(size > std::numeric_limits<int>::max())
 	{
-		std::cout << "COMBBLAS_WARNING: total data to receive exceeds max int: " << newsize << std::endl;
+		std::cout << "COMBBLAS_WARNING: total data to receive exceeds max int: " << size << std::endl;
 	}
-	// re-use the receive buffer as sendbuf of second stage
-    IT totalsend = std::accumulate(sendcnt, sendcnt+nprocs, static_cast<IT>(0));
-    if(totalsend != totrecv || newsize != size)
-    {
-        std::cout << "COMBBLAS_WARNING: sending different sized data than received: " << totalsend << "=" << totrecv << " , " << newsize << "=" << size << std::endl;
-    }
-    for(int i=0; i<nprocs; ++i)
-    {
-        std::copy(data_send[i].begin(), data_send[i].end(), recvbuf+sdispls[i]);
-        std::vector<NT>().swap(data_send[i]);	// free memory
-    }
-    // re-use the send buffer as receive buffer of second stage
-    MPI_Alltoallv(recvbuf, sendcnt, sdispls, MPIType<NT>(), sendbuf, recvcnt, rdispls, MPIType<NT>(), World);
-    delete [] recvbuf;
-    IT * newinds = new IT[totalsend];
-    for(int i=0; i<nprocs; ++i)
-    {
-        std::copy(locs_send[i].begin(), locs_send[i].end(), newinds+sdispls[i]);
-        std::vector<IT>().swap(locs_send[i]);	// free memory
-    }
-    IT * indsbuf = new IT[size];
-	MPI_Alltoallv(newinds, sendcnt, sdispls, MPIType<IT>(), indsbuf, recvcnt, rdispls, MPIType<IT>(), World);
-    DeleteAll(newinds, sendcnt, sdispls, rdispls, recvcnt);
-    arr.resize(size);
-    for(IT i=0; i<size; ++i)
-    {
-        arr[indsbuf[i]] = sendbuf[i];
-    }
+
+	NT * sendbuf = new NT[size];
+	std::vector<int> curptrs(sdispls, sdispls+nprocs);
+	for(IT i=0; i<size; ++i)
+		sendbuf[curptrs[owners[i]]++] = arr[i];
+	std::vector<int>().swap(owners);
+
+	NT * recvbuf = new NT[size];
+	MPI_Alltoallv(sendbuf, sendcnt, sdispls, MPIType<NT>(), recvbuf, recvcnt, rdispls, MPIType<NT>(), World);
+	DeleteAll(sendbuf, sendcnt, recvcnt, sdispls, rdispls);
+
+#ifdef _OPENMP
+#pragma omp parallel for
 #endif
+	for(IT i=0; i<size; ++i)
+		arr[sources[i].second] = recvbuf[i];
+	delete [] recvbuf;
+}
+
+/**
+  * Generates the random permutation vector of length globalsize without any communication
+  * The result satisfies p[FeistelPermutation(globalsize,seed)(i)] = i,
+  * i.e. it is the same as calling iota(globalsize, 0) followed by RandPerm(seed)
+  **/
+template <class IT, class NT>
+void FullyDistVec<IT,NT>::randperm(IT globalsize, uint64_t seed)
+{
+	glen = globalsize;
+	IT length = MyLocLength();
+	arr.resize(length);
+	IT sizeuntil = LengthUntil();
+	FeistelPermutation<IT> perm(glen, seed);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+	for(IT i=0; i<length; ++i)
+		arr[i] = static_cast<NT>(perm.inverse(i+sizeuntil));
 }
 
 // ABAB: In its current form, unless LengthUntil returns NT
@@ -40,6 +40,7 @@
 #include "CommGrid.h"
 #include "FullyDist.h"
 #include "Exception.h"
+#include "RandPermutation.h"
 
 namespace combblas {
 
@@ -55,6 +56,9 @@ class DistEdgeList;
 template <class IU, class NU>
 class DenseVectorLocalIterator;
 
+template <class IU>
+class VertexDictionary;
+
 // ABAB: As opposed to SpParMat, IT here is used to encode global size and global indices;
 // therefore it can not be 32-bits, in general.
 template <class IT, class NT>
@@ -156,6 +160,8 @@ public:
 
 	void iota(IT globalsize, NT first);
 	void RandPerm();	// randomly permute the vector
+	void RandPerm(uint64_t seed);	// randomly permute the vector with a reproducible implicit permutation
+	void randperm(IT globalsize, uint64_t seed);	// generate a random permutation of 0..globalsize-1 without communication
 	FullyDistVec<IT,IT> sort();	// sort and return the permutation
 
 	using FullyDist<IT,NT,typename combblas::disable_if< combblas::is_boolean<NT>::value, NT >::type>::LengthUntil;
@@ -285,6 +291,9 @@ private:
 	template <class IU, class NU, class UDER>
 	friend class SpParMat;
 
+	template <class IU, class NU, class UDER>
+	friend class SpParMat3D;
+
 	template <class IU, class NU>
 	friend class FullyDistVec;
 
@@ -294,10 +303,17 @@ private:
 	template <class IU, class NU>
 	friend class DenseVectorLocalIterator;
 
+	template <class IU>
+	friend class VertexDictionary;
+
 	template <typename SR, typename IU, typename NUM, typename NUV, typename UDER> 
 	friend FullyDistVec<IU,typename promote_trait<NUM,NUV>::T_promote> 
 	SpMV (const SpParMat<IU,NUM,UDER> & A, const FullyDistVec<IU,NUV> & x );
 
+	template <typename SR, typename IU, typename NUM, typename NUV, typename UDER> 
+	friend FullyDistVec<IU,typename promote_trait<NUM,NUV>::T_promote> 
+	SpMVTranspose (const SpParMat<IU,NUM,UDER> & A, const FullyDistVec<IU,NUV> & x );
+
 	template <typename IU, typename NU1, typename NU2>
 	friend FullyDistSpVec<IU,typename promote_trait<NU1,NU2>::T_promote> 
 	EWiseMult (const FullyDistSpVec<IU,NU1> & V, const FullyDistVec<IU,NU2> & W , bool exclude, NU2 zero);
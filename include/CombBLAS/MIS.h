@@ -0,0 +1,539 @@
+/****************************************************************/
+/* Parallel Combinatorial BLAS Library (for Graph Computations) */
+/* version 1.6 -------------------------------------------------*/
+/* date: 6/15/2017 ---------------------------------------------*/
+/* authors: Ariful Azad, Aydin Buluc  --------------------------*/
+/****************************************************************/
+/*
+ Copyright (c) 2010-2017, The Regents of the University of California
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+#ifndef _MIS_H_
+#define _MIS_H_
+
+#include <mpi.h>
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <numeric>
+#include "SpDefs.h"
+#include "SpParMat.h"
+#include "FullyDistVec.h"
+#include "FullyDistSpVec.h"
+#include "PreAllocatedSPA.h"
+#include "BitMap.h"
+#include "ParFriends.h"
+#include "MPIType.h"
+#include "RandPermutation.h"
+
+namespace combblas {
+
+/**
+ * Counter-based hash of (seed, round, vertex), i.e. SplitMix64 applied to a combination of the
+ * three. Every process computes the same priority for a vertex without communication, so the
+ * sets found depend on the seed only, not on the process count.
+ */
+inline uint64_t MISHash(uint64_t seed, uint64_t round, uint64_t v)
+{
+    return SplitMix64(v + 0x9E3779B97F4A7C15ULL * (seed + 0xD1B54A32D192ED03ULL * (round + 1)));
+}
+
+
+template <class NT>
+struct MISSelectMinSR
+{
+    typedef uint64_t T_promote;
+    static T_promote id(){ return std::numeric_limits<uint64_t>::max(); };
+    static bool returnedSAID() { return false; }
+    static MPI_Op mpi_op() { return MPI_MIN; };
+
+    static T_promote add(const T_promote & arg1, const T_promote & arg2)
+    {
+        return std::min(arg1, arg2);
+    }
+
+    static T_promote multiply(const NT & arg1, const T_promote & arg2)
+    {
+        return arg2;
+    }
+
+    static void axpy(const NT & a, const T_promote & x, T_promote & y)
+    {
+        y = std::min(y, x);
+    }
+};
+
+
+/**
+ * Row-wise (CSR) copy of the local submatrix of a symmetric matrix, used to run SpMV rounds
+ * pull-style: every local row scans its own neighbors, and may stop at the first one that
+ * decides its outcome. Inputs are replicated along processor columns (keys or bitmaps),
+ * partial results are combined along processor rows with a single MPI_Reduce_scatter.
+ * Relies on the vector pieces of a processor row tiling the row block of the matrix.
+ */
+template <class IT>
+class MISLocalRows
+{
+public:
+    template <class NT, class DER>
+    MISLocalRows(SpParMat<IT,NT,DER> & A, IT mylen)
+    {
+        std::shared_ptr<CommGrid> commGrid = A.getcommgrid();
+        RowWorld = commGrid->GetRowWorld();
+        ColWorld = commGrid->GetColWorld();
+        World = commGrid->GetWorld();
+        diagneigh = commGrid->GetComplementRank();
+        rowrank = commGrid->GetRankInProcRow();
+        colrank = commGrid->GetRankInProcCol();
+        int pc = commGrid->GetGridCols();
+        int pr = commGrid->GetGridRows();
+
+        DER & spSeq = A.seq();
+        lnrow = spSeq.getnrow();
+        rowptr.assign(lnrow+1, 0);
+        for(auto colit = spSeq.begcol(); colit != spSeq.endcol(); ++colit)
+            for(auto nzit = spSeq.begnz(colit); nzit != spSeq.endnz(colit); ++nzit)
+                ++rowptr[nzit.rowid()+1];
+        std::partial_sum(rowptr.begin(), rowptr.end(), rowptr.begin());
+        colids.resize(rowptr[lnrow]);
+        std::vector<IT> fill(rowptr.begin(), rowptr.end()-1);
+        for(auto colit = spSeq.begcol(); colit != spSeq.endcol(); ++colit)
+            for(auto nzit = spSeq.begnz(colit); nzit != spSeq.endnz(colit); ++nzit)
+                colids[fill[nzit.rowid()]++] = colit.colid();
+
+        myelems = static_cast<int>(mylen);
+        rowcounts.resize(pc);
+        MPI_Allgather(&myelems, 1, MPI_INT, rowcounts.data(), 1, MPI_INT, RowWorld);
+        int trxelems = 0;
+        MPI_Sendrecv(&myelems, 1, MPI_INT, diagneigh, TRX, &trxelems, 1, MPI_INT, diagneigh, TRX, World, MPI_STATUS_IGNORE);
+        colcounts.resize(pr);
+        MPI_Allgather(&trxelems, 1, MPI_INT, colcounts.data(), 1, MPI_INT, ColWorld);
+
+        rowdispls = Displacements(rowcounts);
+        coldispls = Displacements(colcounts);
+        rowwords = Words(rowcounts);
+        colwords = Words(colcounts);
+        rowwdispls = Displacements(rowwords);
+        colwdispls = Displacements(colwords);
+    }
+
+    //! Values of the vector entries of my row block
+    std::vector<uint64_t> GatherRows(const std::vector<uint64_t> & local) const
+    {
+        return Gather(local.data(), myelems, rowcounts, rowdispls, false);
+    }
+
+    //! Values of the vector entries of my column block
+    std::vector<uint64_t> GatherCols(const std::vector<uint64_t> & local) const
+    {
+        return Gather(local.data(), myelems, colcounts, coldispls, true);
+    }
+
+    BitMap GatherRowBits(const std::vector<uint8_t> & flags) const
+    {
+        std::vector<uint64_t> words = Gather(Pack(flags).data(), (myelems+63)/64, rowwords, rowwdispls, false);
+        return Unpack(words, rowcounts, rowdispls, rowwdispls);
+    }
+
+    BitMap GatherColBits(const std::vector<uint8_t> & flags) const
+    {
+        std::vector<uint64_t> words = Gather(Pack(flags).data(), (myelems+63)/64, colwords, colwdispls, true);
+        return Unpack(words, colcounts, coldispls, colwdispls);
+    }
+
+    /**
+     * out[i] = min of colkeys[j] over the neighbors j of my vertex i.
+     * With row thresholds, rows whose threshold is the identity are skipped and the scan of
+     * row i stops at the first key below rowthr[i]: out[i] < rowthr[i] is still exact.
+     */
+    std::vector<uint64_t> PullMin(const std::vector<uint64_t> & colkeys, const std::vector<uint64_t> * rowthr) const
+    {
+        const uint64_t inf = std::numeric_limits<uint64_t>::max();
+        std::vector<uint64_t> partial(lnrow, inf);
+#ifdef THREADED
+#pragma omp parallel for schedule(dynamic, 1024)
+#endif
+        for(IT i=0; i<lnrow; ++i)
+        {
+            uint64_t thr = rowthr ? (*rowthr)[i] : 0;	// no early exit without thresholds
+            if(rowthr && thr == inf) continue;
+            uint64_t best = inf;
+            for(IT k=rowptr[i]; k<rowptr[i+1]; ++k)
+            {
+                best = std::min(best, colkeys[colids[k]]);
+                if(best < thr) break;
+            }
+            partial[i] = best;
+        }
+        std::vector<uint64_t> out(myelems);
+        MPI_Reduce_scatter(partial.data(), out.data(), rowcounts.data(), MPIType<uint64_t>(), MPI_MIN, RowWorld);
+        return out;
+    }
+
+    //! out[i] = 1 if a neighbor of my vertex i is set in colbits; rows not set in rowbits (if given) are skipped
+    std::vector<uint8_t> PullReach(BitMap & colbits, BitMap * rowbits) const
+    {
+        std::vector<uint8_t> partial(lnrow, 0);
+#ifdef THREADED
+#pragma omp parallel for schedule(dynamic, 1024)
+#endif
+        for(IT i=0; i<lnrow; ++i)
+        {
+            if(rowbits && !rowbits->get_bit(i)) continue;
+            for(IT k=rowptr[i]; k<rowptr[i+1]; ++k)
+            {
+                if(colbits.get_bit(colids[k]))
+                {
+                    partial[i] = 1;
+                    break;
+                }
+            }
+        }
+        std::vector<uint8_t> out(myelems);
+        MPI_Reduce_scatter(partial.data(), out.data(), rowcounts.data(), MPIType<uint8_t>(), MPI_MAX, RowWorld);
+        return out;
+    }
+
+private:
+    static std::vector<int> Displacements(const std::vector<int> & counts)
+    {
+        std::vector<int> displs(counts.size(), 0);
+        std::partial_sum(counts.begin(), counts.end()-1, displs.begin()+1);
+        return displs;
+    }
+
+    static std::vector<int> Words(const std::vector<int> & counts)
+    {
+        std::vector<int> words(counts.size());
+        for(size_t k=0; k<counts.size(); ++k)
+            words[k] = (counts[k]+63)/64;
+        return words;
+    }
+
+    static std::vector<uint64_t> Pack(const std::vector<uint8_t> & flags)
+    {
+        std::vector<uint64_t> words((flags.size()+63)/64, 0);
+        for(size_t i=0; i<flags.size(); ++i)
+            if(flags[i]) words[i >> 6] |= (static_cast<uint64_t>(1) << (i & 63));
+        return words;
+    }
+
+    // every piece was packed separately, so its bits are shifted to the piece's offset in the block
+    static BitMap Unpack(const std::vector<uint64_t> & words, const std::vector<int> & counts, const std::vector<int> & displs, const std::vector<int> & wdispls)
+    {
+        BitMap bits(std::max(1, displs.back() + counts.back()));
+        for(size_t k=0; k<counts.size(); ++k)
+        {
+            for(int w=0; w<(counts[k]+63)/64; ++w)
+            {
+                uint64_t word = words[wdispls[k]+w];
+                while(word)
+                {
+                    int b = __builtin_ctzll(word);
+                    bits.set_bit(static_cast<uint64_t>(displs[k]) + 64*w + b);
+                    word &= word - 1;
+                }
+            }
+        }
+        return bits;
+    }
+
+    // the column block is gathered after exchanging with the diagonal neighbor (square grids)
+    template <typename T>
+    std::vector<T> Gather(const T * local, int mycount, const std::vector<int> & counts, const std::vector<int> & displs, bool cols) const
+    {
+        std::vector<T> block(displs.back() + counts.back());
+        if(cols)
+        {
+            int rank = colrank;
+            std::vector<T> trx(counts[rank]);
+            MPI_Sendrecv(local, mycount, MPIType<T>(), diagneigh, TRX, trx.data(), counts[rank], MPIType<T>(), diagneigh, TRX, World, MPI_STATUS_IGNORE);
+            MPI_Allgatherv(trx.data(), counts[rank], MPIType<T>(), block.data(), counts.data(), displs.data(), MPIType<T>(), ColWorld);
+        }
+        else
+        {
+            MPI_Allgatherv(local, mycount, MPIType<T>(), block.data(), counts.data(), displs.data(), MPIType<T>(), RowWorld);
+        }
+        return block;
+    }
+
+    MPI_Comm RowWorld, ColWorld, World;
+    int diagneigh, rowrank, colrank;
+    IT lnrow;
+    int myelems;
+    std::vector<IT> rowptr;
+    std::vector<IT> colids;
+    std::vector<int> rowcounts, rowdispls, colcounts, coldispls;
+    std::vector<int> rowwords, rowwdispls, colwords, colwdispls;
+};
+
+
+/**
+ * Luby-style maximal independent set (MIS), distance-2 MIS and MIS based greedy coloring of
+ * a structurally symmetric matrix (self loops are ignored).
+ * Rounds run pull-style on a local CSR copy, with dense key and bitmap frontiers, while more
+ * than n/pulldivisor vertices are candidates; smaller rounds use the sparse SpMV with a
+ * preallocated SPA. Both are built once, so an engine can serve several calls on the same
+ * matrix. The priority of a vertex in a round is a counter-based hash of (seed, round,
+ * vertex) with the vertex id in its low bits: keys are distinct and independent of the
+ * process count, hence so are the results.
+ * The pull path needs a square process grid; on other grids every round uses the SpMV.
+ */
+template <class IT, class NT, class DER>
+class MISEngine
+{
+public:
+    MISEngine(SpParMat<IT,NT,DER> & A, uint64_t seed = 1, IT pulldivisor = MISPULLDIVISOR)
+    : A(A), seed(seed), pulldivisor(pulldivisor), commGrid(A.getcommgrid()), glen(A.getnrow()), rounds(0), pullrounds(0)
+    {
+        if(A.getnrow() != A.getncol())
+        {
+            SpParHelper::Print("MISEngine needs a square (symmetric) matrix\n");
+            MPI_Abort(MPI_COMM_WORLD, NOTSQUARE);
+        }
+        FullyDistVec<IT, uint8_t> proto(commGrid, glen, 0);
+        mylen = proto.MyLocLength();
+        offset = proto.LengthUntil();
+        idbits = 1;
+        while(idbits < 63 && (static_cast<uint64_t>(1) << idbits) <= static_cast<uint64_t>(glen)) ++idbits;
+
+        int nthreads = 1;
+#ifdef THREADED
+#pragma omp parallel
+        {
+            nthreads = omp_get_num_threads();
+        }
+#endif
+        SPA.reset(new PreAllocatedSPA<uint64_t>(A.seq(), nthreads*4));
+        if(pulldivisor > 0 && commGrid->GetGridRows() == commGrid->GetGridCols())    // MISLocalRows::Gather pairs diagonal neighbors
+            local.reset(new MISLocalRows<IT>(A, mylen));
+    }
+
+    //! Maximal independent set; the values are the vertex ids
+    FullyDistSpVec<IT, IT> MIS()
+    {
+        std::vector<uint8_t> state(mylen, CANDIDATE);
+        Start();
+        Independent(state, 1);
+        return Members(state);
+    }
+
+    //! Maximal independent set of the distance-2 graph (A + A^2), e.g. for aggregation based coarsening
+    FullyDistSpVec<IT, IT> MIS2()
+    {
+        std::vector<uint8_t> state(mylen, CANDIDATE);
+        Start();
+        Independent(state, 2);
+        return Members(state);
+    }
+
+    /**
+     * Greedy coloring by successive independent sets: color c is a maximal independent set
+     * of the vertices left uncolored by colors 0..c-1. Returns the color of every vertex.
+     */
+    FullyDistVec<IT, IT> Color(IT & ncolors)
+    {
+        FullyDistVec<IT, IT> colors(commGrid, glen, (IT) -1);
+        IT * color = (IT*) colors.GetLocArr();
+        std::vector<uint8_t> state(mylen);
+        Start();
+        ncolors = 0;
+        while(true)
+        {
+            IT uncolored = 0;
+            for(IT i=0; i<mylen; ++i)
+            {
+                state[i] = (color[i] == -1) ? CANDIDATE : REMOVED;
+                uncolored += (color[i] == -1);
+            }
+            MPI_Allreduce(MPI_IN_PLACE, &uncolored, 1, MPIType<IT>(), MPI_SUM, commGrid->GetWorld());
+            if(uncolored == 0) break;
+            Independent(state, 1);
+            for(IT i=0; i<mylen; ++i)
+                if(state[i] == MEMBER) color[i] = ncolors;
+            ++ncolors;
+        }
+        return colors;
+    }
+
+    void SetSeed(uint64_t s) { seed = s; }
+    int64_t Rounds() const { return rounds; }		//!< rounds of the last call
+    int64_t PullRounds() const { return pullrounds; }	//!< of which pull-style
+
+private:
+    enum : uint8_t { CANDIDATE = 0, MEMBER = 1, REMOVED = 2 };
+
+    void Start()
+    {
+        round = 0;
+        rounds = 0;
+        pullrounds = 0;
+    }
+
+    uint64_t Key(IT i) const
+    {
+        uint64_t v = static_cast<uint64_t>(offset + i);
+        return (MISHash(seed, round, v) << idbits) | v;
+    }
+
+    // Luby rounds until no candidate is left; winners become members, candidates within hops of them are removed
+    void Independent(std::vector<uint8_t> & state, int hops)
+    {
+        const uint64_t inf = std::numeric_limits<uint64_t>::max();
+        std::vector<uint64_t> keys(mylen);
+        std::vector<uint8_t> cand(mylen), winners(mylen);
+        while(true)
+        {
+            IT ncand = 0;
+            for(IT i=0; i<mylen; ++i)
+            {
+                cand[i] = (state[i] == CANDIDATE);
+                keys[i] = cand[i] ? Key(i) : inf;
+                ncand += cand[i];
+            }
+            MPI_Allreduce(MPI_IN_PLACE, &ncand, 1, MPIType<IT>(), MPI_SUM, commGrid->GetWorld());
+            if(ncand == 0) break;
+            bool pull = (local != nullptr) && (ncand > glen / pulldivisor);
+
+            // equality only comes back to a vertex from itself (self loop or a 2-hop back edge)
+            std::vector<uint64_t> nbrmin = MinNeighbor(keys, pull, (hops == 1) ? &keys : nullptr);
+            if(hops == 2)
+            {
+                std::vector<uint64_t> nbrmin2 = MinNeighbor(nbrmin, pull, &keys);
+                for(IT i=0; i<mylen; ++i)
+                    nbrmin[i] = std::min(nbrmin[i], nbrmin2[i]);
+            }
+            for(IT i=0; i<mylen; ++i)
+                winners[i] = cand[i] && keys[i] <= nbrmin[i];
+
+            std::vector<uint8_t> reach = Reach(winners, pull, (hops == 1) ? &cand : nullptr);
+            if(hops == 2)
+            {
+                std::vector<uint8_t> reach2 = Reach(reach, pull, &cand);
+                for(IT i=0; i<mylen; ++i)
+                    reach[i] |= reach2[i];
+            }
+            for(IT i=0; i<mylen; ++i)
+            {
+                if(winners[i]) state[i] = MEMBER;
+                else if(cand[i] && reach[i]) state[i] = REMOVED;
+            }
+            ++round;
+            ++rounds;
+            if(pull) ++pullrounds;
+        }
+    }
+
+    // minimum key among the neighbors of every local vertex; thr enables early exits, see MISLocalRows::PullMin
+    std::vector<uint64_t> MinNeighbor(const std::vector<uint64_t> & keys, bool pull, const std::vector<uint64_t> * thr)
+    {
+        const uint64_t inf = std::numeric_limits<uint64_t>::max();
+        if(pull)
+        {
+            std::vector<uint64_t> colkeys = local->GatherCols(keys);
+            if(thr)
+            {
+                std::vector<uint64_t> rowthr = local->GatherRows(*thr);
+                return local->PullMin(colkeys, &rowthr);
+            }
+            return local->PullMin(colkeys, nullptr);
+        }
+        std::vector<IT> ind;
+        std::vector<uint64_t> num;
+        for(IT i=0; i<mylen; ++i)
+        {
+            if(keys[i] != inf)
+            {
+                ind.push_back(i);
+                num.push_back(keys[i]);
+            }
+        }
+        FullyDistSpVec<IT, uint64_t> x(commGrid, glen, ind, num, false, true);
+        FullyDistSpVec<IT, uint64_t> y(commGrid, glen);
+        SpMV<MISSelectMinSR<NT>>(A, x, y, false, *SPA);
+        std::vector<uint64_t> out(mylen, inf);
+        std::vector<IT> yind = y.GetLocalInd();
+        std::vector<uint64_t> ynum = y.GetLocalNum();
+        for(size_t k=0; k<yind.size(); ++k)
+            out[yind[k]] = ynum[k];
+        return out;
+    }
+
+    // flags the local vertices having a flagged neighbor; only the ones in check (all if null) are needed
+    std::vector<uint8_t> Reach(const std::vector<uint8_t> & flags, bool pull, const std::vector<uint8_t> * check)
+    {
+        if(pull)
+        {
+            BitMap colbits = local->GatherColBits(flags);
+            if(check)
+            {
+                BitMap rowbits = local->GatherRowBits(*check);
+                return local->PullReach(colbits, &rowbits);
+            }
+            return local->PullReach(colbits, nullptr);
+        }
+        std::vector<IT> ind;
+        for(IT i=0; i<mylen; ++i)
+            if(flags[i]) ind.push_back(i);
+        std::vector<uint64_t> num(ind.size(), 0);
+        FullyDistSpVec<IT, uint64_t> x(commGrid, glen, ind, num, false, true);
+        FullyDistSpVec<IT, uint64_t> y(commGrid, glen);
+        SpMV<MISSelectMinSR<NT>>(A, x, y, false, *SPA);
+        std::vector<uint8_t> out(mylen, 0);
+        std::vector<IT> yind = y.GetLocalInd();
+        for(size_t k=0; k<yind.size(); ++k)
+            out[yind[k]] = 1;
+        return out;
+    }
+
+    FullyDistSpVec<IT, IT> Members(const std::vector<uint8_t> & state) const
+    {
+        std::vector<IT> ind, num;
+        for(IT i=0; i<mylen; ++i)
+        {
+            if(state[i] == MEMBER)
+            {
+                ind.push_back(i);
+                num.push_back(offset + i);
+            }
+        }
+        return FullyDistSpVec<IT, IT>(commGrid, glen, ind, num, false, true);
+    }
+
+    SpParMat<IT,NT,DER> & A;
+    uint64_t seed;
+    IT pulldivisor;
+    std::shared_ptr<CommGrid> commGrid;
+    IT glen;
+    IT mylen;
+    IT offset;
+    int idbits;
+    uint64_t round;
+    int64_t rounds;
+    int64_t pullrounds;
+    std::unique_ptr< PreAllocatedSPA<uint64_t> > SPA;
+    std::unique_ptr< MISLocalRows<IT> > local;
+};
+
+}
+
+#endif
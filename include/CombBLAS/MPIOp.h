@@ -5,6 +5,7 @@
 #include <typeinfo>
 #include <map>
 #include <functional>
+#include <type_traits>
 #include <mpi.h>
 #include <stdint.h>
 #include "Operations.h"
@@ -59,6 +60,29 @@ public:
 extern MPIOpCache mpioc;	// global variable
 
 
+// MPIOpCommutes: whether a user defined Op may be applied to the operands in any order
+// Ops are not assumed to commute, so MPI reduces them in rank order unless this is specialized to true
+template <typename Op>
+struct MPIOpCommutes : std::false_type {};
+
+// SRingAdd: the addition of the semiring SR as a binary functor, so that MPIOp can turn it into an MPI_Op
+template <typename SR, typename T>
+struct SRingAdd
+{
+    T operator()(const T & arg1, const T & arg2) const
+    {
+        return SR::add(arg1, arg2);
+    }
+};
+
+// SRingAddCommutes: semiring addition commutes by definition
+// A "semiring" whose add keeps one of the operands (e.g. the second one) specializes this to false
+template <typename SR>
+struct SRingAddCommutes : std::true_type {};
+
+template <typename SR, typename T>
+struct MPIOpCommutes< SRingAdd<SR,T> > : SRingAddCommutes<SR> {};
+
 // MPIOp: A class that has a static op() function that takes no arguments and returns the corresponding MPI_Op
 // if and only if the given Op has a mapping to a valid MPI_Op
 // No concepts checking for the applicability of Op on the datatype T at the moment
@@ -84,7 +108,7 @@ struct MPIOp
         
         if (foundop == MPI_OP_NULL)
         {
-            MPI_Op_create(funcmpi, false, &foundop);
+            MPI_Op_create(funcmpi, MPIOpCommutes<Op>::value, &foundop);
           
             int myrank;
             MPI_Comm_rank(MPI_COMM_WORLD, &myrank);
@@ -97,6 +121,20 @@ struct MPIOp
     }
 };
 
+// SRingMPIOp: the MPI_Op that reduces values of type T with the addition of SR
+// Uses SR::mpi_op() when the semiring provides one, otherwise the MPI_Op is created from SR::add and cached
+template <typename SR, typename T, typename Enable = void>
+struct SRingMPIOp
+{
+    static MPI_Op op() { return MPIOp< SRingAdd<SR,T>, T >::op(); }
+};
+
+template <typename SR, typename T>
+struct SRingMPIOp< SR, T, decltype((void) SR::mpi_op()) >
+{
+    static MPI_Op op() { return SR::mpi_op(); }
+};
+
 template<typename T> struct MPIOp< maximum<T>,T,typename std::enable_if<std::is_pod<T>::value, void>::type > {  static MPI_Op op() { return MPI_MAX; } };
 template<typename T> struct MPIOp< minimum<T>,T,typename std::enable_if<std::is_pod<T>::value, void>::type > {  static MPI_Op op() { return MPI_MIN; } };
 template<typename T> struct MPIOp< std::plus<T>,T,typename std::enable_if<std::is_pod<T>::value, void>::type > {  static MPI_Op op() { return MPI_SUM; } };
@@ -34,6 +34,9 @@
 #include <list>
 #include <new>			// For "placement new" (classes using this memory pool may need it)
 #include <fstream>
+#include <vector>
+#include <cstddef>
+#include <type_traits>
 
 namespace combblas {
 
@@ -81,6 +84,78 @@ private:
 };
 
 
+
+/**
+  * Bump allocator for the scratch space of the threaded local kernels (SpGEMM heaps, hash tables, column indices)
+  * Every thread owns one arena (ScratchArena::Local()), so allocation is a pointer increment without any locking.
+  * Memory is only given back wholesale, by rewinding to an earlier mark; ArenaScope does that automatically.
+  * New blocks are first touched by the owning thread, which places their pages on that thread's NUMA node.
+  * \invariant blocks[0..cur) are full (or skipped), allocation happens at blocks[cur] + offset
+  */
+class ScratchArena
+{
+public:
+	struct Mark
+	{
+		size_t block;
+		size_t offset;
+	};
+
+	ScratchArena(size_t m_blocksize = DEFAULT_BLOCKSIZE);
+	~ScratchArena();
+
+	void * alloc(size_t size, size_t align = sizeof(double));
+
+	//! space for n default constructed objects of type T; rewinding never runs destructors, hence the assertion
+	template <typename T>
+	T * allocate(size_t n)
+	{
+		static_assert(std::is_trivially_destructible<T>::value, "ScratchArena only holds trivially destructible objects");
+		T * space = static_cast<T*>(alloc(n * sizeof(T), alignof(T)));
+		for(size_t i=0; i< n; ++i)
+			new (space + i) T;
+		return space;
+	}
+
+	Mark mark() const { Mark m = {cur, offset}; return m; }
+	void rewind(const Mark & m);	//!< frees everything allocated after m was taken
+	void reset() { Mark m = {0, 0}; rewind(m); }
+	void release();			//!< returns all blocks to the system
+	size_t capacity() const;
+
+	static ScratchArena & Local();	//!< the calling thread's arena
+
+private:
+	enum { DEFAULT_BLOCKSIZE = 1 << 20 };
+	struct Block
+	{
+		char * begin;
+		size_t size;
+	};
+	void NewBlock(size_t minsize);
+
+	ScratchArena(const ScratchArena &);		// non-copyable
+	ScratchArena & operator=(const ScratchArena &);
+
+	std::vector<Block> blocks;
+	size_t cur;
+	size_t offset;
+	size_t blocksize;
+};
+
+//! Rewinds the arena to where it was at construction, so nested kernels can share the arena of their thread
+class ArenaScope
+{
+public:
+	ArenaScope(ScratchArena & m_arena = ScratchArena::Local()): arena(m_arena), start(m_arena.mark()) {}
+	~ArenaScope() { arena.rewind(start); }
+	ScratchArena & get() { return arena; }
+
+private:
+	ScratchArena & arena;
+	ScratchArena::Mark start;
+};
+
 }
 
 #endif
@@ -459,6 +459,218 @@ SpTuples<IT, NT>* MultiwayMerge( std::vector<SpTuples<IT,NT> *> & ArrSpTups, IT
 }
 
 
+    /*
+     "Internal function" called by MultiwayMergeDcsc inside threaded region.
+     Merges the column range [startCol, endCol) of the input lists; lo[j] and hi[j] delimit that range in list j.
+     If out == NULL, only counts the merged nonzeros (nnz) and the nonempty columns (nzc) in this range.
+     Otherwise writes the merged entries straight into out->cp/jc/ir/numx, starting at offsets nnz and nzc.
+     Assumption: the input lists are column sorted, and row sorted within each column
+     */
+    template<class SR, class IT, class NT>
+    void SerialMergeDcsc( const std::vector<SpTuples<IT,NT> *> & ArrSpTups, const std::vector<IT> & lo, const std::vector<IT> & hi,
+                         Dcsc<IT,NT> * out, IT & nnz, IT & nzc)
+    {
+        int nlists =  ArrSpTups.size();
+        ColLexiCompare<IT,int> heapcomp;
+        std::vector<std::tuple<IT, IT, int>> heap(nlists);
+        std::vector<IT> curptr(lo);
+        IT hsize = 0;
+        for(int i=0; i< nlists; ++i)
+        {
+            if(curptr[i] < hi[i])
+                heap[hsize++] = std::make_tuple(ArrSpTups[i]->rowindex(curptr[i]), ArrSpTups[i]->colindex(curptr[i]), i);
+        }
+        std::make_heap(heap.data(), heap.data()+hsize, std::not2(heapcomp));
+        
+        IT cnz = nnz;      // write position in ir/numx
+        IT cnzc = nzc;     // write position in jc
+        IT lastrow = -1, lastcol = -1;
+        while(hsize > 0)
+        {
+            std::pop_heap(heap.data(), heap.data() + hsize, std::not2(heapcomp));   // result is stored in heap[hsize-1]
+            IT row = std::get<0>(heap[hsize-1]);
+            IT col = std::get<1>(heap[hsize-1]);
+            int source = std::get<2>(heap[hsize-1]);
+            
+            if(col != lastcol)   // a new nonempty column starts
+            {
+                if(out != NULL)
+                {
+                    out->jc[cnzc] = col;
+                    out->cp[cnzc] = cnz;
+                    out->ir[cnz] = row;
+                    out->numx[cnz] = ArrSpTups[source]->numvalue(curptr[source]);
+                }
+                ++cnzc;
+                ++cnz;
+            }
+            else if(row != lastrow)
+            {
+                if(out != NULL)
+                {
+                    out->ir[cnz] = row;
+                    out->numx[cnz] = ArrSpTups[source]->numvalue(curptr[source]);
+                }
+                ++cnz;
+            }
+            else if(out != NULL)   // duplicate entry
+            {
+                out->numx[cnz-1] = SR::add(out->numx[cnz-1], ArrSpTups[source]->numvalue(curptr[source]));
+            }
+            lastrow = row;
+            lastcol = col;
+            
+            if(++curptr[source] != hi[source])	// That array has not been depleted
+            {
+                heap[hsize-1] = std::make_tuple(ArrSpTups[source]->rowindex(curptr[source]), ArrSpTups[source]->colindex(curptr[source]), source);
+                std::push_heap(heap.data(), heap.data()+hsize, std::not2(heapcomp));
+            }
+            else
+            {
+                --hsize;
+            }
+        }
+        nnz = cnz;
+        nzc = cnzc;
+    }
+
+
+    // Performs a balanced merge of the array of SpTuples, directly into a preallocated Dcsc
+    // Column ranges are chosen so that each range holds about the same number of input nonzeros;
+    // a counting pass sizes every range, then each thread fills its part of cp/jc/ir/numx in place.
+    // Compared to MultiwayMerge, this saves the intermediate SpTuples copy of C and its serial conversion.
+    // Returns NULL if the merged matrix is empty (SpDCCols treats a NULL dcsc as an empty matrix)
+    template<class SR, class IT, class NT>
+    Dcsc<IT, NT>* MultiwayMergeDcsc( std::vector<SpTuples<IT,NT> *> & ArrSpTups, IT mdim = 0, IT ndim = 0, bool delarrs = false )
+    {
+        int nlists =  ArrSpTups.size();
+        for(int i=0; i< nlists; ++i)
+        {
+            if((mdim != ArrSpTups[i]->getnrow()) || ndim != ArrSpTups[i]->getncol())
+            {
+                std::cerr << "Dimensions of SpTuples do not match on multiwayMerge()" << std::endl;
+                return NULL;
+            }
+        }
+        
+        int nthreads = 1;
+#ifdef THREADED
+#pragma omp parallel
+        {
+            nthreads = omp_get_num_threads();
+        }
+#endif
+        int nsplits = 4*nthreads; // oversplit for load balance
+        nsplits = std::max(1, std::min(nsplits, (int)ndim)); // we cannot split a column
+        
+        // number of input tuples in columns [0, col)
+        ColLexiCompare<IT,NT> comp;
+        auto tuplesBefore = [&](int j, IT col)
+        {
+            std::tuple<IT,IT,NT> search_tuple(0, col, NT());
+            return static_cast<IT>(std::lower_bound(ArrSpTups[j]->tuples, ArrSpTups[j]->tuples + ArrSpTups[j]->getnnz(), search_tuple, comp) - ArrSpTups[j]->tuples);
+        };
+        IT inputnnz = 0;
+        for(int j=0; j< nlists; ++j)
+            inputnnz += ArrSpTups[j]->getnnz();
+        
+        // splitCols[k] is the first column of range k, found by bisection on the input nonzero count
+        std::vector<IT> splitCols(nsplits+1, ndim);
+        splitCols[0] = 0;
+#ifdef THREADED
+#pragma omp parallel for
+#endif
+        for(int k=1; k< nsplits; ++k)
+        {
+            IT target = (inputnnz / nsplits) * k;
+            IT left = 0, right = ndim;
+            while(left < right)
+            {
+                IT mid = left + (right-left)/2;
+                IT before = 0;
+                for(int j=0; j< nlists; ++j)
+                    before += tuplesBefore(j, mid);
+                if(before < target) left = mid+1;
+                else right = mid;
+            }
+            splitCols[k] = left;
+        }
+        
+        std::vector< std::vector<IT> > colPtrs(nsplits+1, std::vector<IT>(nlists));
+#ifdef THREADED
+#pragma omp parallel for
+#endif
+        for(int k=0; k<= nsplits; ++k)
+            for(int j=0; j< nlists; ++j)
+                colPtrs[k][j] = tuplesBefore(j, splitCols[k]);
+        
+        // ------ pass 1: count merged nonzeros and nonempty columns in each range ------
+        std::vector<IT> nnzPerSplit(nsplits+1, 0);
+        std::vector<IT> nzcPerSplit(nsplits+1, 0);
+#ifdef THREADED
+#pragma omp parallel for schedule(dynamic)
+#endif
+        for(int k=0; k< nsplits; ++k)
+        {
+            SerialMergeDcsc<SR>(ArrSpTups, colPtrs[k], colPtrs[k+1], static_cast<Dcsc<IT,NT>*>(NULL), nnzPerSplit[k+1], nzcPerSplit[k+1]);
+        }
+        std::partial_sum(nnzPerSplit.begin(), nnzPerSplit.end(), nnzPerSplit.begin());
+        std::partial_sum(nzcPerSplit.begin(), nzcPerSplit.end(), nzcPerSplit.begin());
+        IT mergedNnzAll = nnzPerSplit[nsplits];
+        IT mergedNzcAll = nzcPerSplit[nsplits];
+        
+        Dcsc<IT,NT> * merged = NULL;
+        if(mergedNnzAll > 0)
+        {
+            // ------ pass 2: fill the preallocated arrays, range by range ------
+            merged = new Dcsc<IT,NT>(mergedNnzAll, mergedNzcAll);
+#ifdef THREADED
+#pragma omp parallel for schedule(dynamic)
+#endif
+            for(int k=0; k< nsplits; ++k)
+            {
+                IT nnzoffset = nnzPerSplit[k];
+                IT nzcoffset = nzcPerSplit[k];
+                SerialMergeDcsc<SR>(ArrSpTups, colPtrs[k], colPtrs[k+1], merged, nnzoffset, nzcoffset);
+            }
+            merged->cp[mergedNzcAll] = mergedNnzAll;
+        }
+        
+        for(int i=0; i< nlists; i++)
+        {
+            if(delarrs)
+                delete ArrSpTups[i]; // May be expensive for large local matrices
+        }
+        return merged;
+    }
+
+
+    // Merges the array of SpTuples into the local storage format DER
+    // Formats other than SpDCCols are built from the merged SpTuples
+    template<class SR, class DER>
+    struct MultiwayMergeInto
+    {
+        template<class IT, class NT>
+        static DER * Merge( std::vector<SpTuples<IT,NT> *> & ArrSpTups, IT mdim, IT ndim, bool delarrs = false )
+        {
+            SpTuples<IT,NT> * merged_tuples = MultiwayMerge<SR>(ArrSpTups, mdim, ndim, delarrs);
+            DER * merged = new DER(*merged_tuples, false);
+            delete merged_tuples;
+            return merged;
+        }
+    };
+    
+    // SpDCCols is assembled directly from the merge, without the intermediate SpTuples
+    template<class SR, class IT, class NT>
+    struct MultiwayMergeInto< SR, SpDCCols<IT,NT> >
+    {
+        static SpDCCols<IT,NT> * Merge( std::vector<SpTuples<IT,NT> *> & ArrSpTups, IT mdim, IT ndim, bool delarrs = false )
+        {
+            return new SpDCCols<IT,NT>(mdim, ndim, MultiwayMergeDcsc<SR>(ArrSpTups, mdim, ndim, delarrs));
+        }
+    };
+
+
    
     // --------------------------------------------------------
     // Hash-based multiway merge
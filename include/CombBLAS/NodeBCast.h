@@ -0,0 +1,174 @@
+/****************************************************************/
+/* Parallel Combinatorial BLAS Library (for Graph Computations) */
+/* version 1.6 -------------------------------------------------*/
+/* date: 6/15/2017 ---------------------------------------------*/
+/* authors: Ariful Azad, Aydin Buluc  --------------------------*/
+/****************************************************************/
+/*
+ Copyright (c) 2010-2017, The Regents of the University of California
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+#ifndef _NODE_BCAST_H_
+#define _NODE_BCAST_H_
+
+#include <mpi.h>
+#include <vector>
+#include <cstddef>
+#include <cstring>
+#include "SpDefs.h"
+#include "MPIType.h"
+#include "dcsc.h"
+
+namespace combblas {
+
+/***************************************************************************
+ * Hierarchical broadcast of SUMMA panels along a processor row or column.
+ * The ranks of the 1D communicator that share a node hold a single copy of the
+ * panel in an MPI_Win_allocate_shared segment: the node leaders receive it over
+ * the network (the root copies it into its own node's segment first) and every
+ * other rank multiplies from a read-only view of the segment. Only SpDCCols
+ * panels are supported, since the view wraps the segment in a non-owning Dcsc.
+ ***************************************************************************/
+template <class DER>
+class NodeBCast
+{
+public:
+	typedef typename DER::LocalIT IT;
+	typedef typename DER::LocalNT NT;
+
+	//! Collective over comm1d; the hierarchy is only used if some node hosts more than one of its ranks
+	NodeBCast(MPI_Comm comm1d): world(comm1d), nodeWorld(MPI_COMM_NULL), leaderWorld(MPI_COMM_NULL), haswin(false), enabled(false)
+	{
+		MPI_Comm_rank(world, &myrank);
+		int nprocs;
+		MPI_Comm_size(world, &nprocs);
+		MPI_Comm_split_type(world, MPI_COMM_TYPE_SHARED, myrank, MPI_INFO_NULL, &nodeWorld);
+		int nodesize, maxnodesize;
+		MPI_Comm_rank(nodeWorld, &noderank);
+		MPI_Comm_size(nodeWorld, &nodesize);
+		MPI_Allreduce(&nodesize, &maxnodesize, 1, MPI_INT, MPI_MAX, world);
+		enabled = (maxnodesize > 1);
+		if(!enabled)
+		{
+			MPI_Comm_free(&nodeWorld);
+			return;
+		}
+		MPI_Comm_split(world, (noderank == 0)? 0 : MPI_UNDEFINED, myrank, &leaderWorld);
+		int leaderrank = -1;
+		if(noderank == 0)	MPI_Comm_rank(leaderWorld, &leaderrank);
+		MPI_Bcast(&leaderrank, 1, MPI_INT, 0, nodeWorld);	// the rank of our node's leader among the leaders
+		leaderOf.resize(nprocs);
+		MPI_Allgather(&leaderrank, 1, MPI_INT, leaderOf.data(), 1, MPI_INT, world);
+	}
+
+	~NodeBCast()
+	{
+		Release();
+		if(nodeWorld != MPI_COMM_NULL)	MPI_Comm_free(&nodeWorld);
+		if(leaderWorld != MPI_COMM_NULL)	MPI_Comm_free(&leaderWorld);
+	}
+
+	bool Enabled() const { return enabled; }
+
+	/**
+	 * Collective over comm1d. Returns own on the root; every other rank gets a new view of the root's panel 
+	 * that is valid until the next BCast or Release, and that the caller deletes (which leaves the segment alone).
+	 * @param[in] sizes essentials of every rank's panel, as filled by SpParHelper::GetSetSizes
+	 **/
+	template <typename SIT>
+	DER * BCast(DER * own, SIT ** sizes, int root)
+	{
+		Release();
+		IT nnz = static_cast<IT>(sizes[0][root]);
+		IT m = static_cast<IT>(sizes[1][root]);
+		IT n = static_cast<IT>(sizes[2][root]);
+		IT nzc = static_cast<IT>(sizes[3][root]);
+		if(nnz == 0)
+			return (myrank == root)? own : new DER(m, n, NULL);
+
+		size_t jcoff = sizeof(IT) * (nzc+1);
+		size_t iroff = jcoff + sizeof(IT) * nzc;
+		size_t numoff = Align(iroff + sizeof(IT) * nnz);
+		size_t bytes = numoff + sizeof(NT) * nnz;
+
+		char * segment;
+		MPI_Win_allocate_shared((noderank == 0)? bytes : 0, 1, MPI_INFO_NULL, nodeWorld, &segment, &win);
+		haswin = true;
+		MPI_Aint segsize;
+		int dispunit;
+		MPI_Win_shared_query(win, 0, &segsize, &dispunit, &segment);
+		IT * cp = reinterpret_cast<IT*>(segment);
+		IT * jc = reinterpret_cast<IT*>(segment + jcoff);
+		IT * ir = reinterpret_cast<IT*>(segment + iroff);
+		NT * numx = reinterpret_cast<NT*>(segment + numoff);
+
+		MPI_Win_fence(0, win);
+		if(myrank == root)
+		{
+			Dcsc<IT,NT> * dcsc = own->GetDCSC();
+			std::copy(dcsc->cp, dcsc->cp + nzc+1, cp);
+			std::copy(dcsc->jc, dcsc->jc + nzc, jc);
+			std::copy(dcsc->ir, dcsc->ir + nnz, ir);
+			std::copy(dcsc->numx, dcsc->numx + nnz, numx);
+		}
+		MPI_Win_fence(0, win);
+		if(leaderWorld != MPI_COMM_NULL)
+		{
+			int leaderroot = leaderOf[root];
+			MPI_Bcast(cp, nzc+1, MPIType<IT>(), leaderroot, leaderWorld);
+			MPI_Bcast(jc, nzc, MPIType<IT>(), leaderroot, leaderWorld);
+			MPI_Bcast(ir, nnz, MPIType<IT>(), leaderroot, leaderWorld);
+			MPI_Bcast(numx, nnz, MPIType<NT>(), leaderroot, leaderWorld);
+		}
+		MPI_Win_fence(0, win);
+		if(myrank == root)	return own;
+		return new DER(m, n, new Dcsc<IT,NT>(cp, jc, ir, numx, nnz, nzc, false));
+	}
+
+	//! Frees the current segment (collective over the node); all views of it must be deleted by now
+	void Release()
+	{
+		if(haswin)
+		{
+			MPI_Win_free(&win);
+			haswin = false;
+		}
+	}
+
+private:
+	static size_t Align(size_t offset)
+	{
+		const size_t a = alignof(std::max_align_t);
+		return (offset + a - 1) / a * a;
+	}
+
+	MPI_Comm world, nodeWorld, leaderWorld;	// leaderWorld is MPI_COMM_NULL on ranks that don't lead their node
+	std::vector<int> leaderOf;	// for every rank of world, the rank of its node's leader in leaderWorld
+	int myrank, noderank;
+	MPI_Win win;
+	bool haswin;
+	bool enabled;
+};
+
+}
+
+#endif
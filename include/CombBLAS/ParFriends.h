@@ -41,6 +41,9 @@
 #include "OptBuf.h"
 #include "mtSpGEMM.h"
 #include "MultiwayMerge.h"
+#include "FiberReduce.h"
+#include "NodeBCast.h"
+#include "DenseMultiVec.h"
 #include <unistd.h>
 #include <type_traits>
 
@@ -180,6 +183,22 @@ bool CheckSpGEMMCompliance(const MATRIXA & A, const MATRIXB & B)
 	return true;
 }	
 
+/**
+ * The SUMMA variants other than Mult_AnXBn_Synch pair the ith processor column of A with the ith processor row of B 
+ * at stage i, which is only meaningful on a square processor grid
+ **/
+template <typename MATRIX>
+void CheckSquareSUMMAGrid(const MATRIX & A, const std::string & caller)
+{
+	if(A.getcommgrid()->GetGridRows() != A.getcommgrid()->GetGridCols())
+	{
+		std::ostringstream outs;
+		outs << caller << " needs a square processor grid, use Mult_AnXBn_Synch on rectangular grids" << std::endl;
+		SpParHelper::Print(outs.str());
+		MPI_Abort(MPI_COMM_WORLD, GRIDMISMATCH);
+	}
+}
+
 
 // Combined logic for prune, recovery, and select
 template <typename IT, typename NT, typename DER>
@@ -440,13 +459,54 @@ IU EstimateFLOP
     return global_flops;
 }
 
+/**
+ * A plan for a sequence of SUMMA products whose operands keep their sparsity patterns while the values change
+ * (AMG re-setup, time stepping, iterative reweighting): the phase count of MemEfficientSpGEMM and one
+ * LocalSpGEMMPlan per phase and stage. Pass the same plan to every product of the sequence.
+ * A local plan whose operands changed structure rebuilds itself, but the phase count is kept until Clear()
+ **/
+template <typename LIT>
+class SpGEMMPlan
+{
+public:
+	SpGEMMPlan(): phases(0) {}
+
+	LocalSpGEMMPlan<LIT> * Local(int phase, int stage, int stages)
+	{
+		size_t index = static_cast<size_t>(phase) * stages + stage;
+		if(local.size() <= index)
+			local.resize(index+1);
+		return &(local[index]);
+	}
+
+	//! number of local products that skipped their symbolic phase
+	int64_t Reuses() const
+	{
+		int64_t reuses = 0;
+		for(const auto & lp : local)
+			reuses += lp.reuses;
+		return reuses;
+	}
+
+	void Clear()
+	{
+		phases = 0;
+		std::vector< LocalSpGEMMPlan<LIT> >().swap(local);
+	}
+
+	int phases;	// 0 until a product decides it
+	std::vector< LocalSpGEMMPlan<LIT> > local;
+};
+
 /**
  * Broadcasts A multiple times (#phases) in order to save storage in the output
  * Only uses 1/phases of C memory if the threshold/max limits are proper
+ * With a plan, the phase count and the local symbolic phases of an earlier call are reused (see SpGEMMPlan)
  */
 template <typename SR, typename NUO, typename UDERO, typename IU, typename NU1, typename NU2, typename UDERA, typename UDERB>
 SpParMat<IU,NUO,UDERO> MemEfficientSpGEMM (SpParMat<IU,NU1,UDERA> & A, SpParMat<IU,NU2,UDERB> & B,
-                                           int phases, NUO hardThreshold, IU selectNum, IU recoverNum, NUO recoverPct, int kselectVersion, int64_t perProcessMemory)
+                                           int phases, NUO hardThreshold, IU selectNum, IU recoverNum, NUO recoverPct, int kselectVersion, int64_t perProcessMemory,
+                                           SpGEMMPlan<typename UDERO::LocalIT> * plan = nullptr)
 {
     typedef typename UDERA::LocalIT LIA;
     typedef typename UDERB::LocalIT LIB;
@@ -463,6 +523,7 @@ SpParMat<IU,NUO,UDERO> MemEfficientSpGEMM (SpParMat<IU,NU1,UDERA> & A, SpParMat<
         MPI_Abort(MPI_COMM_WORLD, DIMMISMATCH);
         return SpParMat< IU,NUO,UDERO >();
     }
+    CheckSquareSUMMAGrid(A, "MemEfficientSpGEMM");
     if(phases <1 || phases >= A.getncol())
     {
         SpParHelper::Print("MemEfficientSpGEMM: The value of phases is too small or large. Resetting to 1.\n");
@@ -477,7 +538,11 @@ SpParMat<IU,NUO,UDERO> MemEfficientSpGEMM (SpParMat<IU,NU1,UDERA> & A, SpParMat<
     MPI_Barrier(A.getcommgrid()->GetWorld());
     t0 = MPI_Wtime();
 #endif
-    if(perProcessMemory>0) // estimate the number of phases permitted by memory
+    if(plan != nullptr && plan->phases > 0)
+    {
+        phases = plan->phases;  // decided by an earlier product, no symbolic pass
+    }
+    else if(perProcessMemory>0) // estimate the number of phases permitted by memory
     {
         int p;
         MPI_Comm World = GridC->GetWorld();
@@ -532,6 +597,8 @@ SpParMat<IU,NUO,UDERO> MemEfficientSpGEMM (SpParMat<IU,NU1,UDERA> & A, SpParMat<
         }
     }
 
+    if(plan != nullptr)
+        plan->phases = phases;
     if(myrank == 0){
         fprintf(stderr, "[MemEfficientSpGEMM] Running with phase: %d\n", phases);
     }
@@ -568,6 +635,8 @@ SpParMat<IU,NUO,UDERO> MemEfficientSpGEMM (SpParMat<IU,NU1,UDERA> & A, SpParMat<
     
     int Aself = (A.commGrid)->GetRankInProcRow();
     int Bself = (B.commGrid)->GetRankInProcCol();
+    NodeBCast<UDERA> Abcast(GridC->GetRowWorld());	// ranks sharing a node share the received panels
+    NodeBCast<UDERB> Bbcast(GridC->GetColWorld());
 
     for(int dbg = 0; dbg < 1; dbg++){
     for(int p = 0; p< phases; ++p)
@@ -578,7 +647,7 @@ SpParMat<IU,NUO,UDERO> MemEfficientSpGEMM (SpParMat<IU,NU1,UDERA> & A, SpParMat<
         {
             std::vector<LIA> ess;
             if(i == Aself)  ARecv = A.spSeq;	// shallow-copy
-            else
+            else if(!Abcast.Enabled())
             {
                 ess.resize(UDERA::esscount);
                 for(int j=0; j< UDERA::esscount; ++j)
@@ -590,7 +659,10 @@ SpParMat<IU,NUO,UDERO> MemEfficientSpGEMM (SpParMat<IU,NU1,UDERA> & A, SpParMat<
             MPI_Barrier(A.getcommgrid()->GetWorld());
             t0 = MPI_Wtime();
 #endif
-            SpParHelper::BCastMatrix(GridC->GetRowWorld(), *ARecv, ess, i);	// then, receive its elements
+            if(Abcast.Enabled())
+                ARecv = Abcast.BCast(A.spSeq, ARecvSizes, i);
+            else
+                SpParHelper::BCastMatrix(GridC->GetRowWorld(), *ARecv, ess, i);	// then, receive its elements
 #ifdef TIMING
             MPI_Barrier(A.getcommgrid()->GetWorld());
             t1 = MPI_Wtime();
@@ -599,7 +671,7 @@ SpParMat<IU,NUO,UDERO> MemEfficientSpGEMM (SpParMat<IU,NU1,UDERA> & A, SpParMat<
             ess.clear();
 
             if(i == Bself)  BRecv = &(PiecesOfB[p]);	// shallow-copy
-            else
+            else if(!Bbcast.Enabled())
             {
                 ess.resize(UDERB::esscount);
                 for(int j=0; j< UDERB::esscount; ++j)
@@ -610,7 +682,10 @@ SpParMat<IU,NUO,UDERO> MemEfficientSpGEMM (SpParMat<IU,NU1,UDERA> & A, SpParMat<
             MPI_Barrier(A.getcommgrid()->GetWorld());
             double t2=MPI_Wtime();
 #endif
-            SpParHelper::BCastMatrix(GridC->GetColWorld(), *BRecv, ess, i);	// then, receive its elements
+            if(Bbcast.Enabled())
+                BRecv = Bbcast.BCast(&(PiecesOfB[p]), BRecvSizes, i);
+            else
+                SpParHelper::BCastMatrix(GridC->GetColWorld(), *BRecv, ess, i);	// then, receive its elements
 #ifdef TIMING
             MPI_Barrier(A.getcommgrid()->GetWorld());
             double t3=MPI_Wtime();
@@ -623,7 +698,8 @@ SpParMat<IU,NUO,UDERO> MemEfficientSpGEMM (SpParMat<IU,NU1,UDERA> & A, SpParMat<
             double t4=MPI_Wtime();
 #endif
             double vm_usage, resident_set;
-            SpTuples<LIC,NUO> * C_cont = LocalHybridSpGEMM<SR, NUO>(*ARecv, *BRecv,i != Aself, i != Bself);
+            LocalSpGEMMPlan<LIC> * localplan = (plan != nullptr) ? plan->Local(p, i, stages) : nullptr;
+            SpTuples<LIC,NUO> * C_cont = LocalHybridSpGEMM<SR, NUO>(*ARecv, *BRecv,i != Aself, i != Bself, static_cast<LIC*>(nullptr), localplan);
 
 #ifdef TIMING
             MPI_Barrier(A.getcommgrid()->GetWorld());
@@ -660,13 +736,12 @@ SpParMat<IU,NUO,UDERO> MemEfficientSpGEMM (SpParMat<IU,NU1,UDERA> & A, SpParMat<
         MPI_Barrier(A.getcommgrid()->GetWorld());
         double t6=MPI_Wtime();
 #endif
-        //UDERO OnePieceOfC(MergeAll<SR>(tomerge, C_m, PiecesOfB[p].getncol(),true), false);
-        // TODO: MultiwayMerge can directly return UDERO inorder to avoid the extra copy
-        SpTuples<LIC,NUO> * OnePieceOfC_tuples = MultiwayMerge<SR>(tomerge, C_m, PiecesOfB[p].getncol(),true);
+        // merges straight into DCSC when UDERO is SpDCCols, avoiding the extra SpTuples copy
+        UDERO * OnePieceOfC = MultiwayMergeInto<SR,UDERO>::Merge(tomerge, C_m, PiecesOfB[p].getncol(), true);
         
 #ifdef SHOW_MEMORY_USAGE
         int64_t gcnnz_merged, lcnnz_merged ;
-        lcnnz_merged = OnePieceOfC_tuples->getnnz();
+        lcnnz_merged = OnePieceOfC->getnnz();
         MPI_Allreduce(&lcnnz_merged, &gcnnz_merged, 1, MPIType<int64_t>(), MPI_MAX, MPI_COMM_WORLD);
        
         // TODO: we can remove gcnnz_merged memory here because we don't need to concatenate anymore
@@ -687,9 +762,6 @@ SpParMat<IU,NUO,UDERO> MemEfficientSpGEMM (SpParMat<IU,NU1,UDERA> & A, SpParMat<
         double t7=MPI_Wtime();
         mcl_multiwaymergetime += (t7-t6);
 #endif
-        UDERO * OnePieceOfC = new UDERO(* OnePieceOfC_tuples, false);
-        delete OnePieceOfC_tuples;
-        
         SpParMat<IU,NUO,UDERO> OnePieceOfC_mat(OnePieceOfC, GridC);
         MCLPruneRecoverySelect(OnePieceOfC_mat, hardThreshold, selectNum, recoverNum, recoverPct, kselectVersion);
         //mcl_nnzc += OnePieceOfC_mat.getnnz();
@@ -736,9 +808,12 @@ SpParMat<IU,NUO,UDERO> MemEfficientSpGEMM (SpParMat<IU,NU1,UDERA> & A, SpParMat<
 
 template <typename SR, typename NUO, typename UDERO, typename IU, typename NU1, typename NU2, typename UDERA, typename UDERB>
 int CalculateNumberOfPhases (SpParMat<IU,NU1,UDERA> & A, SpParMat<IU,NU2,UDERB> & B,
-        NUO hardThreshold, IU selectNum, IU recoverNum, NUO recoverPct, int kselectVersion, int64_t perProcessMemory){
+        NUO hardThreshold, IU selectNum, IU recoverNum, NUO recoverPct, int kselectVersion, int64_t perProcessMemory,
+        SpGEMMPlan<typename UDERO::LocalIT> * plan = nullptr){
     
     int phases;
+    if(plan != nullptr && plan->phases > 0)
+        return plan->phases;
 
     typedef typename UDERA::LocalIT LIA;
     typedef typename UDERB::LocalIT LIB;
@@ -746,6 +821,7 @@ int CalculateNumberOfPhases (SpParMat<IU,NU1,UDERA> & A, SpParMat<IU,NU2,UDERB>
     
     int myrank;
     MPI_Comm_rank(MPI_COMM_WORLD,&myrank);
+    CheckSquareSUMMAGrid(A, "CalculateNumberOfPhases");
     
     int stages, dummy; 	// last two parameters of ProductGrid are ignored for Synch multiplication
     std::shared_ptr<CommGrid> GridC = ProductGrid((A.commGrid).get(), (B.commGrid).get(), stages, dummy, dummy);
@@ -788,6 +864,8 @@ int CalculateNumberOfPhases (SpParMat<IU,NU1,UDERA> & A, SpParMat<IU,NU2,UDERB>
         //phases = 1 + (asquareMem+kselectmem) / remainingMem;
     //}
     phases = 1 + asquareMem / remainingMem;
+    if(plan != nullptr)
+        plan->phases = phases;
     return phases;
 }
 
@@ -809,6 +887,7 @@ SpParMat<IU,NUO,UDERO> Mult_AnXBn_DoubleBuff
 	{
 		return SpParMat< IU,NUO,UDERO >();
 	}
+	CheckSquareSUMMAGrid(A, "Mult_AnXBn_DoubleBuff");
 	typedef typename UDERA::LocalIT LIA;
     	typedef typename UDERB::LocalIT LIB;
 	typedef typename UDERO::LocalIT LIC;
@@ -1051,14 +1130,162 @@ void process_mem_usage(double& vm_usage, double& resident_set)
 
 
 
+/**
+ * Columns [lo,hi) of a local block (or its rows [lo,hi) if rows is true) as a new block, with indices rebased to zero
+ **/
+template <typename DER>
+DER * LocalBlockSlice(const DER & M, typename DER::LocalIT lo, typename DER::LocalIT hi, bool rows)
+{
+	typedef typename DER::LocalIT LIT;
+	typedef typename DER::LocalNT LNT;
+	SpTuples<LIT,LNT> tuples(M);
+	LIT nnz = tuples.getnnz();
+	std::tuple<LIT,LIT,LNT> * kept = new std::tuple<LIT,LIT,LNT>[nnz];
+	LIT cnt = 0;
+	for(LIT i=0; i< nnz; ++i)
+	{
+		LIT key = rows? tuples.rowindex(i) : tuples.colindex(i);
+		if(key >= lo && key < hi)
+		{
+			if(rows)	kept[cnt++] = std::make_tuple(tuples.rowindex(i)-lo, tuples.colindex(i), tuples.numvalue(i));
+			else		kept[cnt++] = std::make_tuple(tuples.rowindex(i), tuples.colindex(i)-lo, tuples.numvalue(i));
+		}
+	}
+	SpTuples<LIT,LNT> sliced(cnt, rows? (hi-lo) : M.getnrow(), rows? M.getncol() : (hi-lo), kept);	// sliced owns kept
+	return new DER(sliced, false);
+}
+
+/**
+ * SUMMA on a rectangular pr x pc grid, called by Mult_AnXBn_Synch
+ * The inner dimension of A is cut into pc column blocks but that of B is cut into pr row blocks, 
+ * so the stages are the intervals between the union of both sets of boundaries (at most pr+pc-1 of them).
+ * A block is broadcast once when its owner changes and the slice of it that falls into the stage is multiplied
+ **/
+template <typename SR, typename NUO, typename UDERO, typename IU, typename NU1, typename NU2, typename UDERA, typename UDERB> 
+SpParMat<IU, NUO, UDERO> Mult_AnXBn_RectGrid
+		(SpParMat<IU,NU1,UDERA> & A, SpParMat<IU,NU2,UDERB> & B, bool clearA, bool clearB)
+{
+	int stages, dummy; 	// last two parameters of ProductGrid are ignored for Synch multiplication
+	std::shared_ptr<CommGrid> GridC = ProductGrid((A.commGrid).get(), (B.commGrid).get(), stages, dummy, dummy);		
+	int pr = GridC->GetGridRows();
+	int pc = GridC->GetGridCols();
+	typedef typename UDERA::LocalIT LIA;
+	typedef typename UDERB::LocalIT LIB;
+	typedef typename UDERO::LocalIT LIC;
+	static_assert(std::is_same<LIA, LIB>::value, "local index types for both input matrices should be the same");
+	static_assert(std::is_same<LIA, LIC>::value, "local index types for input and output matrices should be the same");
+	LIC C_m = A.spSeq->getnrow();
+	LIC C_n = B.spSeq->getncol();
+	IU kdim = A.getncol();
+
+	LIA ** ARecvSizes = SpHelper::allocate2D<LIA>(UDERA::esscount, pc);
+	LIB ** BRecvSizes = SpHelper::allocate2D<LIB>(UDERB::esscount, pr);
+	SpParHelper::GetSetSizes( *(A.spSeq), ARecvSizes, (A.commGrid)->GetRowWorld());
+	SpParHelper::GetSetSizes( *(B.spSeq), BRecvSizes, (B.commGrid)->GetColWorld());
+
+	IU aperblock = kdim / pc;	// column blocks of A
+	IU bperblock = kdim / pr;	// row blocks of B
+	std::vector<IU> cuts;
+	for(int j=0; j< pc; ++j)	cuts.push_back(aperblock * j);
+	for(int i=0; i< pr; ++i)	cuts.push_back(bperblock * i);
+	cuts.push_back(kdim);
+	std::sort(cuts.begin(), cuts.end());
+	cuts.erase(std::unique(cuts.begin(), cuts.end()), cuts.end());
+
+	int Aself = (A.commGrid)->GetRankInProcRow();
+	int Bself = (B.commGrid)->GetRankInProcCol();	
+	int Aowner = -1, Bowner = -1;
+	UDERA * ARecv = NULL; 
+	UDERB * BRecv = NULL;
+	std::vector< SpTuples<LIC,NUO>  *> tomerge;
+	for(size_t s = 0; s+1 < cuts.size(); ++s)
+	{
+		IU lo = cuts[s];
+		IU hi = cuts[s+1];
+		int Ablock = (aperblock != 0)? std::min(static_cast<int>(lo / aperblock), pc-1) : (pc-1);
+		int Bblock = (bperblock != 0)? std::min(static_cast<int>(lo / bperblock), pr-1) : (pr-1);
+		if(Ablock != Aowner)
+		{
+			if(ARecv != NULL && Aowner != Aself)	delete ARecv;
+			std::vector<LIA> ess;	
+			if(Ablock == Aself)	
+			{
+				ARecv = A.spSeq;
+			}
+			else
+			{
+				ess.resize(UDERA::esscount);
+				for(int j=0; j< UDERA::esscount; ++j)	
+					ess[j] = ARecvSizes[j][Ablock];
+				ARecv = new UDERA();
+			}
+			SpParHelper::BCastMatrix(GridC->GetRowWorld(), *ARecv, ess, Ablock);
+			Aowner = Ablock;
+		}
+		if(Bblock != Bowner)
+		{
+			if(BRecv != NULL && Bowner != Bself)	delete BRecv;
+			std::vector<LIB> ess;	
+			if(Bblock == Bself)	
+			{
+				BRecv = B.spSeq;
+			}
+			else
+			{
+				ess.resize(UDERB::esscount);
+				for(int j=0; j< UDERB::esscount; ++j)	
+					ess[j] = BRecvSizes[j][Bblock];
+				BRecv = new UDERB();
+			}
+			SpParHelper::BCastMatrix(GridC->GetColWorld(), *BRecv, ess, Bblock);
+			Bowner = Bblock;
+		}
+		LIA Alo = static_cast<LIA>(lo - aperblock * Ablock);
+		LIB Blo = static_cast<LIB>(lo - bperblock * Bblock);
+		bool Awhole = (Alo == 0 && hi-lo == ARecv->getncol());
+		bool Bwhole = (Blo == 0 && hi-lo == BRecv->getnrow());
+		UDERA * Aslice = Awhole? ARecv : LocalBlockSlice(*ARecv, Alo, static_cast<LIA>(Alo + (hi-lo)), false);
+		UDERB * Bslice = Bwhole? BRecv : LocalBlockSlice(*BRecv, Blo, static_cast<LIB>(Blo + (hi-lo)), true);
+
+		SpTuples<LIC,NUO> * C_cont = LocalHybridSpGEMM<SR, NUO>(*Aslice, *Bslice, false, false);
+		if(!Awhole)	delete Aslice;
+		if(!Bwhole)	delete Bslice;
+		if(!C_cont->isZero()) 
+			tomerge.push_back(C_cont);
+		else
+			delete C_cont;
+	}
+	if(ARecv != NULL && Aowner != Aself)	delete ARecv;
+	if(BRecv != NULL && Bowner != Bself)	delete BRecv;
+
+	if(clearA && A.spSeq != NULL) 
+	{	
+		delete A.spSeq;
+		A.spSeq = NULL;
+	}	
+	if(clearB && B.spSeq != NULL) 
+	{
+		delete B.spSeq;
+		B.spSeq = NULL;
+	}
+	SpHelper::deallocate2D(ARecvSizes, UDERA::esscount);
+	SpHelper::deallocate2D(BRecvSizes, UDERB::esscount);
+
+	UDERO * C = MultiwayMergeInto<SR,UDERO>::Merge(tomerge, C_m, C_n, true);
+	return SpParMat<IU,NUO,UDERO> (C, GridC);
+}
+
 /**
  * Parallel A = B*C routine that uses only MPI-1 features
  * Relies on simple blocking broadcast
+ * Works on rectangular processor grids as well (see Mult_AnXBn_RectGrid)
+ * A plan makes repeated products with the same sparsity patterns skip the local symbolic phases (square grids only)
  * @pre { Input matrices, A and B, should not alias }
  **/  
 template <typename SR, typename NUO, typename UDERO, typename IU, typename NU1, typename NU2, typename UDERA, typename UDERB> 
 SpParMat<IU, NUO, UDERO> Mult_AnXBn_Synch 
-		(SpParMat<IU,NU1,UDERA> & A, SpParMat<IU,NU2,UDERB> & B, bool clearA = false, bool clearB = false )
+		(SpParMat<IU,NU1,UDERA> & A, SpParMat<IU,NU2,UDERB> & B, bool clearA = false, bool clearB = false,
+		 SpGEMMPlan<typename UDERA::LocalIT> * plan = nullptr)
 
 {
     int myrank;
@@ -1067,15 +1294,22 @@ SpParMat<IU, NUO, UDERO> Mult_AnXBn_Synch
 	{
 		return SpParMat< IU,NUO,UDERO >();
 	}
+	if(A.commGrid->GetGridRows() != A.commGrid->GetGridCols())
+		return Mult_AnXBn_RectGrid<SR, NUO, UDERO>(A, B, clearA, clearB);
 	int stages, dummy; 	// last two parameters of ProductGrid are ignored for Synch multiplication
 	std::shared_ptr<CommGrid> GridC = ProductGrid((A.commGrid).get(), (B.commGrid).get(), stages, dummy, dummy);		
-	IU C_m = A.spSeq->getnrow();
-	IU C_n = B.spSeq->getncol();
+	typedef typename UDERA::LocalIT LIA;
+	typedef typename UDERB::LocalIT LIB;
+	typedef typename UDERO::LocalIT LIC;
+	static_assert(std::is_same<LIA, LIB>::value, "local index types for both input matrices should be the same");
+	static_assert(std::is_same<LIA, LIC>::value, "local index types for input and output matrices should be the same");
+	LIC C_m = A.spSeq->getnrow();
+	LIC C_n = B.spSeq->getncol();
 	
 	//const_cast< UDERB* >(B.spSeq)->Transpose(); // do not transpose for colum-by-column multiplication
 
-	IU ** ARecvSizes = SpHelper::allocate2D<IU>(UDERA::esscount, stages);
-	IU ** BRecvSizes = SpHelper::allocate2D<IU>(UDERB::esscount, stages);
+	LIA ** ARecvSizes = SpHelper::allocate2D<LIA>(UDERA::esscount, stages);
+	LIB ** BRecvSizes = SpHelper::allocate2D<LIB>(UDERB::esscount, stages);
 	
 	SpParHelper::GetSetSizes( *(A.spSeq), ARecvSizes, (A.commGrid)->GetRowWorld());
 	SpParHelper::GetSetSizes( *(B.spSeq), BRecvSizes, (B.commGrid)->GetColWorld());
@@ -1083,10 +1317,12 @@ SpParMat<IU, NUO, UDERO> Mult_AnXBn_Synch
 	// Remotely fetched matrices are stored as pointers
 	UDERA * ARecv; 
 	UDERB * BRecv;
-	std::vector< SpTuples<IU,NUO>  *> tomerge;
+	std::vector< SpTuples<LIC,NUO>  *> tomerge;
 
 	int Aself = (A.commGrid)->GetRankInProcRow();
 	int Bself = (B.commGrid)->GetRankInProcCol();	
+	NodeBCast<UDERA> Abcast(GridC->GetRowWorld());	// ranks sharing a node share the received panels
+	NodeBCast<UDERB> Bbcast(GridC->GetColWorld());
 
     double Abcast_time = 0;
     double Bbcast_time = 0;
@@ -1094,12 +1330,12 @@ SpParMat<IU, NUO, UDERO> Mult_AnXBn_Synch
 	
 	for(int i = 0; i < stages; ++i) 
 	{
-		std::vector<IU> ess;	
+		std::vector<LIA> ess;	
 		if(i == Aself)
 		{	
 			ARecv = A.spSeq;	// shallow-copy 
 		}
-		else
+		else if(!Abcast.Enabled())
 		{
 			ess.resize(UDERA::esscount);
 			for(int j=0; j< UDERA::esscount; ++j)	
@@ -1112,7 +1348,10 @@ SpParMat<IU, NUO, UDERO> Mult_AnXBn_Synch
         MPI_Barrier(A.getcommgrid()->GetWorld());
         double t0 = MPI_Wtime();
 #endif
-		SpParHelper::BCastMatrix(GridC->GetRowWorld(), *ARecv, ess, i);	// then, receive its elements	
+		if(Abcast.Enabled())
+			ARecv = Abcast.BCast(A.spSeq, ARecvSizes, i);
+		else
+			SpParHelper::BCastMatrix(GridC->GetRowWorld(), *ARecv, ess, i);	// then, receive its elements	
 #ifdef TIMING
         MPI_Barrier(A.getcommgrid()->GetWorld());
         double t1 = MPI_Wtime();
@@ -1125,7 +1364,7 @@ SpParMat<IU, NUO, UDERO> Mult_AnXBn_Synch
 		{
 			BRecv = B.spSeq;	// shallow-copy
 		}
-		else
+		else if(!Bbcast.Enabled())
 		{
 			ess.resize(UDERB::esscount);		
 			for(int j=0; j< UDERB::esscount; ++j)	
@@ -1138,7 +1377,10 @@ SpParMat<IU, NUO, UDERO> Mult_AnXBn_Synch
         MPI_Barrier(A.getcommgrid()->GetWorld());
 		double t2 = MPI_Wtime();
 #endif
-		SpParHelper::BCastMatrix(GridC->GetColWorld(), *BRecv, ess, i);	// then, receive its elements
+		if(Bbcast.Enabled())
+			BRecv = Bbcast.BCast(B.spSeq, BRecvSizes, i);
+		else
+			SpParHelper::BCastMatrix(GridC->GetColWorld(), *BRecv, ess, i);	// then, receive its elements
 #ifdef TIMING
         MPI_Barrier(A.getcommgrid()->GetWorld());
 		double t3 = MPI_Wtime();
@@ -1150,10 +1392,11 @@ SpParMat<IU, NUO, UDERO> Mult_AnXBn_Synch
         MPI_Barrier(A.getcommgrid()->GetWorld());
         double t4 = MPI_Wtime();
 #endif
-		SpTuples<IU,NUO> * C_cont = LocalHybridSpGEMM<SR, NUO>
+		SpTuples<LIC,NUO> * C_cont = LocalHybridSpGEMM<SR, NUO>
 						(*ARecv, *BRecv, // parameters themselves
 						i != Aself, 	// 'delete A' condition
-						i != Bself);	// 'delete B' condition
+						i != Bself,	// 'delete B' condition
+						static_cast<LIA*>(nullptr), (plan != nullptr) ? plan->Local(0, i, stages) : nullptr);
 #ifdef TIMING
         MPI_Barrier(A.getcommgrid()->GetWorld());
         double t5 = MPI_Wtime();
@@ -1192,15 +1435,12 @@ SpParMat<IU, NUO, UDERO> Mult_AnXBn_Synch
     MPI_Barrier(A.getcommgrid()->GetWorld());
 	double t0 = MPI_Wtime();
 #endif
-	SpTuples<IU,NUO> * C_tuples = MultiwayMerge<SR>(tomerge, C_m, C_n,true);
+	UDERO * C = MultiwayMergeInto<SR,UDERO>::Merge(tomerge, C_m, C_n, true);	// merges straight into DCSC when UDERO is SpDCCols
 #ifdef TIMING
     MPI_Barrier(A.getcommgrid()->GetWorld());
 	double t1 = MPI_Wtime();
     mcl3d_SUMMAmergetime += (t1-t0);
 #endif
-	
-    UDERO * C = new UDERO(*C_tuples, false);
-    delete C_tuples;
 
 	//if(!clearB)
 	//	const_cast< UDERB* >(B.spSeq)->Transpose();	// transpose back to original
@@ -1215,6 +1455,298 @@ SpParMat<IU, NUO, UDERO> Mult_AnXBn_Synch
 
 	return SpParMat<IU,NUO,UDERO> (C, GridC);		// return the result object
 }
+
+//! A local block built from (row, column, value) triples that are unique but in no particular order
+template <typename DER, typename LIT, typename NT>
+DER * LocalFromTuples(const std::vector< std::tuple<LIT,LIT,NT> > & triples, LIT m, LIT n)
+{
+	std::tuple<LIT,LIT,NT> * copied = new std::tuple<LIT,LIT,NT>[triples.size()];
+	std::copy(triples.begin(), triples.end(), copied);
+	SpTuples<LIT,NT> tuples(static_cast<int64_t>(triples.size()), m, n, copied);	// takes ownership of copied
+	tuples.SortColBased();
+	return new DER(tuples, false);
+}
+
+/**
+ * Galerkin triple product C = R'*A*R, the coarse operator of AMG, without forming all of A*R or the transpose of R
+ * The columns of R are processed in phases: the strip X = A*R(:,phase) is formed by SUMMA, transposed locally,
+ * broadcast along the processor rows and multiplied by the local blocks of R, and the partial products are summed
+ * along the processor columns. The sums land as the local blocks of C', so C' is transposed at the end, which moves
+ * a coarse matrix only. SR has to multiply the output type with that of R for the second product.
+ * If A is symmetric, so is C, and each phase only multiplies by the columns of R in the same or later phases;
+ * the block triangle that is skipped is the transpose of the computed strict block triangle, which completes C.
+ * Needs a square processor grid, like the other SUMMA variants that pair processor rows and columns
+ **/
+template <typename SR, typename NUO, typename UDERO, typename IU, typename NU1, typename NU2, typename UDERA, typename UDERB>
+SpParMat<IU, NUO, UDERO> GalerkinProduct
+		(SpParMat<IU,NU1,UDERA> & A, SpParMat<IU,NU2,UDERB> & R, int phases = 1, bool symmetric = false)
+{
+	typedef typename UDERO::LocalIT LIT;
+	if(!CheckSpGEMMCompliance(A,R) )
+	{
+		return SpParMat< IU,NUO,UDERO >();
+	}
+	CheckSquareSUMMAGrid(A, "GalerkinProduct");
+	std::shared_ptr<CommGrid> grid = R.getcommgrid();
+	MPI_Comm RowWorld = grid->GetRowWorld();
+	MPI_Comm ColWorld = grid->GetColWorld();
+	int gridcols = grid->GetGridCols();
+	int myrow = grid->GetRankInProcCol();
+	int mycol = grid->GetRankInProcRow();
+
+	// the column blocks of R along the processor row, which are also the row blocks of C'
+	std::vector<LIT> blockcols(gridcols);
+	LIT mycols = R.getlocalcols();
+	MPI_Allgather(&mycols, 1, MPIType<LIT>(), blockcols.data(), 1, MPIType<LIT>(), RowWorld);
+	LIT fewest = *std::min_element(blockcols.begin(), blockcols.end());
+	MPI_Allreduce(MPI_IN_PLACE, &fewest, 1, MPIType<LIT>(), MPI_MIN, grid->GetWorld());
+	phases = static_cast<int>(std::max<LIT>(1, std::min<LIT>(static_cast<LIT>(phases), fewest)));	// ColSplit cuts at most once per column
+	auto phaseof = [phases](LIT index, LIT blocklen) { return std::min(static_cast<int>(index / (blocklen / phases)), phases-1); };
+
+	UDERB Rcopy(*(R.seqptr()));
+	std::vector<UDERB> Rpieces;	// the phases of the local block of R, the same cuts as ColSplit makes in every block
+	Rcopy.ColSplit(phases, Rpieces);
+
+	MPI_Datatype MPI_triple;
+	MPI_Type_contiguous(sizeof(std::tuple<LIT,LIT,NUO>), MPI_CHAR, &MPI_triple);
+	MPI_Type_commit(&MPI_triple);
+
+	std::vector< std::tuple<LIT,LIT,NUO> > mine;	// the local block of C', phase after phase
+	for(int p = 0; p < phases; ++p)
+	{
+		SpParMat<IU,NU2,UDERB> Rp(new UDERB(Rpieces[p]), grid);
+		SpParMat<IU,NUO,UDERO> X = Mult_AnXBn_Synch<SR, NUO, UDERO>(A, Rp, false, true);
+		X.seqptr()->Transpose();	// only a strip of A*R, the local transpose is cheap
+
+		IU ** XRecvSizes = SpHelper::allocate2D<IU>(UDERO::esscount, gridcols);
+		SpParHelper::GetSetSizes( *(X.seqptr()), XRecvSizes, RowWorld);
+		std::vector< std::vector< std::tuple<LIT,LIT,NUO> > > sendto(gridcols);	// partial sums of C'(block b, mine)
+		for(int b = 0; b < gridcols; ++b)
+		{
+			UDERO * XRecv;
+			std::vector<IU> ess;
+			if(b == mycol)
+			{
+				XRecv = X.seqptr();
+			}
+			else
+			{
+				ess.resize(UDERO::esscount);
+				for(int j=0; j< UDERO::esscount; ++j)
+					ess[j] = XRecvSizes[j][b];
+				XRecv = new UDERO();
+			}
+			SpParHelper::BCastMatrix(RowWorld, *XRecv, ess, b);
+
+			LIT rowoffset = p * (blockcols[b] / phases);
+			for(int q = (symmetric ? p : 0); q < phases; ++q)
+			{
+				SpTuples<LIT,NUO> * part = LocalHybridSpGEMM<SR, NUO>(*XRecv, Rpieces[q], false, false);
+				LIT coloffset = q * (mycols / phases);
+				for(int64_t e = 0; e < part->getnnz(); ++e)
+					sendto[b].push_back(std::make_tuple(part->rowindex(e) + rowoffset, part->colindex(e) + coloffset, part->numvalue(e)));
+				delete part;
+			}
+			if(b != mycol)	delete XRecv;
+		}
+		SpHelper::deallocate2D(XRecvSizes, UDERO::esscount);
+
+		// the ith processor row holds the ith row block of C', so the partial sums are summed up along the processor column
+		std::vector<int> sendcnt(gridcols), recvcnt(gridcols), sdispls(gridcols, 0), rdispls(gridcols, 0);
+		for(int b = 0; b < gridcols; ++b)
+			sendcnt[b] = static_cast<int>(sendto[b].size());
+		MPI_Alltoall(sendcnt.data(), 1, MPI_INT, recvcnt.data(), 1, MPI_INT, ColWorld);
+		std::partial_sum(sendcnt.begin(), sendcnt.end()-1, sdispls.begin()+1);
+		std::partial_sum(recvcnt.begin(), recvcnt.end()-1, rdispls.begin()+1);
+		std::vector< std::tuple<LIT,LIT,NUO> > sendbuf;
+		sendbuf.reserve(sdispls[gridcols-1] + sendcnt[gridcols-1]);
+		for(int b = 0; b < gridcols; ++b)
+		{
+			sendbuf.insert(sendbuf.end(), sendto[b].begin(), sendto[b].end());
+			std::vector< std::tuple<LIT,LIT,NUO> >().swap(sendto[b]);
+		}
+		int64_t recvsize = rdispls[gridcols-1] + recvcnt[gridcols-1];
+		std::tuple<LIT,LIT,NUO> * recvbuf = new std::tuple<LIT,LIT,NUO>[recvsize];
+		MPI_Alltoallv(sendbuf.data(), sendcnt.data(), sdispls.data(), MPI_triple, recvbuf, recvcnt.data(), rdispls.data(), MPI_triple, ColWorld);
+		std::vector< std::tuple<LIT,LIT,NUO> >().swap(sendbuf);
+
+		SpTuples<LIT,NUO> summed(recvsize, blockcols[myrow], mycols, recvbuf);	// takes ownership of recvbuf
+		summed.SortColBased();
+		summed.RemoveDuplicates([](const NUO & a, const NUO & b) { return SR::add(a, b); });
+		for(int64_t e = 0; e < summed.getnnz(); ++e)
+			mine.push_back(std::make_tuple(summed.rowindex(e), summed.colindex(e), summed.numvalue(e)));
+	}
+	MPI_Type_free(&MPI_triple);
+
+	std::vector< std::tuple<LIT,LIT,NUO> > strict;	// the computed entries whose transposes were skipped
+	if(symmetric)
+	{
+		for(auto & t : mine)
+			if(phaseof(std::get<0>(t), blockcols[myrow]) != phaseof(std::get<1>(t), mycols))
+				strict.push_back(t);
+	}
+	SpParMat<IU,NUO,UDERO> C(LocalFromTuples<UDERO>(mine, blockcols[myrow], mycols), grid);
+	if(symmetric)
+	{
+		SpParMat<IU,NUO,UDERO> Mirror(LocalFromTuples<UDERO>(strict, blockcols[myrow], mycols), grid);
+		Mirror.Transpose();
+		C += Mirror;
+	}
+	else
+	{
+		C.Transpose();
+	}
+	return C;
+}
+
+/**
+ * SpGEMM for products known to be symmetric, such as A*A' or A*A with symmetric A: only the upper triangle
+ * of C is computed and stored, and C is flagged so (see SpParMat::MirrorUpper for the full matrix)
+ * Blocks above the diagonal are split with their mirror images below it so that the triangular work
+ * is spread over the whole grid: P(i,j) forms the first half of the columns of C(i,j), and P(j,i) forms the
+ * rows of C(j,i) = C(i,j)' that mirror the other half and sends them back transposed. Diagonal blocks use
+ * LocalSpGEMMUpper. Every process does about half the multiplications and merging of Mult_AnXBn_Synch.
+ * Needs a square processor grid, the caller guarantees that the product is symmetric
+ **/
+template <typename SR, typename NUO, typename UDERO, typename IU, typename NU1, typename NU2, typename UDERA, typename UDERB>
+SpParMat<IU, NUO, UDERO> Mult_AnXBn_Symmetric
+		(SpParMat<IU,NU1,UDERA> & A, SpParMat<IU,NU2,UDERB> & B, bool clearA = false, bool clearB = false )
+{
+	typedef typename UDERO::LocalIT LIT;
+	if(!CheckSpGEMMCompliance(A,B) )
+	{
+		return SpParMat< IU,NUO,UDERO >();
+	}
+	CheckSquareSUMMAGrid(A, "Mult_AnXBn_Symmetric");
+	if(A.getnrow() != B.getncol())
+	{
+		std::ostringstream outs;
+		outs << "Can not be symmetric, the product is " << A.getnrow() << " x " << B.getncol() << std::endl;
+		SpParHelper::Print(outs.str());
+		MPI_Abort(MPI_COMM_WORLD, DIMMISMATCH);
+	}
+	int stages, dummy; 	// last two parameters of ProductGrid are ignored for Synch multiplication
+	std::shared_ptr<CommGrid> GridC = ProductGrid((A.commGrid).get(), (B.commGrid).get(), stages, dummy, dummy);
+	int myrow = GridC->GetRankInProcCol();
+	int mycol = GridC->GetRankInProcRow();
+	LIT C_m = A.spSeq->getnrow();
+	LIT C_n = B.spSeq->getncol();
+	LIT half = (myrow < mycol) ? C_n / 2 : C_m / 2;	// the halves of C(i,j) for the upper block P(i,j) and the lower block P(j,i) agree
+
+	IU ** ARecvSizes = SpHelper::allocate2D<IU>(UDERA::esscount, stages);
+	IU ** BRecvSizes = SpHelper::allocate2D<IU>(UDERB::esscount, stages);
+	SpParHelper::GetSetSizes( *(A.spSeq), ARecvSizes, (A.commGrid)->GetRowWorld());
+	SpParHelper::GetSetSizes( *(B.spSeq), BRecvSizes, (B.commGrid)->GetColWorld());
+
+	int Aself = (A.commGrid)->GetRankInProcRow();
+	int Bself = (B.commGrid)->GetRankInProcCol();
+	std::vector< SpTuples<LIT,NUO>  *> tomerge;
+	for(int i = 0; i < stages; ++i)
+	{
+		UDERA * ARecv;
+		UDERB * BRecv;
+		std::vector<IU> ess;
+		if(i == Aself)
+		{
+			ARecv = A.spSeq;
+		}
+		else
+		{
+			ess.resize(UDERA::esscount);
+			for(int j=0; j< UDERA::esscount; ++j)
+				ess[j] = ARecvSizes[j][i];
+			ARecv = new UDERA();
+		}
+		SpParHelper::BCastMatrix(GridC->GetRowWorld(), *ARecv, ess, i);
+		ess.clear();
+		if(i == Bself)
+		{
+			BRecv = B.spSeq;
+		}
+		else
+		{
+			ess.resize(UDERB::esscount);
+			for(int j=0; j< UDERB::esscount; ++j)
+				ess[j] = BRecvSizes[j][i];
+			BRecv = new UDERB();
+		}
+		SpParHelper::BCastMatrix(GridC->GetColWorld(), *BRecv, ess, i);
+
+		SpTuples<LIT,NUO> * C_cont;
+		if(myrow == mycol)
+		{
+			C_cont = LocalSpGEMMUpper<SR, NUO>(*ARecv, *BRecv);
+		}
+		else if(myrow < mycol)
+		{
+			UDERB * Bslice = LocalBlockSlice(*BRecv, 0, half, false);
+			C_cont = LocalHybridSpGEMM<SR, NUO>(*ARecv, *Bslice, false, false);
+			delete Bslice;
+		}
+		else
+		{
+			UDERA * Aslice = LocalBlockSlice(*ARecv, half, C_m, true);
+			C_cont = LocalHybridSpGEMM<SR, NUO>(*Aslice, *BRecv, false, false);
+			delete Aslice;
+		}
+		if(!C_cont->isZero())
+			tomerge.push_back(C_cont);
+		else
+			delete C_cont;
+		if(i != Aself)	delete ARecv;
+		if(i != Bself)	delete BRecv;
+	}
+	SpHelper::deallocate2D(ARecvSizes, UDERA::esscount);
+	SpHelper::deallocate2D(BRecvSizes, UDERB::esscount);
+	if(clearA && A.spSeq != NULL)
+	{
+		delete A.spSeq;
+		A.spSeq = NULL;
+	}
+	if(clearB && B.spSeq != NULL)
+	{
+		delete B.spSeq;
+		B.spSeq = NULL;
+	}
+
+	LIT piece_m = (myrow > mycol) ? (C_m - half) : C_m;
+	LIT piece_n = (myrow < mycol) ? half : C_n;
+	UDERO * piece = MultiwayMergeInto<SR,UDERO>::Merge(tomerge, piece_m, piece_n, true);
+
+	UDERO * mine;
+	if(myrow == mycol)
+	{
+		mine = piece;
+	}
+	else
+	{
+		// the lower block hands its rows, transposed into the last columns of C(i,j), to the upper block
+		std::vector< std::tuple<LIT,LIT,NUO> > sendbuf, recvbuf, kept;
+		SpTuples<LIT,NUO> tuples(*piece);
+		delete piece;
+		for(int64_t e = 0; e < tuples.getnnz(); ++e)
+		{
+			if(myrow > mycol)
+				sendbuf.push_back(std::make_tuple(tuples.colindex(e), tuples.rowindex(e) + half, tuples.numvalue(e)));
+			else
+				kept.push_back(std::make_tuple(tuples.rowindex(e), tuples.colindex(e), tuples.numvalue(e)));
+		}
+		MPI_Datatype MPI_triple;
+		MPI_Type_contiguous(sizeof(std::tuple<LIT,LIT,NUO>), MPI_CHAR, &MPI_triple);
+		MPI_Type_commit(&MPI_triple);
+		int diagneigh = GridC->GetComplementRank();
+		int sendcnt = static_cast<int>(sendbuf.size()), recvcnt;
+		MPI_Sendrecv(&sendcnt, 1, MPI_INT, diagneigh, TRTAGNZ, &recvcnt, 1, MPI_INT, diagneigh, TRTAGNZ, GridC->GetWorld(), MPI_STATUS_IGNORE);
+		recvbuf.resize(recvcnt);
+		MPI_Sendrecv(sendbuf.data(), sendcnt, MPI_triple, diagneigh, TRTAGVALS, recvbuf.data(), recvcnt, MPI_triple, diagneigh, TRTAGVALS, GridC->GetWorld(), MPI_STATUS_IGNORE);
+		MPI_Type_free(&MPI_triple);
+		kept.insert(kept.end(), recvbuf.begin(), recvbuf.end());
+		mine = LocalFromTuples<UDERO>(kept, C_m, C_n);	// empty below the diagonal
+	}
+	SpParMat<IU,NUO,UDERO> C(mine, GridC);
+	C.symmetricUpper = true;
+	return C;
+}
     
 template <typename SR, typename NUO, typename UDERO, typename IU, typename NU1, typename NU2, typename UDERA, typename UDERB> 
 SpParMat<IU, NUO, UDERO> Mult_AnXBn_Overlap 
@@ -1226,6 +1758,7 @@ SpParMat<IU, NUO, UDERO> Mult_AnXBn_Overlap
 	{
 		return SpParMat< IU,NUO,UDERO >();
 	}
+	CheckSquareSUMMAGrid(A, "Mult_AnXBn_Overlap");
 	int stages, dummy; 	// last two parameters of ProductGrid are ignored for Synch multiplication
 	std::shared_ptr<CommGrid> GridC = ProductGrid((A.commGrid).get(), (B.commGrid).get(), stages, dummy, dummy);		
 	IU C_m = A.spSeq->getnrow();
@@ -1331,11 +1864,8 @@ SpParMat<IU, NUO, UDERO> Mult_AnXBn_Overlap
 	SpHelper::deallocate2D(BRecvSizes, UDERB::esscount);
 
 	// the last parameter to MergeAll deletes tomerge arrays
-	SpTuples<IU,NUO> * C_tuples = MultiwayMerge<SR>(tomerge, C_m, C_n,true);
+	UDERO * C = MultiwayMergeInto<SR,UDERO>::Merge(tomerge, C_m, C_n, true);
     std::vector< SpTuples<IU,NUO> *>().swap(tomerge);
-	
-    UDERO * C = new UDERO(*C_tuples, false);
-    delete C_tuples;
 
 	//if(!clearB)
 	//	const_cast< UDERB* >(B.spSeq)->Transpose();	// transpose back to original
@@ -1369,6 +1899,7 @@ int64_t EstPerProcessNnzSUMMA(SpParMat<IU,NU1,UDERA> & A, SpParMat<IU,NU2,UDERB>
             return nnzC_SUMMA;
         }
        
+        CheckSquareSUMMAGrid(A, "EstPerProcessNnzSUMMA");
         int stages, dummy;     // last two parameters of ProductGrid are ignored for Synch multiplication
         std::shared_ptr<CommGrid> GridC = ProductGrid((A.commGrid).get(), (B.commGrid).get(), stages, dummy, dummy);
   
@@ -1554,9 +2085,56 @@ template<typename IU, typename NV>
 void TransposeVector(MPI_Comm & World, const FullyDistSpVec<IU,NV> & x, int32_t & trxlocnz, IU & lenuntil, int32_t * & trxinds, NV * & trxnums, bool indexisvalue)
 {
 	int32_t xlocnz = (int32_t) x.getlocnnz();	
+	IU luntil = x.LengthUntil();
+	int pr = x.commGrid->GetGridRows();
+	int pc = x.commGrid->GetGridCols();
+	if(pr != pc)
+	{
+		// there is no P(j,i) on a rectangular grid; route each nonzero to its owner in the column layout instead
+		// the indices we receive are relative to the start of our processor column's block, just like the square case
+		int nprocs = pr*pc;
+		IU glen = x.TotalLength();
+		int * sendcnt = new int[nprocs]();
+		int * recvcnt = new int[nprocs];
+		int * sdispls = new int[nprocs]();
+		int * rdispls = new int[nprocs]();
+		std::vector<int> owner(xlocnz);
+		std::vector<int32_t> lind(xlocnz);
+		for(int32_t i=0; i< xlocnz; ++i)
+		{
+			IU lcol;
+			owner[i] = SpParHelper::ColumnLayoutOwner(glen, pr, pc, x.ind[i]+luntil, lcol);
+			lind[i] = (int32_t) lcol;
+			++sendcnt[owner[i]];
+		}
+		MPI_Alltoall(sendcnt, 1, MPI_INT, recvcnt, 1, MPI_INT, World);
+		std::partial_sum(sendcnt, sendcnt+nprocs-1, sdispls+1);
+		std::partial_sum(recvcnt, recvcnt+nprocs-1, rdispls+1);
+		trxlocnz = std::accumulate(recvcnt, recvcnt+nprocs, 0);
+
+		std::vector<int> curptr(sdispls, sdispls+nprocs);
+		std::vector<int32_t> sendinds(xlocnz);
+		std::vector<NV> sendnums(indexisvalue? 0 : xlocnz);
+		for(int32_t i=0; i< xlocnz; ++i)
+		{
+			int k = curptr[owner[i]]++;
+			sendinds[k] = lind[i];
+			if(!indexisvalue)	sendnums[k] = x.num[i];
+		}
+		trxinds = new int32_t[trxlocnz];
+		MPI_Alltoallv(sendinds.data(), sendcnt, sdispls, MPIType<int32_t>(), trxinds, recvcnt, rdispls, MPIType<int32_t>(), World);
+		if(!indexisvalue)
+		{
+			trxnums = new NV[trxlocnz];
+			MPI_Alltoallv(sendnums.data(), sendcnt, sdispls, MPIType<NV>(), trxnums, recvcnt, rdispls, MPIType<NV>(), World);
+		}
+		IU blocklen;
+		SpParHelper::LayoutRange(glen, pc, 1, x.commGrid->GetRankInProcRow(), 0, lenuntil, blocklen);
+		DeleteAll(sendcnt, recvcnt, sdispls, rdispls);
+		return;
+	}
 	int32_t roffst = (int32_t) x.RowLenUntil();	// since trxinds is int32_t
 	int32_t roffset;
-	IU luntil = x.LengthUntil();
 	int diagneigh = x.commGrid->GetComplementRank();
 
 	MPI_Status status;
@@ -2085,7 +2663,11 @@ FullyDistSpVec<IU,typename promote_trait<NUM,IU>::T_promote>  SpMV
 }
 
 /**
- * Parallel dense SpMV
+ * Parallel dense SpMV, pipelined on both sides of the local multiply
+ * The pieces of x are broadcast along the processor column with one MPI_Ibcast each, and the first row block
+ * of the local product consumes them in the order they arrive (in column order if SR::add does not commute,
+ * see SRingAddCommutes). A row block (the rows that one process in the processor row owns in y) is reduced
+ * to its owner with MPI_Ireduce as soon as it is complete, while the next row block computes.
  **/ 
 template <typename SR, typename IU, typename NUM, typename NUV, typename UDER> 
 FullyDistVec<IU,typename promote_trait<NUM,NUV>::T_promote>  SpMV 
@@ -2094,19 +2676,12 @@ FullyDistVec<IU,typename promote_trait<NUM,NUV>::T_promote>  SpMV
 	typedef typename promote_trait<NUM,NUV>::T_promote T_promote;
 	CheckSpMVCompliance(A, x);
 
-	MPI_Comm World = x.commGrid->GetWorld();
 	MPI_Comm ColWorld = x.commGrid->GetColWorld();
 	MPI_Comm RowWorld = x.commGrid->GetRowWorld();
 
-	int xsize = (int) x.LocArrSize();
-	int trxsize = 0;
-
-	int diagneigh = x.commGrid->GetComplementRank();
-	MPI_Status status;
-	MPI_Sendrecv(&xsize, 1, MPI_INT, diagneigh, TRX, &trxsize, 1, MPI_INT, diagneigh, TRX, World, &status);
-	
-	NUV * trxnums = new NUV[trxsize];
-	MPI_Sendrecv(const_cast<NUV*>(SpHelper::p2a(x.arr)), xsize, MPIType<NUV>(), diagneigh, TRX, trxnums, trxsize, MPIType<NUV>(), diagneigh, TRX, World, &status);
+	std::vector<NUV> trxnums;	// our piece of the column block of x (swap with P(j,i) on square grids)
+	SpParHelper::TransposeLayout(x.commGrid, x.TotalLength(), true, SpHelper::p2a(x.arr), trxnums);
+	int trxsize = (int) trxnums.size();
 
         int colneighs, colrank;
 	MPI_Comm_size(ColWorld, &colneighs);
@@ -2119,29 +2694,24 @@ FullyDistVec<IU,typename promote_trait<NUM,NUV>::T_promote>  SpMV
 	int accsize = std::accumulate(colsize, colsize+colneighs, 0);
 	NUV * numacc = new NUV[accsize];
 
-	MPI_Allgatherv(trxnums, trxsize, MPIType<NUV>(), numacc, colsize, dpls, MPIType<NUV>(), ColWorld);
-	delete [] trxnums;
+	// piece k of the column block of x comes from the kth process of the processor column
+	std::copy(trxnums.begin(), trxnums.end(), numacc + dpls[colrank]);
+	std::vector<NUV>().swap(trxnums);
+	std::vector<MPI_Request> xreqs(colneighs);
+	for(int k=0; k< colneighs; ++k)
+		MPI_Ibcast(numacc + dpls[k], colsize[k], MPIType<NUV>(), k, ColWorld, &xreqs[k]);
 
-	// serial SpMV with dense vector
 	T_promote id = SR::id();
 	IU ysize = A.getlocalrows();
 	T_promote * localy = new T_promote[ysize];
 	std::fill_n(localy, ysize, id);		
 
-#ifdef THREADED
-	dcsc_gespmv_threaded<SR>(*(A.spSeq), numacc, localy);
-#else
-	dcsc_gespmv<SR>(*(A.spSeq), numacc, localy);	
-#endif
-	
-
-	DeleteAll(numacc,colsize, dpls);
-
 	// FullyDistVec<IT,NT>(shared_ptr<CommGrid> grid, IT globallen, NT initval, NT id)
 	FullyDistVec<IU, T_promote> y ( x.commGrid, A.getnrow(), id);
 	
 	int rowneighs;
 	MPI_Comm_size(RowWorld, &rowneighs);
+	std::vector<MPI_Request> yreqs(rowneighs);
 
 	IU begptr, endptr;
 	for(int i=0; i< rowneighs; ++i)
@@ -2155,12 +2725,364 @@ FullyDistVec<IU,typename promote_trait<NUM,NUV>::T_promote>  SpMV
 		{
 			endptr = y.RowLenUntil(i+1);
 		}
-		MPI_Reduce(localy+begptr, SpHelper::p2a(y.arr), endptr-begptr, MPIType<T_promote>(), SR::mpi_op(), i, RowWorld);
+		if(i == 0)	// the whole of x is in place once the first row block is done
+		{
+			for(int k=0; k< colneighs; ++k)
+			{
+				int arrived = k;	// an addition that does not commute has to see the columns in order
+				if(SRingAddCommutes<SR>::value)
+					MPI_Waitany(colneighs, xreqs.data(), &arrived, MPI_STATUS_IGNORE);
+				else
+					MPI_Wait(&xreqs[k], MPI_STATUS_IGNORE);
+				gespmv_dense_tile<SR>(*(A.spSeq), numacc, localy, begptr, endptr, (IU) dpls[arrived], (IU) (dpls[arrived] + colsize[arrived]));
+			}
+		}
+		else
+		{
+			gespmv_dense_tile<SR>(*(A.spSeq), numacc, localy, begptr, endptr, (IU) 0, A.getlocalcols());
+		}
+		MPI_Ireduce(localy+begptr, SpHelper::p2a(y.arr), endptr-begptr, MPIType<T_promote>(), SRingMPIOp<SR, T_promote>::op(), i, RowWorld, &yreqs[i]);
+
+		int done;	// lets the outstanding reductions progress while the next row block computes
+		MPI_Testall(i+1, yreqs.data(), &done, MPI_STATUSES_IGNORE);
 	}
-	delete [] localy;
+	MPI_Waitall(rowneighs, yreqs.data(), MPI_STATUSES_IGNORE);
+	DeleteAll(numacc, colsize, dpls, localy);
 	return y;
 }
 
+/**
+ * Parallel dense SpMV with the transpose, y = A'*x, using the storage of A as is
+ * x is distributed like the rows of A and y like its columns; the communication mirrors SpMV:
+ * x is gathered along processor rows and the partial results are reduced along processor columns
+ **/
+template <typename SR, typename IU, typename NUM, typename NUV, typename UDER>
+FullyDistVec<IU,typename promote_trait<NUM,NUV>::T_promote>  SpMVTranspose
+	(const SpParMat<IU,NUM,UDER> & A, const FullyDistVec<IU,NUV> & x )
+{
+	typedef typename promote_trait<NUM,NUV>::T_promote T_promote;
+	if(A.getnrow() != x.TotalLength())
+	{
+		std::ostringstream outs;
+		outs << "Can not multiply with the transpose, dimensions does not match"<< std::endl;
+		outs << A.getnrow() << " != " << x.TotalLength() << std::endl;
+		SpParHelper::Print(outs.str());
+		MPI_Abort(MPI_COMM_WORLD, DIMMISMATCH);
+	}
+	if(! ( *(A.getcommgrid()) == *(x.getcommgrid())) )
+	{
+		std::cout << "Grids are not comparable for SpMV" << std::endl;
+		MPI_Abort(MPI_COMM_WORLD, GRIDMISMATCH);
+	}
+
+	MPI_Comm ColWorld = x.commGrid->GetColWorld();
+	MPI_Comm RowWorld = x.commGrid->GetRowWorld();
+
+	// the pieces of x along the processor row make up the x entries of the local rows
+	int rowneighs, rowrank;
+	MPI_Comm_size(RowWorld, &rowneighs);
+	MPI_Comm_rank(RowWorld, &rowrank);
+	int * rowsize = new int[rowneighs];
+	rowsize[rowrank] = (int) x.LocArrSize();
+	MPI_Allgather(MPI_IN_PLACE, 1, MPI_INT, rowsize, 1, MPI_INT, RowWorld);
+	int * rowdpls = new int[rowneighs]();
+	std::partial_sum(rowsize, rowsize+rowneighs-1, rowdpls+1);
+	NUV * numacc = new NUV[rowdpls[rowneighs-1] + rowsize[rowneighs-1]];
+	MPI_Allgatherv(const_cast<NUV*>(SpHelper::p2a(x.arr)), rowsize[rowrank], MPIType<NUV>(), numacc, rowsize, rowdpls, MPIType<NUV>(), RowWorld);
+
+	T_promote id = SR::id();
+	IU ysize = A.getlocalcols();
+	T_promote * localy = new T_promote[ysize];
+	std::fill_n(localy, ysize, id);
+	gespmv_dense_transpose<SR>(*(A.seqptr()), numacc, localy);
+	DeleteAll(numacc, rowsize, rowdpls);
+
+	// reduce along the processor column into the column layout, then move the pieces to their FullyDist owners
+	FullyDistVec<IU, T_promote> y ( x.commGrid, A.getncol(), id);
+	int colneighs, colrank;
+	MPI_Comm_size(ColWorld, &colneighs);
+	MPI_Comm_rank(ColWorld, &colrank);
+	int * colsize = new int[colneighs];
+	int * coldpls = new int[colneighs]();
+	for(int i=0; i< colneighs; ++i)
+	{
+		IU piecestart, piecelen;
+		SpParHelper::LayoutRange(y.TotalLength(), x.commGrid->GetGridCols(), colneighs, x.commGrid->GetRankInProcRow(), i, piecestart, piecelen);
+		colsize[i] = (int) piecelen;
+	}
+	std::partial_sum(colsize, colsize+colneighs-1, coldpls+1);
+
+	T_promote * trynums = new T_promote[colsize[colrank]];
+	for(int i=0; i< colneighs; ++i)
+		MPI_Reduce(localy+coldpls[i], trynums, colsize[i], MPIType<T_promote>(), SRingMPIOp<SR, T_promote>::op(), i, ColWorld);
+	SpParHelper::TransposeLayout(x.commGrid, y.TotalLength(), false, trynums, y.arr);
+	DeleteAll(localy, trynums, colsize, coldpls);
+	return y;
+}
+
+
+//! The nonzero columns of the local submatrix, when the storage lists them; false otherwise
+template <typename DER, typename IU>
+bool LocalNonzeroColumns(const DER & A, std::vector<IU> & cols)
+{
+	return false;
+}
+
+template <typename IU, typename NU>
+bool LocalNonzeroColumns(const SpDCCols<IU,NU> & A, std::vector<IU> & cols)
+{
+	if(A.getnsplit() > 0)
+		return false;
+	cols.clear();
+	if(A.getnnz() > 0)
+		cols.assign(A.GetDCSC()->jc, A.GetDCSC()->jc + A.GetDCSC()->nzc);
+	return true;
+}
+
+/**
+ * The rows of X (as long as the columns of A) that the local submatrix of A multiplies, i.e. the column block of X
+ * replicated along the processor column, with k entries per row in numacc
+ * If the local nonzero columns need a small part of the column block (at most 1/SPMMFETCHRATIO of the rows that an
+ * Allgatherv would move), each process fetches only those rows from their owners in its processor column and the
+ * rows of empty columns are left as value initialized
+ **/
+template <typename IU, typename NUM, typename UDER, typename NUV>
+void GatherColumnBlock(const SpParMat<IU,NUM,UDER> & A, const DenseMultiVec<IU,NUV> & X, std::vector<NUV> & numacc)
+{
+	std::shared_ptr<CommGrid> grid = X.getcommgrid();
+	MPI_Comm ColWorld = grid->GetColWorld();
+	int k = X.getnvec();
+
+	std::vector<NUV> trxnums;	// our piece of the column block of X, k entries per row
+	SpParHelper::TransposeLayout(grid, X.TotalLength(), true, X.GetLocArr(), trxnums, k);
+
+	int colneighs, colrank;
+	MPI_Comm_size(ColWorld, &colneighs);
+	MPI_Comm_rank(ColWorld, &colrank);
+	std::vector<int> colsize(colneighs), dpls(colneighs, 0);	// in rows
+	colsize[colrank] = (k > 0) ? (int) (trxnums.size() / k) : 0;
+	MPI_Allgather(MPI_IN_PLACE, 1, MPI_INT, colsize.data(), 1, MPI_INT, ColWorld);
+	std::partial_sum(colsize.begin(), colsize.end()-1, dpls.begin()+1);
+
+	IU loccols = A.getlocalcols();
+	numacc.resize(loccols * k);
+	std::vector<IU> needed;
+	int listed = LocalNonzeroColumns(*(A.seqptr()), needed);
+	int alllisted;
+	int64_t rows[2] = {static_cast<int64_t>(needed.size()), static_cast<int64_t>(loccols)};
+	MPI_Allreduce(&listed, &alllisted, 1, MPI_INT, MPI_LAND, ColWorld);
+	MPI_Allreduce(MPI_IN_PLACE, rows, 2, MPIType<int64_t>(), MPI_SUM, ColWorld);
+
+	if(alllisted && rows[0] * SPMMFETCHRATIO <= rows[1])
+	{
+		// needed is sorted, so the requests come out grouped by the process that owns the piece
+		std::vector<int> reqcnt(colneighs, 0), reqdpls(colneighs, 0), askcnt(colneighs), askdpls(colneighs, 0);
+		std::vector<IU> reqs(needed.size());
+		for(size_t r=0; r< needed.size(); ++r)
+		{
+			int owner = (int) (std::upper_bound(dpls.begin(), dpls.end(), (int) needed[r]) - dpls.begin()) - 1;
+			reqs[r] = needed[r] - dpls[owner];
+			++reqcnt[owner];
+		}
+		std::partial_sum(reqcnt.begin(), reqcnt.end()-1, reqdpls.begin()+1);
+		MPI_Alltoall(reqcnt.data(), 1, MPI_INT, askcnt.data(), 1, MPI_INT, ColWorld);
+		std::partial_sum(askcnt.begin(), askcnt.end()-1, askdpls.begin()+1);
+		std::vector<IU> asked(askdpls[colneighs-1] + askcnt[colneighs-1]);
+		MPI_Alltoallv(reqs.data(), reqcnt.data(), reqdpls.data(), MPIType<IU>(), asked.data(), askcnt.data(), askdpls.data(), MPIType<IU>(), ColWorld);
+
+		std::vector<NUV> answers(asked.size() * k), fetched(needed.size() * k);
+		for(size_t r=0; r< asked.size(); ++r)
+			std::copy(trxnums.begin() + asked[r] * k, trxnums.begin() + (asked[r]+1) * k, answers.begin() + r * k);
+		for(int i=0; i< colneighs; ++i)	// from here on, the counts are in entries
+		{
+			reqcnt[i] *= k;	reqdpls[i] *= k;
+			askcnt[i] *= k;	askdpls[i] *= k;
+		}
+		MPI_Alltoallv(answers.data(), askcnt.data(), askdpls.data(), MPIType<NUV>(), fetched.data(), reqcnt.data(), reqdpls.data(), MPIType<NUV>(), ColWorld);
+		for(size_t r=0; r< needed.size(); ++r)
+			std::copy(fetched.begin() + r * k, fetched.begin() + (r+1) * k, numacc.begin() + needed[r] * k);
+	}
+	else
+	{
+		for(int i=0; i< colneighs; ++i)
+		{
+			colsize[i] *= k;	dpls[i] *= k;
+		}
+		MPI_Allgatherv(trxnums.data(), (int) trxnums.size(), MPIType<NUV>(), numacc.data(), colsize.data(), dpls.data(), MPIType<NUV>(), ColWorld);
+	}
+	std::vector<NUV>().swap(trxnums);
+}
+
+/**
+ * The rows of X (as long as the rows of A) that the local submatrix of A meets, i.e. the row block of X
+ * gathered along the processor row, with k entries per row in numacc
+ **/
+template <typename IU, typename NUV>
+void GatherRowBlock(const DenseMultiVec<IU,NUV> & X, std::vector<NUV> & numacc)
+{
+	MPI_Comm RowWorld = X.getcommgrid()->GetRowWorld();
+	int k = X.getnvec();
+	int rowneighs, rowrank;
+	MPI_Comm_size(RowWorld, &rowneighs);
+	MPI_Comm_rank(RowWorld, &rowrank);
+	std::vector<int> rowsize(rowneighs), rowdpls(rowneighs, 0);
+	rowsize[rowrank] = (int) (X.LocArrSize() * k);
+	MPI_Allgather(MPI_IN_PLACE, 1, MPI_INT, rowsize.data(), 1, MPI_INT, RowWorld);
+	std::partial_sum(rowsize.begin(), rowsize.end()-1, rowdpls.begin()+1);
+	numacc.resize(rowdpls[rowneighs-1] + rowsize[rowneighs-1]);
+	MPI_Allgatherv(const_cast<NUV*>(X.GetLocArr()), rowsize[rowrank], MPIType<NUV>(), numacc.data(), rowsize.data(), rowdpls.data(), MPIType<NUV>(), RowWorld);
+}
+
+/**
+ * Parallel SpMM, Y = A*X, where X is a tall-skinny dense matrix of k columns stored as a DenseMultiVec
+ * The communication is that of the dense SpMV with rows of k entries in place of single entries: X moves to the
+ * column layout, is replicated along processor columns, multiplied locally and reduced along processor rows.
+ * If the local nonzero columns need a small part of the column block of X (at most 1/SPMMFETCHRATIO of the rows
+ * that an Allgatherv would move), each process fetches only those rows from their owners in its processor column
+ **/
+template <typename SR, typename IU, typename NUM, typename NUV, typename UDER>
+DenseMultiVec<IU,typename promote_trait<NUM,NUV>::T_promote>  SpMM
+	(const SpParMat<IU,NUM,UDER> & A, const DenseMultiVec<IU,NUV> & X)
+{
+	typedef typename promote_trait<NUM,NUV>::T_promote T_promote;
+	if(A.getncol() != X.TotalLength())
+	{
+		std::ostringstream outs;
+		outs << "Can not multiply, dimensions does not match"<< std::endl;
+		outs << A.getncol() << " != " << X.TotalLength() << std::endl;
+		SpParHelper::Print(outs.str());
+		MPI_Abort(MPI_COMM_WORLD, DIMMISMATCH);
+	}
+	if(! ( *(A.getcommgrid()) == *(X.getcommgrid())) )
+	{
+		std::cout << "Grids are not comparable for SpMM" << std::endl;
+		MPI_Abort(MPI_COMM_WORLD, GRIDMISMATCH);
+	}
+	std::shared_ptr<CommGrid> grid = X.getcommgrid();
+	MPI_Comm RowWorld = grid->GetRowWorld();
+	int k = X.getnvec();
+
+	std::vector<NUV> numacc;
+	GatherColumnBlock(A, X, numacc);
+
+	T_promote id = SR::id();
+	std::vector<T_promote> localy(A.getlocalrows() * k, id);
+	gespmm_dense<SR>(*(A.seqptr()), numacc.data(), localy.data(), k);
+	std::vector<NUV>().swap(numacc);
+
+	// the row blocks of the result go to their owners along the processor row
+	DenseMultiVec<IU,T_promote> Y(grid, A.getnrow(), k, id);
+	int rowneighs;
+	MPI_Comm_size(RowWorld, &rowneighs);
+	std::vector<int> recvcnt(rowneighs);
+	for(int i=0; i< rowneighs; ++i)
+	{
+		IU endptr = (i == rowneighs-1) ? A.getlocalrows() : Y.RowLenUntil(i+1);
+		recvcnt[i] = (int) ((endptr - Y.RowLenUntil(i)) * k);
+	}
+	MPI_Reduce_scatter(localy.data(), Y.GetLocArr(), recvcnt.data(), MPIType<T_promote>(), SRingMPIOp<SR, T_promote>::op(), RowWorld);
+	return Y;
+}
+
+/**
+ * Parallel SpMM with the transpose, Y = A'*X, using the storage of A as is
+ * X is distributed like the rows of A and Y like its columns; the communication mirrors SpMVTranspose
+ **/
+template <typename SR, typename IU, typename NUM, typename NUV, typename UDER>
+DenseMultiVec<IU,typename promote_trait<NUM,NUV>::T_promote>  SpMMTranspose
+	(const SpParMat<IU,NUM,UDER> & A, const DenseMultiVec<IU,NUV> & X)
+{
+	typedef typename promote_trait<NUM,NUV>::T_promote T_promote;
+	if(A.getnrow() != X.TotalLength())
+	{
+		std::ostringstream outs;
+		outs << "Can not multiply with the transpose, dimensions does not match"<< std::endl;
+		outs << A.getnrow() << " != " << X.TotalLength() << std::endl;
+		SpParHelper::Print(outs.str());
+		MPI_Abort(MPI_COMM_WORLD, DIMMISMATCH);
+	}
+	if(! ( *(A.getcommgrid()) == *(X.getcommgrid())) )
+	{
+		std::cout << "Grids are not comparable for SpMM" << std::endl;
+		MPI_Abort(MPI_COMM_WORLD, GRIDMISMATCH);
+	}
+	std::shared_ptr<CommGrid> grid = X.getcommgrid();
+	MPI_Comm ColWorld = grid->GetColWorld();
+	MPI_Comm RowWorld = grid->GetRowWorld();
+	int k = X.getnvec();
+
+	std::vector<NUV> numacc;
+	GatherRowBlock(X, numacc);
+
+	T_promote id = SR::id();
+	std::vector<T_promote> localy(A.getlocalcols() * k, id);
+	gespmm_dense_transpose<SR>(*(A.seqptr()), numacc.data(), localy.data(), k);
+	std::vector<NUV>().swap(numacc);
+
+	// reduce along the processor column into the column layout, then move the pieces to their FullyDist owners
+	int colneighs, colrank;
+	MPI_Comm_size(ColWorld, &colneighs);
+	MPI_Comm_rank(ColWorld, &colrank);
+	std::vector<int> recvcnt(colneighs);
+	for(int i=0; i< colneighs; ++i)
+	{
+		IU piecestart, piecelen;
+		SpParHelper::LayoutRange(A.getncol(), grid->GetGridCols(), colneighs, grid->GetRankInProcRow(), i, piecestart, piecelen);
+		recvcnt[i] = (int) (piecelen * k);
+	}
+	std::vector<T_promote> trynums(recvcnt[colrank]), ynums;
+	MPI_Reduce_scatter(localy.data(), trynums.data(), recvcnt.data(), MPIType<T_promote>(), SRingMPIOp<SR, T_promote>::op(), ColWorld);
+	SpParHelper::TransposeLayout(grid, A.getncol(), false, trynums.data(), ynums, k);
+
+	DenseMultiVec<IU,T_promote> Y(grid, A.getncol(), k, id);
+	std::copy(ynums.begin(), ynums.end(), Y.GetLocArr());
+	return Y;
+}
+
+/**
+ * Sampled dense-dense matrix product (SDDMM): every nonzero S(i,j) becomes __binary_op(S(i,j), U(i,:) . V(j,:)), where
+ * the dot product multiplies with SR::multiply and folds with SR::add
+ * U is distributed like the rows of S and V like its columns; they are replicated along the processor rows and columns
+ * the way the dense SpMV replicates x (V only fetches the rows of nonzero columns when that is cheaper), and the nonzeros
+ * never move, so the result keeps the distribution and the storage format of S
+ **/
+template <typename SR, typename IU, typename NUM, typename UDER, typename NU1, typename NU2, typename _BinaryOperation>
+SpParMat<IU,NUM,UDER> SDDMM
+	(const SpParMat<IU,NUM,UDER> & S, const DenseMultiVec<IU,NU1> & U, const DenseMultiVec<IU,NU2> & V, _BinaryOperation __binary_op)
+{
+	if(S.getnrow() != U.TotalLength() || S.getncol() != V.TotalLength() || U.getnvec() != V.getnvec())
+	{
+		std::ostringstream outs;
+		outs << "Can not sample the dense product, dimensions does not match"<< std::endl;
+		outs << S.getnrow() << " x " << S.getncol() << " vs. " << U.TotalLength() << " x " << U.getnvec();
+		outs << " and " << V.TotalLength() << " x " << V.getnvec() << std::endl;
+		SpParHelper::Print(outs.str());
+		MPI_Abort(MPI_COMM_WORLD, DIMMISMATCH);
+	}
+	if(! ( *(S.getcommgrid()) == *(U.getcommgrid())) || ! ( *(S.getcommgrid()) == *(V.getcommgrid())) )
+	{
+		std::cout << "Grids are not comparable for SDDMM" << std::endl;
+		MPI_Abort(MPI_COMM_WORLD, GRIDMISMATCH);
+	}
+	std::vector<NU1> urows;
+	std::vector<NU2> vrows;
+	GatherRowBlock(U, urows);
+	GatherColumnBlock(S, V, vrows);
+
+	SpParMat<IU,NUM,UDER> C(S);
+	sddmm_dense<SR>(*(C.seqptr()), urows.data(), vrows.data(), U.getnvec(), __binary_op);
+	return C;
+}
+
+//! SDDMM that keeps only the sampled dot products, S acting as the mask
+template <typename SR, typename IU, typename NUM, typename UDER, typename NU1, typename NU2>
+SpParMat<IU,NUM,UDER> SDDMM
+	(const SpParMat<IU,NUM,UDER> & S, const DenseMultiVec<IU,NU1> & U, const DenseMultiVec<IU,NU2> & V)
+{
+	typedef typename promote_trait<NU1,NU2>::T_promote T_promote;
+	return SDDMM<SR>(S, U, V, [](const NUM &, const T_promote & dot) { return static_cast<NUM>(dot); });
+}
+
 	
 /**
  * \TODO: Old version that is no longer considered optimal
@@ -3236,124 +4158,23 @@ SpParMat3D<IU,NUO,UDERO> Mult_AnXBn_SUMMA3D(SpParMat3D<IU,NU1,UDER1> & A, SpParM
 #endif
     /*
      * 3d-reduction starts
+     * Column-compressed pieces of C_tuples travel to the layers owning their columns and are merged as they arrive
      * */
 #ifdef TIMING
-    //MPI_Barrier(getcommgrid3D()->GetWorld());
     t0 = MPI_Wtime();
 #endif
-    MPI_Datatype MPI_tuple;
-    MPI_Type_contiguous(sizeof(std::tuple<LIC,LIC,NUO>), MPI_CHAR, &MPI_tuple);
-    MPI_Type_commit(&MPI_tuple);
-    
-    /*
-     *  Create a profile with information regarding data to be sent and received between layers 
-     *  These memory allocation needs to be `int` specifically because some of these arrays would be used in communication
-     *  This is requirement is for MPI as MPI_Alltoallv takes pointer to integer exclusively as count and displacement
-     * */
-    int * sendcnt    = new int[A.getcommgrid3D()->GetGridLayers()];
-    int * sendprfl   = new int[A.getcommgrid3D()->GetGridLayers()*3];
-    int * sdispls    = new int[A.getcommgrid3D()->GetGridLayers()]();
-    int * recvcnt    = new int[A.getcommgrid3D()->GetGridLayers()];
-    int * recvprfl   = new int[A.getcommgrid3D()->GetGridLayers()*3];
-    int * rdispls    = new int[A.getcommgrid3D()->GetGridLayers()]();
-
-    vector<IU> divisions3dPrefixSum(divisions3d.size());
-    divisions3dPrefixSum[0] = 0;
-    std::partial_sum(divisions3d.begin(), divisions3d.end()-1, divisions3dPrefixSum.begin()+1);
-    ColLexiCompare<IU,NUO> comp;
-    IU totsend = C_tuples->getnnz();
-    
-#pragma omp parallel for
-    for(int i=0; i < A.getcommgrid3D()->GetGridLayers(); ++i){
-        IU start_col = divisions3dPrefixSum[i];
-        IU end_col = divisions3dPrefixSum[i] + divisions3d[i];
-        std::tuple<IU, IU, NUO> search_tuple_start(0, start_col, NUO());
-        std::tuple<IU, IU, NUO> search_tuple_end(0, end_col, NUO());
-        std::tuple<IU, IU, NUO>* start_it = std::lower_bound(C_tuples->tuples, C_tuples->tuples + C_tuples->getnnz(), search_tuple_start, comp);
-        std::tuple<IU, IU, NUO>* end_it = std::lower_bound(C_tuples->tuples, C_tuples->tuples + C_tuples->getnnz(), search_tuple_end, comp);
-        // This type casting is important from semantic point of view
-        sendcnt[i] = (int)(end_it - start_it);
-        sendprfl[i*3+0] = (int)(sendcnt[i]); // Number of nonzeros in ith chunk
-        sendprfl[i*3+1] = (int)(A.GetLayerMat()->seqptr()->getnrow()); // Number of rows in ith chunk
-        sendprfl[i*3+2] = (int)(divisions3d[i]); // Number of columns in ith chunk
-    }
-    std::partial_sum(sendcnt, sendcnt+A.getcommgrid3D()->GetGridLayers()-1, sdispls+1);
-
-    // Send profile ready. Now need to update the tuples to reflect correct column id after column split.
-    for(int i=0; i < A.getcommgrid3D()->GetGridLayers(); ++i){
-#pragma omp parallel for schedule(static)
-        for(int j = 0; j < sendcnt[i]; j++){
-            std::get<1>(C_tuples->tuples[sdispls[i]+j]) = std::get<1>(C_tuples->tuples[sdispls[i]+j]) - divisions3dPrefixSum[i];
-        }
-    }
-
-    MPI_Alltoall(sendprfl, 3, MPI_INT, recvprfl, 3, MPI_INT, A.getcommgrid3D()->fiberWorld);
-
-    for(int i = 0; i < A.getcommgrid3D()->GetGridLayers(); i++) recvcnt[i] = recvprfl[i*3];
-    std::partial_sum(recvcnt, recvcnt+A.getcommgrid3D()->GetGridLayers()-1, rdispls+1);
-    IU totrecv = std::accumulate(recvcnt,recvcnt+A.getcommgrid3D()->GetGridLayers(), static_cast<IU>(0));
-    std::tuple<LIC,LIC,NUO>* recvTuples = static_cast<std::tuple<LIC,LIC,NUO>*> (::operator new (sizeof(std::tuple<LIC,LIC,NUO>[totrecv])));
-
-#ifdef TIMING
-    t2 = MPI_Wtime();
-#endif
-    MPI_Alltoallv(C_tuples->tuples, sendcnt, sdispls, MPI_tuple, recvTuples, recvcnt, rdispls, MPI_tuple, A.getcommgrid3D()->fiberWorld);
-    delete C_tuples;
-#ifdef TIMING
-    t3 = MPI_Wtime();
-    if(myrank == 0) fprintf(stderr, "[SUMMA3D]\tAlltoallv: %lf\n", (t3-t2));
-#endif
-    vector<SpTuples<IU, NUO>*> recvChunks(A.getcommgrid3D()->GetGridLayers());
-#pragma omp parallel for
-    for (int i = 0; i < A.getcommgrid3D()->GetGridLayers(); i++){
-        recvChunks[i] = new SpTuples<LIC, NUO>(recvcnt[i], recvprfl[i*3+1], recvprfl[i*3+2], recvTuples + rdispls[i], true, false);
-    }
-
-    // Free all memory except tempTuples; Because that memory is holding data of newly created local matrices after receiving.
-    DeleteAll(sendcnt, sendprfl, sdispls);
-    DeleteAll(recvcnt, recvprfl, rdispls); 
-    MPI_Type_free(&MPI_tuple);
-    /*
-     * 3d-reduction ends 
-     * */
-    
+    SpTuples<IU, NUO> * merged_tuples = FiberReduce<SR>(C_tuples, divisions3d, A.getcommgrid3D()->fiberWorld, false); // deletes C_tuples; rows within columns stay unsorted
 #ifdef TIMING
     t1 = MPI_Wtime();
     mcl3d_reductiontime += (t1-t0);
     if(myrank == 0) fprintf(stderr, "[SUMMA3D]\tReduction time: %lf\n", (t1-t0));
-#endif
-#ifdef TIMING
-    t0 = MPI_Wtime();
-    t2 = MPI_Wtime();
-#endif
-    /*
-     * 3d-merge starts 
-     * */
-    SpTuples<IU, NUO> * merged_tuples = MultiwayMergeHash<SR, IU, NUO>(recvChunks, recvChunks[0]->getnrow(), recvChunks[0]->getncol(), false, false); // Do not delete
-#ifdef TIMING
-    t3 = MPI_Wtime();
-    if(myrank == 0) fprintf(stderr, "[SUMMA3D]\tMultiway Merge: %lf\n", (t3-t2));
     mcl3d_layer_nnzc += merged_tuples->getnnz();
 #endif
-    //Create SpDCCol and delete merged_tuples;
-    UDERO * localResultant = new UDERO(*merged_tuples, false);
-
-    // Do not delete elements of recvChunks, because that would give segmentation fault due to double free
-    //delete [] recvTuples;
-    ::operator delete(recvTuples);
-    for(int i = 0; i < recvChunks.size(); i++){
-        recvChunks[i]->tuples_deleted = true; // Temporary patch to avoid memory leak and segfault
-        delete recvChunks[i];
-    }
-    vector<SpTuples<IU,NUO>*>().swap(recvChunks);
     /*
-     * 3d-merge ends
+     * 3d-reduction ends 
      * */
-#ifdef TIMING
-    t1 = MPI_Wtime();
-    mcl3d_3dmergetime += (t1-t0);
-    if(myrank == 0) fprintf(stderr, "[SUMMA3D]\t3D Merge time: %lf\n", (t1-t0));
-#endif
+    UDERO * localResultant = new UDERO(*merged_tuples, false);
+    delete merged_tuples;
 
     std::shared_ptr<CommGrid3D> grid3d;
     grid3d.reset(new CommGrid3D(A.getcommgrid3D()->GetWorld(), A.getcommgrid3D()->GetGridLayers(), A.getcommgrid3D()->GetGridRows(), A.getcommgrid3D()->GetGridCols(), A.isSpecial()));
@@ -3659,169 +4480,29 @@ SpParMat3D<IU, NUO, UDERO> MemEfficientSpGEMM3D(SpParMat3D<IU, NU1, UDERA> & A,
 #endif
         /*
          * 3d-reduction starts
+         * Column-compressed pieces of C_tuples travel to the layers owning their columns and are merged as they arrive
          * */
 #ifdef TIMING
         t0 = MPI_Wtime();
-        t2 = MPI_Wtime();
-#endif
-        MPI_Datatype MPI_tuple;
-        MPI_Type_contiguous(sizeof(std::tuple<LIC,LIC,NUO>), MPI_CHAR, &MPI_tuple);
-        MPI_Type_commit(&MPI_tuple);
-        
-        /*
-         *  Create a profile with information regarding data to be sent and received between layers 
-         *  These memory allocation needs to be `int` specifically because some of these arrays would be used in communication
-         *  This is requirement is for MPI as MPI_Alltoallv takes pointer to integer exclusively as count and displacement
-         * */
-        int * sendcnt    = new int[A.getcommgrid3D()->GetGridLayers()];
-        int * sendprfl   = new int[A.getcommgrid3D()->GetGridLayers()*3];
-        int * sdispls    = new int[A.getcommgrid3D()->GetGridLayers()]();
-        int * recvcnt    = new int[A.getcommgrid3D()->GetGridLayers()];
-        int * recvprfl   = new int[A.getcommgrid3D()->GetGridLayers()*3];
-        int * rdispls    = new int[A.getcommgrid3D()->GetGridLayers()]();
-
-        vector<IU> lbDivisions3dPrefixSum(lbDivisions3d.size());
-        lbDivisions3dPrefixSum[0] = 0;
-        std::partial_sum(lbDivisions3d.begin(), lbDivisions3d.end()-1, lbDivisions3dPrefixSum.begin()+1);
-        ColLexiCompare<IU,NUO> comp;
-        IU totsend = C_tuples->getnnz();
-#ifdef TIMING
-        t3 = MPI_Wtime();
-        if(myrank == 0) fprintf(stderr, "[MemEfficientSpGEMM3D]\tPhase: %d\tAllocation of alltoall information: %lf\n", p, (t3-t2));
-#endif
-        
-#ifdef TIMING
-        t2 = MPI_Wtime();
 #endif
-#pragma omp parallel for
-        for(int i=0; i < A.getcommgrid3D()->GetGridLayers(); ++i){
-            IU start_col = lbDivisions3dPrefixSum[i];
-            IU end_col = lbDivisions3dPrefixSum[i] + lbDivisions3d[i];
-            std::tuple<IU, IU, NUO> search_tuple_start(0, start_col, NUO());
-            std::tuple<IU, IU, NUO> search_tuple_end(0, end_col, NUO());
-            std::tuple<IU, IU, NUO>* start_it = std::lower_bound(C_tuples->tuples, C_tuples->tuples + C_tuples->getnnz(), search_tuple_start, comp);
-            std::tuple<IU, IU, NUO>* end_it = std::lower_bound(C_tuples->tuples, C_tuples->tuples + C_tuples->getnnz(), search_tuple_end, comp);
-            // This type casting is important from semantic point of view
-            sendcnt[i] = (int)(end_it - start_it);
-            sendprfl[i*3+0] = (int)(sendcnt[i]); // Number of nonzeros in ith chunk
-            sendprfl[i*3+1] = (int)(A.GetLayerMat()->seqptr()->getnrow()); // Number of rows in ith chunk
-            sendprfl[i*3+2] = (int)(lbDivisions3d[i]); // Number of columns in ith chunk
-        }
-        std::partial_sum(sendcnt, sendcnt+A.getcommgrid3D()->GetGridLayers()-1, sdispls+1);
-#ifdef TIMING
-        t3 = MPI_Wtime();
-        if(myrank == 0) fprintf(stderr, "[MemEfficientSpGEMM3D]\tPhase: %d\tGetting Alltoall data ready: %lf\n", p, (t3-t2));
-#endif
-
-        // Send profile ready. Now need to update the tuples to reflect correct column id after column split.
-#ifdef TIMING
-        t2 = MPI_Wtime();
-#endif
-        for(int i=0; i < A.getcommgrid3D()->GetGridLayers(); ++i){
-#pragma omp parallel for schedule(static)
-            for(int j = 0; j < sendcnt[i]; j++){
-                std::get<1>(C_tuples->tuples[sdispls[i]+j]) = std::get<1>(C_tuples->tuples[sdispls[i]+j]) - lbDivisions3dPrefixSum[i];
-            }
-        }
-#ifdef TIMING
-        t3 = MPI_Wtime();
-        if(myrank == 0) fprintf(stderr, "[MemEfficientSpGEMM3D]\tPhase: %d\tGetting Alltoallv data ready: %lf\n", p, (t3-t2));
-#endif
-
-#ifdef TIMING
-        t2 = MPI_Wtime();
-#endif
-        MPI_Alltoall(sendprfl, 3, MPI_INT, recvprfl, 3, MPI_INT, A.getcommgrid3D()->fiberWorld);
-#ifdef TIMING
-        t3 = MPI_Wtime();
-        if(myrank == 0) fprintf(stderr, "[MemEfficientSpGEMM3D]\tPhase: %d\tAlltoall: %lf\n", p, (t3-t2));
-#endif
-#ifdef TIMING
-        t2 = MPI_Wtime();
-#endif
-        for(int i = 0; i < A.getcommgrid3D()->GetGridLayers(); i++) recvcnt[i] = recvprfl[i*3];
-        std::partial_sum(recvcnt, recvcnt+A.getcommgrid3D()->GetGridLayers()-1, rdispls+1);
-        IU totrecv = std::accumulate(recvcnt,recvcnt+A.getcommgrid3D()->GetGridLayers(), static_cast<IU>(0));
-        std::tuple<LIC,LIC,NUO>* recvTuples = static_cast<std::tuple<LIC,LIC,NUO>*> (::operator new (sizeof(std::tuple<LIC,LIC,NUO>[totrecv])));
-#ifdef TIMING
-        t3 = MPI_Wtime();
-        if(myrank == 0) fprintf(stderr, "[MemEfficientSpGEMM3D]\tPhase: %d\tAllocation of receive data: %lf\n", p, (t3-t2));
-#endif
-
-#ifdef TIMING
-        t2 = MPI_Wtime();
-#endif
-        MPI_Alltoallv(C_tuples->tuples, sendcnt, sdispls, MPI_tuple, recvTuples, recvcnt, rdispls, MPI_tuple, A.getcommgrid3D()->fiberWorld);
-        delete C_tuples;
-#ifdef TIMING
-        t3 = MPI_Wtime();
-        if(myrank == 0) fprintf(stderr, "[MemEfficientSpGEMM3D]\tPhase: %d\tAlltoallv: %lf\n", p, (t3-t2));
-#endif
-#ifdef TIMING
-        t2 = MPI_Wtime();
-#endif
-        vector<SpTuples<IU, NUO>*> recvChunks(A.getcommgrid3D()->GetGridLayers());
-#pragma omp parallel for
-        for (int i = 0; i < A.getcommgrid3D()->GetGridLayers(); i++){
-            recvChunks[i] = new SpTuples<LIC, NUO>(recvcnt[i], recvprfl[i*3+1], recvprfl[i*3+2], recvTuples + rdispls[i], true, false);
-        }
-#ifdef TIMING
-        t3 = MPI_Wtime();
-        if(myrank == 0) fprintf(stderr, "[MemEfficientSpGEMM3D]\tPhase: %d\trecvChunks creation: %lf\n", p, (t3-t2));
-#endif
-
-#ifdef TIMING
-        t2 = MPI_Wtime();
-#endif
-        // Free all memory except tempTuples; Because that is holding data of newly created local matrices after receiving.
-        DeleteAll(sendcnt, sendprfl, sdispls);
-        DeleteAll(recvcnt, recvprfl, rdispls); 
-        MPI_Type_free(&MPI_tuple);
-#ifdef TIMING
-        t3 = MPI_Wtime();
-        if(myrank == 0) fprintf(stderr, "[MemEfficientSpGEMM3D]\tPhase: %d\tMemory freeing: %lf\n", p, (t3-t2));
-#endif
-        /*
-         * 3d-reduction ends 
-         * */
-        
+        SpTuples<IU, NUO> * merged_tuples = FiberReduce<SR>(C_tuples, lbDivisions3d, A.getcommgrid3D()->fiberWorld, false); // deletes C_tuples
 #ifdef TIMING
         t1 = MPI_Wtime();
         mcl3d_reductiontime += (t1-t0);
         if(myrank == 0) fprintf(stderr, "[MemEfficientSpGEMM3D]\tPhase: %d\tReduction time: %lf\n", p, (t1-t0));
-#endif
-#ifdef TIMING
-        t0 = MPI_Wtime();
-#endif
-        /*
-         * 3d-merge starts 
-         * */
-        SpTuples<IU, NUO> * merged_tuples = MultiwayMergeHash<SR, IU, NUO>(recvChunks, recvChunks[0]->getnrow(), recvChunks[0]->getncol(), false, false); // Do not delete
-#ifdef TIMING
-        t1 = MPI_Wtime();
-        mcl3d_3dmergetime += (t1-t0);
-        if(myrank == 0) fprintf(stderr, "[MemEfficientSpGEMM3D]\tPhase: %d\t3D Merge time: %lf\n", p, (t1-t0));
         mcl3d_proc_nnzc_post_red += merged_tuples->getnnz();
 #endif
         /*
-         * 3d-merge ends
+         * 3d-reduction ends 
          * */
-        // Discard merged result if not needed anymore
-        //delete merged_tuples; 
 #ifdef TIMING
         t0 = MPI_Wtime();
 #endif
-        // Do not delete elements of recvChunks, because that would give segmentation fault due to double free
-        ::operator delete(recvTuples);
-        for(int i = 0; i < recvChunks.size(); i++){
-            recvChunks[i]->tuples_deleted = true; // Temporary patch to avoid memory leak and segfault
-            delete recvChunks[i]; // As the patch is used, now delete each element of recvChunks
-        }
-        vector<SpTuples<IU,NUO>*>().swap(recvChunks); // As the patch is used, now delete recvChunks
 
         // This operation is not needed if result can be used and discareded right away
         // This operation is being done because it is needed by MCLPruneRecoverySelect
         UDERO * phaseResultant = new UDERO(*merged_tuples, false);
+        delete merged_tuples;
         SpParMat<IU, NUO, UDERO> phaseResultantLayer(phaseResultant, A.getcommgrid3D()->layerWorld);
         MCLPruneRecoverySelect(phaseResultantLayer, hardThreshold, selectNum, recoverNum, recoverPct, kselectVersion);
 #ifdef TIMING
@@ -0,0 +1,787 @@
+/****************************************************************/
+/* Parallel Combinatorial BLAS Library (for Graph Computations) */
+/* version 1.6 -------------------------------------------------*/
+/* date: 6/15/2017 ---------------------------------------------*/
+/* authors: Ariful Azad, Aydin Buluc  --------------------------*/
+/****************************************************************/
+/*
+ Copyright (c) 2010-2017, The Regents of the University of California
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+#ifndef _RCM_H_
+#define _RCM_H_
+
+#include <mpi.h>
+#include <iostream>
+#include <vector>
+#include <tuple>
+#include <algorithm>
+#include <numeric>
+#include "SpDefs.h"
+#include "SpParMat.h"
+#include "FullyDistVec.h"
+#include "FullyDistSpVec.h"
+#include "PreAllocatedSPA.h"
+#include "ParFriends.h"
+#include "MPIType.h"
+
+namespace combblas {
+
+/**
+ * (parent order, degree) key of a vertex in the next BFS level
+ */
+struct RCMVertex
+{
+public:
+    RCMVertex(int64_t ord=-1, int64_t deg=-1){order=ord; degree = deg;};
+
+    friend bool operator<(const RCMVertex & vtx1, const RCMVertex & vtx2 )
+    {
+        if(vtx1.order==vtx2.order) return vtx1.degree < vtx2.degree;
+        else return vtx1.order<vtx2.order;
+    };
+    friend bool operator<=(const RCMVertex & vtx1, const RCMVertex & vtx2 )
+    {
+        if(vtx1.order==vtx2.order) return vtx1.degree <= vtx2.degree;
+        else return vtx1.order<vtx2.order;
+    };
+    friend bool operator>(const RCMVertex & vtx1, const RCMVertex & vtx2 )
+    {
+        if(vtx1.order==vtx2.order) return vtx1.degree > vtx2.degree;
+        else return vtx1.order>vtx2.order;
+    };
+    friend bool operator>=(const RCMVertex & vtx1, const RCMVertex & vtx2 )
+    {
+        if(vtx1.order==vtx2.order) return vtx1.degree >= vtx2.degree;
+        else return vtx1.order>vtx2.order;
+    };
+    friend bool operator==(const RCMVertex & vtx1, const RCMVertex & vtx2 ){return vtx1.order==vtx2.order && vtx1.degree==vtx2.degree;};
+    friend std::ostream& operator<<(std::ostream& os, const RCMVertex & vertex ){os << "(" << vertex.order << "," << vertex.degree << ")"; return os;};
+
+    int64_t order;
+    int64_t degree;
+};
+
+
+struct RCMSelectMinSR
+{
+    typedef int64_t T_promote;
+    static T_promote id(){ return -1; };
+    static bool returnedSAID() { return false; }
+
+    static T_promote add(const T_promote & arg1, const T_promote & arg2)
+    {
+        return std::min(arg1, arg2);
+    }
+
+    static T_promote multiply(const bool & arg1, const T_promote & arg2)
+    {
+        return arg2;
+    }
+
+    static void axpy(bool a, const T_promote & x, T_promote & y)
+    {
+        y = std::min(y, x);
+    }
+};
+
+
+struct RCMCountSR
+{
+    typedef int64_t T_promote;
+    static T_promote id(){ return 0; };
+    static bool returnedSAID() { return false; }
+
+    static T_promote add(const T_promote & arg1, const T_promote & arg2)
+    {
+        return arg1 + arg2;
+    }
+
+    static T_promote multiply(const bool & arg1, const T_promote & arg2)
+    {
+        return arg2;
+    }
+
+    static void axpy(bool a, const T_promote & x, T_promote & y)
+    {
+        y += x;
+    }
+};
+
+
+/**
+ * Replicates the concatenation of every process' local vector on all processes
+ */
+template <typename T>
+std::vector<T> RCMAllGather(const std::vector<T> & local, MPI_Comm World)
+{
+    int nprocs;
+    MPI_Comm_size(World, &nprocs);
+    int mysize = static_cast<int>(local.size());
+    std::vector<int> recvcnt(nprocs);
+    std::vector<int> rdispls(nprocs+1, 0);
+    MPI_Allgather(&mysize, 1, MPI_INT, recvcnt.data(), 1, MPI_INT, World);
+    std::partial_sum(recvcnt.begin(), recvcnt.end(), rdispls.begin()+1);
+    std::vector<T> all(rdispls[nprocs]);
+    MPI_Allgatherv(local.data(), mysize, MPIType<T>(), all.data(), recvcnt.data(), rdispls.data(), MPIType<T>(), World);
+    return all;
+}
+
+/**
+ * Replicates the nonzeros of x on all processes, sorted by their global indices
+ */
+inline void RCMAllGather(FullyDistSpVec<int64_t, int64_t> & x, std::vector<int64_t> & inds, std::vector<int64_t> & nums)
+{
+    MPI_Comm World = x.getcommgrid()->GetWorld();
+    std::vector<int64_t> lind = x.GetLocalInd();
+    int64_t offset = x.LengthUntil();
+    for(auto & i : lind) i += offset;
+    inds = RCMAllGather(lind, World);
+    nums = RCMAllGather(x.GetLocalNum(), World);
+}
+
+/**
+ * Inverse of RCMAllGather: every process keeps the replicated (vertex, value) pairs it owns
+ */
+inline FullyDistSpVec<int64_t, int64_t> RCMScatter(std::shared_ptr<CommGrid> grid, int64_t glen, const std::vector<int64_t> & inds, const std::vector<int64_t> & nums)
+{
+    FullyDistSpVec<int64_t, int64_t> owners(grid, glen);
+    int myrank = grid->GetRank();
+    std::vector<int64_t> lind, lnum;
+    for(size_t i=0; i < inds.size(); ++i)
+    {
+        int64_t locind;
+        if(owners.Owner(inds[i], locind) == myrank)
+        {
+            lind.push_back(locind);
+            lnum.push_back(nums[i]);
+        }
+    }
+    return FullyDistSpVec<int64_t, int64_t>(grid, glen, lind, lnum);
+}
+
+
+/**
+ * Column-indexed copy of the local block of a symmetric matrix, used to gather the adjacency of small BFS levels
+ * without a distributed SpMV. Costs one local index per local nonzero, built once per RCM call.
+ */
+template <typename PARMAT>
+class RCMLocalColumns
+{
+public:
+    typedef typename PARMAT::LocalIT LocalIT;
+
+    RCMLocalColumns(PARMAT & A): commGrid(A.getcommgrid())
+    {
+        int64_t m_perproc = A.getnrow() / commGrid->GetGridRows();
+        int64_t n_perproc = A.getncol() / commGrid->GetGridCols();
+        roffset = commGrid->GetRankInProcCol() * m_perproc;
+        coffset = commGrid->GetRankInProcRow() * n_perproc;
+        ncols = A.getlocalcols();
+
+        colptr.assign(ncols+1, 0);
+        for(auto colit = A.seq().begcol(); colit != A.seq().endcol(); ++colit)
+            colptr[colit.colid()+1] = colit.nnz();
+        std::partial_sum(colptr.begin(), colptr.end(), colptr.begin());
+        rowids.resize(colptr[ncols]);
+        for(auto colit = A.seq().begcol(); colit != A.seq().endcol(); ++colit)
+        {
+            LocalIT k = colptr[colit.colid()];
+            for(auto nzit = A.seq().begnz(colit); nzit != A.seq().endnz(colit); ++nzit)
+                rowids[k++] = nzit.rowid();
+        }
+    }
+
+    /**
+     * Gathers the complete columns of the sorted vertices on every process.
+     * The neighbors of vertices[i] are stored in adj[ptr[i]], ..., adj[ptr[i+1]-1]
+     */
+    void Gather(const std::vector<int64_t> & vertices, std::vector<int64_t> & ptr, std::vector<int64_t> & adj) const
+    {
+        std::vector<int64_t> sendbuf;	// (vertex, neighbor) pairs found in the local block
+        auto lower = std::lower_bound(vertices.begin(), vertices.end(), coffset);
+        auto upper = std::lower_bound(lower, vertices.end(), coffset + static_cast<int64_t>(ncols));
+        for(auto it = lower; it != upper; ++it)
+        {
+            LocalIT j = static_cast<LocalIT>(*it - coffset);
+            for(LocalIT k = colptr[j]; k < colptr[j+1]; ++k)
+            {
+                sendbuf.push_back(*it);
+                sendbuf.push_back(roffset + rowids[k]);
+            }
+        }
+        std::vector<int64_t> recvbuf = RCMAllGather(sendbuf, commGrid->GetWorld());
+
+        // a column is split across a processor column, so bucket the pairs by vertex
+        int64_t npairs = recvbuf.size() / 2;
+        std::vector<int64_t> pos(npairs);
+        ptr.assign(vertices.size()+1, 0);
+        for(int64_t k=0; k < npairs; ++k)
+        {
+            pos[k] = std::lower_bound(vertices.begin(), vertices.end(), recvbuf[2*k]) - vertices.begin();
+            ++ptr[pos[k]+1];
+        }
+        std::partial_sum(ptr.begin(), ptr.end(), ptr.begin());
+        std::vector<int64_t> curptr(ptr.begin(), ptr.end()-1);
+        adj.resize(npairs);
+        for(int64_t k=0; k < npairs; ++k)
+            adj[curptr[pos[k]]++] = recvbuf[2*k+1];
+    }
+
+private:
+    std::shared_ptr<CommGrid> commGrid;
+    int64_t roffset;
+    int64_t coffset;
+    LocalIT ncols;
+    std::vector<LocalIT> colptr;
+    std::vector<LocalIT> rowids;
+};
+
+
+/**
+ * Returns the sorted vertices adjacent to the sorted level that belong neither to it nor to the sorted level prev
+ * preceding it, each paired with the smallest key among its neighbors in level
+ */
+inline std::vector< std::pair<int64_t, int64_t> > RCMNextLevel(const std::vector<int64_t> & prev, const std::vector<int64_t> & level, const std::vector<int64_t> & keys,
+                                                             const std::vector<int64_t> & ptr, const std::vector<int64_t> & adj)
+{
+    std::vector< std::pair<int64_t, int64_t> > next;
+    for(size_t i=0; i < level.size(); ++i)
+    {
+        for(int64_t k = ptr[i]; k < ptr[i+1]; ++k)
+        {
+            int64_t u = adj[k];
+            if(!std::binary_search(prev.begin(), prev.end(), u) && !std::binary_search(level.begin(), level.end(), u))
+                next.push_back(std::make_pair(u, keys[i]));
+        }
+    }
+    std::sort(next.begin(), next.end());
+    next.erase(std::unique(next.begin(), next.end(), [](const std::pair<int64_t, int64_t> & a, const std::pair<int64_t, int64_t> & b){ return a.first == b.first; }), next.end());
+    return next;
+}
+
+
+/**
+ * Distributed sort of the next BFS level by (parent order, degree, vertex);
+ * returns the new labels, which start at endLabel+1
+ */
+inline FullyDistSpVec<int64_t, int64_t> RCMGetOrder(FullyDistSpVec<int64_t, RCMVertex> &fringeRow, int64_t startLabel, int64_t endLabel)
+{
+    MPI_Comm World = fringeRow.getcommgrid()->GetWorld();
+    int myrank, nprocs;
+    MPI_Comm_rank(World,&myrank);
+    MPI_Comm_size(World,&nprocs);
+
+    std::vector<int64_t> lind = fringeRow.GetLocalInd ();
+    std::vector<RCMVertex> lnum = fringeRow.GetLocalNum ();
+    int64_t ploclen = lind.size();
+
+    int64_t nparents = endLabel - startLabel + 1;
+    int64_t perproc = nparents/nprocs;
+
+    int * rdispls = new int[nprocs+1];
+    int * recvcnt = new int[nprocs];
+    int * sendcnt = new int[nprocs](); // initialize to 0
+    int * sdispls = new int[nprocs+1];
+
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for(int64_t k=0; k < ploclen; ++k)
+    {
+        int64_t temp = lnum[k].order-startLabel;
+        int owner;
+        if(perproc==0 || temp/perproc > nprocs-1)
+            owner = nprocs-1;
+        else
+            owner = temp/perproc;
+
+#ifdef _OPENMP
+        __sync_fetch_and_add(&sendcnt[owner], 1);
+#else
+        sendcnt[owner]++;
+#endif
+    }
+
+    MPI_Alltoall(sendcnt, 1, MPI_INT, recvcnt, 1, MPI_INT, World);  // share the request counts
+
+    sdispls[0] = 0;
+    rdispls[0] = 0;
+    for(int i=0; i<nprocs; ++i)
+    {
+        sdispls[i+1] = sdispls[i] + sendcnt[i];
+        rdispls[i+1] = rdispls[i] + recvcnt[i];
+    }
+
+    int64_t * datbuf1 = new int64_t[ploclen];
+    int64_t * datbuf2 = new int64_t[ploclen];
+    int64_t * indbuf = new int64_t[ploclen];
+    int *count = new int[nprocs](); //current position
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for(int64_t i=0; i < ploclen; ++i)
+    {
+        int64_t temp = lnum[i].order-startLabel;
+        int owner;
+        if(perproc==0 || temp/perproc > nprocs-1)
+            owner = nprocs-1;
+        else
+            owner = temp/perproc;
+
+        int id;
+#ifdef _OPENMP
+        id = sdispls[owner] + __sync_fetch_and_add(&count[owner], 1);
+#else
+        id = sdispls[owner] + count[owner];
+        count[owner]++;
+#endif
+
+        datbuf1[id] = temp;
+        datbuf2[id] = lnum[i].degree;
+        indbuf[id] = lind[i] + fringeRow.LengthUntil();
+    }
+    delete [] count;
+
+    int64_t totrecv = rdispls[nprocs];
+    int64_t * recvdatbuf1 = new int64_t[totrecv];
+    int64_t * recvdatbuf2 = new int64_t[totrecv];
+    MPI_Alltoallv(datbuf1, sendcnt, sdispls, MPIType<int64_t>(), recvdatbuf1, recvcnt, rdispls, MPIType<int64_t>(), World);
+    delete [] datbuf1;
+    MPI_Alltoallv(datbuf2, sendcnt, sdispls, MPIType<int64_t>(), recvdatbuf2, recvcnt, rdispls, MPIType<int64_t>(), World);
+    delete [] datbuf2;
+
+    int64_t * recvindbuf = new int64_t[totrecv];
+    MPI_Alltoallv(indbuf, sendcnt, sdispls, MPIType<int64_t>(), recvindbuf, recvcnt, rdispls, MPIType<int64_t>(), World);
+    delete [] indbuf;
+
+    std::tuple<int64_t,int64_t, int64_t>* tosort = static_cast<std::tuple<int64_t,int64_t, int64_t>*> (::operator new (sizeof(std::tuple<int64_t,int64_t, int64_t>)*totrecv));
+
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for(int64_t i=0; i<totrecv; ++i)
+    {
+        tosort[i] = std::make_tuple(recvdatbuf1[i], recvdatbuf2[i], recvindbuf[i]);
+    }
+
+#if defined(GNU_PARALLEL) && defined(_OPENMP)
+    __gnu_parallel::sort(tosort, tosort+totrecv);
+#else
+    std::sort(tosort, tosort+totrecv);
+#endif
+
+    // send order back
+    int * sendcnt1 = new int[nprocs]();
+
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for(int64_t k=0; k < totrecv; ++k)
+    {
+        int64_t locind;
+        int owner = fringeRow.Owner(std::get<2>(tosort[k]), locind);
+#ifdef _OPENMP
+        __sync_fetch_and_add(&sendcnt1[owner], 1);
+#else
+        sendcnt1[owner]++;
+#endif
+    }
+
+    MPI_Alltoall(sendcnt1, 1, MPI_INT, recvcnt, 1, MPI_INT, World);  // share the request counts
+
+    sdispls[0] = 0;
+    rdispls[0] = 0;
+    for(int i=0; i<nprocs; ++i)
+    {
+        sdispls[i+1] = sdispls[i] + sendcnt1[i];
+        rdispls[i+1] = rdispls[i] + recvcnt[i];
+    }
+
+    std::vector<int64_t> sortperproc (nprocs);
+    sortperproc[myrank] = totrecv;
+    MPI_Allgather(MPI_IN_PLACE, 1, MPIType<int64_t>(), sortperproc.data(), 1, MPIType<int64_t>(), World);
+
+    std::vector<int64_t> disp(nprocs+1);
+    disp[0] = 0;
+    for(int i=0; i<nprocs; ++i)
+    {
+        disp[i+1] = disp[i] + sortperproc[i];
+    }
+
+    ploclen = totrecv;
+
+    int64_t * datbuf = new int64_t[ploclen];
+    indbuf = new int64_t[ploclen];
+    count = new int[nprocs](); //current position
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for(int64_t i=0; i < ploclen; ++i)
+    {
+        int64_t locind;
+        int owner = fringeRow.Owner(std::get<2>(tosort[i]), locind);
+        int id;
+#ifdef _OPENMP
+        id = sdispls[owner] + __sync_fetch_and_add(&count[owner], 1);
+#else
+        id = sdispls[owner] + count[owner];
+        count[owner]++;
+#endif
+        datbuf[id] = i + disp[myrank] + endLabel + 1;
+        indbuf[id] = locind;
+    }
+    delete [] count;
+
+    totrecv = rdispls[nprocs];
+    std::vector<int64_t> recvdatbuf3 (totrecv);
+    MPI_Alltoallv(datbuf, sendcnt1, sdispls, MPIType<int64_t>(), recvdatbuf3.data(), recvcnt, rdispls, MPIType<int64_t>(), World);
+    delete [] datbuf;
+
+    std::vector<int64_t> recvindbuf3 (totrecv);
+    MPI_Alltoallv(indbuf, sendcnt1, sdispls, MPIType<int64_t>(), recvindbuf3.data(), recvcnt, rdispls, MPIType<int64_t>(), World);
+    delete [] indbuf;
+
+    FullyDistSpVec<int64_t, int64_t> order(fringeRow.getcommgrid(), fringeRow.TotalLength(), recvindbuf3, recvdatbuf3);
+    DeleteAll(recvindbuf, recvdatbuf1, recvdatbuf2);
+    DeleteAll(sdispls, rdispls, sendcnt, sendcnt1, recvcnt);
+    ::operator delete(tosort);
+
+    return order;
+}
+
+
+/**
+ * Orders consecutive small BFS levels redundantly on every process, replacing the distributed SpMV and sort of each level
+ * by a single gather of the level's columns. A level is sorted by (parent order, column nonzeros, vertex), which matches
+ * RCMGetOrder as long as the degrees are the column nonzero counts.
+ * On entry, level holds the last labeled level and fringe the next one with the smallest order of their parents.
+ * On return, fringe holds the last level labeled here (empty if the component is exhausted) and [startLabel, endLabel] its labels.
+ * @return the number of levels labeled
+ */
+template <typename PARMAT>
+int64_t RCMLocalOrder(const RCMLocalColumns<PARMAT> & local, FullyDistSpVec<int64_t, int64_t> & level, FullyDistSpVec<int64_t, int64_t> & fringe,
+                      FullyDistVec<int64_t, int64_t> & order, int64_t & startLabel, int64_t & endLabel, int64_t smallfrontier)
+{
+    std::vector<int64_t> prev, prevlabels, next, parents, ptr, adj;
+    RCMAllGather(level, prev, prevlabels);
+    RCMAllGather(fringe, next, parents);
+    int64_t nlevels = 0;
+    while(!next.empty() && static_cast<int64_t>(next.size()) <= smallfrontier)
+    {
+        local.Gather(next, ptr, adj);
+        std::vector< std::tuple<int64_t, int64_t, int64_t> > tosort(next.size());
+        for(size_t i=0; i < next.size(); ++i)
+            tosort[i] = std::make_tuple(parents[i], ptr[i+1]-ptr[i], next[i]);
+        std::sort(tosort.begin(), tosort.end());
+
+        std::vector<int64_t> labels(next.size());
+        for(size_t k=0; k < tosort.size(); ++k)
+        {
+            int64_t v = std::get<2>(tosort[k]);
+            labels[std::lower_bound(next.begin(), next.end(), v) - next.begin()] = endLabel + 1 + k;
+            order.SetElement(v, endLabel + 1 + k);	// no communication: only the owner stores it
+        }
+        startLabel = endLabel + 1;
+        endLabel += next.size();
+        ++nlevels;
+
+        std::vector< std::pair<int64_t, int64_t> > following = RCMNextLevel(prev, next, labels, ptr, adj);
+        prev.swap(next);
+        prevlabels.swap(labels);
+        next.resize(following.size());
+        parents.resize(following.size());
+        for(size_t i=0; i < following.size(); ++i)
+        {
+            next[i] = following[i].first;
+            parents[i] = following[i].second;
+        }
+    }
+    if(next.empty())
+    {
+        fringe = FullyDistSpVec<int64_t, int64_t>(fringe.getcommgrid(), fringe.TotalLength());
+        startLabel = endLabel + 1;
+    }
+    else	// the distributed path recomputes the large level from the last small one
+    {
+        fringe = RCMScatter(fringe.getcommgrid(), fringe.TotalLength(), prev, prevlabels);
+    }
+    return nlevels;
+}
+
+/**
+ * Level structure counterpart of RCMLocalOrder used by the pseudo-peripheral vertex search: marks consecutive small
+ * levels in levels with curLevel, curLevel+1, ... and leaves the last marked level in fringe
+ * @return the size of fringe
+ */
+template <typename PARMAT>
+int64_t RCMLocalLevels(const RCMLocalColumns<PARMAT> & local, FullyDistSpVec<int64_t, int64_t> & level, FullyDistSpVec<int64_t, int64_t> & fringe,
+                       FullyDistVec<int64_t, int64_t> & levels, int64_t & curLevel, int64_t smallfrontier)
+{
+    std::vector<int64_t> prev, next, values, ptr, adj;
+    RCMAllGather(level, prev, values);
+    RCMAllGather(fringe, next, values);
+    while(!next.empty() && static_cast<int64_t>(next.size()) <= smallfrontier)
+    {
+        for(int64_t v : next)
+            levels.SetElement(v, curLevel);
+        curLevel++;
+        local.Gather(next, ptr, adj);
+        values.assign(next.size(), curLevel);
+        std::vector< std::pair<int64_t, int64_t> > following = RCMNextLevel(prev, next, values, ptr, adj);
+        prev.swap(next);
+        next.resize(following.size());
+        for(size_t i=0; i < following.size(); ++i)
+            next[i] = following[i].first;
+    }
+    if(next.empty())
+    {
+        fringe = FullyDistSpVec<int64_t, int64_t>(fringe.getcommgrid(), fringe.TotalLength());
+        curLevel++;	// the distributed loop counts the empty level as well
+        return 0;
+    }
+    values.assign(prev.size(), curLevel-1);
+    fringe = RCMScatter(fringe.getcommgrid(), fringe.TotalLength(), prev, values);
+    return prev.size();
+}
+
+
+/**
+ * Cuthill-McKee ordering of one connected component from a pseudo peripheral vertex.
+ * With local != NULL, runs of levels with at most smallfrontier vertices are ordered by RCMLocalOrder.
+ */
+template <typename PARMAT>
+void RCMOrder(PARMAT & A, int64_t source, FullyDistVec<int64_t, int64_t>& order, int64_t startOrder, FullyDistVec<int64_t, int64_t> degrees, PreAllocatedSPA<int64_t>& SPA,
+              const RCMLocalColumns<PARMAT> * local = NULL, int64_t smallfrontier = RCMSMALLFRONTIER)
+{
+    double tSpMV=0, tOrder, tSpMV1, tsort=0, tsort1, tlocal=0, tlocal1;
+    int64_t locallevels = 0;
+    tOrder = MPI_Wtime();
+
+    int64_t nv = A.getnrow();
+    FullyDistSpVec<int64_t, int64_t> fringe(A.getcommgrid(),  nv );
+    order.SetElement(source, startOrder);
+    fringe.SetElement(source, startOrder);
+
+    int64_t startLabel = startOrder;
+    int64_t endLabel = startOrder;
+
+    while(startLabel <= endLabel) // continue until the frontier is empty
+    {
+        fringe = EWiseApply<int64_t>(fringe, order,
+                                     [](int64_t parent_order, int64_t ord){return ord;},
+                                     [](int64_t parent_order, int64_t ord){return true;},
+                                     false, (int64_t) -1);
+        bool smalllevel = (local != NULL && endLabel - startLabel + 1 <= smallfrontier);
+        FullyDistSpVec<int64_t, int64_t> level(A.getcommgrid(), nv);
+        if(smalllevel) level = fringe;
+
+        tSpMV1 = MPI_Wtime();
+        SpMV<RCMSelectMinSR>(A, fringe, fringe, false, SPA);
+        tSpMV += MPI_Wtime() - tSpMV1;
+        fringe = EWiseMult(fringe, order, true, (int64_t) -1);
+        int64_t nnext = fringe.getnnz();
+
+        if(smalllevel && nnext <= smallfrontier)
+        {
+            tlocal1 = MPI_Wtime();
+            locallevels += RCMLocalOrder(*local, level, fringe, order, startLabel, endLabel, smallfrontier);
+            tlocal += MPI_Wtime() - tlocal1;
+            continue;
+        }
+
+        FullyDistSpVec<int64_t, RCMVertex> fringeRow = EWiseApply<RCMVertex>(fringe, degrees,
+                                                                               [](int64_t parent_order, int64_t degree){return RCMVertex(parent_order, degree);},
+                                                                               [](int64_t parent_order, int64_t degree){return true;},
+                                                                               false, (int64_t) -1);
+
+        tsort1 = MPI_Wtime();
+        FullyDistSpVec<int64_t, int64_t> levelOrder = RCMGetOrder(fringeRow, startLabel, endLabel);
+        tsort += MPI_Wtime()-tsort1;
+        order.Set(levelOrder);
+        startLabel = endLabel + 1;
+        endLabel += nnext;
+    }
+
+    tOrder = MPI_Wtime() - tOrder;
+#ifdef TIMING
+    double tOther = tOrder - tSpMV - tsort - tlocal;
+    std::ostringstream outs;
+    outs << "    Computing the RCM ordering: " <<  tOrder << " seconds [SpMV: " << tSpMV << ", sorting: " << tsort << ", local levels: " << tlocal << " (" << locallevels << "), other: " << tOther << "]" << std::endl;
+    SpParHelper::Print(outs.str());
+#endif
+}
+
+
+template <typename PARMAT>
+int64_t PseudoPeripheralVertex(PARMAT & A, FullyDistSpVec<int64_t, std::pair<int64_t, int64_t>>& unvisitedVertices, FullyDistVec<int64_t, int64_t> degrees, PreAllocatedSPA<int64_t>& SPA,
+                               const RCMLocalColumns<PARMAT> * local = NULL, int64_t smallfrontier = RCMSMALLFRONTIER)
+{
+    double tTotal = MPI_Wtime();
+    int64_t prevLevel=-1, curLevel=0; // initialized just to make the first iteration going
+
+    // Select a minimum-degree unvisited vertex as the initial source
+    std::pair<int64_t, int64_t> mindegree_vertex = unvisitedVertices.Reduce(minimum<std::pair<int64_t, int64_t> >(), std::make_pair(LLONG_MAX, (int64_t)-1));
+    int64_t source = mindegree_vertex.second;
+
+    //level structure in the current BFS tree
+    //we are not using this information. Currently it is serving as visited flag
+    FullyDistVec<int64_t, int64_t> level ( A.getcommgrid(),  A.getnrow(), (int64_t) -1);
+
+    int iterations = 0;
+    double tSpMV=0, tSpMV1;
+    while(curLevel > prevLevel)
+    {
+        prevLevel = curLevel;
+        FullyDistSpVec<int64_t, int64_t> fringe(A.getcommgrid(),  A.getnrow() );
+        level = (int64_t)-1; // reset level structure in every iteration
+        level.SetElement(source, 1); // place source at level 1
+        fringe.SetElement(source, 1); // include source to the initial fringe
+        curLevel = 2;
+        int64_t nfringe = 1;
+        while(nfringe > 0) // continue until the frontier is empty
+        {
+            bool smalllevel = (local != NULL && nfringe <= smallfrontier);
+            FullyDistSpVec<int64_t, int64_t> visited(A.getcommgrid(), A.getnrow());
+            if(smalllevel) visited = fringe;
+
+            tSpMV1 = MPI_Wtime();
+            SpMV<RCMSelectMinSR>(A, fringe, fringe, false, SPA);
+            tSpMV += MPI_Wtime() - tSpMV1;
+            fringe = EWiseMult(fringe, level, true, (int64_t) -1);
+            nfringe = fringe.getnnz();
+            if(smalllevel && nfringe <= smallfrontier)
+            {
+                nfringe = RCMLocalLevels(*local, visited, fringe, level, curLevel, smallfrontier);
+                continue;
+            }
+            // set value to the current level
+            fringe=curLevel;
+            curLevel++;
+            level.Set(fringe);
+        }
+        curLevel = curLevel-2;
+
+        // last non-empty level (we can avoid this by keeping the last nonempty fringe)
+        fringe = level.Find(curLevel);
+        fringe.setNumToInd();
+
+        // find a minimum degree vertex in the last level
+        FullyDistSpVec<int64_t, std::pair<int64_t, int64_t>> fringe_degree =
+        EWiseApply<std::pair<int64_t, int64_t>>(fringe, degrees,
+                                           [](int64_t vtx, int64_t deg){return std::make_pair(deg, vtx);},
+                                           [](int64_t vtx, int64_t deg){return true;},
+                                           false, (int64_t) -1);
+        mindegree_vertex = fringe_degree.Reduce(minimum<std::pair<int64_t, int64_t> >(), std::make_pair(LLONG_MAX, (int64_t)-1));
+        if (curLevel > prevLevel)
+            source = mindegree_vertex.second;
+        iterations++;
+    }
+
+    // remove vertices in the current connected component
+    unvisitedVertices = EWiseApply<std::pair<int64_t, int64_t>>(unvisitedVertices, level,
+                                                           [](std::pair<int64_t, int64_t> vtx, int64_t visited){return vtx;},
+                                                           [](std::pair<int64_t, int64_t> vtx, int64_t visited){return visited==-1;},
+                                                           false, std::make_pair((int64_t)-1, (int64_t)0));
+
+    tTotal = MPI_Wtime() - tTotal;
+#ifdef TIMING
+    double tOther = tTotal - tSpMV;
+    std::ostringstream outs;
+    outs << "    vertex " << source << " is a pseudo peripheral vertex" << std::endl;
+    outs << "    pseudo diameter: " << curLevel << ", #iterations: "<< iterations <<  std::endl;
+    outs << "    Total time: " <<  tTotal << " seconds [SpMV: " << tSpMV << ", other: " << tOther << "]" << std::endl;
+    SpParHelper::Print(outs.str());
+#endif
+    return source;
+}
+
+
+/**
+ * Cuthill-McKee ordering of a symmetric matrix without self loops, one connected component at a time.
+ * Subtract the returned labels from the number of vertices for the reverse ordering.
+ * @param[in] degrees number of nonzeros in every column of A
+ * @param[in] smallfrontier BFS levels with at most this many vertices are expanded redundantly on every process
+ * with one gather per level instead of a distributed SpMV and sort; 0 keeps every level distributed
+ */
+template <typename PARMAT>
+FullyDistVec<int64_t, int64_t> RCM(PARMAT & A, FullyDistVec<int64_t, int64_t> degrees, PreAllocatedSPA<int64_t>& SPA, int64_t smallfrontier = RCMSMALLFRONTIER)
+{
+    RCMLocalColumns<PARMAT> * local = NULL;
+    if(smallfrontier > 0)
+        local = new RCMLocalColumns<PARMAT>(A);
+
+    FullyDistSpVec<int64_t, int64_t> unvisited ( A.getcommgrid(),  A.getnrow());
+    unvisited.iota(A.getnrow(), (int64_t) 0); // index and values become the same
+    // The list of unvisited vertices. The value is (degree, vertex index) pair
+    FullyDistSpVec<int64_t, std::pair<int64_t, int64_t>> unvisitedVertices =
+    EWiseApply<std::pair<int64_t, int64_t>>(unvisited, degrees,
+                                       [](int64_t vtx, int64_t deg){return std::make_pair(deg, vtx);},
+                                       [](int64_t vtx, int64_t deg){return true;},
+                                       false, (int64_t) -1);
+
+    // The RCM order will be stored here
+    FullyDistVec<int64_t, int64_t> rcmorder ( A.getcommgrid(),  A.getnrow(), (int64_t) -1);
+
+    int64_t numUnvisited = unvisitedVertices.getnnz();
+    while(numUnvisited>0) // for each connected component
+    {
+        // Get a pseudo-peripheral vertex to start the RCM algorithm
+        int64_t source = PseudoPeripheralVertex(A, unvisitedVertices, degrees, SPA, local, smallfrontier);
+
+        // Get the RCM ordering in this connected component
+        int64_t curOrder =  A.getnrow() - numUnvisited;
+        RCMOrder(A, source, rcmorder, curOrder, degrees, SPA, local, smallfrontier);
+
+        numUnvisited = unvisitedVertices.getnnz();
+    }
+    delete local;
+    return rcmorder;
+}
+
+/**
+ * Convenience overload that computes the degrees and the SpMV accumulator itself
+ */
+template <typename PARMAT>
+FullyDistVec<int64_t, int64_t> RCM(PARMAT & A, int64_t smallfrontier = RCMSMALLFRONTIER)
+{
+    int nthreads = 1;
+#ifdef THREADED
+#pragma omp parallel
+    {
+        nthreads = omp_get_num_threads();
+    }
+#endif
+    PreAllocatedSPA<int64_t> SPA(A.seq(), nthreads*4);
+
+    // column reductions are not implemented for every local format, so count the neighbors of all vertices with SpMSpV instead (A is symmetric)
+    FullyDistSpVec<int64_t, int64_t> all ( A.getcommgrid(),  A.getnrow());
+    all.iota(A.getnrow(), (int64_t) 0);
+    all = (int64_t) 1;
+    SpMV<RCMCountSR>(A, all, all, false, SPA);
+    FullyDistVec<int64_t, int64_t> degrees ( A.getcommgrid(),  A.getnrow(), (int64_t) 0);
+    degrees.Set(all);
+    return RCM(A, degrees, SPA, smallfrontier);
+}
+
+}
+
+#endif
@@ -0,0 +1,124 @@
+/****************************************************************/
+/* Parallel Combinatorial BLAS Library (for Graph Computations) */
+/* version 1.6 -------------------------------------------------*/
+/* date: 6/15/2017 ---------------------------------------------*/
+/* authors: Ariful Azad, Aydin Buluc  --------------------------*/
+/****************************************************************/
+/*
+ Copyright (c) 2010-2017, The Regents of the University of California
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+#ifndef _RAND_PERMUTATION_H_
+#define _RAND_PERMUTATION_H_
+
+#include <stdint.h>
+
+namespace combblas {
+
+/**
+  * Finalizer of splitmix64, a cheap bijective avalanche function
+  * Hashing (key, counter) with it gives a counter-based random stream that any thread or process can index directly
+  **/
+inline uint64_t SplitMix64(uint64_t z)
+{
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+/**
+  * Implicit random permutation of {0,...,n-1}
+  * A balanced Feistel network keyed by (seed,round) is a bijection on [0,4^h) for any round function.
+  * Restricting it to [0,n) by cycle-walking gives a bijection on [0,n) as well, with 4^h < 4n.
+  * Hence p(i) and its inverse are computable by any processor for any i, without storage or communication.
+  * All processors that construct the object with the same (n,seed) agree on the same permutation
+  **/
+template <class IT>
+class FeistelPermutation
+{
+public:
+	FeistelPermutation(IT n, uint64_t seed): glen(static_cast<uint64_t>(n))
+	{
+		int bits = 2;
+		while(bits < 64 && (static_cast<uint64_t>(1) << bits) < glen)	++bits;
+		halfbits = (bits+1)/2;
+		mask = (static_cast<uint64_t>(1) << halfbits) - 1;
+		for(int r=0; r < NROUNDS; ++r)
+			keys[r] = SplitMix64(seed + static_cast<uint64_t>(r+1) * 0x9E3779B97F4A7C15ULL);
+	}
+
+	//! new position of element i
+	IT operator()(IT i) const
+	{
+		uint64_t x = Encrypt(static_cast<uint64_t>(i));
+		while(x >= glen)	x = Encrypt(x);	// cycle-walk back into [0,n)
+		return static_cast<IT>(x);
+	}
+
+	//! original position of the element that ends up at i
+	IT inverse(IT i) const
+	{
+		uint64_t x = Decrypt(static_cast<uint64_t>(i));
+		while(x >= glen)	x = Decrypt(x);
+		return static_cast<IT>(x);
+	}
+
+	IT size() const { return static_cast<IT>(glen); }
+
+private:
+	enum { NROUNDS = 6 };
+
+	uint64_t Encrypt(uint64_t x) const
+	{
+		uint64_t left = x >> halfbits;
+		uint64_t right = x & mask;
+		for(int r=0; r < NROUNDS; ++r)
+		{
+			uint64_t newright = left ^ (SplitMix64(right ^ keys[r]) & mask);
+			left = right;
+			right = newright;
+		}
+		return (left << halfbits) | right;
+	}
+
+	uint64_t Decrypt(uint64_t x) const
+	{
+		uint64_t left = x >> halfbits;
+		uint64_t right = x & mask;
+		for(int r=NROUNDS-1; r >= 0; --r)
+		{
+			uint64_t newleft = right ^ (SplitMix64(left ^ keys[r]) & mask);
+			right = left;
+			left = newleft;
+		}
+		return (left << halfbits) | right;
+	}
+
+	uint64_t glen;
+	int halfbits;
+	uint64_t mask;
+	uint64_t keys[NROUNDS];
+};
+
+}
+
+#endif
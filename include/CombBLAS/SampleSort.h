@@ -0,0 +1,484 @@
+/****************************************************************/
+/* Parallel Combinatorial BLAS Library (for Graph Computations) */
+/* version 1.6 -------------------------------------------------*/
+/* date: 6/15/2017 ---------------------------------------------*/
+/* authors: Ariful Azad, Aydin Buluc  --------------------------*/
+/****************************************************************/
+/*
+ Copyright (c) 2010-2017, The Regents of the University of California
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+#ifndef _SAMPLE_SORT_H_
+#define _SAMPLE_SORT_H_
+
+#include <mpi.h>
+#include <vector>
+#include <limits>
+#include <climits>
+#include <cstring>
+#include <cstdint>
+#include <numeric>
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+#ifdef THREADED
+#include <omp.h>
+#endif
+#include "SpDefs.h"
+#include "MPIType.h"
+#include "PBBS/radixSort.h"
+
+namespace combblas {
+
+/***************************************************************************
+ * Distributed sample sort with exact splitting.
+ * The local phase radix sorts pairs of arithmetic keys (comparison sort otherwise) in
+ * per-thread runs that are merged in parallel. Splitters are first bracketed by regular
+ * sampling, then refined to the exact global ranks by weighted medians of the active
+ * ranges. Equal elements are told apart by (rank, local position), so heavy duplicates
+ * never overload a process. The exchange falls back to segmented point-to-point
+ * messages when element counts or displacements do not fit in an int.
+ ***************************************************************************/
+
+/**
+ * Order preserving map of an arithmetic key to an unsigned integer of the same width
+ * (flipped sign bit for signed integers, IEEE trick for floating point, -0.0 taken as 0.0)
+ */
+template <class T, class Enable = void>
+struct RadixKey
+{
+	static const bool radixable = false;
+};
+
+template <class T>
+struct RadixKey<T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T,bool>::value>::type>
+{
+	static const bool radixable = true;
+	typedef typename std::make_unsigned<T>::type UT;
+	static UT Map(T x)
+	{
+		const UT sign = std::is_signed<T>::value ? (static_cast<UT>(1) << (8*sizeof(T)-1)) : 0;
+		return static_cast<UT>(x) ^ sign;
+	}
+};
+
+template <class T>
+struct RadixKey<T, typename std::enable_if<std::is_same<T,float>::value || std::is_same<T,double>::value>::type>
+{
+	static const bool radixable = true;
+	typedef typename std::conditional<sizeof(T) == 4, uint32_t, uint64_t>::type UT;
+	static UT Map(T x)
+	{
+		const UT sign = static_cast<UT>(1) << (8*sizeof(T)-1);
+		if(x == 0) x = 0;
+		UT bits;
+		std::memcpy(&bits, &x, sizeof(T));
+		return (bits & sign) ? ~bits : (bits | sign);
+	}
+};
+
+/**
+ * Radix sort of (key,value) pairs into lexicographic order: LSD passes of intSort::radixStep
+ * on the keys, one 8-bit digit per pass, skipping the digits that are equal in all keys.
+ * The (usually short) runs of equal keys are then sorted by value.
+ * A is sorted in place, B is scratch space of the same length
+ */
+template <class KEY, class VAL>
+void RadixSortPairs(std::pair<KEY,VAL> * A, std::pair<KEY,VAL> * B, int n)
+{
+	typedef std::pair<KEY,VAL> E;
+	if(n < 2) return;
+	typename RadixKey<KEY>::UT keydiff = 0;
+	for(int i=1; i<n; ++i)
+		keydiff |= RadixKey<KEY>::Map(A[i].first) ^ RadixKey<KEY>::Map(A[0].first);
+	std::vector<intSort::bIndexT> Tmp(n);
+	int counts[BUCKETS];
+	E * from = A;
+	E * to = B;
+	for(int b=0; b<static_cast<int>(sizeof(KEY)); ++b)
+	{
+		if(((keydiff >> (8*b)) & 0xFF) == 0) continue;
+		intSort::radixStep(from, to, Tmp.data(), counts, n, BUCKETS,
+			[b](const E & e){ return static_cast<int>((RadixKey<KEY>::Map(e.first) >> (8*b)) & 0xFF); });
+		std::swap(from, to);
+	}
+	if(from != A)
+		std::copy(from, from+n, A);
+	for(int i=0; i<n; )
+	{
+		int j = i+1;
+		while(j < n && !(A[i].first < A[j].first) && !(A[j].first < A[i].first)) ++j;
+		if(j - i > 1)
+			std::sort(A+i, A+j, [](const E & x, const E & y){ return x.second < y.second; });
+		i = j;
+	}
+}
+
+template <class E>
+struct PairRadixable
+{
+	static const bool value = false;
+};
+
+template <class KEY, class VAL>
+struct PairRadixable< std::pair<KEY,VAL> >
+{
+	static const bool value = RadixKey<KEY>::radixable && RadixKey<VAL>::radixable;
+};
+
+//! Sorts a single run, buf is scratch space of the same length
+template <class E, bool RADIX = PairRadixable<E>::value>
+struct SortRun
+{
+	static void Sort(E * run, E * buf, int64_t n)
+	{
+		std::sort(run, run+n);
+	}
+};
+
+template <class E>
+struct SortRun<E, true>
+{
+	static void Sort(E * run, E * buf, int64_t n)
+	{
+		if(n < SORTRADIXMIN || n > INT_MAX)
+			std::sort(run, run+n);
+		else
+			RadixSortPairs(run, buf, static_cast<int>(n));
+	}
+};
+
+/**
+ * Merges the sorted runs src[bounds[r]..bounds[r+1]) into dst. Every thread merges the
+ * slice of all runs that falls between two splitters sampled from the runs, pairwise
+ * with streaming merges rather than through a heap
+ */
+template <class E>
+void MergeSortedRuns(const E * src, const std::vector<int64_t> & bounds, E * dst, int nthreads)
+{
+	int nruns = static_cast<int>(bounds.size()) - 1;
+	int64_t total = bounds.back() - bounds.front();
+	if(nruns == 1 || total == 0)
+	{
+#ifdef THREADED
+#pragma omp parallel for num_threads(nthreads)
+#endif
+		for(int64_t i=0; i<total; ++i)
+			dst[i] = src[bounds.front()+i];
+		return;
+	}
+	nthreads = static_cast<int>(std::max<int64_t>(1, std::min<int64_t>(nthreads, total / SORTRADIXMIN)));
+	std::vector<E> samples;
+	for(int r=0; r<nruns; ++r)
+	{
+		int64_t len = bounds[r+1] - bounds[r];
+		for(int t=0; t<nthreads && len > 0; ++t)
+			samples.push_back(src[bounds[r] + (len * (2*t+1)) / (2*nthreads)]);
+	}
+	std::sort(samples.begin(), samples.end());
+
+	// cuts[t][r]: first element of run r that belongs to thread t
+	std::vector< std::vector<int64_t> > cuts(nthreads+1, std::vector<int64_t>(nruns));
+	for(int r=0; r<nruns; ++r)
+	{
+		cuts[0][r] = bounds[r];
+		cuts[nthreads][r] = bounds[r+1];
+	}
+	for(int t=1; t<nthreads; ++t)
+	{
+		const E & splitter = samples[(samples.size() * t) / nthreads];
+		for(int r=0; r<nruns; ++r)
+			cuts[t][r] = std::lower_bound(src + bounds[r], src + bounds[r+1], splitter) - src;
+	}
+#ifdef THREADED
+#pragma omp parallel for schedule(dynamic) num_threads(nthreads)
+#endif
+	for(int t=0; t<nthreads; ++t)
+	{
+		int64_t out = 0;
+		for(int r=0; r<nruns; ++r)
+			out += cuts[t][r] - bounds[r];
+		// copy the slices next to each other, then merge neighbors bottom-up
+		std::vector<int64_t> seams(1, out);
+		for(int r=0; r<nruns; ++r)
+		{
+			if(cuts[t][r] == cuts[t+1][r]) continue;
+			std::copy(src + cuts[t][r], src + cuts[t+1][r], dst + seams.back());
+			seams.push_back(seams.back() + cuts[t+1][r] - cuts[t][r]);
+		}
+		for(size_t width = 1; width+1 < seams.size(); width *= 2)
+			for(size_t k = 0; k + width < seams.size()-1; k += 2*width)
+				std::inplace_merge(dst + seams[k], dst + seams[k+width], dst + seams[std::min(k+2*width, seams.size()-1)]);
+	}
+}
+
+/**
+ * Sorts array[0..length) with one run per thread and merges the runs into sorted
+ */
+template <class E>
+void LocalSampleSort(E * array, int64_t length, E * sorted)
+{
+	int nthreads = 1;
+#ifdef THREADED
+	nthreads = omp_get_max_threads();
+#endif
+	nthreads = static_cast<int>(std::max<int64_t>(1, std::min<int64_t>(nthreads, length / SORTRADIXMIN)));
+	std::vector<int64_t> bounds(nthreads+1);
+	for(int t=0; t<=nthreads; ++t)
+		bounds[t] = (length * t) / nthreads;
+#ifdef THREADED
+#pragma omp parallel for schedule(dynamic) num_threads(nthreads)
+#endif
+	for(int t=0; t<nthreads; ++t)
+		SortRun<E>::Sort(array + bounds[t], sorted + bounds[t], bounds[t+1] - bounds[t]);
+	MergeSortedRuns(array, bounds, sorted, nthreads);
+}
+
+/**
+ * A splitter candidate. Elements are ordered by (value, rank, index), which makes all of
+ * them distinct; weight is the size of the active range it was picked from
+ */
+template <class E, class IT>
+struct SortPivot
+{
+	E value;
+	int rank;
+	IT index;
+	IT weight;
+
+	bool operator<(const SortPivot & rhs) const
+	{
+		if(value < rhs.value) return true;
+		if(rhs.value < value) return false;
+		if(rank != rhs.rank) return rank < rhs.rank;
+		return index < rhs.index;
+	}
+};
+
+//! number of local elements below pivot (inclusive: below or equal to it)
+template <class E, class IT>
+IT SortPivotRank(const E * sorted, IT length, const SortPivot<E,IT> & pivot, int myrank, bool inclusive)
+{
+	if(myrank == pivot.rank)
+		return pivot.index + (inclusive ? 1 : 0);
+	if(myrank < pivot.rank)
+		return std::upper_bound(sorted, sorted+length, pivot.value) - sorted;
+	return std::lower_bound(sorted, sorted+length, pivot.value) - sorted;
+}
+
+/**
+ * Personalized all-to-all of sorted slices, MPI_Alltoallv when every count and displacement
+ * fits in an int, otherwise a train of point-to-point messages of at most SORTSEGMENT bytes
+ */
+template <class E>
+void SampleSortExchange(const E * sendbuf, const std::vector<int64_t> & sendcnt, E * recvbuf, const std::vector<int64_t> & recvcnt, MPI_Comm comm)
+{
+	int nprocs, myrank;
+	MPI_Comm_size(comm, &nprocs);
+	MPI_Comm_rank(comm, &myrank);
+	std::vector<int64_t> sdispls(nprocs+1, 0), rdispls(nprocs+1, 0);
+	std::partial_sum(sendcnt.begin(), sendcnt.end(), sdispls.begin()+1);
+	std::partial_sum(recvcnt.begin(), recvcnt.end(), rdispls.begin()+1);
+	int large = (sdispls.back() > INT_MAX || rdispls.back() > INT_MAX);
+	MPI_Allreduce(MPI_IN_PLACE, &large, 1, MPI_INT, MPI_LOR, comm);
+
+	MPI_Datatype MPI_elemType;
+	MPI_Type_contiguous(sizeof(E), MPI_CHAR, &MPI_elemType);
+	MPI_Type_commit(&MPI_elemType);
+	if(!large)
+	{
+		std::vector<int> sc(sendcnt.begin(), sendcnt.end()), rc(recvcnt.begin(), recvcnt.end());
+		std::vector<int> sd(sdispls.begin(), sdispls.end()-1), rd(rdispls.begin(), rdispls.end()-1);
+		MPI_Alltoallv(const_cast<E*>(sendbuf), sc.data(), sd.data(), MPI_elemType, recvbuf, rc.data(), rd.data(), MPI_elemType, comm);
+	}
+	else
+	{
+		// messages with the same source, tag and communicator do not overtake each other
+		const int64_t segment = std::max<int64_t>(1, SORTSEGMENT / sizeof(E));
+		std::vector<MPI_Request> reqs;
+		for(int i=0; i<nprocs; ++i)
+		{
+			if(i == myrank) continue;
+			for(int64_t off = 0; off < recvcnt[i]; off += segment)
+			{
+				reqs.push_back(MPI_REQUEST_NULL);
+				MPI_Irecv(recvbuf + rdispls[i] + off, static_cast<int>(std::min(segment, recvcnt[i] - off)), MPI_elemType, i, SORTTAG, comm, &reqs.back());
+			}
+		}
+		for(int i=0; i<nprocs; ++i)
+		{
+			if(i == myrank) continue;
+			for(int64_t off = 0; off < sendcnt[i]; off += segment)
+			{
+				reqs.push_back(MPI_REQUEST_NULL);
+				MPI_Isend(const_cast<E*>(sendbuf) + sdispls[i] + off, static_cast<int>(std::min(segment, sendcnt[i] - off)), MPI_elemType, i, SORTTAG, comm, &reqs.back());
+			}
+		}
+		std::copy(sendbuf + sdispls[myrank], sendbuf + sdispls[myrank] + sendcnt[myrank], recvbuf + rdispls[myrank]);
+		MPI_Waitall(static_cast<int>(reqs.size()), reqs.data(), MPI_STATUSES_IGNORE);
+	}
+	MPI_Type_free(&MPI_elemType);
+}
+
+/**
+ * Sorts the distributed array in place: afterwards process i holds the dist[i] elements
+ * of global ranks [sum(dist[0..i)), sum(dist[0..i])) in increasing order.
+ * dist must add up to the global number of elements (usually dist[i] is the input length of i).
+ * E needs operator< and must be safe to copy bytewise
+ */
+template <class E, class IT>
+void SampleSort(E * array, IT length, IT * dist, MPI_Comm comm)
+{
+	int nprocs, myrank;
+	MPI_Comm_size(comm, &nprocs);
+	MPI_Comm_rank(comm, &myrank);
+	int nthreads = 1;
+#ifdef THREADED
+	nthreads = omp_get_max_threads();
+#endif
+	std::vector<E> sorted(length);
+	LocalSampleSort(array, static_cast<int64_t>(length), sorted.data());
+	if(nprocs == 1)
+	{
+		std::copy(sorted.begin(), sorted.end(), array);
+		return;
+	}
+
+	typedef SortPivot<E,IT> Pivot;
+	MPI_Datatype MPI_pivotType;
+	MPI_Type_contiguous(sizeof(Pivot), MPI_CHAR, &MPI_pivotType);
+	MPI_Type_commit(&MPI_pivotType);
+
+	std::vector<IT> targets(nprocs+1, 0);	// global rank of the first element of every process
+	for(int i=0; i<nprocs; ++i)
+		targets[i+1] = targets[i] + dist[i];
+
+	// regular sampling: sorted candidates with their exact global ranks
+	int nsamples = static_cast<int>(std::min<IT>(length, SORTSAMPLES));
+	std::vector<Pivot> mysamples(nsamples);
+	for(int j=0; j<nsamples; ++j)
+	{
+		IT pos = (length * (2*j+1)) / (2*nsamples);
+		mysamples[j] = Pivot{sorted[pos], myrank, pos, 0};
+	}
+	std::vector<int> samplecnt(nprocs), sampledspl(nprocs, 0);
+	MPI_Allgather(&nsamples, 1, MPI_INT, samplecnt.data(), 1, MPI_INT, comm);
+	std::partial_sum(samplecnt.begin(), samplecnt.end()-1, sampledspl.begin()+1);
+	std::vector<Pivot> candidates(sampledspl.back() + samplecnt.back());
+	MPI_Allgatherv(mysamples.data(), nsamples, MPI_pivotType, candidates.data(), samplecnt.data(), sampledspl.data(), MPI_pivotType, comm);
+	std::sort(candidates.begin(), candidates.end());
+	std::vector<IT> mybelow(candidates.size()), below(candidates.size());
+	for(size_t c=0; c<candidates.size(); ++c)
+		mybelow[c] = SortPivotRank(sorted.data(), length, candidates[c], myrank, false);
+	MPI_Allreduce(mybelow.data(), below.data(), static_cast<int>(candidates.size()), MPIType<IT>(), MPI_SUM, comm);
+
+	// [lo[i], hi[i]) is the local part of the range that still contains the i-th split
+	std::vector<IT> lo(nprocs+1, 0), hi(nprocs+1, length);
+	lo[nprocs] = length;
+	hi[0] = 0;
+	for(int i=1; i<nprocs; ++i)
+	{
+		auto upper = std::upper_bound(below.begin(), below.end(), targets[i]);
+		if(upper != below.begin())
+			lo[i] = mybelow[(upper - below.begin()) - 1];
+		auto lower = std::lower_bound(below.begin(), below.end(), targets[i]);
+		if(lower != below.end())
+			hi[i] = mybelow[lower - below.begin()];
+	}
+
+	// weighted median refinement; process i picks the pivot of the i-th split
+	std::vector<Pivot> proposals(nprocs), received(nprocs), pivots(nprocs);
+	std::vector<IT> pivbelow(nprocs), pivrank(nprocs);
+	while(true)
+	{
+		for(int i=0; i<nprocs; ++i)
+		{
+			IT mid = (lo[i] + hi[i]) / 2;
+			proposals[i] = Pivot{(hi[i] > lo[i]) ? sorted[mid] : E(), myrank, mid, hi[i] - lo[i]};
+		}
+		MPI_Alltoall(proposals.data(), 1, MPI_pivotType, received.data(), 1, MPI_pivotType, comm);
+		std::vector<Pivot> active;
+		IT totweight = 0;
+		for(int j=0; j<nprocs; ++j)
+		{
+			if(received[j].weight > 0)
+			{
+				active.push_back(received[j]);
+				totweight += received[j].weight;
+			}
+		}
+		Pivot mine = Pivot{E(), 0, 0, 0};
+		if(myrank > 0 && totweight > 0)
+		{
+			std::sort(active.begin(), active.end());
+			IT acc = 0;
+			for(const Pivot & p : active)
+			{
+				acc += p.weight;
+				mine = p;
+				if(2*acc >= totweight) break;
+			}
+			mine.weight = totweight;
+		}
+		MPI_Allgather(&mine, 1, MPI_pivotType, pivots.data(), 1, MPI_pivotType, comm);
+
+		bool any = false;
+		for(int i=1; i<nprocs; ++i)
+		{
+			pivbelow[i] = 0;
+			if(pivots[i].weight > 0)
+			{
+				any = true;
+				pivbelow[i] = SortPivotRank(sorted.data(), length, pivots[i], myrank, false);
+			}
+		}
+		if(!any) break;
+		MPI_Allreduce(pivbelow.data(), pivrank.data(), nprocs, MPIType<IT>(), MPI_SUM, comm);
+		for(int i=1; i<nprocs; ++i)
+		{
+			if(pivots[i].weight == 0) continue;
+			if(pivrank[i] == targets[i])
+				lo[i] = hi[i] = pivbelow[i];
+			else if(pivrank[i] < targets[i])
+				lo[i] = std::max(lo[i], SortPivotRank(sorted.data(), length, pivots[i], myrank, true));
+			else
+				hi[i] = std::min(hi[i], pivbelow[i]);
+		}
+	}
+	MPI_Type_free(&MPI_pivotType);
+
+	std::vector<int64_t> sendcnt(nprocs), recvcnt(nprocs);
+	for(int i=0; i<nprocs; ++i)
+		sendcnt[i] = static_cast<int64_t>(lo[i+1] - lo[i]);
+	MPI_Alltoall(sendcnt.data(), 1, MPIType<int64_t>(), recvcnt.data(), 1, MPIType<int64_t>(), comm);
+	std::vector<E> received_elems(std::accumulate(recvcnt.begin(), recvcnt.end(), static_cast<int64_t>(0)));
+	SampleSortExchange(sorted.data(), sendcnt, received_elems.data(), recvcnt, comm);
+	std::vector<E>().swap(sorted);
+
+	std::vector<int64_t> runs(nprocs+1, 0);
+	std::partial_sum(recvcnt.begin(), recvcnt.end(), runs.begin()+1);
+	MergeSortedRuns(received_elems.data(), runs, array, nthreads);
+}
+
+}
+
+#endif
@@ -0,0 +1,147 @@
+/****************************************************************/
+/* Parallel Combinatorial BLAS Library (for Graph Computations) */
+/* version 1.6 -------------------------------------------------*/
+/* date: 6/15/2017 ---------------------------------------------*/
+/* authors: Ariful Azad, Aydin Buluc  --------------------------*/
+/****************************************************************/
+/*
+ Copyright (c) 2010-2017, The Regents of the University of California
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+
+#include "SpCSB.h"
+#include <algorithm>
+#include <numeric>
+#include <iostream>
+
+namespace combblas {
+
+template <class IT, class NT>
+SpCSB<IT,NT>::SpCSB(): m(0), n(0), nnz(0), lgbeta(0), nbr(0), nbc(0), blkptr(1, 0)
+{
+}
+
+template <class IT, class NT>
+SpCSB<IT,NT>::SpCSB(const SpTuples<IT,NT> & rhs, bool transpose)
+{
+	Build(rhs, transpose);
+}
+
+template <class IT, class NT>
+SpCSB<IT,NT>::SpCSB(const SpDCCols<IT,NT> & rhs)
+{
+	SpTuples<IT,NT> tuples(rhs);
+	Build(tuples, false);
+}
+
+/**
+ * Counting sort of the triples into blocks, then a sort of each block by packed index,
+ * which is row-major order inside the block
+ */
+template <class IT, class NT>
+void SpCSB<IT,NT>::Build(const SpTuples<IT,NT> & rhs, bool transpose)
+{
+	m = transpose ? rhs.getncol() : rhs.getnrow();
+	n = transpose ? rhs.getnrow() : rhs.getncol();
+	nnz = rhs.getnnz();
+
+	IT maxdim = std::max<IT>(std::max(m, n), 1);
+	lgbeta = 0;
+	while(lgbeta < 16 && (static_cast<uint64_t>(1) << (2*lgbeta)) < static_cast<uint64_t>(maxdim))
+		++lgbeta;
+	IT beta = static_cast<IT>(1) << lgbeta;
+	nbr = (m + beta - 1) / beta;
+	nbc = (n + beta - 1) / beta;
+
+	blkptr.assign(nbr * nbc + 1, 0);
+	for(IT k = 0; k < nnz; ++k)
+	{
+		IT row = transpose ? rhs.colindex(k) : rhs.rowindex(k);
+		IT col = transpose ? rhs.rowindex(k) : rhs.colindex(k);
+		++blkptr[(row >> lgbeta) * nbc + (col >> lgbeta) + 1];
+	}
+	std::partial_sum(blkptr.begin(), blkptr.end(), blkptr.begin());
+
+	std::vector< std::pair<uint32_t,NT> > entries(nnz);
+	std::vector<IT> next(blkptr.begin(), blkptr.end()-1);
+	const IT mask = beta - 1;
+	for(IT k = 0; k < nnz; ++k)
+	{
+		IT row = transpose ? rhs.colindex(k) : rhs.rowindex(k);
+		IT col = transpose ? rhs.rowindex(k) : rhs.colindex(k);
+		uint32_t packed = static_cast<uint32_t>(((row & mask) << lgbeta) | (col & mask));
+		entries[next[(row >> lgbeta) * nbc + (col >> lgbeta)]++] = std::make_pair(packed, rhs.numvalue(k));
+	}
+	std::vector<IT>().swap(next);
+
+#ifdef THREADED
+#pragma omp parallel for schedule(dynamic, 64)
+#endif
+	for(IT b = 0; b < nbr * nbc; ++b)
+	{
+		std::sort(entries.begin() + blkptr[b], entries.begin() + blkptr[b+1],
+			[](const std::pair<uint32_t,NT> & a, const std::pair<uint32_t,NT> & c) { return a.first < c.first; });
+	}
+	idx.resize(nnz);
+	num.resize(nnz);
+	for(IT k = 0; k < nnz; ++k)
+	{
+		idx[k] = entries[k].first;
+		num[k] = entries[k].second;
+	}
+}
+
+template <class IT, class NT>
+SpTuples<IT,NT> * SpCSB<IT,NT>::ToTuples() const
+{
+	std::tuple<IT,IT,NT> * tuples = (nnz > 0) ? new std::tuple<IT,IT,NT>[nnz] : NULL;
+	const IT mask = (static_cast<IT>(1) << lgbeta) - 1;
+	for(IT bi = 0; bi < nbr; ++bi)
+	{
+		for(IT bj = 0; bj < nbc; ++bj)
+		{
+			for(IT k = blkptr[bi*nbc+bj]; k < blkptr[bi*nbc+bj+1]; ++k)
+				tuples[k] = std::make_tuple((bi << lgbeta) + (idx[k] >> lgbeta), (bj << lgbeta) + (idx[k] & mask), num[k]);
+		}
+	}
+	return new SpTuples<IT,NT>(nnz, m, n, tuples, false);	// sorts by columns
+}
+
+template <class IT, class NT>
+SpCSB<IT,NT>::operator SpDCCols<IT,NT> () const
+{
+	SpTuples<IT,NT> * tuples = ToTuples();
+	SpDCCols<IT,NT> dcsc(*tuples, false);
+	delete tuples;
+	return dcsc;
+}
+
+template <class IT, class NT>
+void SpCSB<IT,NT>::PrintInfo() const
+{
+	std::cout << "m: " << m ;
+	std::cout << ", n: " << n ;
+	std::cout << ", nnz: "<< nnz ;
+	std::cout << ", block dimension: " << getblockdim() << " (" << nbr << "x" << nbc << " blocks)" << std::endl;
+}
+
+}
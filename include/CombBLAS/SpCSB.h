@@ -0,0 +1,330 @@
+/****************************************************************/
+/* Parallel Combinatorial BLAS Library (for Graph Computations) */
+/* version 1.6 -------------------------------------------------*/
+/* date: 6/15/2017 ---------------------------------------------*/
+/* authors: Ariful Azad, Aydin Buluc  --------------------------*/
+/****************************************************************/
+/*
+ Copyright (c) 2010-2017, The Regents of the University of California
+ 
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ 
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+ 
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+
+#ifndef _SP_CSB_H_
+#define _SP_CSB_H_
+
+#include <vector>
+#include <cstdint>
+#include "SpMat.h"	// Best to include the base class first
+#include "SpHelper.h"
+#include "SpTuples.h"
+#include "SpDCCols.h"
+
+namespace combblas {
+
+/**
+ * Compressed sparse blocks (CSB): the matrix is tiled into beta-by-beta blocks (beta a power of two,
+ * about the square root of the larger dimension), stored block-row by block-row. Each nonzero keeps
+ * its offsets inside the block packed into one 32-bit word, (row offset << lgbeta) | column offset.
+ * Block-rows and block-columns are equally easy to reach, so A*x runs in parallel over block-rows
+ * and A'*x over block-columns from the same copy, neither needing atomics or a transposed matrix.
+ * The block pointers take O(m*n/beta^2) = O(max(m,n)) space, so hypersparse submatrices should stay in DCSC.
+ */
+template <class IT, class NT>
+class SpCSB: public SpMat<IT, NT, SpCSB<IT, NT> >
+{
+public:
+	typedef IT LocalIT;
+	typedef NT LocalNT;
+
+	SpCSB ();
+	SpCSB (const SpTuples<IT,NT> & rhs, bool transpose);
+	SpCSB (const SpDCCols<IT,NT> & rhs);
+
+	operator SpDCCols<IT,NT> () const;	//!< conversion back to DCSC
+	SpTuples<IT,NT> * ToTuples() const;	//!< column-sorted triples, to be deleted by the caller
+
+	bool operator== (const SpCSB<IT,NT> & rhs) const
+	{
+		return m == rhs.m && n == rhs.n && lgbeta == rhs.lgbeta && blkptr == rhs.blkptr && idx == rhs.idx && num == rhs.num;
+	}
+
+	IT getnrow() const { return m; }
+	IT getncol() const { return n; }
+	IT getnnz() const { return nnz; }
+	int getnsplit() const { return 0; }
+	IT getblockdim() const { return static_cast<IT>(1) << lgbeta; }
+	bool isZero() const { return (nnz == 0); }
+
+	void PrintInfo() const;
+
+	template <typename SR, typename IU, typename NU, typename RHS, typename LHS>
+	friend void csb_gespmv (const SpCSB<IU,NU> & A, const RHS * x, LHS * y);
+
+	template <typename SR, typename IU, typename NU, typename RHS, typename LHS>
+	friend void csb_gespmv_transpose (const SpCSB<IU,NU> & A, const RHS * x, LHS * y);
+
+	template <typename SR, typename IU, typename NU, typename RHS, typename LHS>
+	friend void csb_gespmv_tile (const SpCSB<IU,NU> & A, const RHS * x, LHS * y, IU rowlo, IU rowhi, IU collo, IU colhi);
+
+	template <typename SR, typename IU, typename NU, typename RHS, typename LHS>
+	friend void csb_gespmm (const SpCSB<IU,NU> & A, const RHS * X, LHS * Y, int k);
+
+	template <typename SR, typename IU, typename NU, typename RHS, typename LHS>
+	friend void csb_gespmm_transpose (const SpCSB<IU,NU> & A, const RHS * X, LHS * Y, int k);
+
+	template <typename SR, typename IU, typename NU, typename UT, typename VT, typename _BinaryOperation>
+	friend void csb_sddmm (SpCSB<IU,NU> & A, const UT * U, const VT * V, int k, _BinaryOperation __binary_op);
+
+private:
+	void Build(const SpTuples<IT,NT> & rhs, bool transpose);
+
+	IT m;
+	IT n;
+	IT nnz;
+	int lgbeta;		// log2 of the block dimension, at most 16 so that both offsets fit in 32 bits
+	IT nbr;			// number of block-rows
+	IT nbc;			// number of block-columns
+	std::vector<IT> blkptr;		// nonzeros of block (i,j) are [blkptr[i*nbc+j], blkptr[i*nbc+j+1])
+	std::vector<uint32_t> idx;	// packed (row offset, column offset) inside the block
+	std::vector<NT> num;
+};
+
+
+/**
+ * y = A*x over the semiring SR, y has to be initialized (with SR::id() for a plain product)
+ * Threads own block-rows, hence disjoint pieces of y
+ */
+template <typename SR, typename IU, typename NU, typename RHS, typename LHS>
+void csb_gespmv (const SpCSB<IU,NU> & A, const RHS * x, LHS * y)
+{
+	const IU mask = (static_cast<IU>(1) << A.lgbeta) - 1;
+#ifdef THREADED
+#pragma omp parallel for schedule(dynamic)
+#endif
+	for(IU bi = 0; bi < A.nbr; ++bi)
+	{
+		LHS * ybase = y + (bi << A.lgbeta);
+		for(IU bj = 0; bj < A.nbc; ++bj)
+		{
+			const RHS * xbase = x + (bj << A.lgbeta);
+			for(IU k = A.blkptr[bi*A.nbc+bj]; k < A.blkptr[bi*A.nbc+bj+1]; ++k)
+				SR::axpy(A.num[k], xbase[A.idx[k] & mask], ybase[A.idx[k] >> A.lgbeta]);
+		}
+	}
+}
+
+/**
+ * One tile of y = A*x, restricted to the rows [rowlo, rowhi) and columns [collo, colhi) of A
+ * Only the blocks that meet the tile are visited, the partial blocks at its border are filtered per nonzero
+ */
+template <typename SR, typename IU, typename NU, typename RHS, typename LHS>
+void csb_gespmv_tile (const SpCSB<IU,NU> & A, const RHS * x, LHS * y, IU rowlo, IU rowhi, IU collo, IU colhi)
+{
+	if(A.nnz == 0 || rowlo >= rowhi || collo >= colhi)
+		return;
+	const IU mask = (static_cast<IU>(1) << A.lgbeta) - 1;
+	IU bjbeg = collo >> A.lgbeta;
+	IU bjend = ((colhi - 1) >> A.lgbeta) + 1;
+#ifdef THREADED
+#pragma omp parallel for schedule(dynamic)
+#endif
+	for(IU bi = (rowlo >> A.lgbeta); bi <= ((rowhi - 1) >> A.lgbeta); ++bi)
+	{
+		IU rowbase = bi << A.lgbeta;
+		for(IU bj = bjbeg; bj < bjend; ++bj)
+		{
+			IU colbase = bj << A.lgbeta;
+			for(IU k = A.blkptr[bi*A.nbc+bj]; k < A.blkptr[bi*A.nbc+bj+1]; ++k)
+			{
+				IU row = rowbase + (A.idx[k] >> A.lgbeta);
+				IU col = colbase + (A.idx[k] & mask);
+				if(row >= rowlo && row < rowhi && col >= collo && col < colhi)
+					SR::axpy(A.num[k], x[col], y[row]);
+			}
+		}
+	}
+}
+
+/**
+ * y = A'*x over the semiring SR from the same storage, y has to be initialized
+ * Threads own block-columns, hence disjoint pieces of y
+ */
+template <typename SR, typename IU, typename NU, typename RHS, typename LHS>
+void csb_gespmv_transpose (const SpCSB<IU,NU> & A, const RHS * x, LHS * y)
+{
+	const IU mask = (static_cast<IU>(1) << A.lgbeta) - 1;
+#ifdef THREADED
+#pragma omp parallel for schedule(dynamic)
+#endif
+	for(IU bj = 0; bj < A.nbc; ++bj)
+	{
+		LHS * ybase = y + (bj << A.lgbeta);
+		for(IU bi = 0; bi < A.nbr; ++bi)
+		{
+			const RHS * xbase = x + (bi << A.lgbeta);
+			for(IU k = A.blkptr[bi*A.nbc+bj]; k < A.blkptr[bi*A.nbc+bj+1]; ++k)
+				SR::axpy(A.num[k], xbase[A.idx[k] >> A.lgbeta], ybase[A.idx[k] & mask]);
+		}
+	}
+}
+
+/**
+ * Y = A*X for k right hand sides, X (ncol-by-k) and Y (nrow-by-k) are dense and row-major
+ * Y has to be initialized
+ */
+template <typename SR, typename IU, typename NU, typename RHS, typename LHS>
+void csb_gespmm (const SpCSB<IU,NU> & A, const RHS * X, LHS * Y, int k)
+{
+	const IU mask = (static_cast<IU>(1) << A.lgbeta) - 1;
+#ifdef THREADED
+#pragma omp parallel for schedule(dynamic)
+#endif
+	for(IU bi = 0; bi < A.nbr; ++bi)
+	{
+		LHS * ybase = Y + (bi << A.lgbeta) * k;
+		for(IU bj = 0; bj < A.nbc; ++bj)
+		{
+			const RHS * xbase = X + (bj << A.lgbeta) * k;
+			for(IU e = A.blkptr[bi*A.nbc+bj]; e < A.blkptr[bi*A.nbc+bj+1]; ++e)
+			{
+				const RHS * xrow = xbase + (A.idx[e] & mask) * k;
+				LHS * yrow = ybase + (A.idx[e] >> A.lgbeta) * k;
+				for(int t = 0; t < k; ++t)
+					SR::axpy(A.num[e], xrow[t], yrow[t]);
+			}
+		}
+	}
+}
+
+/**
+ * Y = A'*X for k right hand sides, X (nrow-by-k) and Y (ncol-by-k) are dense and row-major
+ * Y has to be initialized
+ */
+template <typename SR, typename IU, typename NU, typename RHS, typename LHS>
+void csb_gespmm_transpose (const SpCSB<IU,NU> & A, const RHS * X, LHS * Y, int k)
+{
+	const IU mask = (static_cast<IU>(1) << A.lgbeta) - 1;
+#ifdef THREADED
+#pragma omp parallel for schedule(dynamic)
+#endif
+	for(IU bj = 0; bj < A.nbc; ++bj)
+	{
+		LHS * ybase = Y + (bj << A.lgbeta) * k;
+		for(IU bi = 0; bi < A.nbr; ++bi)
+		{
+			const RHS * xbase = X + (bi << A.lgbeta) * k;
+			for(IU e = A.blkptr[bi*A.nbc+bj]; e < A.blkptr[bi*A.nbc+bj+1]; ++e)
+			{
+				const RHS * xrow = xbase + (A.idx[e] >> A.lgbeta) * k;
+				LHS * yrow = ybase + (A.idx[e] & mask) * k;
+				for(int t = 0; t < k; ++t)
+					SR::axpy(A.num[e], xrow[t], yrow[t]);
+			}
+		}
+	}
+}
+
+/**
+ * A(i,j) = __binary_op(A(i,j), U(i,:) . V(j,:)) on the nonzeros of A, U (nrow-by-k) and V (ncol-by-k) are dense and row-major
+ * Threads own block-rows, so each reads its own rows of U
+ */
+template <typename SR, typename IU, typename NU, typename UT, typename VT, typename _BinaryOperation>
+void csb_sddmm (SpCSB<IU,NU> & A, const UT * U, const VT * V, int k, _BinaryOperation __binary_op)
+{
+	typedef typename promote_trait<UT,VT>::T_promote T_promote;
+	const IU mask = (static_cast<IU>(1) << A.lgbeta) - 1;
+#ifdef THREADED
+#pragma omp parallel for schedule(dynamic)
+#endif
+	for(IU bi = 0; bi < A.nbr; ++bi)
+	{
+		const UT * ubase = U + (bi << A.lgbeta) * k;
+		for(IU bj = 0; bj < A.nbc; ++bj)
+		{
+			const VT * vbase = V + (bj << A.lgbeta) * k;
+			for(IU e = A.blkptr[bi*A.nbc+bj]; e < A.blkptr[bi*A.nbc+bj+1]; ++e)
+			{
+				const UT * urow = ubase + (A.idx[e] >> A.lgbeta) * k;
+				const VT * vrow = vbase + (A.idx[e] & mask) * k;
+				T_promote dot = SR::id();
+				for(int t = 0; t < k; ++t)
+					dot = SR::add(dot, SR::multiply(urow[t], vrow[t]));
+				A.num[e] = __binary_op(A.num[e], dot);
+			}
+		}
+	}
+}
+
+//! Local step of the parallel dense SpMV for CSB storage
+template <typename SR, typename IU, typename NU, typename RHS, typename LHS>
+void gespmv_dense (const SpCSB<IU,NU> & A, const RHS * x, LHS * y)
+{
+	csb_gespmv<SR>(A, x, y);
+}
+
+//! One tile of the local step of the parallel dense SpMV for CSB storage
+template <typename SR, typename IU, typename NU, typename RHS, typename LHS>
+void gespmv_dense_tile (const SpCSB<IU,NU> & A, const RHS * x, LHS * y, IU rowlo, IU rowhi, IU collo, IU colhi)
+{
+	csb_gespmv_tile<SR>(A, x, y, rowlo, rowhi, collo, colhi);
+}
+
+//! Local step of the parallel dense SpMV with the transpose for CSB storage
+template <typename SR, typename IU, typename NU, typename RHS, typename LHS>
+void gespmv_dense_transpose (const SpCSB<IU,NU> & A, const RHS * x, LHS * y)
+{
+	csb_gespmv_transpose<SR>(A, x, y);
+}
+
+
+//! Local step of the parallel SpMM for CSB storage
+template <typename SR, typename IU, typename NU, typename RHS, typename LHS>
+void gespmm_dense (const SpCSB<IU,NU> & A, const RHS * X, LHS * Y, int k)
+{
+	csb_gespmm<SR>(A, X, Y, k);
+}
+
+//! Local step of the parallel SpMM with the transpose for CSB storage
+template <typename SR, typename IU, typename NU, typename RHS, typename LHS>
+void gespmm_dense_transpose (const SpCSB<IU,NU> & A, const RHS * X, LHS * Y, int k)
+{
+	csb_gespmm_transpose<SR>(A, X, Y, k);
+}
+
+//! Local step of the parallel SDDMM for CSB storage
+template <typename SR, typename IU, typename NU, typename UT, typename VT, typename _BinaryOperation>
+void sddmm_dense (SpCSB<IU,NU> & A, const UT * U, const VT * V, int k, _BinaryOperation __binary_op)
+{
+	csb_sddmm<SR>(A, U, V, k, __binary_op);
+}
+
+template <class NIT, class NNT, class OIT, class ONT>
+struct create_trait< SpCSB<OIT, ONT> , NIT, NNT >
+{
+	typedef SpCSB<NIT,NNT> T_inferred;
+};
+
+}
+
+#include "SpCSB.cpp"
+
+#endif
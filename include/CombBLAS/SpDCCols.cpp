@@ -619,6 +619,92 @@ SpDCCols<IT,NT>* SpDCCols<IT,NT>::PruneColumn(IT* pinds, NT* pvals, _BinaryOpera
 
 
 
+/**
+ * Applies a batch of edge updates in one pass over the columns, like the merge step of a log-structured store
+ * updates are (row, column, value, op) sorted by column then row; updates to the same entry apply in the given order
+ * EdgeAccumulate combines as __binary_op(existing, value), deletes of missing entries are ignored
+ * \attention Not for split (multithreaded) matrices
+ */
+template <class IT, class NT>
+template <typename _BinaryOperation>
+void SpDCCols<IT,NT>::MergeUpdates(const std::tuple<IT,IT,NT,EdgeOp> * updates, IT count, _BinaryOperation __binary_op)
+{
+	assert(splits == 0);
+	if(count == 0) return;
+
+	IT oldnzc = (nnz > 0) ? dcsc->nzc : 0;
+	Dcsc<IT,NT> * merged = new Dcsc<IT,NT>(nnz + count, oldnzc + count);	// upper bounds, shrunk at the end
+	IT curnz = 0, curnzc = 0;
+	IT i = 0, k = 0;
+	merged->cp[0] = 0;
+	while(i < oldnzc || k < count)
+	{
+		IT col = (i < oldnzc && (k == count || dcsc->jc[i] <= std::get<1>(updates[k]))) ? dcsc->jc[i] : std::get<1>(updates[k]);
+		IT o = 0, oend = 0;
+		if(i < oldnzc && dcsc->jc[i] == col)
+		{
+			o = dcsc->cp[i];
+			oend = dcsc->cp[i+1];
+			++i;
+		}
+		IT kend = k;
+		while(kend < count && std::get<1>(updates[kend]) == col) ++kend;
+
+		IT colstart = curnz;
+		while(o < oend || k < kend)
+		{
+			IT row = (o < oend && (k == kend || dcsc->ir[o] <= std::get<0>(updates[k]))) ? dcsc->ir[o] : std::get<0>(updates[k]);
+			bool present = false;
+			NT value = NT();
+			if(o < oend && dcsc->ir[o] == row)
+			{
+				present = true;
+				value = dcsc->numx[o++];
+			}
+			for(; k < kend && std::get<0>(updates[k]) == row; ++k)
+			{
+				switch(std::get<3>(updates[k]))
+				{
+					case EdgeSet:
+						value = std::get<2>(updates[k]);
+						present = true;
+						break;
+					case EdgeAccumulate:
+						value = present ? __binary_op(value, std::get<2>(updates[k])) : std::get<2>(updates[k]);
+						present = true;
+						break;
+					case EdgeDelete:
+						present = false;
+						break;
+				}
+			}
+			if(present)
+			{
+				merged->ir[curnz] = row;
+				merged->numx[curnz++] = value;
+			}
+		}
+		if(curnz > colstart)
+		{
+			merged->jc[curnzc++] = col;
+			merged->cp[curnzc] = curnz;
+		}
+	}
+	if(dcsc != NULL) delete dcsc;
+	if(curnz > 0)
+	{
+		merged->Resize(curnzc, curnz);
+		dcsc = merged;
+	}
+	else
+	{
+		delete merged;
+		dcsc = NULL;
+	}
+	nnz = curnz;
+}
+
+
 template <class IT, class NT>
 void SpDCCols<IT,NT>::EWiseMult (const SpDCCols<IT,NT> & rhs, bool exclude)
 {
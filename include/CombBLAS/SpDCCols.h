@@ -61,6 +61,7 @@ public:
     SpDCCols (IT nRow, IT nCol, IT nnz1, const std::tuple<IT, IT, NT> * rhs, bool transpose);
 
 	SpDCCols (const SpDCCols<IT,NT> & rhs);					// Actual copy constructor		
+	SpDCCols (IT nRow, IT nCol, Dcsc<IT,NT> * mydcsc);			// Takes ownership of mydcsc (used by multiplication and merging)
 	~SpDCCols();
 
 	template <typename NNT> operator SpDCCols<IT,NNT> () const;		//!< NNT: New numeric type
@@ -270,6 +271,9 @@ public:
 
 	void EWiseScale(NT ** scaler, IT m_scaler, IT n_scaler);
 	void EWiseMult (const SpDCCols<IT,NT> & rhs, bool exclude);
+
+	template <typename _BinaryOperation>
+	void MergeUpdates(const std::tuple<IT,IT,NT,EdgeOp> * updates, IT count, _BinaryOperation __binary_op);
 	
 	void Transpose();				//!< Mutator version, replaces the calling object 
 	SpDCCols<IT,NT> TransposeConst() const;		//!< Const version, doesn't touch the existing object
@@ -348,7 +352,6 @@ private:
 	SpDCCols< IT, typename promote_trait<NT,NTR>::T_promote > OrdColByCol(const SpDCCols<IT,NTR> & rhs) const;	
 	
 	SpDCCols (IT size, IT nRow, IT nCol, const std::vector<IT> & indices, bool isRow);	// Constructor for indexing
-	SpDCCols (IT nRow, IT nCol, Dcsc<IT,NT> * mydcsc);			// Constructor for multiplication
 
 	// Anonymous union
 	union {
@@ -409,6 +412,21 @@ private:
     
     template <typename SR, typename IU, typename NU, typename RHS, typename LHS>
     friend void dcsc_gespmv_threaded_nosplit (const SpDCCols<IU, NU> & A, const RHS * x, LHS * y);
+
+	template <typename SR, typename IU, typename NU, typename RHS, typename LHS>
+	friend void dcsc_gespmv_transpose (const SpDCCols<IU, NU> & A, const RHS * x, LHS * y);
+
+	template <typename SR, typename IU, typename NU, typename RHS, typename LHS>
+	friend void dcsc_gespmv_tile (const SpDCCols<IU, NU> & A, const RHS * x, LHS * y, IU rowlo, IU rowhi, IU collo, IU colhi);
+
+	template <typename SR, typename IU, typename NU, typename RHS, typename LHS>
+	friend void dcsc_gespmm (const SpDCCols<IU, NU> & A, const RHS * X, LHS * Y, int k);
+
+	template <typename SR, typename IU, typename NU, typename RHS, typename LHS>
+	friend void dcsc_gespmm_transpose (const SpDCCols<IU, NU> & A, const RHS * X, LHS * Y, int k);
+
+	template <typename SR, typename IU, typename NU, typename UT, typename VT, typename _BinaryOperation>
+	friend void dcsc_sddmm (SpDCCols<IU, NU> & A, const UT * U, const VT * V, int k, _BinaryOperation __binary_op);
     
     template <typename SR, typename IU, typename NUM, typename DER, typename IVT, typename OVT>
     friend int generic_gespmv_threaded (const SpMat<IU,NUM,DER> & A, const int32_t * indx, const IVT * numx, int32_t nnzx,
@@ -66,6 +66,18 @@ namespace combblas {
 #define HEAPMERGE 1	// use heapmerge for accumulating contributions from row neighbors
 #define MEM_EFFICIENT_STAGES 16
 #define MAXVERTNAME 64
+#define HUBCOLUMN_MINFLOP 65536	// a column of the local SpGEMM needs at least this many flops to be split across threads
+#define FIBERTREELAYERS 16	// 3D fiber reductions over at least this many (power of two) layers use recursive halving
+#define FIBERSEGMENT (1 << 30)	// largest single message (in bytes) of a fiber reduction
+#define RCMSMALLFRONTIER 1024	// RCM/BFS levels with at most this many vertices are expanded redundantly on every process
+#define MISPULLDIVISOR 16	// MIS rounds with more than n/MISPULLDIVISOR candidates run pull-style on dense frontiers
+#define SORTSAMPLES 64	// regular samples per process that bracket the splitters of SampleSort
+#define SORTRADIXMIN 4096	// shorter local runs of SampleSort are comparison sorted, and each thread merges at least this many elements
+#define SORTSEGMENT (1 << 30)	// largest single message (in bytes) of a SampleSort exchange that overflows int counts
+#define EDGEDELTADIVISOR 16	// the update buffer of DynamicSpParMat is folded once it holds more than nnz/EDGEDELTADIVISOR edges
+#define EDGEDELTAMIN 65536	// ... or this many, whichever is larger
+#define SPMMPANEL 16	// the local SpMM kernels sweep the k columns of the dense operand in panels this wide
+#define SPMMFETCHRATIO 2	// SpMM fetches only the dense rows that local nonzero columns need, if that moves at most 1/SPMMFETCHRATIO of a full gather
 
 
 // MPI::Abort codes
@@ -108,6 +120,8 @@ namespace combblas {
 #define ROTATE 140
 #define PUPSIZE 141
 #define PUPDATA 142
+#define FIBERTAG 143
+#define SORTTAG 144
 
 enum Dim
 {
@@ -115,6 +129,14 @@ Column,
 Row
 };
 
+//! What an edge update does to the entry at its (row, column)
+enum EdgeOp
+{
+EdgeSet,		// insert, or overwrite an existing value
+EdgeAccumulate,		// insert, or combine with an existing value
+EdgeDelete
+};
+
 
 // force 8-bytes alignment in heap allocated memory
 #ifndef ALIGN
@@ -33,6 +33,8 @@
 
 #include <vector>
 #include <limits>
+#include <cctype>
+#include <cstdlib>
 #include <map>
 #include <string>
 #include <utility>
@@ -41,7 +43,6 @@
 #include "promote.h"
 #include "Isect.h"
 #include "HeapEntry.h"
-#include "SpImpl.h"
 #include "hash.hpp"
 
 namespace combblas {
@@ -90,55 +91,34 @@ public:
         }
     }
     
-    static void ProcessLinesWithStringKeys(std::vector< std::map < std::string, uint64_t> > & allkeys, std::vector<std::string> & lines, int nprocs)
+    /**
+      * Splits "from to [value]" lines on whitespace, labels of any length are added to the table
+      * and each line appends the table entries of its two endpoints to ends; a missing value is 1
+      */
+    template <typename TABLE, typename NT1>
+    static void ProcessLabeledLines(TABLE & labels, std::vector<uint64_t> & ends, std::vector<NT1> & vals, std::vector<std::string> & lines)
     {
-    	std::string frstr, tostr;
-    	uint64_t frhash, tohash;    
-    	double vv;
     	for (auto itr=lines.begin(); itr != lines.end(); ++itr)
     	{
-		char fr[MAXVERTNAME];
-		char to[MAXVERTNAME];
-		sscanf(itr->c_str(), "%s %s %lg", fr, to, &vv);
-		frstr = std::string(fr);
-		tostr = std::string(to);
-		MurmurHash3_x64_64(frstr.c_str(),frstr.size(),0,&frhash);
-		MurmurHash3_x64_64(tostr.c_str(),tostr.size(),0,&tohash);	
-
-		double range_fr = static_cast<double>(frhash) * static_cast<double>(nprocs);
-		double range_to = static_cast<double>(tohash) * static_cast<double>(nprocs);
-    		size_t owner_fr = range_fr / static_cast<double>(std::numeric_limits<uint64_t>::max());
-    		size_t owner_to = range_to / static_cast<double>(std::numeric_limits<uint64_t>::max());
-
-		// cout << frstr << " with hash " << frhash << " is going to " << owner_fr << endl;
-		// cout << tostr << " with hash " << tohash << " is going to " << owner_to << endl;
-
-		allkeys[owner_fr].insert(std::make_pair(frstr, frhash)); 
-		allkeys[owner_to].insert(std::make_pair(tostr, tohash));
-   	}
-        lines.clear();	
-    }
-
-    template <typename IT1, typename NT1>
-    static void ProcessStrLinesNPermute(std::vector<IT1> & rows, std::vector<IT1> & cols, std::vector<NT1> & vals, std::vector<std::string> & lines, std::map<std::string, uint64_t> & ultperm)
-    {
-	char * fr = new char[MAXVERTNAME];
-    	char * to = new char[MAXVERTNAME];
-    	std::string frstr, tostr;
-    	double vv;
-    	for (auto itr=lines.begin(); itr != lines.end(); ++itr)
-    	{
-		sscanf(itr->c_str(), "%s %s %lg", fr, to, &vv);
-		frstr = std::string(fr);
-		tostr = std::string(to);
-	
-		rows.emplace_back((IT1) ultperm[frstr]);
-		cols.emplace_back((IT1) ultperm[tostr]); 
-		vals.emplace_back((NT1) vv);
+		const char * pos = itr->c_str();
+		uint64_t entries[2];
+		int found = 0;
+		for(; found < 2; ++found)
+		{
+			while(*pos != '\0' && isspace(static_cast<unsigned char>(*pos))) ++pos;
+			const char * begin = pos;
+			while(*pos != '\0' && !isspace(static_cast<unsigned char>(*pos))) ++pos;
+			if(pos == begin) break;
+			entries[found] = labels.Insert(begin, static_cast<uint32_t>(pos - begin), 0).first;
+		}
+		if(found < 2) continue;	// blank or malformed line
+		char * valend;
+		double vv = strtod(pos, &valend);
+		ends.push_back(entries[0]);
+		ends.push_back(entries[1]);
+		vals.emplace_back((valend == pos) ? (NT1) 1 : (NT1) vv);
    	}
-	delete [] fr;
-	delete [] to;
-        lines.clear();	
+        lines.clear();
     }
 
 
@@ -539,4 +519,6 @@ IT SpHelper::SpColByCol(const Dcsc<IT,NT1> & Adcsc, const Dcsc<IT,NT2> & Bdcsc,
 
 }
 
+#include "SpImpl.h"	// after SpHelper, since SpImpl.cpp pulls in SpParHelper, which uses SpHelper
+
 #endif
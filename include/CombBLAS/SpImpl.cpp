@@ -29,6 +29,7 @@
 
 #include "SpImpl.h"
 #include "SpParHelper.h"
+#include "MemoryPool.h"
 #include "PBBS/radixSort.h"
 #include "Tommy/tommyhashdyn.h"
 
@@ -58,13 +59,14 @@ void SpImpl<SR,IT,NUM,IVT,OVT>::SpMXSpV(const Dcsc<IT,NUM> & Adcsc, int32_t mA,
 			std::vector<int32_t> & indy, std::vector< OVT > & numy)
 {
 	int32_t hsize = 0;		
+	ArenaScope scratch;	// colinds and the heap are drawn from the calling thread's arena
 	// colinds dereferences A.ir (valid from colinds[].first to colinds[].second)
-	std::vector< std::pair<IT,IT> > colinds( (IT) veclen);		
+	std::pair<IT,IT> * colinds = scratch.get().allocate< std::pair<IT,IT> >(veclen);
 	Adcsc.FillColInds(indx, (IT) veclen, colinds, NULL, 0);	// csize is irrelevant if aux is NULL	
 
 	if(sizeof(NUM) > sizeof(OVT))	// ABAB: include a filtering based runtime choice as well?
 	{
-		HeapEntry<IT, OVT> * wset = new HeapEntry<IT, OVT>[veclen]; 
+		HeapEntry<IT, OVT> * wset = scratch.get().allocate< HeapEntry<IT, OVT> >(veclen);
 		for(IT j =0; j< veclen; ++j)		// create the initial heap 
 		{
 			while(colinds[j].first != colinds[j].second )	// iterate until finding the first entry within this column that passes the filter
@@ -111,12 +113,11 @@ void SpImpl<SR,IT,NUM,IVT,OVT>::SpMXSpV(const Dcsc<IT,NUM> & Adcsc, int32_t mA,
 			}
 			if(!pushed)	--hsize;
 		}
-		delete [] wset;
 	}
 	
 	else
 	{
-		HeapEntry<IT, NUM> * wset = new HeapEntry<IT, NUM>[veclen]; 
+		HeapEntry<IT, NUM> * wset = scratch.get().allocate< HeapEntry<IT, NUM> >(veclen);
 		for(IT j =0; j< veclen; ++j)		// create the initial heap 
 		{
 			if(colinds[j].first != colinds[j].second)	// current != end
@@ -153,7 +154,6 @@ void SpImpl<SR,IT,NUM,IVT,OVT>::SpMXSpV(const Dcsc<IT,NUM> & Adcsc, int32_t mA,
 			}
 			else		--hsize;
 		}
-		delete [] wset;
 	}
 }
 
@@ -223,7 +223,8 @@ template <typename SR, typename IT, typename IVT, class OVT>
 void SpImpl<SR,IT,bool,IVT,OVT>::SpMXSpV(const Dcsc<IT,bool> & Adcsc, int32_t mA, const int32_t * indx, const IVT * numx, int32_t veclen,  
 			int32_t * indy, OVT * numy, int * cnts, int * dspls, int p_c)
 {   
-	OVT * localy = new OVT[mA];
+	ArenaScope scratch;
+	OVT * localy = scratch.get().allocate<OVT>(mA);
 	BitMap isthere(mA);
 	std::vector< std::vector<int32_t> > nzinds(p_c);	// nonzero indices		
 
@@ -268,7 +269,6 @@ void SpImpl<SR,IT,bool,IVT,OVT>::SpMXSpV(const Dcsc<IT,bool> & Adcsc, int32_t mA
 			numy[dspls[p]+i] = localy[locnzinds[i]]; 	
 		}
 	}
-	delete [] localy;
 }
 
 
@@ -519,8 +519,9 @@ void SpMXSpV_Bucket(const Csc<IT,NT> & Acsc, int32_t mA, const int32_t * indx, c
 #pragma omp parallel
 #endif
     {
-        int32_t* tIndSplitA = new int32_t[rowSplits*THREAD_BUF_LEN];
-        OVT* tNumSplitA = new OVT[rowSplits*THREAD_BUF_LEN];
+        ArenaScope scratch;     // thread private buckets
+        int32_t* tIndSplitA = scratch.get().allocate<int32_t>(rowSplits*THREAD_BUF_LEN);
+        OVT* tNumSplitA = scratch.get().allocate<OVT>(rowSplits*THREAD_BUF_LEN);
         std::vector<int32_t> tBucketSize(rowSplits);
         std::vector<int32_t> tOffset(rowSplits);
 #ifdef _OPENMP
@@ -571,8 +572,6 @@ void SpMXSpV_Bucket(const Csc<IT,NT> & Acsc, int32_t mA, const int32_t * indx, c
                 }
             }
         }
-        delete [] tIndSplitA;
-        delete [] tNumSplitA;
     }
     
 #ifdef BENCHMARK_SPMSPV
@@ -580,7 +579,8 @@ void SpMXSpV_Bucket(const Csc<IT,NT> & Acsc, int32_t mA, const int32_t * indx, c
     t0 = MPI_Wtime();
 #endif
     std::vector<uint32_t> nzInRowSplits(rowSplits);
-    uint32_t* nzinds = new uint32_t[disp[rowSplits]];
+    ArenaScope shared;      // the master thread's arena, written by all threads below
+    uint32_t* nzinds = shared.get().allocate<uint32_t>(disp[rowSplits]);
     
 #ifdef _OPENMP
 #pragma omp parallel for schedule(dynamic,1)
@@ -643,8 +643,8 @@ void SpMXSpV_Bucket(const Csc<IT,NT> & Acsc, int32_t mA, const int32_t * indx, c
 #pragma omp parallel
 #endif
     {
-        OVT* tnumy = new OVT [THREAD_BUF_LEN];
-        int32_t* tindy = new int32_t [THREAD_BUF_LEN];
+        ArenaScope scratch;
+        OVT* tnumy = scratch.get().allocate<OVT>(THREAD_BUF_LEN);
        	int curSize, tdisp;
 #ifdef _OPENMP
 #pragma omp for schedule(dynamic,1)
@@ -675,8 +675,6 @@ void SpMXSpV_Bucket(const Csc<IT,NT> & Acsc, int32_t mA, const int32_t * indx, c
                 std::copy(tnumy, tnumy+curSize, numy.begin()+dispRowSplits[rs]+tdisp);
             }
         }
-        delete [] tnumy;
-        delete [] tindy;
     }
     
     
@@ -684,7 +682,6 @@ void SpMXSpV_Bucket(const Csc<IT,NT> & Acsc, int32_t mA, const int32_t * indx, c
     t4 = MPI_Wtime() - t0;
 #endif
     
-    delete[] nzinds;
     
     
     
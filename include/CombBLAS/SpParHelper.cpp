@@ -28,6 +28,12 @@
 
 
 #include "usort/parUtils.h"
+#include "SpHelper.h"
+extern "C" {
+#include "mmio.h"
+}
+#include <sys/types.h>
+#include <sys/stat.h>
 
 namespace combblas {
 
@@ -102,176 +108,16 @@ void SpParHelper::ReDistributeToVector(int* & map_scnt, std::vector< std::vector
 template<typename KEY, typename VAL, typename IT>
 void SpParHelper::MemoryEfficientPSort(std::pair<KEY,VAL> * array, IT length, IT * dist, const MPI_Comm & comm)
 {
-	int nprocs, myrank;
-	MPI_Comm_size(comm, &nprocs);
-	MPI_Comm_rank(comm, &myrank);
-	int nsize = nprocs / 2;	// new size
-	if(nprocs < 10000)
-	{
-		bool excluded =  false;
-		if(dist[myrank] == 0)	excluded = true;
-
-		int nreals = 0; 
-		for(int i=0; i< nprocs; ++i)	
-			if(dist[i] != 0) ++nreals;
-
-        //SpParHelper::MemoryEfficientPSort(vecpair, nnz, dist, World);
-        
-		if(nreals == nprocs)	// general case
-		{
-            long * dist_in = new long[nprocs];
-            for(int i=0; i< nprocs; ++i)    dist_in[i] = (long) dist[i];
-            vpsort::parallel_sort (array, array+length,  dist_in, comm);
-            delete [] dist_in;
-		}
-		else
-		{
-			long * dist_in = new long[nreals];
-			int * dist_out = new int[nprocs-nreals];	// ranks to exclude
-			int indin = 0;
-			int indout = 0;
-			for(int i=0; i< nprocs; ++i)	
-			{
-				if(dist[i] == 0)
-					dist_out[indout++] = i;
-				else
-					dist_in[indin++] = (long) dist[i];	
-			}
-		
-			#ifdef DEBUG	
-      std::ostringstream outs;
-			outs << "To exclude indices: ";
-      std::copy(dist_out, dist_out+indout, std::ostream_iterator<int>(outs, " ")); outs << std::endl;
-			SpParHelper::Print(outs.str());
-			#endif
-
-			MPI_Group sort_group, real_group;
-			MPI_Comm_group(comm, &sort_group);
-			MPI_Group_excl(sort_group, indout, dist_out, &real_group);
-			MPI_Group_free(&sort_group);
-
-			// The Create() function should be executed by all processes in comm, 
-			// even if they do not belong to the new group (in that case MPI_COMM_NULL is returned as real_comm?)
-			// MPI::Intracomm MPI::Intracomm::Create(const MPI::Group& group) const;
-			MPI_Comm real_comm;
-			MPI_Comm_create(comm, real_group, &real_comm);
-			if(!excluded)
-			{
-				vpsort::parallel_sort (array, array+length,  dist_in, real_comm);
-				MPI_Comm_free(&real_comm);
-			}
-			MPI_Group_free(&real_group);
-			delete [] dist_in;
-			delete [] dist_out;
-		}
-	}
-	else
-	{
-		IT gl_median = std::accumulate(dist, dist+nsize, static_cast<IT>(0));	// global rank of the first element of the median processor
-		sort(array, array+length);	// re-sort because we might have swapped data in previous iterations
-		int color = (myrank < nsize)? 0: 1;
-		
-		std::pair<KEY,VAL> * low = array;
-		std::pair<KEY,VAL> * upp = array;
-		GlobalSelect(gl_median, low, upp, array, length, comm);
-		BipartiteSwap(low, array, length, nsize, color, comm);
-
-		if(color == 1)	dist = dist + nsize;	// adjust for the second half of processors
-
-		// recursive call; two implicit 'spawn's where half of the processors execute different paramaters
-		// MPI::Intracomm MPI::Intracomm::Split(int color, int key) const;
-
-		MPI_Comm halfcomm;
-		MPI_Comm_split(comm, color, myrank, &halfcomm);	// split into two communicators
-		MemoryEfficientPSort(array, length, dist, halfcomm);
-	}
-    
+	SampleSort(array, length, dist, comm);
 }
 
 
-/*
- TODO: This function is just a hack at this moment. 
- The payload (VAL) can only be integer at this moment.
- FIX this.
- */
 template<typename KEY, typename VAL, typename IT>
 std::vector<std::pair<KEY,VAL>> SpParHelper::KeyValuePSort(std::pair<KEY,VAL> * array, IT length, IT * dist, const MPI_Comm & comm)
 {
-    int nprocs, myrank;
-    MPI_Comm_size(comm, &nprocs);
-    MPI_Comm_rank(comm, &myrank);
-    int nsize = nprocs / 2;	// new size
-    
-    
-    
-    bool excluded =  false;
-    if(dist[myrank] == 0)	excluded = true;
-    
-    int nreals = 0;
-    for(int i=0; i< nprocs; ++i)
-        if(dist[i] != 0) ++nreals;
-    
-    std::vector<IndexHolder<KEY>> in(length);
-#ifdef THREADED
-#pragma omp parallel for
-#endif
-    for(int i=0; i< length; ++i)
-    {
-        in[i] = IndexHolder<KEY>(array[i].first, static_cast<unsigned long>(array[i].second));
-    }
-    
-    if(nreals == nprocs)	// general case
-    {
-        par::sampleSort(in, comm);
-    }
-    else
-    {
-        long * dist_in = new long[nreals];
-        int * dist_out = new int[nprocs-nreals];	// ranks to exclude
-        int indin = 0;
-        int indout = 0;
-        for(int i=0; i< nprocs; ++i)
-        {
-            if(dist[i] == 0)
-                dist_out[indout++] = i;
-            else
-                dist_in[indin++] = (long) dist[i];
-        }
-        
-#ifdef DEBUG
-        std::ostringstream outs;
-        outs << "To exclude indices: ";
-        std::copy(dist_out, dist_out+indout, std::ostream_iterator<int>(outs, " ")); outs << std::endl;
-        SpParHelper::Print(outs.str());
-#endif
-        
-        MPI_Group sort_group, real_group;
-        MPI_Comm_group(comm, &sort_group);
-        MPI_Group_excl(sort_group, indout, dist_out, &real_group);
-        MPI_Group_free(&sort_group);
-        
-        // The Create() function should be executed by all processes in comm,
-        // even if they do not belong to the new group (in that case MPI_COMM_NULL is returned as real_comm?)
-        // MPI::Intracomm MPI::Intracomm::Create(const MPI::Group& group) const;
-        MPI_Comm real_comm;
-        MPI_Comm_create(comm, real_group, &real_comm);
-        if(!excluded)
-        {
-            par::sampleSort(in, real_comm);
-            MPI_Comm_free(&real_comm);
-        }
-        MPI_Group_free(&real_group);
-        delete [] dist_in;
-        delete [] dist_out;
-    }
-
-    std::vector<std::pair<KEY,VAL>> sorted(in.size());
-    for(int i=0; i<in.size(); i++)
-    {
-        sorted[i].second = static_cast<VAL>(in[i].index);
-        sorted[i].first = in[i].value;
-    }
-    return sorted;
+	std::vector<std::pair<KEY,VAL>> sorted(array, array+length);
+	SampleSort(sorted.data(), length, dist, comm);
+	return sorted;
 }
 
 
@@ -950,4 +796,235 @@ inline void SpParHelper::FreeWindows(std::vector<MPI_Win> & arrwin)
 	}
 }
 
+
+/**
+  * Reads a matrix market file collectively over comm, every process parses an equal share of the file's bytes
+  * Symmetric files are expanded, so the number of tuples returned may exceed the number of lines read
+  * Used by SpParMat::ParallelReadMM and SpParMat3D::ParallelReadMM, which only differ in where tuples are sent
+  **/
+template <typename IT, typename NT>
+void SpParHelper::ReadMMTuples(const std::string & filename, bool onebased, MPI_Comm comm, int64_t & nrows, int64_t & ncols,
+				std::vector<IT> & rows, std::vector<IT> & cols, std::vector<NT> & vals)
+{
+    int32_t type = -1;
+    int32_t symmetric = 0;
+    int64_t nonzeros;
+    int64_t linesread = 0;
+    
+    FILE *f;
+    int myrank, nprocs;
+    MPI_Comm_rank(comm, &myrank);
+    MPI_Comm_size(comm, &nprocs);
+    if(myrank == 0)
+    {
+        MM_typecode matcode;
+        if ((f = fopen(filename.c_str(), "r")) == NULL)
+        {
+            printf("COMBBLAS: Matrix-market file %s can not be found\n", filename.c_str());
+            MPI_Abort(MPI_COMM_WORLD, NOFILE);
+        }
+        if (mm_read_banner(f, &matcode) != 0)
+        {
+            printf("Could not process Matrix Market banner.\n");
+            exit(1);
+        }
+        linesread++;
+        
+        if (mm_is_complex(matcode))
+        {
+            printf("Sorry, this application does not support complext types");
+            printf("Market Market type: [%s]\n", mm_typecode_to_str(matcode));
+        }
+        else if(mm_is_real(matcode))
+        {
+            std::cout << "Matrix is Float" << std::endl;
+            type = 0;
+        }
+        else if(mm_is_integer(matcode))
+        {
+            std::cout << "Matrix is Integer" << std::endl;
+            type = 1;
+        }
+        else if(mm_is_pattern(matcode))
+        {
+            std::cout << "Matrix is Boolean" << std::endl;
+            type = 2;
+        }
+        if(mm_is_symmetric(matcode) || mm_is_hermitian(matcode))
+        {
+            std::cout << "Matrix is symmetric" << std::endl;
+            symmetric = 1;
+        }
+        int ret_code;
+        if ((ret_code = mm_read_mtx_crd_size(f, &nrows, &ncols, &nonzeros, &linesread)) !=0)  // ABAB: mm_read_mtx_crd_size made 64-bit friendly
+            exit(1);
+    
+        std::cout << "Total number of nonzeros expected across all processors is " << nonzeros << std::endl;
+
+    }
+    MPI_Bcast(&type, 1, MPI_INT, 0, comm);
+    MPI_Bcast(&symmetric, 1, MPI_INT, 0, comm);
+    MPI_Bcast(&nrows, 1, MPIType<int64_t>(), 0, comm);
+    MPI_Bcast(&ncols, 1, MPIType<int64_t>(), 0, comm);
+    MPI_Bcast(&nonzeros, 1, MPIType<int64_t>(), 0, comm);
+
+    // Use fseek again to go backwards two bytes and check that byte with fgetc
+    struct stat st;     // get file size
+    if (stat(filename.c_str(), &st) == -1)
+    {
+        MPI_Abort(MPI_COMM_WORLD, NOFILE);
+    }
+    int64_t file_size = st.st_size;
+    MPI_Offset fpos, end_fpos, endofheader;
+    if(myrank == 0)    // the offset needs to be for this rank
+    {
+        std::cout << "File is " << file_size << " bytes" << std::endl;
+	fpos = ftell(f);
+	endofheader =  fpos;
+    	MPI_Bcast(&endofheader, 1, MPIType<MPI_Offset>(), 0, comm);
+        fclose(f);
+    }
+    else
+    {
+    	MPI_Bcast(&endofheader, 1, MPIType<MPI_Offset>(), 0, comm);  // receive the file loc at the end of header
+	fpos = endofheader + myrank * (file_size-endofheader) / nprocs;
+    }
+    if(myrank != (nprocs-1)) end_fpos = endofheader + (myrank + 1) * (file_size-endofheader) / nprocs;
+    else end_fpos = file_size;
+
+    MPI_File mpi_fh;
+    MPI_File_open (comm, const_cast<char*>(filename.c_str()), MPI_MODE_RDONLY, MPI_INFO_NULL, &mpi_fh);
+
+	 
+
+    std::vector<std::string> lines;
+    bool finished = SpParHelper::FetchBatch(mpi_fh, fpos, end_fpos, true, lines, myrank);
+    int64_t entriesread = lines.size();
+    SpHelper::ProcessLines(rows, cols, vals, lines, symmetric, type, onebased);
+    MPI_Barrier(comm);
+
+    while(!finished)
+    {
+        finished = SpParHelper::FetchBatch(mpi_fh, fpos, end_fpos, false, lines, myrank);
+        entriesread += lines.size();
+        SpHelper::ProcessLines(rows, cols, vals, lines, symmetric, type, onebased);
+    }
+    int64_t allentriesread;
+    MPI_Reduce(&entriesread, &allentriesread, 1, MPIType<int64_t>(), MPI_SUM, 0, comm);
+#ifdef COMBBLAS_DEBUG
+    if(myrank == 0)
+        std::cout << "Reading finished. Total number of entries read across all processors is " << allentriesread << std::endl;
+#endif
+    MPI_File_close(&mpi_fh);
+}
+
+
+/**
+ * A vector of length glen is cut into nblocks blocks (the last one takes the remainder) 
+ * and each block into npieces pieces (again the last one takes the remainder). 
+ * Returns the global start and the length of the given piece of the given block.
+ * FullyDist vectors use (nblocks,npieces) = (pr,pc) with block = processor row;
+ * the columns of a SpParMat use (pc,pr) with block = processor column 
+ **/
+template <typename IT>
+void SpParHelper::LayoutRange(IT glen, int nblocks, int npieces, int block, int piece, IT & start, IT & len)
+{
+	IT perblock = glen / nblocks;
+	IT blocklen = (block == nblocks-1)? (glen - perblock*(nblocks-1)) : perblock;
+	IT perpiece = blocklen / npieces;
+	start = perblock * block + perpiece * piece;
+	len = (piece == npieces-1)? (blocklen - perpiece*(npieces-1)) : perpiece;
+}
+
+/**
+ * Owner of global index gind in the column layout of a pr x pc grid: 
+ * processor (i,j) holds the i-th piece of the j-th column block.
+ * lind is set to the index within the column block (not within the piece), which is what the local matrix uses
+ **/
+template <typename IT>
+int SpParHelper::ColumnLayoutOwner(IT glen, int pr, int pc, IT gind, IT & lind)
+{
+	IT perblock = glen / pc;
+	int block = (perblock != 0)? std::min(static_cast<int>(gind / perblock), pc-1) : (pc-1);
+	IT blocklen = (block == pc-1)? (glen - perblock*(pc-1)) : perblock;
+	lind = gind - perblock * block;
+	IT perpiece = blocklen / pr;
+	int piece = (perpiece != 0)? std::min(static_cast<int>(lind / perpiece), pr-1) : (pr-1);
+	return piece * pc + block;
+}
+
+/**
+ * Moves a dense vector of length glen between the FullyDist layout (processor (i,j) owns the j-th piece of the i-th row block) 
+ * and the column layout (processor (i,j) owns the i-th piece of the j-th column block), in the direction given by tocolumns.
+ * On square grids the two layouts are transposes of each other and the exchange is a single Sendrecv with P(j,i);
+ * on rectangular grids a piece can overlap several pieces of the other layout, so we use an Alltoallv over the intersections
+ * Every element can be a row of width consecutive entries (as in DenseMultiVec), glen still counts rows
+ **/
+template <typename IT, typename NT>
+void SpParHelper::TransposeLayout(const std::shared_ptr<CommGrid> & grid, IT glen, bool tocolumns, const NT * sendbuf, std::vector<NT> & recvbuf, int width)
+{
+	int pr = grid->GetGridRows();
+	int pc = grid->GetGridCols();
+	int myrow = grid->GetRankInProcCol();
+	int mycol = grid->GetRankInProcRow();
+	IT mystart, mylen, tostart, tolen;
+	if(tocolumns)
+	{
+		LayoutRange(glen, pr, pc, myrow, mycol, mystart, mylen);
+		LayoutRange(glen, pc, pr, mycol, myrow, tostart, tolen);
+	}
+	else
+	{
+		LayoutRange(glen, pc, pr, mycol, myrow, mystart, mylen);
+		LayoutRange(glen, pr, pc, myrow, mycol, tostart, tolen);
+	}
+	recvbuf.resize(tolen * width);
+	if(pr == pc)
+	{
+		int diagneigh = grid->GetComplementRank();
+		MPI_Status status;
+		MPI_Sendrecv(const_cast<NT*>(sendbuf), (int) (mylen * width), MPIType<NT>(), diagneigh, TRX, recvbuf.data(), (int) (tolen * width), MPIType<NT>(), diagneigh, TRX, grid->GetWorld(), &status);
+		return;
+	}
+	int nprocs = pr * pc;
+	int * sendcnt = new int[nprocs]();
+	int * sdispls = new int[nprocs]();
+	int * recvcnt = new int[nprocs]();
+	int * rdispls = new int[nprocs]();
+	for(int i=0; i< pr; ++i)
+	{
+		for(int j=0; j< pc; ++j)
+		{
+			IT hisstart, hislen, hisfrom, hisfromlen;	// his range in the target layout and in the source layout
+			if(tocolumns)
+			{
+				LayoutRange(glen, pc, pr, j, i, hisstart, hislen);
+				LayoutRange(glen, pr, pc, i, j, hisfrom, hisfromlen);
+			}
+			else
+			{
+				LayoutRange(glen, pr, pc, i, j, hisstart, hislen);
+				LayoutRange(glen, pc, pr, j, i, hisfrom, hisfromlen);
+			}
+			int rank = grid->GetRank(i, j);
+			IT beg = std::max(mystart, hisstart);
+			IT end = std::min(mystart+mylen, hisstart+hislen);
+			if(beg < end)
+			{
+				sendcnt[rank] = (int) ((end - beg) * width);
+				sdispls[rank] = (int) ((beg - mystart) * width);
+			}
+			beg = std::max(tostart, hisfrom);
+			end = std::min(tostart+tolen, hisfrom+hisfromlen);
+			if(beg < end)
+			{
+				recvcnt[rank] = (int) ((end - beg) * width);
+				rdispls[rank] = (int) ((beg - tostart) * width);
+			}
+		}
+	}
+	MPI_Alltoallv(const_cast<NT*>(sendbuf), sendcnt, sdispls, MPIType<NT>(), recvbuf.data(), recvcnt, rdispls, MPIType<NT>(), grid->GetWorld());
+	DeleteAll(sendcnt, sdispls, recvcnt, rdispls);
+}
+
 }
@@ -42,6 +42,7 @@
 #include "MPIType.h"
 #include "SpDefs.h"
 #include "psort/psort.h"
+#include "SampleSort.h"
 
 namespace combblas {
 
@@ -58,13 +59,8 @@ public:
 	template<typename KEY, typename VAL, typename IT>
 	static void BipartiteSwap(std::pair<KEY,VAL> * low, std::pair<KEY,VAL> * array, IT length, int nfirsthalf, int color, const MPI_Comm & comm);
 
-	// Necessary because psort creates three 2D vectors of size p-by-p
-	// One of those vector with 8 byte data uses 8*(4096)^2 = 128 MB space 
-	// Per processor extra storage becomes:
-	//	24 MB with 1K processors
-	//	96 MB with 2K processors
-	//	384 MB with 4K processors
-	// 	1.5 GB with 8K processors
+	// Both sort the pairs and leave dist[i] of them on process i, see SampleSort.h
+	// Unlike psort, the splitter selection needs O(p) rather than O(p^2) extra storage per processor
 	template<typename KEY, typename VAL, typename IT>
 	static void MemoryEfficientPSort(std::pair<KEY,VAL> * array, IT length, IT * dist, const MPI_Comm & comm);
 
@@ -109,7 +105,19 @@ public:
     	static void PrintFile(const std::string & s, const std::string & filename, MPI_Comm & world);
     	static void check_newline(int *bytes_read, int bytes_requested, char *buf);
    	static bool FetchBatch(MPI_File & infile, MPI_Offset & curpos, MPI_Offset end_fpos, bool firstcall, std::vector<std::string> & lines, int myrank);
+	template <typename IT, typename NT>
+	static void ReadMMTuples(const std::string & filename, bool onebased, MPI_Comm comm, int64_t & nrows, int64_t & ncols,
+				std::vector<IT> & rows, std::vector<IT> & cols, std::vector<NT> & vals);
     
+	template <typename IT>
+	static void LayoutRange(IT glen, int nblocks, int npieces, int block, int piece, IT & start, IT & len);
+
+	template <typename IT>
+	static int ColumnLayoutOwner(IT glen, int pr, int pc, IT gind, IT & lind);
+
+	template <typename IT, typename NT>
+	static void TransposeLayout(const std::shared_ptr<CommGrid> & grid, IT glen, bool tocolumns, const NT * sendbuf, std::vector<NT> & recvbuf, int width = 1);
+
 	static void WaitNFree(std::vector<MPI_Win> & arrwin);
 	static void FreeWindows(std::vector<MPI_Win> & arrwin);
 };
@@ -622,6 +622,7 @@ SpParMat< IT,NT,DER >::SpParMat (const SpParMat< IT,NT,DER > & rhs)
 		spSeq = new DER(*(rhs.spSeq));  	// Deep copy of local block
 
 	commGrid =  rhs.commGrid;
+	symmetricUpper = rhs.symmetricUpper;
 }
 
 template <class IT, class NT, class DER>
@@ -636,6 +637,7 @@ SpParMat< IT,NT,DER > & SpParMat< IT,NT,DER >::operator=(const SpParMat< IT,NT,D
 			spSeq = new DER(*(rhs.spSeq));  // Deep copy of local block
 	
 		commGrid = rhs.commGrid;
+		symmetricUpper = rhs.symmetricUpper;
 	}
 	return *this;
 }
@@ -710,21 +712,15 @@ void SpParMat<IT,NT,DER>::DimApply(Dim dim, const FullyDistVec<IT, NT>& x, _Bina
 		MPI_Abort(MPI_COMM_WORLD, GRIDMISMATCH);
 	}
 
-	MPI_Comm World = x.commGrid->GetWorld();
 	MPI_Comm ColWorld = x.commGrid->GetColWorld();
 	MPI_Comm RowWorld = x.commGrid->GetRowWorld();
 	switch(dim)
 	{
 		case Column:	// scale each column
 		{
-			int xsize = (int) x.LocArrSize();
-			int trxsize = 0;
-			int diagneigh = x.commGrid->GetComplementRank();
-			MPI_Status status;
-			MPI_Sendrecv(&xsize, 1, MPI_INT, diagneigh, TRX, &trxsize, 1, MPI_INT, diagneigh, TRX, World, &status);
-	
-			NT * trxnums = new NT[trxsize];
-			MPI_Sendrecv(const_cast<NT*>(SpHelper::p2a(x.arr)), xsize, MPIType<NT>(), diagneigh, TRX, trxnums, trxsize, MPIType<NT>(), diagneigh, TRX, World, &status);
+			std::vector<NT> trxnums;
+			SpParHelper::TransposeLayout(x.commGrid, x.TotalLength(), true, SpHelper::p2a(x.arr), trxnums);
+			int trxsize = (int) trxnums.size();
 
 			int colneighs, colrank;
 			MPI_Comm_size(ColWorld, &colneighs);
@@ -738,8 +734,8 @@ void SpParMat<IT,NT,DER>::DimApply(Dim dim, const FullyDistVec<IT, NT>& x, _Bina
 			int accsize = std::accumulate(colsize, colsize+colneighs, 0);
 			NT * scaler = new NT[accsize];
 
-			MPI_Allgatherv(trxnums, trxsize, MPIType<NT>(), scaler, colsize, dpls, MPIType<NT>(), ColWorld);
-			DeleteAll(trxnums,colsize, dpls);
+			MPI_Allgatherv(trxnums.data(), trxsize, MPIType<NT>(), scaler, colsize, dpls, MPIType<NT>(), ColWorld);
+			DeleteAll(colsize, dpls);
 
 			for(typename DER::SpColIter colit = spSeq->begcol(); colit != spSeq->endcol(); ++colit)	// iterate over columns
 			{
@@ -918,14 +914,8 @@ void SpParMat<IT,NT,DER>::Reduce(FullyDistVec<GIT,VT> & rvec, Dim dim, _BinaryOp
 			}
 			DeleteAll(loclens, lensums);
 
-			GIT reallen;	// Now we have to transpose the vector
-			GIT trlen = trarr.size();
-			int diagneigh = commGrid->GetComplementRank();
-			MPI_Status status;
-			MPI_Sendrecv(&trlen, 1, MPIType<IT>(), diagneigh, TRNNZ, &reallen, 1, MPIType<IT>(), diagneigh, TRNNZ, commGrid->GetWorld(), &status);
-	
-			rvec.arr.resize(reallen);
-			MPI_Sendrecv(SpHelper::p2a(trarr), trlen, MPIType<VT>(), diagneigh, TRX, SpHelper::p2a(rvec.arr), reallen, MPIType<VT>(), diagneigh, TRX, commGrid->GetWorld(), &status);
+			// Now we have to transpose the vector
+			SpParHelper::TransposeLayout(commGrid, static_cast<GIT>(getncol()), false, SpHelper::p2a(trarr), rvec.arr);
 			rvec.glen = getncol();	// ABAB: Put a sanity check here
 			break;
 
@@ -2824,6 +2814,214 @@ SpParMat<IT, NT, DER>::BlockSplit (int br, int bc)
 
 
 
+/**
+  * Relabels every local nonzero (i,j) as (newrows[i],newcols[j]) and routes it to its new owner in a single all-to-all
+  * @param[in] newrows {new global row index of each local row}
+  * @param[in] newcols {new global column index of each local column}
+  * The send buffer is sized by a counting pass and filled in place, and the local block is freed before the exchange,
+  * so at most two copies of the local nonzeros are alive at any point (SparseCommon would need a third for its buckets)
+  **/
+template <class IT, class NT, class DER>
+void SpParMat<IT,NT,DER>::RelabelAndRedistribute(const std::vector<IT> & newrows, const std::vector<IT> & newcols)
+{
+	typedef typename DER::LocalIT LIT;
+	IT total_m = getnrow();
+	IT total_n = getncol();
+	int nprocs = commGrid->GetSize();
+	int * sendcnt = new int[nprocs]();
+	int * recvcnt = new int[nprocs];
+	int * sdispls = new int[nprocs]();
+	int * rdispls = new int[nprocs]();
+
+	for(typename DER::SpColIter colit = spSeq->begcol(); colit != spSeq->endcol(); ++colit)
+	{
+		IT gcol = newcols[colit.colid()];
+		for(typename DER::SpColIter::NzIter nzit = spSeq->begnz(colit); nzit != spSeq->endnz(colit); ++nzit)
+		{
+			LIT lrow, lcol;
+			++sendcnt[Owner(total_m, total_n, newrows[nzit.rowid()], gcol, lrow, lcol)];
+		}
+	}
+	std::partial_sum(sendcnt, sendcnt+nprocs-1, sdispls+1);
+	IT totsent = std::accumulate(sendcnt,sendcnt+nprocs, static_cast<IT>(0));
+
+	std::tuple<LIT,LIT,NT> * senddata = new std::tuple<LIT,LIT,NT>[totsent];
+	std::vector<int> curptrs(sdispls, sdispls+nprocs);
+	for(typename DER::SpColIter colit = spSeq->begcol(); colit != spSeq->endcol(); ++colit)
+	{
+		IT gcol = newcols[colit.colid()];
+		for(typename DER::SpColIter::NzIter nzit = spSeq->begnz(colit); nzit != spSeq->endnz(colit); ++nzit)
+		{
+			LIT lrow, lcol;
+			int owner = Owner(total_m, total_n, newrows[nzit.rowid()], gcol, lrow, lcol);
+			senddata[curptrs[owner]++] = std::make_tuple(lrow, lcol, nzit.value());
+		}
+	}
+	delete spSeq;
+	spSeq = NULL;
+
+	MPI_Alltoall(sendcnt, 1, MPI_INT, recvcnt, 1, MPI_INT, commGrid->GetWorld());
+	std::partial_sum(recvcnt, recvcnt+nprocs-1, rdispls+1);
+	IT totrecv = std::accumulate(recvcnt,recvcnt+nprocs, static_cast<IT>(0));
+	assert((totsent < std::numeric_limits<int>::max()));
+	assert((totrecv < std::numeric_limits<int>::max()));
+
+	MPI_Datatype MPI_triple;
+	MPI_Type_contiguous(sizeof(std::tuple<LIT,LIT,NT>), MPI_CHAR, &MPI_triple);
+	MPI_Type_commit(&MPI_triple);
+	std::tuple<LIT,LIT,NT> * recvdata = new std::tuple<LIT,LIT,NT>[totrecv];
+	MPI_Alltoallv(senddata, sendcnt, sdispls, MPI_triple, recvdata, recvcnt, rdispls, MPI_triple, commGrid->GetWorld());
+	DeleteAll(senddata, sendcnt, recvcnt, sdispls, rdispls);
+	MPI_Type_free(&MPI_triple);
+
+	LIT locrows = newrows.size();	// a permutation keeps the local dimensions intact
+	LIT loccols = newcols.size();
+	SpTuples<LIT,NT> A(totrecv, locrows, loccols, recvdata);	// It is ~SpTuples's job to deallocate
+	spSeq = new DER(A,false);	// a permutation creates no duplicates
+}
+
+/**
+  * Computes, for every local row (Dim=Row) or column (Dim=Column), its global index after applying A(perm,:) or A(:,perm)
+  * Since B(i,:) = A(perm[i],:), old index perm[i] becomes i. Each (perm[i],i) pair is sent straight to the processor
+  * that holds the matching piece of its row (column) block, and the pieces are then allgathered along the processor row (column)
+  **/
+template <class IT, class NT, class DER>
+void SpParMat<IT,NT,DER>::InvertToLocalLabels(const FullyDistVec<IT,IT> & perm, Dim dim, std::vector<IT> & newlabels) const
+{
+	MPI_Comm World = commGrid->GetWorld();
+	int nprocs = commGrid->GetSize();
+	int nblocks = (dim == Row) ? commGrid->GetGridRows() : commGrid->GetGridCols();
+	int nsplits = (dim == Row) ? commGrid->GetGridCols() : commGrid->GetGridRows();
+	int myblock = (dim == Row) ? commGrid->GetRankInProcCol() : commGrid->GetRankInProcRow();
+	int mysplit = (dim == Row) ? commGrid->GetRankInProcRow() : commGrid->GetRankInProcCol();
+	IT total = (dim == Row) ? getnrow() : getncol();
+	IT perblock = total / nblocks;
+	auto blocklength = [&](int b) { return (b == nblocks-1) ? total - perblock*(nblocks-1) : perblock; };
+	auto piecelength = [&](IT blocklen, int k) { return (k == nsplits-1) ? blocklen - (blocklen/nsplits)*(nsplits-1) : blocklen/nsplits; };
+
+	std::vector< std::vector<IT> > data(nprocs);
+	IT sizeuntil = perm.LengthUntil();
+	for(IT i=0; i < perm.LocArrSize(); ++i)
+	{
+		IT old = perm.arr[i];
+		int b = (perblock != 0) ? std::min(static_cast<int>(old / perblock), nblocks-1) : nblocks-1;
+		IT inblock = old - b*perblock;
+		IT perpiece = blocklength(b) / nsplits;
+		int k = (perpiece != 0) ? std::min(static_cast<int>(inblock / perpiece), nsplits-1) : nsplits-1;
+		int dest = (dim == Row) ? commGrid->GetRank(b,k) : commGrid->GetRank(k,b);
+		data[dest].push_back(inblock - k*perpiece);	// index within the piece
+		data[dest].push_back(i + sizeuntil);		// new global index
+	}
+
+	int * sendcnt = new int[nprocs];
+	int * recvcnt = new int[nprocs];
+	int * sdispls = new int[nprocs]();
+	int * rdispls = new int[nprocs]();
+	for(int i=0; i<nprocs; ++i)
+		sendcnt[i] = data[i].size();
+	MPI_Alltoall(sendcnt, 1, MPI_INT, recvcnt, 1, MPI_INT, World);
+	std::partial_sum(sendcnt, sendcnt+nprocs-1, sdispls+1);
+	std::partial_sum(recvcnt, recvcnt+nprocs-1, rdispls+1);
+	IT totsend = std::accumulate(sendcnt,sendcnt+nprocs, static_cast<IT>(0));
+	IT totrecv = std::accumulate(recvcnt,recvcnt+nprocs, static_cast<IT>(0));
+
+	IT * sendbuf = new IT[totsend];
+	for(int i=0; i<nprocs; ++i)
+	{
+		std::copy(data[i].begin(), data[i].end(), sendbuf+sdispls[i]);
+		std::vector<IT>().swap(data[i]);
+	}
+	IT * recvbuf = new IT[totrecv];
+	MPI_Alltoallv(sendbuf, sendcnt, sdispls, MPIType<IT>(), recvbuf, recvcnt, rdispls, MPIType<IT>(), World);
+	DeleteAll(sendbuf, sendcnt, recvcnt, sdispls, rdispls);
+
+	IT myblocklen = blocklength(myblock);
+	std::vector<IT> piece(piecelength(myblocklen, mysplit));
+	for(IT i=0; i < totrecv; i+=2)
+		piece[recvbuf[i]] = recvbuf[i+1];
+	delete [] recvbuf;
+
+	int * piecelens = new int[nsplits];
+	int * piecedispls = new int[nsplits]();
+	for(int k=0; k<nsplits; ++k)
+		piecelens[k] = piecelength(myblocklen, k);
+	std::partial_sum(piecelens, piecelens+nsplits-1, piecedispls+1);
+	newlabels.resize(myblocklen);
+	MPI_Comm pieceWorld = (dim == Row) ? commGrid->GetRowWorld() : commGrid->GetColWorld();
+	MPI_Allgatherv(piece.data(), piece.size(), MPIType<IT>(), newlabels.data(), piecelens, piecedispls, MPIType<IT>(), pieceWorld);
+	DeleteAll(piecelens, piecedispls);
+}
+
+/**
+  * Applies the permutations directly: the result is A(ri,ci) for permutation vectors ri and ci
+  * Tuples are relabeled locally and routed to their new owners in one all-to-all, as opposed to
+  * SubsRef_SR which forms two permutation matrices and performs two SpGEMMs
+  * @param[in] inplace {if true, this object is permuted and a blank matrix is returned (matches the PruneI convention)}
+  **/
+template <class IT, class NT, class DER>
+SpParMat<IT,NT,DER> SpParMat<IT,NT,DER>::Permute(const FullyDistVec<IT,IT> & ri, const FullyDistVec<IT,IT> & ci, bool inplace)
+{
+	if((*(ri.commGrid) != *(commGrid)) || (*(ci.commGrid) != *(commGrid)))
+	{
+		SpParHelper::Print("Grids are not comparable, Permute() fails!\n");
+		MPI_Abort(MPI_COMM_WORLD, GRIDMISMATCH);
+	}
+	if(ri.TotalLength() != getnrow() || ci.TotalLength() != getncol())
+	{
+		SpParHelper::Print("Permutation lengths do not match the matrix dimensions, Permute() fails!\n");
+		MPI_Abort(MPI_COMM_WORLD, DIMMISMATCH);
+	}
+	if(!inplace)
+	{
+		SpParMat<IT,NT,DER> B(*this);
+		B.Permute(ri, ci, true);
+		return B;
+	}
+	std::vector<IT> newrows, newcols;
+	InvertToLocalLabels(ri, Row, newrows);
+	InvertToLocalLabels(ci, Column, newcols);
+	RelabelAndRedistribute(newrows, newcols);
+	return SpParMat<IT,NT,DER>(commGrid);	// return blank to match signature
+}
+
+/**
+  * Randomly relabels rows and columns with the implicit permutations generated by FullyDistVec::randperm
+  * If symmetric (square matrices only) the result is A(p,p) where p.randperm(getnrow(), seed),
+  * otherwise it is A(p,q) where p.randperm(getnrow(), seed) and q.randperm(getncol(), seed+1)
+  * Unlike A(p,q) via SubsRef_SR, no permutation vector is stored or communicated and no SpGEMM is performed
+  **/
+template <class IT, class NT, class DER>
+void SpParMat<IT,NT,DER>::RandomRelabel(uint64_t seed, bool symmetric)
+{
+	IT total_m = getnrow();
+	IT total_n = getncol();
+	if(symmetric && total_m != total_n)
+	{
+		SpParHelper::Print("Symmetric relabeling requires a square matrix, RandomRelabel() fails!\n");
+		MPI_Abort(MPI_COMM_WORLD, NOTSQUARE);
+	}
+	FeistelPermutation<IT> rperm(total_m, seed);
+	FeistelPermutation<IT> cperm(total_n, symmetric ? seed : seed+1);
+
+	IT roffset, coffset;
+	GetPlaceInGlobalGrid(roffset, coffset);
+	std::vector<IT> newrows(getlocalrows());
+	std::vector<IT> newcols(getlocalcols());
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+	for(IT i=0; i < static_cast<IT>(newrows.size()); ++i)
+		newrows[i] = rperm(roffset + i);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+	for(IT j=0; j < static_cast<IT>(newcols.size()); ++j)
+		newcols[j] = cperm(coffset + j);
+
+	RelabelAndRedistribute(newrows, newcols);
+}
+
+
 //! All vectors are zero-based indexed (as usual)
 template <class IT, class NT, class DER>
 SpParMat< IT,NT,DER >::SpParMat (IT total_m, IT total_n, const FullyDistVec<IT,IT> & distrows, 
@@ -2842,22 +3040,23 @@ SpParMat< IT,NT,DER >::SpParMat (IT total_m, IT total_n, const FullyDistVec<IT,I
 
 	commGrid = distrows.commGrid;	
 	int nprocs = commGrid->GetSize();
-	std::vector< std::vector < std::tuple<IT,IT,NT> > > data(nprocs);
+	typedef typename DER::LocalIT LIT;
+	std::vector< std::vector < std::tuple<LIT,LIT,NT> > > data(nprocs);	// local indices, possibly narrower than IT
 
 	IT locsize = distrows.LocArrSize();
 	for(IT i=0; i<locsize; ++i)
 	{
-		IT lrow, lcol; 
+		LIT lrow, lcol; 
 		int owner = Owner(total_m, total_n, distrows.arr[i], distcols.arr[i], lrow, lcol);
 		data[owner].push_back(std::make_tuple(lrow,lcol,distvals.arr[i]));	
 	}
     if(SumDuplicates)
     {
-        SparseCommon(data, locsize, total_m, total_n, std::plus<NT>());
+        SparseCommon(data, static_cast<LIT>(locsize), total_m, total_n, std::plus<NT>());
     }
     else
     {
-        SparseCommon(data, locsize, total_m, total_n, maximum<NT>());
+        SparseCommon(data, static_cast<LIT>(locsize), total_m, total_n, maximum<NT>());
     }
 }
 
@@ -2879,22 +3078,23 @@ SpParMat< IT,NT,DER >::SpParMat (IT total_m, IT total_n, const FullyDistVec<IT,I
 	}
 	commGrid = distrows.commGrid;
 	int nprocs = commGrid->GetSize();
-	std::vector< std::vector < std::tuple<IT,IT,NT> > > data(nprocs);
+	typedef typename DER::LocalIT LIT;
+	std::vector< std::vector < std::tuple<LIT,LIT,NT> > > data(nprocs);	// local indices, possibly narrower than IT
 
 	IT locsize = distrows.LocArrSize();
 	for(IT i=0; i<locsize; ++i)
 	{
-		IT lrow, lcol; 
+		LIT lrow, lcol; 
 		int owner = Owner(total_m, total_n, distrows.arr[i], distcols.arr[i], lrow, lcol);
 		data[owner].push_back(std::make_tuple(lrow,lcol,val));	
 	}
     if(SumDuplicates)
     {
-        SparseCommon(data, locsize, total_m, total_n, std::plus<NT>());
+        SparseCommon(data, static_cast<LIT>(locsize), total_m, total_n, std::plus<NT>());
     }
     else
     {
-        SparseCommon(data, locsize, total_m, total_n, maximum<NT>());
+        SparseCommon(data, static_cast<LIT>(locsize), total_m, total_n, maximum<NT>());
     }
 }
 
@@ -2927,6 +3127,23 @@ SpParMat< IT,NT,DER >::SpParMat (const DistEdgeList<DELIT> & DEL, bool removeloo
 	int64_t perstage = DEL.nedges / stages;
 	LIT totrecv = 0;
 	std::vector<LIT> alledges;
+
+	if(DEL.ownerlocal)	// edges were generated on their owners, only translate to local indices
+	{
+		stages = 0;
+		alledges.reserve(2*DEL.nedges);
+		for (int64_t i = 0; i < DEL.nedges; i++)
+		{
+			if(DEL.edges[2*i+0] >= 0 && DEL.edges[2*i+1] >= 0)
+			{
+				IT lrow, lcol;
+				Owner(DEL.getGlobalV(), DEL.getGlobalV(), DEL.edges[2*i+0], DEL.edges[2*i+1], lrow, lcol);
+				alledges.push_back(lrow);
+				alledges.push_back(lcol);
+			}
+		}
+		totrecv = alledges.size();
+	}
     
 	for(LIT s=0; s< stages; ++s)
 	{
@@ -3022,7 +3239,26 @@ IT SpParMat<IT,NT,DER>::RemoveLoops()
 	MPI_Comm DiagWorld = commGrid->GetDiagWorld();
 	IT totrem;
 	IT removed = 0;
-	if(DiagWorld != MPI_COMM_NULL) // Diagonal processors only
+	if(commGrid->GetGridRows() != commGrid->GetGridCols())	// any block can intersect the diagonal
+	{
+		typedef typename DER::LocalIT LIT;
+		IT roffset, coffset;
+		GetPlaceInGlobalGrid(roffset, coffset);
+		SpTuples<LIT,NT> tuples(*spSeq);
+		delete spSeq;
+		LIT locnnz = tuples.getnnz();
+		std::tuple<LIT,LIT,NT> * kept = new std::tuple<LIT,LIT,NT>[locnnz];
+		LIT cnt = 0;
+		for(LIT i=0; i< locnnz; ++i)
+		{
+			if(roffset + tuples.rowindex(i) != coffset + tuples.colindex(i))
+				kept[cnt++] = std::make_tuple(tuples.rowindex(i), tuples.colindex(i), tuples.numvalue(i));
+		}
+		removed = locnnz - cnt;
+		SpTuples<LIT,NT> nonloops(cnt, tuples.getnrow(), tuples.getncol(), kept);	// nonloops owns kept
+		spSeq = new DER(nonloops, false);
+	}
+	else if(DiagWorld != MPI_COMM_NULL) // Diagonal processors only
 	{
 		typedef typename DER::LocalIT LIT;
 		SpTuples<LIT,NT> tuples(*spSeq);
@@ -3039,6 +3275,11 @@ IT SpParMat<IT,NT,DER>::RemoveLoops()
 template <class IT, class NT, class DER>
 void SpParMat<IT,NT,DER>::AddLoops(NT loopval, bool replaceExisting)
 {
+	if(commGrid->GetGridRows() != commGrid->GetGridCols())
+	{
+		SpParHelper::Print("SpParMat::AddLoops() needs a square processor grid\n", commGrid->GetWorld());
+		MPI_Abort(MPI_COMM_WORLD,GRIDMISMATCH);
+	}
 	MPI_Comm DiagWorld = commGrid->GetDiagWorld();
 	if(DiagWorld != MPI_COMM_NULL) // Diagonal processors only
 	{
@@ -3068,6 +3309,11 @@ void SpParMat<IT,NT,DER>::AddLoops(FullyDistVec<IT,NT> loopvals, bool replaceExi
         SpParHelper::Print("The number of entries in loopvals is not equal to the number of diagonal entries.\n");
         MPI_Abort(MPI_COMM_WORLD,DIMMISMATCH);
     }
+    if(commGrid->GetGridRows() != commGrid->GetGridCols())
+    {
+        SpParHelper::Print("SpParMat::AddLoops() needs a square processor grid\n", commGrid->GetWorld());
+        MPI_Abort(MPI_COMM_WORLD,GRIDMISMATCH);
+    }
     
     // Gather data on the diagonal processor
     IT locsize = loopvals.LocArrSize();
@@ -3287,9 +3533,48 @@ void SpParMat<IT,NT,DER>::Square ()
 }
 
 
+/**
+ * Gives a symmetric matrix of which only the upper triangle is stored (see Mult_AnXBn_Symmetric) its strict lower
+ * triangle, the transpose of the strict upper one; any other matrix is left as is
+ **/
+template <class IT, class NT, class DER>
+void SpParMat<IT,NT,DER>::MirrorUpper()
+{
+	if(!symmetricUpper)
+		return;
+	symmetricUpper = false;
+	SpParMat<IT,NT,DER> Lower(*this);
+	Lower.RemoveLoops();
+	Lower.Transpose();
+	*this += Lower;
+}
+
 template <class IT, class NT, class DER>
 void SpParMat<IT,NT,DER>::Transpose()
 {
+	if(symmetricUpper)	// the stored upper triangle already is that of the transpose
+		return;
+	if(commGrid->GetGridRows() != commGrid->GetGridCols())
+	{
+		// the block of A' owned by P(i,j) is not the transpose of a single block of A, so route every nonzero to its new owner
+		typedef typename DER::LocalIT LIT;
+		IT total_m = getnrow();
+		IT total_n = getncol();
+		IT roffset, coffset;
+		GetPlaceInGlobalGrid(roffset, coffset);
+		SpTuples<LIT,NT> Atuples(*spSeq);
+		LIT locnnz = Atuples.getnnz();
+		std::vector< std::vector < std::tuple<LIT,LIT,NT> > > data(commGrid->GetSize());
+		for(LIT i=0; i < locnnz; ++i)
+		{
+			LIT lrow, lcol;
+			int owner = Owner(total_n, total_m, coffset + Atuples.colindex(i), roffset + Atuples.rowindex(i), lrow, lcol);	// swap (i,j) here
+			data[owner].push_back(std::make_tuple(lrow, lcol, Atuples.numvalue(i)));
+		}
+		delete spSeq;
+		SparseCommon(data, locnnz, total_n, total_m, maximum<NT>());	// no duplicates, so the operation is never applied
+		return;
+	}
 	if(commGrid->myproccol == commGrid->myprocrow)	// Diagonal
 	{
 		spSeq->Transpose();			
@@ -3466,16 +3751,35 @@ void SpParMat< IT,NT,DER >::SaveGathered(std::string filename, HANDLER handler,
 }
 
 
-//! Private subroutine of ReadGeneralizedTuples
-//! totallength is the length of the dictionary, which we don't know in this labeled tuples format apriori
+//! Handles all sorts of orderings as long as there are no duplicates
+//! Does not take matrix market banner (only tuples)
+//! Data can be load imbalanced and the vertex labels can be arbitrary strings
+//! Replaces ReadDistribute for imbalanced arbitrary input in tuples format
+//! Returns the id -> label mapping with labels truncated to MAXVERTNAME, use the VertexDictionary overload to keep it
+template <class IT, class NT, class DER>
+template <typename _BinaryOperation>
+FullyDistVec<IT,std::array<char, MAXVERTNAME> > SpParMat< IT,NT,DER >::ReadGeneralizedTuples (const std::string & filename, _BinaryOperation BinOp)
+{
+    VertexDictionary<IT> dict(commGrid);
+    ReadGeneralizedTuples(filename, BinOp, dict);
+    return dict.DistMapper();
+}
+
+
+/**
+  * Reads labeled tuples in a single pass, labels are translated through dict
+  * Labels already in dict keep their ids and unseen ones are appended, so the same dictionary can be
+  * reused (or saved and reloaded) across loads of related edge streams
+  * The matrix is dict.getnvert()-by-dict.getnvert() after the call
+  */
 template <class IT, class NT, class DER>
-MPI_File SpParMat< IT,NT,DER >::TupleRead1stPassNExchange (const std::string & filename, TYPE2SEND * & senddata, IT & totsend, 
-							FullyDistVec<IT,STRASARRAY> & distmapper, uint64_t & totallength)
+template <typename _BinaryOperation>
+void SpParMat< IT,NT,DER >::ReadGeneralizedTuples (const std::string & filename, _BinaryOperation BinOp, VertexDictionary<IT> & dict)
 {
     int myrank = commGrid->GetRank();
-    int nprocs = commGrid->GetSize();     
+    int nprocs = commGrid->GetSize();
 
-    MPI_Offset fpos, end_fpos;    
+    MPI_Offset fpos, end_fpos;
     struct stat st;     // get file size
     if (stat(filename.c_str(), &st) == -1)
     {
@@ -3494,243 +3798,58 @@ MPI_File SpParMat< IT,NT,DER >::TupleRead1stPassNExchange (const std::string & f
     MPI_File mpi_fh;
     MPI_File_open (commGrid->commWorld, const_cast<char*>(filename.c_str()), MPI_MODE_RDONLY, MPI_INFO_NULL, &mpi_fh);
 
-    typedef std::map<std::string, uint64_t> KEYMAP; // due to potential (but extremely unlikely) collusions in MurmurHash, make the key to the std:map the string itself
-    std::vector< KEYMAP > allkeys(nprocs);	  // map keeps the outgoing data unique, we could have applied this to HipMer too
+    // endpoints are kept as entries of a local label table until the dictionary numbers them
+    LabelTable<IT> locallabels;
+    std::vector<uint64_t> ends;
+    std::vector<NT> vals;
 
     std::vector<std::string> lines;
     bool finished = SpParHelper::FetchBatch(mpi_fh, fpos, end_fpos, true, lines, myrank);
     int64_t entriesread = lines.size();
-    SpHelper::ProcessLinesWithStringKeys(allkeys, lines,nprocs);
+    SpHelper::ProcessLabeledLines(locallabels, ends, vals, lines);
 
     while(!finished)
     {
         finished = SpParHelper::FetchBatch(mpi_fh, fpos, end_fpos, false, lines, myrank);
-
         entriesread += lines.size();
-    	SpHelper::ProcessLinesWithStringKeys(allkeys, lines,nprocs);
+        SpHelper::ProcessLabeledLines(locallabels, ends, vals, lines);
     }
+    MPI_File_close(&mpi_fh);
     int64_t allentriesread;
     MPI_Reduce(&entriesread, &allentriesread, 1, MPIType<int64_t>(), MPI_SUM, 0, commGrid->commWorld);
 #ifdef COMBBLAS_DEBUG
     if(myrank == 0)
-        std::cout << "Initial reading finished. Total number of entries read across all processors is " << allentriesread << std::endl;
-#endif
-
-    int * sendcnt = new int[nprocs];
-    int * recvcnt = new int[nprocs];
-    for(int i=0; i<nprocs; ++i)
-	sendcnt[i] = allkeys[i].size();
-
-    MPI_Alltoall(sendcnt, 1, MPI_INT, recvcnt, 1, MPI_INT, commGrid->GetWorld()); // share the counts
-    int * sdispls = new int[nprocs]();
-    int * rdispls = new int[nprocs]();
-    std::partial_sum(sendcnt, sendcnt+nprocs-1, sdispls+1);
-    std::partial_sum(recvcnt, recvcnt+nprocs-1, rdispls+1);
-    totsend = std::accumulate(sendcnt,sendcnt+nprocs, static_cast<IT>(0));
-    IT totrecv = std::accumulate(recvcnt,recvcnt+nprocs, static_cast<IT>(0));	
-
-    assert((totsend < std::numeric_limits<int>::max()));	
-    assert((totrecv < std::numeric_limits<int>::max()));
-
-    // The following are declared in SpParMat.h
-    // typedef std::array<char, MAXVERTNAME> STRASARRAY;
-    // typedef std::pair< STRASARRAY, uint64_t> TYPE2SEND;
-    senddata = new TYPE2SEND[totsend];	
-
-    #pragma omp parallel for
-    for(int i=0; i<nprocs; ++i)
-    {
-	size_t j = 0;
-	for(auto pobj:allkeys[i])
-	{
-		// The naked C-style array type is not copyable or assignable, but pair will require it, hence used std::array
-		std::array<char, MAXVERTNAME> vname;
-		std::copy( pobj.first.begin(), pobj.first.end(), vname.begin() );  
-		if(pobj.first.length() < MAXVERTNAME)  vname[pobj.first.length()] = '\0';	// null termination		
-
-		senddata[sdispls[i]+j] = TYPE2SEND(vname, pobj.second);
-		j++;
-	}
-    }
-    allkeys.clear();  // allkeys is no longer needed after this point
-
-    MPI_Datatype MPI_HASH;
-    MPI_Type_contiguous(sizeof(TYPE2SEND), MPI_CHAR, &MPI_HASH);
-    MPI_Type_commit(&MPI_HASH);
-
-    TYPE2SEND * recvdata = new TYPE2SEND[totrecv];	
-    MPI_Alltoallv(senddata, sendcnt, sdispls, MPI_HASH, recvdata, recvcnt, rdispls, MPI_HASH, commGrid->GetWorld());
-    // do not delete send buffers yet as we will use them to recv back the data
-    
-    std::set< std::pair<uint64_t, std::string>  > uniqsorted;
-    for(IT i=0; i< totrecv; ++i)
-    {
-	    auto locnull = std::find(recvdata[i].first.begin(), recvdata[i].first.end(), '\0'); // find the null character (or string::end)
-	    std::string strtmp(recvdata[i].first.begin(), locnull); // range constructor 
-	    
-	    uniqsorted.insert(std::make_pair(recvdata[i].second, strtmp));
-    }
-    uint64_t uniqsize = uniqsorted.size();
-    
-#ifdef COMBBLAS_DEBUG
-    if(myrank == 0)
-	    std::cout << "out of " << totrecv << " vertices received, " << uniqsize << " were unique" << std::endl;
+        std::cout << "Reading finished. Total number of entries read across all processors is " << allentriesread << std::endl;
 #endif
-    uint64_t sizeuntil = 0;
-    totallength = 0;
-    MPI_Exscan( &uniqsize, &sizeuntil, 1, MPIType<uint64_t>(), MPI_SUM, commGrid->GetWorld() );
-    MPI_Allreduce(&uniqsize, &totallength, 1,  MPIType<uint64_t>(), MPI_SUM, commGrid->GetWorld());
-    if(myrank == 0) sizeuntil = 0;  // because MPI_Exscan says the recvbuf in process 0 is undefined
-
-    distmapper =  FullyDistVec<IT,STRASARRAY>(commGrid, totallength,STRASARRAY{});	
-	
-    // invindex does not conform to FullyDistVec boundaries, otherwise its contents are essentially the same as distmapper    
-    KEYMAP invindex;	// KEYMAP is map<string, uint64_t>. 
-    uint64_t locindex = 0;
-    std::vector< std::vector< IT > > locs_send(nprocs);
-    std::vector< std::vector< std::string > > data_send(nprocs);
-    int * map_scnt = new int[nprocs]();	// send counts for this map only (to no confuse with the other sendcnt)        
-    for(auto itr = uniqsorted.begin(); itr != uniqsorted.end(); ++itr)
-    {
-	    uint64_t globalindex = sizeuntil + locindex;
-	    invindex.insert(std::make_pair(itr->second, globalindex));
-	    
-	    IT newlocid;	
-	    int owner = distmapper.Owner(globalindex, newlocid);
-
-	    //if(myrank == 0)
-	    //    std::cout << "invindex received " << itr->second << " with global index " << globalindex << " to be owned by " << owner << " with index " << newlocid << std::endl;
-
-	    locs_send[owner].push_back(newlocid);
-	    data_send[owner].push_back(itr->second);
-	    map_scnt[owner]++;
-	    locindex++;
-    }
-    uniqsorted.clear();	// clear memory
-
-
-    /* BEGIN: Redistributing the permutation vector to fit the FullyDistVec semantics */
-    SpParHelper::ReDistributeToVector(map_scnt, locs_send, data_send, distmapper.arr, commGrid->GetWorld());   // map_scnt is deleted here
-    /* END: Redistributing the permutation vector to fit the FullyDistVec semantics */ 
-
-    for(IT i=0; i< totrecv; ++i)
-    {
-	    auto locnull = std::find(recvdata[i].first.begin(), recvdata[i].first.end(), '\0');
-	    std::string searchstr(recvdata[i].first.begin(), locnull); // range constructor 
-
-	    auto resp = invindex.find(searchstr); // recvdata[i] is of type pair< STRASARRAY, uint64_t>
-	    if (resp != invindex.end())
-	    {
-		recvdata[i].second = resp->second;	// now instead of random numbers, recvdata's second entry will be its new index
-	    }
-	    else
-		std::cout << "Assertion failed at proc " << myrank << ": the absence of the entry in invindex is unexpected!!!" << std::endl;
-    }
-    MPI_Alltoallv(recvdata, recvcnt, rdispls, MPI_HASH, senddata, sendcnt, sdispls, MPI_HASH, commGrid->GetWorld());    
-    DeleteAll(recvdata, sendcnt, recvcnt, sdispls, rdispls);
-    MPI_Type_free(&MPI_HASH);
-
-    // the following gets deleted here: allkeys
-    return mpi_fh;
-}
-
-
-
-//! Handles all sorts of orderings as long as there are no duplicates
-//! Does not take matrix market banner (only tuples)
-//! Data can be load imbalanced and the vertex labels can be arbitrary strings
-//! Replaces ReadDistribute for imbalanced arbitrary input in tuples format
-template <class IT, class NT, class DER>
-template <typename _BinaryOperation>
-FullyDistVec<IT,std::array<char, MAXVERTNAME> > SpParMat< IT,NT,DER >::ReadGeneralizedTuples (const std::string & filename, _BinaryOperation BinOp)
-{       
-    int myrank = commGrid->GetRank();
-    int nprocs = commGrid->GetSize();  
-    TYPE2SEND * senddata;
-    IT totsend;
-    uint64_t totallength;
-    FullyDistVec<IT,STRASARRAY> distmapper(commGrid); // choice of array<char, MAXVERTNAME> over string = array is required to be a contiguous container and an aggregate
-
-    MPI_File mpi_fh = TupleRead1stPassNExchange(filename, senddata, totsend, distmapper, totallength);
-
-    typedef std::map<std::string, uint64_t> KEYMAP;    
-    KEYMAP ultimateperm;	// the ultimate permutation
-    for(IT i=0; i< totsend; ++i)	
-    {
-	    auto locnull = std::find(senddata[i].first.begin(), senddata[i].first.end(), '\0');
-	    
-	    std::string searchstr(senddata[i].first.begin(), locnull);
-	    auto ret = ultimateperm.emplace(std::make_pair(searchstr, senddata[i].second));
-	    if(!ret.second)	// the second is the boolean that tells success
-	    {
-	        // remember, we only sent unique vertex ids in the first place so we are expecting unique values in return		
-		std::cout << "the duplication in ultimateperm is unexpected!!!" << std::endl;	
-	    }
-    }
-    delete [] senddata;
-
-    // rename the data now, first reset file pointers    
-    MPI_Offset fpos, end_fpos;
-    struct stat st;     // get file size
-    if (stat(filename.c_str(), &st) == -1)
-    {
-        MPI_Abort(MPI_COMM_WORLD, NOFILE);
-    }
-    int64_t file_size = st.st_size;
 
-    fpos = myrank * file_size / nprocs;   
-
-    if(myrank != (nprocs-1)) end_fpos = (myrank + 1) * file_size / nprocs;
-    else end_fpos = file_size;
+    std::vector<std::string> uniqlabels(locallabels.size());
+    for(size_t k=0; k<locallabels.size(); ++k)
+        uniqlabels[k] = locallabels.Label(k);
+    locallabels.Clear();
+    std::vector<IT> ids = dict.Insert(uniqlabels);
+    std::vector<std::string>().swap(uniqlabels);
+    IT totallength = dict.getnvert();
 
     typedef typename DER::LocalIT LIT;
-    std::vector<LIT> rows;
-    std::vector<LIT> cols;
-    std::vector<NT> vals;
-
-    std::vector<std::string> lines;
-    bool finished = SpParHelper::FetchBatch(mpi_fh, fpos, end_fpos, true, lines, myrank);
-    int64_t entriesread = lines.size();
-   
-    SpHelper::ProcessStrLinesNPermute(rows, cols, vals, lines, ultimateperm);
-
-    while(!finished)
-    {
-        finished = SpParHelper::FetchBatch(mpi_fh, fpos, end_fpos, false, lines, myrank);
-        entriesread += lines.size();
-    	SpHelper::ProcessStrLinesNPermute(rows, cols, vals, lines, ultimateperm);
-    }
-    int64_t allentriesread;
-    MPI_Reduce(&entriesread, &allentriesread, 1, MPIType<int64_t>(), MPI_SUM, 0, commGrid->commWorld);
-#ifdef COMBBLAS_DEBUG
-    if(myrank == 0)
-        std::cout << "Second reading finished. Total number of entries read across all processors is " << allentriesread << std::endl;
-#endif
-
-    MPI_File_close(&mpi_fh);
     std::vector< std::vector < std::tuple<LIT,LIT,NT> > > data(nprocs);
-    
-    LIT locsize = rows.size();   // remember: locsize != entriesread (unless the matrix is unsymmetric)
+
+    LIT locsize = vals.size();
     for(LIT i=0; i<locsize; ++i)
     {
         LIT lrow, lcol;
-        int owner = Owner(totallength, totallength, rows[i], cols[i], lrow, lcol);
+        int owner = Owner(totallength, totallength, ids[ends[2*i]], ids[ends[2*i+1]], lrow, lcol);
         data[owner].push_back(std::make_tuple(lrow,lcol,vals[i]));
     }
-    std::vector<LIT>().swap(rows);
-    std::vector<LIT>().swap(cols);
-    std::vector<NT>().swap(vals);	
+    std::vector<uint64_t>().swap(ends);
+    std::vector<NT>().swap(vals);
 
 #ifdef COMBBLAS_DEBUG
     if(myrank == 0)
         std::cout << "Packing to recipients finished, about to send..." << std::endl;
 #endif
-    
+
     if(spSeq)   delete spSeq;
     SparseCommon(data, locsize, totallength, totallength, BinOp);
-    // PrintInfo();
-    // distmapper.ParallelWrite("distmapper.mtx", 1, CharArraySaveHandler());
-    return distmapper; 
 }
 
 
@@ -3742,118 +3861,13 @@ template <class IT, class NT, class DER>
 template <typename _BinaryOperation>
 void SpParMat< IT,NT,DER >::ParallelReadMM (const std::string & filename, bool onebased, _BinaryOperation BinOp)
 {
-    int32_t type = -1;
-    int32_t symmetric = 0;
-    int64_t nrows, ncols, nonzeros;
-    int64_t linesread = 0;
-    
-    FILE *f;
-    int myrank = commGrid->GetRank();
+    int64_t nrows, ncols;
     int nprocs = commGrid->GetSize();
-    if(myrank == 0)
-    {
-        MM_typecode matcode;
-        if ((f = fopen(filename.c_str(), "r")) == NULL)
-        {
-            printf("COMBBLAS: Matrix-market file %s can not be found\n", filename.c_str());
-            MPI_Abort(MPI_COMM_WORLD, NOFILE);
-        }
-        if (mm_read_banner(f, &matcode) != 0)
-        {
-            printf("Could not process Matrix Market banner.\n");
-            exit(1);
-        }
-        linesread++;
-        
-        if (mm_is_complex(matcode))
-        {
-            printf("Sorry, this application does not support complext types");
-            printf("Market Market type: [%s]\n", mm_typecode_to_str(matcode));
-        }
-        else if(mm_is_real(matcode))
-        {
-            std::cout << "Matrix is Float" << std::endl;
-            type = 0;
-        }
-        else if(mm_is_integer(matcode))
-        {
-            std::cout << "Matrix is Integer" << std::endl;
-            type = 1;
-        }
-        else if(mm_is_pattern(matcode))
-        {
-            std::cout << "Matrix is Boolean" << std::endl;
-            type = 2;
-        }
-        if(mm_is_symmetric(matcode) || mm_is_hermitian(matcode))
-        {
-            std::cout << "Matrix is symmetric" << std::endl;
-            symmetric = 1;
-        }
-        int ret_code;
-        if ((ret_code = mm_read_mtx_crd_size(f, &nrows, &ncols, &nonzeros, &linesread)) !=0)  // ABAB: mm_read_mtx_crd_size made 64-bit friendly
-            exit(1);
-    
-        std::cout << "Total number of nonzeros expected across all processors is " << nonzeros << std::endl;
-
-    }
-    MPI_Bcast(&type, 1, MPI_INT, 0, commGrid->commWorld);
-    MPI_Bcast(&symmetric, 1, MPI_INT, 0, commGrid->commWorld);
-    MPI_Bcast(&nrows, 1, MPIType<int64_t>(), 0, commGrid->commWorld);
-    MPI_Bcast(&ncols, 1, MPIType<int64_t>(), 0, commGrid->commWorld);
-    MPI_Bcast(&nonzeros, 1, MPIType<int64_t>(), 0, commGrid->commWorld);
-
-    // Use fseek again to go backwards two bytes and check that byte with fgetc
-    struct stat st;     // get file size
-    if (stat(filename.c_str(), &st) == -1)
-    {
-        MPI_Abort(MPI_COMM_WORLD, NOFILE);
-    }
-    int64_t file_size = st.st_size;
-    MPI_Offset fpos, end_fpos, endofheader;
-    if(commGrid->GetRank() == 0)    // the offset needs to be for this rank
-    {
-        std::cout << "File is " << file_size << " bytes" << std::endl;
-	fpos = ftell(f);
-	endofheader =  fpos;
-    	MPI_Bcast(&endofheader, 1, MPIType<MPI_Offset>(), 0, commGrid->commWorld);
-        fclose(f);
-    }
-    else
-    {
-    	MPI_Bcast(&endofheader, 1, MPIType<MPI_Offset>(), 0, commGrid->commWorld);  // receive the file loc at the end of header
-	fpos = endofheader + myrank * (file_size-endofheader) / nprocs;
-    }
-    if(myrank != (nprocs-1)) end_fpos = endofheader + (myrank + 1) * (file_size-endofheader) / nprocs;
-    else end_fpos = file_size;
-
-    MPI_File mpi_fh;
-    MPI_File_open (commGrid->commWorld, const_cast<char*>(filename.c_str()), MPI_MODE_RDONLY, MPI_INFO_NULL, &mpi_fh);
-
-	 
     typedef typename DER::LocalIT LIT;
     std::vector<LIT> rows;
     std::vector<LIT> cols;
     std::vector<NT> vals;
-
-    std::vector<std::string> lines;
-    bool finished = SpParHelper::FetchBatch(mpi_fh, fpos, end_fpos, true, lines, myrank);
-    int64_t entriesread = lines.size();
-    SpHelper::ProcessLines(rows, cols, vals, lines, symmetric, type, onebased);
-    MPI_Barrier(commGrid->commWorld);
-
-    while(!finished)
-    {
-        finished = SpParHelper::FetchBatch(mpi_fh, fpos, end_fpos, false, lines, myrank);
-        entriesread += lines.size();
-        SpHelper::ProcessLines(rows, cols, vals, lines, symmetric, type, onebased);
-    }
-    int64_t allentriesread;
-    MPI_Reduce(&entriesread, &allentriesread, 1, MPIType<int64_t>(), MPI_SUM, 0, commGrid->commWorld);
-#ifdef COMBBLAS_DEBUG
-    if(myrank == 0)
-        std::cout << "Reading finished. Total number of entries read across all processors is " << allentriesread << std::endl;
-#endif
+    SpParHelper::ReadMMTuples(filename, onebased, commGrid->GetWorld(), nrows, ncols, rows, cols, vals);
 
     std::vector< std::vector < std::tuple<LIT,LIT,NT> > > data(nprocs);
     
@@ -3869,7 +3883,7 @@ void SpParMat< IT,NT,DER >::ParallelReadMM (const std::string & filename, bool o
     std::vector<NT>().swap(vals);	
 
 #ifdef COMBBLAS_DEBUG
-    if(myrank == 0)
+    if(commGrid->GetRank() == 0)
         std::cout << "Packing to recepients finished, about to send..." << std::endl;
 #endif
     
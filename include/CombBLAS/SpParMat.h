@@ -49,6 +49,7 @@
 #include "SpParHelper.h"
 #include "DenseParMat.h"
 #include "FullyDistVec.h"
+#include "VertexDictionary.h"
 #include "Friends.h"
 #include "Operations.h"
 #include "DistEdgeList.h"
@@ -56,6 +57,9 @@
 
 namespace combblas {
 
+template <typename LIT>
+class SpGEMMPlan;
+
 /**
   * Fundamental 2D distributed sparse matrix class
   * The index type IT is encapsulated by the class in a way that it is only
@@ -98,6 +102,8 @@ public:
 
 	float LoadImbalance() const;
 	void Transpose();
+	void MirrorUpper();
+	bool isSymmetricUpper() const { return symmetricUpper; }	//!< Only the upper triangle of a symmetric matrix is stored
 	void FreeMemory();
 	void EWiseMult (const SpParMat< IT,NT,DER >  & rhs, bool exclude);
 	void EWiseScale (const DenseParMat<IT,NT> & rhs);
@@ -231,6 +237,9 @@ public:
 						  BoolCopy2ndSRing<NT>>(v, dim, inplace);
 	}
 	
+	SpParMat<IT,NT,DER> Permute(const FullyDistVec<IT,IT> & ri, const FullyDistVec<IT,IT> & ci, bool inplace = false);	//!< A(ri,ci) for permutation vectors, no SpGEMM
+	void RandomRelabel(uint64_t seed, bool symmetric = true);	//!< In-place A(p,p) or A(p,q) with implicit random permutations, see FullyDistVec::randperm
+	
 	void Prune(const FullyDistVec<IT,IT> & ri, const FullyDistVec<IT,IT> & ci);	//!< prune all entries whose row indices are in ri and column indices are in ci
 	void SpAsgn(const FullyDistVec<IT,IT> & ri, const FullyDistVec<IT,IT> & ci, SpParMat<IT,NT,DER> & B);
 	
@@ -276,6 +285,8 @@ public:
 
     	template <typename _BinaryOperation>
     	FullyDistVec<IT,std::array<char, MAXVERTNAME>> ReadGeneralizedTuples(const std::string&, _BinaryOperation);
+    	template <typename _BinaryOperation>
+    	void ReadGeneralizedTuples(const std::string&, _BinaryOperation, VertexDictionary<IT> & dict);
     
 	template <class HANDLER>
 	void ReadDistribute (const std::string & filename, int master, bool nonum, HANDLER handler, bool transpose = false, bool pario = false);
@@ -295,7 +306,7 @@ public:
 	typename DER::LocalIT getlocalcols() const { return spSeq->getncol();} 
 	typename DER::LocalIT getlocalnnz() const { return spSeq->getnnz(); }
 	DER & seq() { return (*spSeq); }
-	DER * seqptr() { return spSeq; }
+	DER * seqptr() const { return spSeq; }
     
     template <typename _BinaryOperation, typename LIT>
     void SparseCommon(std::vector< std::vector < std::tuple<LIT,LIT,NT> > > & data, LIT locsize, IT total_m, IT total_n, _BinaryOperation BinOp);
@@ -317,11 +328,20 @@ public:
 
 	template <typename SR, typename NUO, typename UDERO, typename IU, typename NU1, typename NU2, typename UDER1, typename UDER2> 
 	friend SpParMat<IU,NUO,UDERO> 
-	Mult_AnXBn_Synch (SpParMat<IU,NU1,UDER1> & A, SpParMat<IU,NU2,UDER2> & B, bool clearA, bool clearB);
+	Mult_AnXBn_Synch (SpParMat<IU,NU1,UDER1> & A, SpParMat<IU,NU2,UDER2> & B, bool clearA, bool clearB,
+			  SpGEMMPlan<typename UDER1::LocalIT> * plan);
+
+	template <typename SR, typename NUO, typename UDERO, typename IU, typename NU1, typename NU2, typename UDER1, typename UDER2> 
+	friend SpParMat<IU,NUO,UDERO> 
+	Mult_AnXBn_RectGrid (SpParMat<IU,NU1,UDER1> & A, SpParMat<IU,NU2,UDER2> & B, bool clearA, bool clearB);
 
 	template <typename SR, typename NUO, typename UDERO, typename IU, typename NU1, typename NU2, typename UDER1, typename UDER2> 
 	friend SpParMat<IU,NUO,UDERO> 
 	Mult_AnXBn_Overlap (SpParMat<IU,NU1,UDER1> & A, SpParMat<IU,NU2,UDER2> & B, bool clearA, bool clearB);
+
+	template <typename SR, typename NUO, typename UDERO, typename IU, typename NU1, typename NU2, typename UDER1, typename UDER2> 
+	friend SpParMat<IU,NUO,UDERO> 
+	Mult_AnXBn_Symmetric (SpParMat<IU,NU1,UDER1> & A, SpParMat<IU,NU2,UDER2> & B, bool clearA, bool clearB);
     
     template <typename IU, typename NU1, typename NU2, typename UDERA, typename UDERB>
     friend int64_t EstPerProcessNnzSUMMA(SpParMat<IU,NU1,UDERA> & A, SpParMat<IU,NU2,UDERB> & B, bool hashEstimate);
@@ -344,11 +364,13 @@ public:
 
     template <typename SR, typename NUO, typename UDERO, typename IU, typename NU1, typename NU2, typename UDERA, typename UDERB>
     friend SpParMat<IU,NUO,UDERO> MemEfficientSpGEMM (SpParMat<IU,NU1,UDERA> & A, SpParMat<IU,NU2,UDERB> & B,
-                                               int phases, NUO hardThreshold, IU selectNum, IU recoverNum, NUO recoverPct, int kselectVersion, int64_t perProcessMem);
+                                               int phases, NUO hardThreshold, IU selectNum, IU recoverNum, NUO recoverPct, int kselectVersion, int64_t perProcessMem,
+                                               SpGEMMPlan<typename UDERO::LocalIT> * plan);
 
     template <typename SR, typename NUO, typename UDERO, typename IU, typename NU1, typename NU2, typename UDERA, typename UDERB>
     friend int CalculateNumberOfPhases (SpParMat<IU,NU1,UDERA> & A, SpParMat<IU,NU2,UDERB> & B,
-                                               NUO hardThreshold, IU selectNum, IU recoverNum, NUO recoverPct, int kselectVersion, int64_t perProcessMem);
+                                               NUO hardThreshold, IU selectNum, IU recoverNum, NUO recoverPct, int kselectVersion, int64_t perProcessMem,
+                                               SpGEMMPlan<typename UDERO::LocalIT> * plan);
 
 	template <typename SR, typename IU, typename NUM, typename NUV, typename UDER> 
 	friend FullyDistSpVec<IU,typename promote_trait<NUM,NUV>::T_promote>  
@@ -390,7 +412,6 @@ public:
 
 private:
 	typedef std::array<char, MAXVERTNAME> STRASARRAY;
-	typedef std::pair< STRASARRAY, uint64_t> TYPE2SEND;
 
 	class CharArraySaveHandler
 	{
@@ -405,8 +426,6 @@ private:
     		}
 	};
     
-	MPI_File TupleRead1stPassNExchange (const std::string & filename, TYPE2SEND * & senddata, IT & totsend, FullyDistVec<IT,STRASARRAY> & distmapper, uint64_t & totallength);
-
 	template <typename VT, typename GIT, typename _BinaryOperation, typename _UnaryOperation >
     	void Reduce(FullyDistVec<GIT,VT> & rvec, Dim dim, _BinaryOperation __binary_op, VT id, _UnaryOperation __unary_op, MPI_Op mympiop) const;
     
@@ -418,6 +437,8 @@ private:
                     IT coffset, const FullyDistVec<GIT,VT> & rvec) const;
     
     void GetPlaceInGlobalGrid(IT& rowOffset, IT& colOffset) const;
+	void RelabelAndRedistribute(const std::vector<IT> & newrows, const std::vector<IT> & newcols);
+	void InvertToLocalLabels(const FullyDistVec<IT,IT> & perm, Dim dim, std::vector<IT> & newlabels) const;
 	
 	void HorizontalSend(IT * & rows, IT * & cols, NT * & vals, IT * & temprows, IT * & tempcols, NT * & tempvals, std::vector < std::tuple <IT,IT,NT> > & localtuples,
 						int * rcurptrs, int * rdispls, IT buffperrowneigh, int rowneighs, int recvcount, IT m_perproc, IT n_perproc, int rankinrow);
@@ -434,6 +455,7 @@ private:
 	
 	std::shared_ptr<CommGrid> commGrid; 
 	DER * spSeq;
+	bool symmetricUpper = false;	// set by Mult_AnXBn_Symmetric, cleared by MirrorUpper
 	
 	template <class IU, class NU>
 	friend class DenseParMat;
@@ -47,6 +47,12 @@ extern "C" {
 
 namespace combblas
 {
+    // defined at the end of this file, used by the constructors
+    template <class IT, class NT>
+    std::tuple<IT,IT,NT>* ExchangeData(std::vector<std::vector<std::tuple<IT,IT,NT>>> & tempTuples, MPI_Comm World, IT& datasize);
+    template <class IT, class NT, class DER>
+    void SpecialExchangeData( std::vector<DER> & sendChunks, MPI_Comm World, IT& datasize, NT dummy, vector<DER> & recvChunks);
+
     template <class IT, class NT, class DER>
     SpParMat3D<IT, NT, DER>::~SpParMat3D(){
         // No need to delete layermat because it is a smart pointer
@@ -845,168 +851,26 @@ namespace combblas
 #endif
             /*
              * 3d-reduction starts
+             * Column-compressed pieces of C_tuples travel to the layers owning their columns and are merged as they arrive
              * */
 #ifdef TIMING
             //MPI_Barrier(getcommgrid()->GetWorld());
             t0 = MPI_Wtime();
 #endif
-            MPI_Datatype MPI_tuple;
-            MPI_Type_contiguous(sizeof(std::tuple<LIT,LIT,NT>), MPI_CHAR, &MPI_tuple);
-            MPI_Type_commit(&MPI_tuple);
-            
-            /*
-             *  Create a profile with information regarding data to be sent and received between layers 
-             *  These memory allocation needs to be `int` specifically because some of these arrays would be used in communication
-             *  This is requirement is for MPI as MPI_Alltoallv takes pointer to integer exclusively as count and displacement
-             * */
-            int * sendcnt    = new int[getcommgrid()->GetGridLayers()];
-            int * sendprfl   = new int[getcommgrid()->GetGridLayers()*3];
-            int * sdispls    = new int[getcommgrid()->GetGridLayers()]();
-            int * recvcnt    = new int[getcommgrid()->GetGridLayers()];
-            int * recvprfl   = new int[getcommgrid()->GetGridLayers()*3];
-            int * rdispls    = new int[getcommgrid()->GetGridLayers()]();
-
-            vector<IT> lbDivisions3dPrefixSum(lbDivisions3d.size());
-            lbDivisions3dPrefixSum[0] = 0;
-            std::partial_sum(lbDivisions3d.begin(), lbDivisions3d.end()-1, lbDivisions3dPrefixSum.begin()+1);
-            ColLexiCompare<IT,NT> comp;
-            IT totsend = C_tuples->getnnz();
-            
-#ifdef TIMING
-            //MPI_Barrier(getcommgrid()->GetWorld());
-            t2 = MPI_Wtime();
-#endif
-#pragma omp parallel for
-            for(int i=0; i < getcommgrid()->GetGridLayers(); ++i){
-                IT start_col = lbDivisions3dPrefixSum[i];
-                IT end_col = lbDivisions3dPrefixSum[i] + lbDivisions3d[i];
-                std::tuple<IT, IT, NT> search_tuple_start(0, start_col, NT());
-                std::tuple<IT, IT, NT> search_tuple_end(0, end_col, NT());
-                std::tuple<IT, IT, NT>* start_it = std::lower_bound(C_tuples->tuples, C_tuples->tuples + C_tuples->getnnz(), search_tuple_start, comp);
-                std::tuple<IT, IT, NT>* end_it = std::lower_bound(C_tuples->tuples, C_tuples->tuples + C_tuples->getnnz(), search_tuple_end, comp);
-                // This type casting is important from semantic point of view
-                sendcnt[i] = (int)(end_it - start_it);
-                sendprfl[i*3+0] = (int)(sendcnt[i]); // Number of nonzeros in ith chunk
-                sendprfl[i*3+1] = (int)(layermat->seqptr()->getnrow()); // Number of rows in ith chunk
-                sendprfl[i*3+2] = (int)(lbDivisions3d[i]); // Number of columns in ith chunk
-            }
-            std::partial_sum(sendcnt, sendcnt+getcommgrid()->GetGridLayers()-1, sdispls+1);
-#ifdef TIMING
-            //MPI_Barrier(getcommgrid()->GetWorld());
-            t3 = MPI_Wtime();
-            if(myrank == 0) fprintf(stderr, "[MemEfficientSpGEMM3D]\tPhase: %d\tGetting Alltoall data ready: %lf\n", p, (t3-t2));
-#endif
-
-            // Send profile ready. Now need to update the tuples to reflect correct column id after column split.
-#ifdef TIMING
-            //MPI_Barrier(getcommgrid()->GetWorld());
-            t2 = MPI_Wtime();
-#endif
-            for(int i=0; i < getcommgrid()->GetGridLayers(); ++i){
-#pragma omp parallel for schedule(static)
-                for(int j = 0; j < sendcnt[i]; j++){
-                    std::get<1>(C_tuples->tuples[sdispls[i]+j]) = std::get<1>(C_tuples->tuples[sdispls[i]+j]) - lbDivisions3dPrefixSum[i];
-                }
-            }
-#ifdef TIMING
-            //MPI_Barrier(getcommgrid()->GetWorld());
-            t3 = MPI_Wtime();
-            if(myrank == 0) fprintf(stderr, "[MemEfficientSpGEMM3D]\tPhase: %d\tGetting Alltoallv data ready: %lf\n", p, (t3-t2));
-#endif
-
-#ifdef TIMING
-            //MPI_Barrier(B.getcommgrid()->GetWorld());
-            t2 = MPI_Wtime();
-#endif
-            MPI_Alltoall(sendprfl, 3, MPI_INT, recvprfl, 3, MPI_INT, commGrid3D->fiberWorld);
-#ifdef TIMING
-            //MPI_Barrier(B.getcommgrid()->GetWorld());
-            t3 = MPI_Wtime();
-            if(myrank == 0) fprintf(stderr, "[MemEfficientSpGEMM3D]\tPhase: %d\tAlltoall: %lf\n", p, (t3-t2));
-#endif
-#ifdef TIMING
-            //MPI_Barrier(getcommgrid()->GetWorld());
-            t2 = MPI_Wtime();
-#endif
-            for(int i = 0; i < getcommgrid()->GetGridLayers(); i++) recvcnt[i] = recvprfl[i*3];
-            std::partial_sum(recvcnt, recvcnt+getcommgrid()->GetGridLayers()-1, rdispls+1);
-            IT totrecv = std::accumulate(recvcnt,recvcnt+getcommgrid()->GetGridLayers(), static_cast<IT>(0));
-            //std::tuple<LIT,LIT,NT>* recvTuples = new std::tuple<LIT,LIT,NT>[totrecv];
-            std::tuple<LIT,LIT,NT>* recvTuples = static_cast<std::tuple<LIT,LIT,NT>*> (::operator new (sizeof(std::tuple<LIT,LIT,NT>[totrecv])));
-#ifdef TIMING
-            //MPI_Barrier(B.getcommgrid()->GetWorld());
-            t3 = MPI_Wtime();
-            if(myrank == 0) fprintf(stderr, "[MemEfficientSpGEMM3D]\tPhase: %d\tAllocation of receive data: %lf\n", p, (t3-t2));
-#endif
-
-#ifdef TIMING
-            //MPI_Barrier(B.getcommgrid()->GetWorld());
-            t2 = MPI_Wtime();
-#endif
-            MPI_Alltoallv(C_tuples->tuples, sendcnt, sdispls, MPI_tuple, recvTuples, recvcnt, rdispls, MPI_tuple, commGrid3D->fiberWorld);
-            delete C_tuples;
-#ifdef TIMING
-            //MPI_Barrier(B.getcommgrid()->GetWorld());
-            t3 = MPI_Wtime();
-            if(myrank == 0) fprintf(stderr, "[MemEfficientSpGEMM3D]\tPhase: %d\tAlltoallv: %lf\n", p, (t3-t2));
-#endif
-            vector<SpTuples<IT, NT>*> recvChunks(getcommgrid()->GetGridLayers());
-#pragma omp parallel for
-            for (int i = 0; i < getcommgrid()->GetGridLayers(); i++){
-                recvChunks[i] = new SpTuples<LIT, NT>(recvcnt[i], recvprfl[i*3+1], recvprfl[i*3+2], recvTuples + rdispls[i], true, false);
-            }
-
-            // Free all memory except tempTuples; Because that memory is holding data of newly created local matrices after receiving.
-            DeleteAll(sendcnt, sendprfl, sdispls);
-            DeleteAll(recvcnt, recvprfl, rdispls); 
-            MPI_Type_free(&MPI_tuple);
-            /*
-             * 3d-reduction ends 
-             * */
-            
+            SpTuples<IT, NT> * merged_tuples = FiberReduce<SR>(C_tuples, lbDivisions3d, commGrid3D->fiberWorld, true); // deletes C_tuples
 #ifdef TIMING
             //MPI_Barrier(B.getcommgrid()->GetWorld());
             t1 = MPI_Wtime();
             mcl3d_reductiontime += (t1-t0);
             if(myrank == 0) fprintf(stderr, "[MemEfficientSpGEMM3D]\tPhase: %d\tReduction time: %lf\n", p, (t1-t0));
-#endif
-#ifdef TIMING
-            //MPI_Barrier(B.getcommgrid()->GetWorld());
-            t0 = MPI_Wtime();
-            t2 = MPI_Wtime();
+            mcl3d_layer_nnzc += merged_tuples->getnnz();
 #endif
             /*
-             * 3d-merge starts 
+             * 3d-reduction ends 
              * */
-            //SpTuples<IT, NT> * merged_tuples = MultiwayMergeHash<SR, IT, NT>(recvChunks, recvChunks[0]->getnrow(), recvChunks[0]->getncol(), false); // Do not delete
-            SpTuples<IT, NT> * merged_tuples = MultiwayMerge<SR, IT, NT>(recvChunks, recvChunks[0]->getnrow(), recvChunks[0]->getncol(), false); // Do not delete
-#ifdef TIMING
-            //MPI_Barrier(B.getcommgrid()->GetWorld());
-            t3 = MPI_Wtime();
-            if(myrank == 0) fprintf(stderr, "[MemEfficientSpGEMM3D]\tPhase: %d\tMultiway Merge: %lf\n", p, (t3-t2));
-            mcl3d_layer_nnzc += merged_tuples->getnnz();
-#endif
-            //delete merged_tuples;
             DER * phaseResultant = new DER(*merged_tuples, false);
-
-            // Do not delete elements of recvChunks, because that would give segmentation fault due to double free
-            //delete [] recvTuples;
-            ::operator delete(recvTuples);
-            for(int i = 0; i < recvChunks.size(); i++){
-                recvChunks[i]->tuples_deleted = true; // Temporary patch to avoid memory leak and segfault
-                delete recvChunks[i];
-            }
-            vector<SpTuples<IT,NT>*>().swap(recvChunks);
+            delete merged_tuples;
             SpParMat<IT, NT, DER> phaseResultantLayer(phaseResultant, commGrid3D->layerWorld);
-            /*
-             * 3d-merge ends
-             * */
-#ifdef TIMING
-            //MPI_Barrier(B.getcommgrid()->GetWorld());
-            t1 = MPI_Wtime();
-            mcl3d_3dmergetime += (t1-t0);
-            if(myrank == 0) fprintf(stderr, "[MemEfficientSpGEMM3D]\tPhase: %d\t3D Merge time: %lf\n", p, (t1-t0));
-#endif
 
 #ifdef TIMING
             //MPI_Barrier(B.getcommgrid()->GetWorld());
@@ -1470,4 +1334,210 @@ namespace combblas
 
 	    return;
     }
+
+    template <class IT, class NT, class DER>
+    SpParMat3D< IT,NT,DER >::SpParMat3D (std::shared_ptr<CommGrid3D> grid3d, bool colsplit): commGrid3D(grid3d), colsplit(colsplit){
+        special = commGrid3D->special;
+        nlayers = commGrid3D->GetGridLayers();
+        layermat.reset(new SpParMat<IT, NT, DER>(commGrid3D->GetCommGridLayer()));
+    }
+
+    /*
+     * Along the split dimension every layer owns complete rows/columns, so the layer's own Reduce is final.
+     * Along the other dimension each layer only saw its slice, the partial results are combined over the fiber.
+     * Vector distribution is identical in all layers because all layers share the same 2D grid shape and length
+     * */
+    template <class IT, class NT, class DER>
+    template <typename _BinaryOperation, typename _UnaryOperation>
+    FullyDistVec<IT,NT> SpParMat3D<IT,NT,DER>::Reduce(Dim dim, _BinaryOperation __binary_op, NT id, _UnaryOperation __unary_op) const
+    {
+        FullyDistVec<IT,NT> parvec = layermat->Reduce(dim, __binary_op, id, __unary_op);
+        if(!IsSplitDim(dim)){
+            if(special){
+                SpParHelper::Print("SpParMat3D::Reduce() along the unsplit dimension is not supported for the special distribution\n");
+                MPI_Abort(MPI_COMM_WORLD, GRIDMISMATCH);
+            }
+            MPI_Allreduce(MPI_IN_PLACE, parvec.arr.data(), parvec.arr.size(), MPIType<NT>(), MPIOp<_BinaryOperation, NT>::op(), commGrid3D->fiberWorld);
+        }
+        return parvec;
+    }
+
+    template <class IT, class NT, class DER>
+    template <typename _BinaryOperation>
+    FullyDistVec<IT,NT> SpParMat3D<IT,NT,DER>::Reduce(Dim dim, _BinaryOperation __binary_op, NT id) const
+    {
+        return Reduce(dim, __binary_op, id, myidentity<NT>());
+    }
+
+    /*
+     * v is laid out as Reduce() returns it, hence scaling is purely layer local in both dimensions
+     * */
+    template <class IT, class NT, class DER>
+    template <typename _BinaryOperation>
+    void SpParMat3D<IT,NT,DER>::DimApply(Dim dim, const FullyDistVec<IT, NT>& v, _BinaryOperation __binary_op)
+    {
+        if(!IsSplitDim(dim) && special){
+            SpParHelper::Print("SpParMat3D::DimApply() along the unsplit dimension is not supported for the special distribution\n");
+            MPI_Abort(MPI_COMM_WORLD, GRIDMISMATCH);
+        }
+        layermat->DimApply(dim, v, __binary_op);
+    }
+
+    template <class IT, class NT, class DER>
+    template <typename _BinaryOperation>
+    void SpParMat3D<IT,NT,DER>::PruneColumn(const FullyDistVec<IT,NT> & pvals, _BinaryOperation __binary_op)
+    {
+        if(!colsplit && special){
+            SpParHelper::Print("SpParMat3D::PruneColumn() is not supported on a special row split matrix\n");
+            MPI_Abort(MPI_COMM_WORLD, GRIDMISMATCH);
+        }
+        layermat->PruneColumn(pvals, __binary_op, true);
+    }
+
+    /*
+     * k-th largest entry of every column, needs complete columns in a layer, i.e. a column split matrix
+     * */
+    template <class IT, class NT, class DER>
+    bool SpParMat3D<IT,NT,DER>::Kselect(FullyDistVec<IT,NT> & rvec, IT k_limit, int kselectVersion) const
+    {
+        if(!colsplit){
+            SpParHelper::Print("SpParMat3D::Kselect() requires a column split matrix\n");
+            MPI_Abort(MPI_COMM_WORLD, GRIDMISMATCH);
+        }
+        return layermat->Kselect(rvec, k_limit, kselectVersion);
+    }
+
+    /*
+     * Global index of the first local row and column, for the non-special distribution (see Owner)
+     * */
+    template <class IT, class NT, class DER>
+    void SpParMat3D<IT,NT,DER>::GetPlaceInGlobalGrid(IT& rowOffset, IT& colOffset) const
+    {
+        int nGridRows = commGrid3D->GetGridRows();
+        int nGridCols = commGrid3D->GetGridCols();
+        int nGridLayers = commGrid3D->GetGridLayers();
+        int rowrank = commGrid3D->commGridLayer->GetRankInProcCol();
+        int colrank = commGrid3D->commGridLayer->GetRankInProcRow();
+        IT m = getnrow();
+        IT n = getncol();
+        IT m_perproc_L0 = m / nGridRows;
+        IT n_perproc_L0 = n / nGridCols;
+        rowOffset = rowrank * m_perproc_L0;
+        colOffset = colrank * n_perproc_L0;
+        if(colsplit){
+            IT blockn = (colrank < nGridCols-1) ? n_perproc_L0 : (n - n_perproc_L0 * (nGridCols-1));
+            colOffset += (blockn / nGridLayers) * commGrid3D->rankInFiber;
+        }
+        else{
+            IT blockm = (rowrank < nGridRows-1) ? m_perproc_L0 : (m - m_perproc_L0 * (nGridRows-1));
+            rowOffset += (blockm / nGridLayers) * commGrid3D->rankInFiber;
+        }
+    }
+
+    /*
+     * Every process parses its share of the file and sends the tuples straight to their 3D owners
+     * Duplicates are combined with BinOp
+     * */
+    template <class IT, class NT, class DER>
+    template <typename _BinaryOperation>
+    void SpParMat3D<IT,NT,DER>::ParallelReadMM(const std::string & filename, bool onebased, _BinaryOperation BinOp)
+    {
+        typedef typename DER::LocalIT LIT;
+        if(special){
+            SpParHelper::Print("SpParMat3D::ParallelReadMM() is not supported for the special distribution\n");
+            MPI_Abort(MPI_COMM_WORLD, GRIDMISMATCH);
+        }
+        int nprocs = commGrid3D->GetSize();
+        int64_t nrows, ncols;
+        std::vector<LIT> rows;
+        std::vector<LIT> cols;
+        std::vector<NT> vals;
+        SpParHelper::ReadMMTuples(filename, onebased, commGrid3D->GetWorld(), nrows, ncols, rows, cols, vals);
+
+        std::vector< std::vector< std::tuple<LIT,LIT,NT> > > data(nprocs);
+        for(size_t i=0; i<rows.size(); ++i){
+            LIT lrow, lcol;
+            int owner = Owner(nrows, ncols, rows[i], cols[i], lrow, lcol);
+            data[owner].push_back(std::make_tuple(lrow, lcol, vals[i]));
+        }
+        std::vector<LIT>().swap(rows);
+        std::vector<LIT>().swap(cols);
+        std::vector<NT>().swap(vals);
+
+        LIT datasize;
+        std::tuple<LIT,LIT,NT>* recvTuples = ExchangeData(data, commGrid3D->GetWorld(), datasize);
+        IT mdim, ndim;
+        LocalDim(nrows, ncols, mdim, ndim);
+        SpTuples<LIT, NT> spTuples3d(datasize, mdim, ndim, recvTuples);     // sorts column-major
+        spTuples3d.RemoveDuplicates(BinOp);
+        layermat.reset(new SpParMat<IT, NT, DER>(new DER(spTuples3d, false), commGrid3D->GetCommGridLayer()));
+    }
+
+    template <class IT, class NT, class DER>
+    template <class HANDLER>
+    void SpParMat3D<IT,NT,DER>::ParallelWriteMM(const std::string & filename, bool onebased, HANDLER handler)
+    {
+        if(special){
+            SpParHelper::Print("SpParMat3D::ParallelWriteMM() is not supported for the special distribution\n");
+            MPI_Abort(MPI_COMM_WORLD, GRIDMISMATCH);
+        }
+        MPI_Comm world = commGrid3D->GetWorld();
+        int myrank = commGrid3D->GetRankInWorld();
+        int nprocs = commGrid3D->GetSize();
+        IT totalm = getnrow();
+        IT totaln = getncol();
+        IT totnnz = getnnz();
+
+        std::stringstream ss;
+        if(myrank == 0){
+            ss << "%%MatrixMarket matrix coordinate real general" << std::endl;
+            ss << totalm << " " << totaln << " " << totnnz << std::endl;
+        }
+        IT roffset = 0;
+        IT coffset = 0;
+        GetPlaceInGlobalGrid(roffset, coffset);
+        if(onebased){
+            roffset += 1;
+            coffset += 1;
+        }
+        DER * spSeq = layermat->seqptr();
+        for(typename DER::SpColIter colit = spSeq->begcol(); colit != spSeq->endcol(); ++colit){
+            for(typename DER::SpColIter::NzIter nzit = spSeq->begnz(colit); nzit != spSeq->endnz(colit); ++nzit){
+                IT glrowid = nzit.rowid() + roffset;
+                IT glcolid = colit.colid() + coffset;
+                ss << glrowid << '\t' << glcolid << '\t';
+                handler.save(ss, nzit.value(), glrowid, glcolid);
+                ss << '\n';
+            }
+        }
+        std::string text = ss.str();
+
+        std::vector<int64_t> bytes(nprocs);
+        bytes[myrank] = text.size();
+        MPI_Allgather(MPI_IN_PLACE, 1, MPIType<int64_t>(), bytes.data(), 1, MPIType<int64_t>(), world);
+        int64_t bytesuntil = std::accumulate(bytes.begin(), bytes.begin()+myrank, static_cast<int64_t>(0));
+        int64_t bytestotal = std::accumulate(bytes.begin(), bytes.end(), static_cast<int64_t>(0));
+
+        MPI_File thefile;
+        MPI_File_open(world, (char*) filename.c_str(), MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &thefile);
+        MPI_File_set_size(thefile, bytestotal);     // drop the tail of an older, longer file
+        int mpi_err = MPI_File_set_view(thefile, bytesuntil, MPI_CHAR, MPI_CHAR, (char*)"external32", MPI_INFO_NULL);
+        if (mpi_err == 51) {
+            // external32 datarep is not supported, use native instead
+            MPI_File_set_view(thefile, bytesuntil, MPI_CHAR, MPI_CHAR, (char*)"native", MPI_INFO_NULL);
+        }
+        int64_t batchSize = 256 * 1024 * 1024;
+        size_t localfileptr = 0;
+        int64_t remaining = bytes[myrank];
+        int64_t totalremaining = bytestotal;
+        while(totalremaining > 0){
+            MPI_Status status;
+            int curBatch = std::min(batchSize, remaining);
+            MPI_File_write_all(thefile, text.c_str()+localfileptr, curBatch, MPI_CHAR, &status);
+            localfileptr += curBatch;
+            remaining -= curBatch;
+            MPI_Allreduce(&remaining, &totalremaining, 1, MPIType<int64_t>(), MPI_SUM, world);
+        }
+        MPI_File_close(&thefile);
+    }
 }
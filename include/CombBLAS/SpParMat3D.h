@@ -55,6 +55,7 @@
 #include "DistEdgeList.h"
 #include "mtSpGEMM.h"
 #include "MultiwayMerge.h"
+#include "FiberReduce.h"
 #include "CombBLAS.h"
 
 namespace combblas
@@ -73,6 +74,7 @@ namespace combblas
         SpParMat3D (const SpParMat < IT,NT,DER > & A2D, int nlayers, bool colsplit, bool special = false);
         SpParMat3D (DER * myseq, std::shared_ptr<CommGrid3D> grid3d, bool colsplit, bool special = false);
         SpParMat3D (const SpParMat3D <IT,NT,DER> & A3D, bool colsplit);
+        SpParMat3D (std::shared_ptr<CommGrid3D> grid3d, bool colsplit);   // empty matrix, e.g. to read into
       
         ~SpParMat3D () ;
         
@@ -87,9 +89,9 @@ namespace combblas
         IT getnnz() const;
         
         std::shared_ptr< SpParMat<IT, NT, DER> > GetLayerMat() {return layermat;}
-        DER * seqptr() {return layermat->seqptr();}
-        bool isSpecial() {return special;}
-        bool isColSplit() {return colsplit;}
+        DER * seqptr() const {return layermat->seqptr();}
+        bool isSpecial() const {return special;}
+        bool isColSplit() const {return colsplit;}
 
         template <typename LIT>
         int Owner(IT total_m, IT total_n, IT grow, IT gcol, LIT & lrow, LIT & lcol) const;
@@ -109,6 +111,34 @@ namespace combblas
         std::shared_ptr<CommGrid3D> getcommgrid() const { return commGrid3D; } 	
         std::shared_ptr<CommGrid3D> getcommgrid3D() const {return commGrid3D;}
 
+        /* 
+         * Operations on the layered distribution, without going through Convert2D
+         * Dense vectors are distributed over the 2D grid of each layer (GetLayerMat()->getcommgrid()):
+         *  - along the split dimension (columns if colsplit, rows otherwise) a layer only holds its own slice,
+         *    so vectors are indexed by the layer-local column (row) ids, exactly as GetLayerMat() sees them
+         *  - along the other dimension every layer holds the complete, identical vector
+         * */
+        template <typename _BinaryOperation, typename _UnaryOperation>
+        FullyDistVec<IT,NT> Reduce(Dim dim, _BinaryOperation __binary_op, NT id, _UnaryOperation __unary_op) const;
+        template <typename _BinaryOperation>
+        FullyDistVec<IT,NT> Reduce(Dim dim, _BinaryOperation __binary_op, NT id) const;
+        template <typename _BinaryOperation>
+        void DimApply(Dim dim, const FullyDistVec<IT, NT>& v, _BinaryOperation __binary_op);
+        template <typename _UnaryOperation>
+        void Apply(_UnaryOperation __unary_op) { layermat->Apply(__unary_op); }
+        template <typename _UnaryOperation>
+        void Prune(_UnaryOperation __unary_op) { layermat->Prune(__unary_op, true); }   //!< in place
+        template <typename _BinaryOperation>
+        void PruneColumn(const FullyDistVec<IT,NT> & pvals, _BinaryOperation __binary_op);   //!< in place
+        bool Kselect(FullyDistVec<IT,NT> & rvec, IT k_limit, int kselectVersion) const;
+
+        template <typename _BinaryOperation>
+        void ParallelReadMM (const std::string & filename, bool onebased, _BinaryOperation BinOp);
+        template <class HANDLER>
+        void ParallelWriteMM(const std::string & filename, bool onebased, HANDLER handler);
+        void ParallelWriteMM(const std::string & filename, bool onebased)
+        { ParallelWriteMM(filename, onebased, typename SpParMat<IT,NT,DER>::ScalarReadSaveHandler()); }
+
         /* 3D SUMMA*/
         template <typename SR, typename NUO, typename UDERO, typename IU, typename NU1, typename NU2, typename UDER1, typename UDER2>
         friend SpParMat3D<IU,NUO,UDERO> Mult_AnXBn_SUMMA3D(SpParMat3D<IU,NU1,UDER1> & A, SpParMat3D<IU,NU2,UDER2> & B);
@@ -119,6 +149,9 @@ namespace combblas
                 int phases, NUO hardThreshold, IU selectNum, IU recoverNum, NUO recoverPct, int kselectVersion, int64_t perProcessMemory);
 
     private:
+        bool IsSplitDim(Dim dim) const { return colsplit ? (dim == Column) : (dim == Row); }
+        void GetPlaceInGlobalGrid(IT& rowOffset, IT& colOffset) const;
+
         std::shared_ptr<CommGrid3D> commGrid3D;
         //SpParMat<IT, NT, DER>* layermat;
         std::shared_ptr< SpParMat<IT, NT, DER> > layermat;
@@ -0,0 +1,543 @@
+/****************************************************************/
+/* Parallel Combinatorial BLAS Library (for Graph Computations) */
+/* version 1.6 -------------------------------------------------*/
+/* date: 6/15/2017 ---------------------------------------------*/
+/* authors: Ariful Azad, Aydin Buluc  --------------------------*/
+/****************************************************************/
+/*
+ Copyright (c) 2010-2017, The Regents of the University of California
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ THE SOFTWARE.
+ */
+
+
+#ifndef _VERTEX_DICTIONARY_H_
+#define _VERTEX_DICTIONARY_H_
+
+#include <mpi.h>
+#include <array>
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstring>
+#include <cstdint>
+#include <numeric>
+#include <algorithm>
+#include "SpDefs.h"
+#include "MPIType.h"
+#include "CommGrid.h"
+#include "SpParHelper.h"
+#include "FullyDistVec.h"
+#include "SampleSort.h"
+#include "hash.hpp"
+
+namespace combblas {
+
+inline uint64_t LabelHash(const char * label, uint32_t len)
+{
+	uint64_t hash;
+	MurmurHash3_x64_64(label, static_cast<int>(len), 0, &hash);
+	return hash;
+}
+
+/**
+ * Open addressing (linear probing) table of strings with a value per entry.
+ * The strings are stored back to back in an arena, so a label of any length costs its
+ * bytes plus one offset; entries are numbered in insertion order
+ */
+template <class VT>
+class LabelTable
+{
+public:
+	LabelTable(): offsets(1, 0), slots(16, -1), shift(60) {}
+
+	size_t size() const { return values.size(); }
+	const char * Data(size_t k) const { return arena.data() + offsets[k]; }
+	uint32_t Length(size_t k) const { return static_cast<uint32_t>(offsets[k+1] - offsets[k]); }
+	std::string Label(size_t k) const { return std::string(Data(k), Length(k)); }
+	uint64_t Hash(size_t k) const { return hashes[k]; }
+	VT & Value(size_t k) { return values[k]; }
+	const VT & Value(size_t k) const { return values[k]; }
+
+	//! entry of the label, -1 if absent
+	int64_t Find(const char * label, uint32_t len, uint64_t hash) const
+	{
+		for(size_t slot = Slot(hash); slots[slot] >= 0; slot = (slot+1) & (slots.size()-1))
+			if(Matches(slots[slot], label, len, hash))
+				return slots[slot];
+		return -1;
+	}
+
+	//! entry of the label, and whether it was inserted (with value) by this call
+	std::pair<size_t,bool> Insert(const char * label, uint32_t len, uint64_t hash, const VT & value)
+	{
+		size_t slot = Slot(hash);
+		for(; slots[slot] >= 0; slot = (slot+1) & (slots.size()-1))
+			if(Matches(slots[slot], label, len, hash))
+				return std::make_pair(static_cast<size_t>(slots[slot]), false);
+		size_t k = values.size();
+		slots[slot] = static_cast<int64_t>(k);
+		arena.insert(arena.end(), label, label+len);
+		offsets.push_back(arena.size());
+		hashes.push_back(hash);
+		values.push_back(value);
+		if(2*values.size() > slots.size())	// keep the load factor at most 1/2
+			Grow();
+		return std::make_pair(k, true);
+	}
+
+	std::pair<size_t,bool> Insert(const char * label, uint32_t len, const VT & value)
+	{
+		return Insert(label, len, LabelHash(label, len), value);
+	}
+
+	void Clear()
+	{
+		LabelTable<VT>().Swap(*this);
+	}
+
+	void Swap(LabelTable<VT> & rhs)
+	{
+		arena.swap(rhs.arena);
+		offsets.swap(rhs.offsets);
+		hashes.swap(rhs.hashes);
+		values.swap(rhs.values);
+		slots.swap(rhs.slots);
+		std::swap(shift, rhs.shift);
+	}
+
+private:
+	size_t Slot(uint64_t hash) const
+	{
+		return static_cast<size_t>((hash * 0x9E3779B97F4A7C15ULL) >> shift);	// the owner uses hash % p
+	}
+
+	bool Matches(int64_t k, const char * label, uint32_t len, uint64_t hash) const
+	{
+		return hashes[k] == hash && Length(k) == len && std::memcmp(Data(k), label, len) == 0;
+	}
+
+	void Grow()
+	{
+		slots.assign(2*slots.size(), -1);
+		--shift;
+		for(size_t k=0; k<values.size(); ++k)
+		{
+			size_t slot = Slot(hashes[k]);
+			while(slots[slot] >= 0) slot = (slot+1) & (slots.size()-1);
+			slots[slot] = static_cast<int64_t>(k);
+		}
+	}
+
+	std::vector<char> arena;
+	std::vector<uint64_t> offsets;
+	std::vector<uint64_t> hashes;
+	std::vector<VT> values;
+	std::vector<int64_t> slots;	// entry or -1
+	int shift;
+};
+
+
+/**
+ * Distributed, persistent dictionary between string labels and vertex ids 0..n-1.
+ * A label lives on process hash(label) % p in a LabelTable; the label of id i is also kept
+ * by process i % p, so that both directions are one exchange away. Batches of new labels
+ * get consecutive ids after the existing ones, so ids never change once assigned and
+ * incremental loads only pay for the labels they bring. All members are collective.
+ * Labels may have any length; only DistMapper() truncates them to MAXVERTNAME.
+ */
+template <class IT>
+class VertexDictionary
+{
+public:
+	VertexDictionary(std::shared_ptr<CommGrid> grid): commGrid(grid), nvert(0) {}
+
+	IT getnvert() const { return nvert; }
+	std::shared_ptr<CommGrid> getcommgrid() const { return commGrid; }
+
+	//! ids of the labels, unseen labels are added
+	std::vector<IT> Insert(const std::vector<std::string> & labels) { return Translate(labels, true); }
+
+	//! ids of the labels, -1 for unseen ones
+	std::vector<IT> Find(const std::vector<std::string> & labels) { return Translate(labels, false); }
+
+	//! labels of the ids, empty for ids out of range
+	std::vector<std::string> Labels(const std::vector<IT> & ids) const
+	{
+		int nprocs = commGrid->GetSize();
+		std::vector< std::vector<char> > sendbufs(nprocs);
+		for(IT id : ids)
+			if(id >= 0 && id < nvert)
+				PackRecord(sendbufs[id % nprocs], id, NULL, 0);
+		std::vector<int64_t> recvcnt;
+		std::vector<char> requests = Exchange(sendbufs, recvcnt);
+
+		std::vector< std::vector<char> > replies(nprocs);
+		const char * pos = requests.data();
+		for(int i=0; i<nprocs; ++i)
+		{
+			const char * end = pos + recvcnt[i];
+			while(pos < end)
+			{
+				IT id;
+				const char * label;
+				uint32_t len;
+				pos = UnpackRecord(pos, id, label, len);
+				size_t slot = id / nprocs;
+				PackRecord(replies[i], id, revarena.data() + revstart[slot], revlen[slot]);
+			}
+		}
+		std::vector<char> answers = Exchange(replies, recvcnt);
+
+		// answers come back grouped by home process, in request order
+		std::vector<const char *> next(nprocs);
+		pos = answers.data();
+		for(int i=0; i<nprocs; ++i)
+		{
+			next[i] = pos;
+			pos += recvcnt[i];
+		}
+		std::vector<std::string> labels(ids.size());
+		for(size_t k=0; k<ids.size(); ++k)
+		{
+			if(ids[k] < 0 || ids[k] >= nvert) continue;
+			IT id;
+			const char * label;
+			uint32_t len;
+			next[ids[k] % nprocs] = UnpackRecord(next[ids[k] % nprocs], id, label, len);
+			labels[k].assign(label, len);
+		}
+		return labels;
+	}
+
+	//! the legacy id -> label vector of ReadGeneralizedTuples, labels are truncated to MAXVERTNAME
+	FullyDistVec<IT, std::array<char, MAXVERTNAME>> DistMapper() const
+	{
+		typedef std::array<char, MAXVERTNAME> STRASARRAY;
+		int nprocs = commGrid->GetSize();
+		int myrank = commGrid->GetRank();
+		FullyDistVec<IT, STRASARRAY> mapper(commGrid, nvert, STRASARRAY{});
+		std::vector< std::vector<char> > sendbufs(nprocs);
+		for(size_t slot=0; slot<revlen.size(); ++slot)
+		{
+			IT locid;
+			int owner = mapper.Owner(static_cast<IT>(slot) * nprocs + myrank, locid);
+			PackRecord(sendbufs[owner], locid, revarena.data() + revstart[slot], std::min<uint32_t>(revlen[slot], MAXVERTNAME));
+		}
+		std::vector<int64_t> recvcnt;
+		std::vector<char> records = Exchange(sendbufs, recvcnt);
+		const char * pos = records.data();
+		while(pos < records.data() + records.size())
+		{
+			IT locid;
+			const char * label;
+			uint32_t len;
+			pos = UnpackRecord(pos, locid, label, len);
+			std::copy(label, label + len, mapper.arr[locid].begin());	// null terminated unless the label fills the array
+		}
+		return mapper;
+	}
+
+	/**
+	 * Writes the dictionary to a single file: a header (magic, number of vertices, number of
+	 * chunks and their offsets) followed by one chunk of (id, length, bytes) records per process
+	 */
+	void Save(const std::string & filename) const
+	{
+		int nprocs = commGrid->GetSize();
+		int myrank = commGrid->GetRank();
+		std::vector<char> chunk;
+		for(size_t slot=0; slot<revlen.size(); ++slot)
+			PackRecord(chunk, static_cast<IT>(slot) * nprocs + myrank, revarena.data() + revstart[slot], revlen[slot]);
+		std::vector<uint64_t> offsets(nprocs+1, 0);
+		uint64_t mybytes = chunk.size();
+		MPI_Allgather(&mybytes, 1, MPIType<uint64_t>(), offsets.data()+1, 1, MPIType<uint64_t>(), commGrid->GetWorld());
+		std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+		std::vector<uint64_t> header(3 + nprocs+1);
+		std::memcpy(header.data(), DICTMAGIC, 8);
+		header[1] = static_cast<uint64_t>(nvert);
+		header[2] = static_cast<uint64_t>(nprocs);
+		std::copy(offsets.begin(), offsets.end(), header.begin()+3);
+		MPI_Offset databegin = header.size() * sizeof(uint64_t);
+
+		MPI_File fh;
+		if(MPI_File_open(commGrid->GetWorld(), const_cast<char*>(filename.c_str()), MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &fh) != MPI_SUCCESS)
+		{
+			SpParHelper::Print("VertexDictionary::Save can not open " + filename + "\n");
+			MPI_Abort(MPI_COMM_WORLD, NOFILE);
+		}
+		MPI_File_set_size(fh, 0);
+		if(myrank == 0)
+			WriteBytes(fh, 0, reinterpret_cast<const char*>(header.data()), databegin);
+		WriteBytes(fh, databegin + offsets[myrank], chunk.data(), chunk.size());
+		MPI_File_close(&fh);
+	}
+
+	//! Replaces the contents with a dictionary written by Save, on any number of processes
+	void Load(const std::string & filename)
+	{
+		int nprocs = commGrid->GetSize();
+		int myrank = commGrid->GetRank();
+		MPI_File fh;
+		if(MPI_File_open(commGrid->GetWorld(), const_cast<char*>(filename.c_str()), MPI_MODE_RDONLY, MPI_INFO_NULL, &fh) != MPI_SUCCESS)
+		{
+			SpParHelper::Print("VertexDictionary::Load can not open " + filename + "\n");
+			MPI_Abort(MPI_COMM_WORLD, NOFILE);
+		}
+		uint64_t head[3] = {0, 0, 0};
+		if(myrank == 0)
+			MPI_File_read_at(fh, 0, head, 3, MPIType<uint64_t>(), MPI_STATUS_IGNORE);
+		MPI_Bcast(head, 3, MPIType<uint64_t>(), 0, commGrid->GetWorld());
+		if(std::memcmp(head, DICTMAGIC, 8) != 0)
+		{
+			SpParHelper::Print(filename + " is not a vertex dictionary\n");
+			MPI_Abort(MPI_COMM_WORLD, NOFILE);
+		}
+		uint64_t nchunks = head[2];
+		std::vector<uint64_t> offsets(nchunks+1);
+		if(myrank == 0)
+			MPI_File_read_at(fh, 3*sizeof(uint64_t), offsets.data(), static_cast<int>(nchunks+1), MPIType<uint64_t>(), MPI_STATUS_IGNORE);
+		MPI_Bcast(offsets.data(), static_cast<int>(nchunks+1), MPIType<uint64_t>(), 0, commGrid->GetWorld());
+		MPI_Offset databegin = (3 + nchunks+1) * sizeof(uint64_t);
+
+		// every record goes both to the owner of its label and to the home of its id
+		std::vector< std::vector<char> > toowners(nprocs), tohomes(nprocs);
+		for(uint64_t c = myrank; c < nchunks; c += nprocs)
+		{
+			std::vector<char> chunk(offsets[c+1] - offsets[c]);
+			ReadBytes(fh, databegin + offsets[c], chunk.data(), chunk.size());
+			const char * pos = chunk.data();
+			while(pos < chunk.data() + chunk.size())
+			{
+				IT id;
+				const char * label;
+				uint32_t len;
+				pos = UnpackRecord(pos, id, label, len);
+				PackRecord(toowners[LabelHash(label, len) % nprocs], id, label, len);
+				PackRecord(tohomes[id % nprocs], id, label, len);
+			}
+		}
+		MPI_File_close(&fh);
+
+		forward.Clear();
+		std::vector<char>().swap(revarena);
+		std::vector<uint64_t>().swap(revstart);
+		std::vector<uint32_t>().swap(revlen);
+		nvert = static_cast<IT>(head[1]);
+
+		std::vector<int64_t> recvcnt;
+		std::vector<char> owned = Exchange(toowners, recvcnt);
+		const char * pos = owned.data();
+		while(pos < owned.data() + owned.size())
+		{
+			IT id;
+			const char * label;
+			uint32_t len;
+			pos = UnpackRecord(pos, id, label, len);
+			forward.Insert(label, len, id);
+		}
+		std::vector<char> homed = Exchange(tohomes, recvcnt);
+		StoreLabels(homed);
+	}
+
+private:
+	static constexpr const char * DICTMAGIC = "CBVDICT1";
+
+	/**
+	 * Sends every label to its owner, which looks it up (or inserts it) in arrival order and
+	 * answers with the ids in the same order
+	 */
+	std::vector<IT> Translate(const std::vector<std::string> & labels, bool insert)
+	{
+		int nprocs = commGrid->GetSize();
+		std::vector<int> owner(labels.size());
+		std::vector< std::vector<char> > sendbufs(nprocs);
+		for(size_t k=0; k<labels.size(); ++k)
+		{
+			uint32_t len = static_cast<uint32_t>(labels[k].size());
+			owner[k] = static_cast<int>(LabelHash(labels[k].data(), len) % nprocs);
+			PackRecord(sendbufs[owner[k]], 0, labels[k].data(), len);
+		}
+		std::vector<int64_t> recvcnt;
+		std::vector<char> requests = Exchange(sendbufs, recvcnt);
+
+		std::vector<int64_t> entries;
+		std::vector<size_t> fresh;
+		std::vector<int64_t> perproc(nprocs, 0);
+		const char * pos = requests.data();
+		for(int i=0; i<nprocs; ++i)
+		{
+			const char * end = pos + recvcnt[i];
+			while(pos < end)
+			{
+				IT unused;
+				const char * label;
+				uint32_t len;
+				pos = UnpackRecord(pos, unused, label, len);
+				uint64_t hash = LabelHash(label, len);
+				if(insert)
+				{
+					std::pair<size_t,bool> ret = forward.Insert(label, len, hash, static_cast<IT>(-1));
+					if(ret.second) fresh.push_back(ret.first);
+					entries.push_back(static_cast<int64_t>(ret.first));
+				}
+				else
+					entries.push_back(forward.Find(label, len, hash));
+				++perproc[i];
+			}
+		}
+		if(insert)
+			NumberLabels(fresh);
+
+		std::vector< std::vector<IT> > replies(nprocs);
+		size_t e = 0;
+		for(int i=0; i<nprocs; ++i)
+			for(int64_t j=0; j<perproc[i]; ++j, ++e)
+				replies[i].push_back((entries[e] < 0) ? static_cast<IT>(-1) : forward.Value(entries[e]));
+		std::vector<IT> answers = Exchange(replies, recvcnt);
+
+		// answers come back grouped by owner, in request order
+		std::vector<int64_t> next(nprocs, 0);
+		std::partial_sum(recvcnt.begin(), recvcnt.end()-1, next.begin()+1);
+		std::vector<IT> ids(labels.size());
+		for(size_t k=0; k<labels.size(); ++k)
+			ids[k] = answers[next[owner[k]]++];
+		return ids;
+	}
+
+	/**
+	 * Gives consecutive ids after the existing ones to the labels inserted in this batch,
+	 * process by process in (hash, label) order, and ships them to the homes of their ids
+	 */
+	void NumberLabels(std::vector<size_t> & fresh)
+	{
+		int nprocs = commGrid->GetSize();
+		std::sort(fresh.begin(), fresh.end(), [this](size_t a, size_t b)
+		{
+			if(forward.Hash(a) != forward.Hash(b)) return forward.Hash(a) < forward.Hash(b);
+			return std::lexicographical_compare(forward.Data(a), forward.Data(a) + forward.Length(a), forward.Data(b), forward.Data(b) + forward.Length(b));
+		});
+		IT mynew = static_cast<IT>(fresh.size());
+		IT before = 0, allnew = 0;
+		MPI_Exscan(&mynew, &before, 1, MPIType<IT>(), MPI_SUM, commGrid->GetWorld());
+		MPI_Allreduce(&mynew, &allnew, 1, MPIType<IT>(), MPI_SUM, commGrid->GetWorld());
+		if(commGrid->GetRank() == 0) before = 0;	// MPI_Exscan leaves the recvbuf of process 0 undefined
+
+		std::vector< std::vector<char> > tohomes(nprocs);
+		for(size_t j=0; j<fresh.size(); ++j)
+		{
+			IT id = nvert + before + static_cast<IT>(j);
+			forward.Value(fresh[j]) = id;
+			PackRecord(tohomes[id % nprocs], id, forward.Data(fresh[j]), forward.Length(fresh[j]));
+		}
+		nvert += allnew;
+		std::vector<int64_t> recvcnt;
+		std::vector<char> homed = Exchange(tohomes, recvcnt);
+		StoreLabels(homed);
+	}
+
+	//! keeps the labels of ids homed here, in slot id / p
+	void StoreLabels(const std::vector<char> & records)
+	{
+		int nprocs = commGrid->GetSize();
+		size_t nslots = static_cast<size_t>((nvert + nprocs - 1 - commGrid->GetRank()) / nprocs);
+		revstart.resize(nslots, 0);
+		revlen.resize(nslots, 0);
+		const char * pos = records.data();
+		while(pos < records.data() + records.size())
+		{
+			IT id;
+			const char * label;
+			uint32_t len;
+			pos = UnpackRecord(pos, id, label, len);
+			size_t slot = id / nprocs;
+			revstart[slot] = revarena.size();
+			revlen[slot] = len;
+			revarena.insert(revarena.end(), label, label+len);
+		}
+	}
+
+	// a record is [id][length][bytes]
+	static void PackRecord(std::vector<char> & buf, IT id, const char * label, uint32_t len)
+	{
+		size_t pos = buf.size();
+		buf.resize(pos + sizeof(IT) + sizeof(uint32_t) + len);
+		std::memcpy(buf.data() + pos, &id, sizeof(IT));
+		std::memcpy(buf.data() + pos + sizeof(IT), &len, sizeof(uint32_t));
+		if(len > 0)
+			std::memcpy(buf.data() + pos + sizeof(IT) + sizeof(uint32_t), label, len);
+	}
+
+	static const char * UnpackRecord(const char * pos, IT & id, const char * & label, uint32_t & len)
+	{
+		std::memcpy(&id, pos, sizeof(IT));
+		std::memcpy(&len, pos + sizeof(IT), sizeof(uint32_t));
+		label = pos + sizeof(IT) + sizeof(uint32_t);
+		return label + len;
+	}
+
+	//! personalized all-to-all of per-process buffers, safe for counts beyond int
+	template <typename T>
+	std::vector<T> Exchange(const std::vector< std::vector<T> > & sendbufs, std::vector<int64_t> & recvcnt) const
+	{
+		int nprocs = commGrid->GetSize();
+		std::vector<int64_t> sendcnt(nprocs);
+		for(int i=0; i<nprocs; ++i)
+			sendcnt[i] = sendbufs[i].size();
+		recvcnt.resize(nprocs);
+		MPI_Alltoall(sendcnt.data(), 1, MPIType<int64_t>(), recvcnt.data(), 1, MPIType<int64_t>(), commGrid->GetWorld());
+		std::vector<T> sendbuf;
+		sendbuf.reserve(std::accumulate(sendcnt.begin(), sendcnt.end(), static_cast<int64_t>(0)));
+		for(int i=0; i<nprocs; ++i)
+			sendbuf.insert(sendbuf.end(), sendbufs[i].begin(), sendbufs[i].end());
+		std::vector<T> recvbuf(std::accumulate(recvcnt.begin(), recvcnt.end(), static_cast<int64_t>(0)));
+		SampleSortExchange(sendbuf.data(), sendcnt, recvbuf.data(), recvcnt, commGrid->GetWorld());
+		return recvbuf;
+	}
+
+	static void WriteBytes(MPI_File & fh, MPI_Offset offset, const char * data, uint64_t bytes)
+	{
+		for(uint64_t off = 0; off < bytes; off += SORTSEGMENT)
+		{
+			int len = static_cast<int>(std::min<uint64_t>(SORTSEGMENT, bytes - off));
+			MPI_File_write_at(fh, offset + off, const_cast<char*>(data) + off, len, MPI_CHAR, MPI_STATUS_IGNORE);
+		}
+	}
+
+	static void ReadBytes(MPI_File & fh, MPI_Offset offset, char * data, uint64_t bytes)
+	{
+		for(uint64_t off = 0; off < bytes; off += SORTSEGMENT)
+		{
+			int len = static_cast<int>(std::min<uint64_t>(SORTSEGMENT, bytes - off));
+			MPI_File_read_at(fh, offset + off, data + off, len, MPI_CHAR, MPI_STATUS_IGNORE);
+		}
+	}
+
+	std::shared_ptr<CommGrid> commGrid;
+	IT nvert;
+	LabelTable<IT> forward;			// labels owned here -> ids
+	std::vector<char> revarena;		// labels of the ids homed here
+	std::vector<uint64_t> revstart;
+	std::vector<uint32_t> revlen;
+};
+
+}
+
+#endif
@@ -1209,7 +1209,7 @@ void Dcsc<IT,NT>::ColConcatenate(std::vector< Dcsc<IT,NT>* > & parts, std::vecto
  **/
 template<class IT, class NT>
 template<class VT>	
-void Dcsc<IT,NT>::FillColInds(const VT * colnums, IT nind, std::vector< std::pair<IT,IT> > & colinds, IT * aux, IT csize) const
+void Dcsc<IT,NT>::FillColInds(const VT * colnums, IT nind, std::pair<IT,IT> * colinds, IT * aux, IT csize) const
 {
 	if ( aux == NULL || (nzc / nind) < THRESHOLD)   	// use scanning indexing
 	{
@@ -1275,6 +1275,7 @@ void Dcsc<IT,NT>::FillColInds(const VT * colnums, IT nind, std::vector< std::pai
 template <class IT, class NT>
 Dcsc<IT,NT>::~Dcsc()
 {
+	if(!memowned)	return;	// wraps arrays that belong to someone else
 	if(nz > 0)			// dcsc may be empty
 	{
 		delete[] numx;
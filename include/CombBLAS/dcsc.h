@@ -105,7 +105,10 @@ public:
 	void Resize(IT nzcnew, IT nznew);
 
 	template<class VT>	
-	void FillColInds(const VT * colnums, IT nind, std::vector< std::pair<IT,IT> > & colinds, IT * aux, IT csize) const;
+	void FillColInds(const VT * colnums, IT nind, std::vector< std::pair<IT,IT> > & colinds, IT * aux, IT csize) const
+	{ FillColInds(colnums, nind, colinds.data(), aux, csize); }
+	template<class VT>	
+	void FillColInds(const VT * colnums, IT nind, std::pair<IT,IT> * colinds, IT * aux, IT csize) const;	//!< colinds has space for nind pairs
 
 	Dcsc<IT,NT> & AddAndAssign (StackEntry<NT, std::pair<IT,IT> > * multstack, IT mdim, IT ndim, IT nnz);
 
@@ -69,6 +69,34 @@ T* prefixsum(T* in, int size, int nthreads)
     return out;
 }
 
+/*
+ Flop-balanced partitioning of the nonempty columns of B
+ Inputs:
+    flopptr: prefix sum of the flops of every nonempty column of C (size nzc+1)
+    nzc: number of nonempty columns
+    nchunks: number of chunks requested
+ 
+ Output:
+    splitters of size nchunks+1, chunk c owns the columns [splitters[c], splitters[c+1])
+    every chunk carries about flopptr[nzc]/nchunks flops, which a plain split over columns
+    does not guarantee when the column flops are skewed (e.g. power-law graphs)
+ */
+template <typename IT>
+std::vector<IT> FlopBalancedSplitters(const IT * flopptr, IT nzc, int nchunks)
+{
+    std::vector<IT> splitters(nchunks+1);
+    IT flop = flopptr[nzc];
+    splitters[0] = 0;
+    for(int c=1; c<nchunks; ++c)
+    {
+        IT target = static_cast<IT>((static_cast<double>(flop) * c) / nchunks);
+        splitters[c] = std::lower_bound(flopptr, flopptr+nzc+1, target) - flopptr;
+        splitters[c] = std::min(std::max(splitters[c], splitters[c-1]), nzc);
+    }
+    splitters[nchunks] = nzc;
+    return splitters;
+}
+
 
 // multithreaded HeapSpGEMM
 template <typename SR, typename NTO, typename IT, typename NT1, typename NT2>
@@ -106,84 +134,79 @@ SpTuples<IT, NTO> * LocalSpGEMM
     IT* colnnzC = estimateNNZ(A, B, aux,false);	// don't free aux	
     IT* colptrC = prefixsum<IT>(colnnzC, Bdcsc->nzc, numThreads);
     delete [] colnnzC;
+    IT* flopC = estimateFLOP(A, B, aux);
+    IT* flopptr = prefixsum<IT>(flopC, Bdcsc->nzc, numThreads);
+    delete [] flopC;
+    // oversplit so that dynamic scheduling can absorb the residual imbalance
+    int nchunks = (numThreads > 1) ? 4*numThreads : 1;
+    std::vector<IT> splitters = FlopBalancedSplitters<IT>(flopptr, Bdcsc->nzc, nchunks);
+    delete [] flopptr;
     IT nnzc = colptrC[Bdcsc->nzc];
     std::tuple<IT,IT,NTO> * tuplesC = static_cast<std::tuple<IT,IT,NTO> *> (::operator new (sizeof(std::tuple<IT,IT,NTO>[nnzc])));
 	
-    // thread private space for heap and colinds
-    std::vector<std::vector< std::pair<IT,IT>>> colindsVec(numThreads);
-    std::vector<std::vector<HeapEntry<IT,NT1>>> globalheapVec(numThreads);
-    
-    for(int i=0; i<numThreads; i++) //inital allocation per thread, may be an overestimate, but does not require more memoty than inputs
-    {
-        colindsVec[i].resize(nnzA/numThreads);
-        globalheapVec[i].resize(nnzA/numThreads);
-    }
-
-    size_t Bnzc = (size_t) Bdcsc->nzc;
 #ifdef THREADED
-#pragma omp parallel for
+#pragma omp parallel for schedule(dynamic)
 #endif
-    for(size_t i=0; i < Bnzc; ++i)
+    for(int c=0; c < nchunks; ++c)
     {
-        size_t nnzcolB = Bdcsc->cp[i+1] - Bdcsc->cp[i]; //nnz in the current column of B
-		int myThread = 0;
-	#ifdef THREADED
-        myThread = omp_get_thread_num();
-	#endif
-        if(colindsVec[myThread].size() < nnzcolB) //resize thread private vectors if needed
+        // thread private space for heap and colinds, drawn from the thread's arena and sized for the whole chunk
+        ArenaScope scratch;
+        size_t maxnnzB = 0;
+        for(IT i=splitters[c]; i < splitters[c+1]; ++i)
+            maxnnzB = std::max(maxnnzB, static_cast<size_t>(Bdcsc->cp[i+1] - Bdcsc->cp[i]));
+        std::pair<IT,IT> * colinds = scratch.get().allocate< std::pair<IT,IT> >(maxnnzB);
+        HeapEntry<IT,NT1> * wset = scratch.get().allocate< HeapEntry<IT,NT1> >(maxnnzB);
+
+        for(IT i=splitters[c]; i < splitters[c+1]; ++i)
         {
-            colindsVec[myThread].resize(nnzcolB);
-            globalheapVec[myThread].resize(nnzcolB);
-        }
-        
+            size_t nnzcolB = Bdcsc->cp[i+1] - Bdcsc->cp[i]; //nnz in the current column of B
         
-        // colinds.first vector keeps indices to A.cp, i.e. it dereferences "colnums" vector (above),
-        // colinds.second vector keeps the end indices (i.e. it gives the index to the last valid element of A.cpnack)
-        Adcsc->FillColInds(Bdcsc->ir + Bdcsc->cp[i], nnzcolB, colindsVec[myThread], aux, csize);
-        std::pair<IT,IT> * colinds = colindsVec[myThread].data();
-        HeapEntry<IT,NT1> * wset = globalheapVec[myThread].data();
-        IT hsize = 0;
+            // colinds.first vector keeps indices to A.cp, i.e. it dereferences "colnums" vector (above),
+            // colinds.second vector keeps the end indices (i.e. it gives the index to the last valid element of A.cpnack)
+            Adcsc->FillColInds(Bdcsc->ir + Bdcsc->cp[i], nnzcolB, colinds, aux, csize);
+            IT hsize = 0;
         
         
-        for(size_t j = 0; j < nnzcolB; ++j)		// create the initial heap
-        {
-            if(colinds[j].first != colinds[j].second)	// current != end
+            for(size_t j = 0; j < nnzcolB; ++j)		// create the initial heap
             {
-                wset[hsize++] = HeapEntry< IT,NT1 > (Adcsc->ir[colinds[j].first], j, Adcsc->numx[colinds[j].first]);
+                if(colinds[j].first != colinds[j].second)	// current != end
+                {
+                    wset[hsize++] = HeapEntry< IT,NT1 > (Adcsc->ir[colinds[j].first], j, Adcsc->numx[colinds[j].first]);
+                }
             }
-        }
-        std::make_heap(wset, wset+hsize);
+            std::make_heap(wset, wset+hsize);
         
-        IT curptr = colptrC[i];
-        while(hsize > 0)
-        {
-            std::pop_heap(wset, wset + hsize);         // result is stored in wset[hsize-1]
-            IT locb = wset[hsize-1].runr;	// relative location of the nonzero in B's current column
-            
-            NTO mrhs = SR::multiply(wset[hsize-1].num, Bdcsc->numx[Bdcsc->cp[i]+locb]);
-            if (!SR::returnedSAID())
+            IT curptr = colptrC[i];
+            while(hsize > 0)
             {
-                if( (curptr > colptrC[i]) && std::get<0>(tuplesC[curptr-1]) == wset[hsize-1].key)
+                std::pop_heap(wset, wset + hsize);         // result is stored in wset[hsize-1]
+                IT locb = wset[hsize-1].runr;	// relative location of the nonzero in B's current column
+            
+                NTO mrhs = SR::multiply(wset[hsize-1].num, Bdcsc->numx[Bdcsc->cp[i]+locb]);
+                if (!SR::returnedSAID())
+                {
+                    if( (curptr > colptrC[i]) && std::get<0>(tuplesC[curptr-1]) == wset[hsize-1].key)
+                    {
+                        std::get<2>(tuplesC[curptr-1]) = SR::add(std::get<2>(tuplesC[curptr-1]), mrhs);
+                    }
+                    else
+                    {
+                        tuplesC[curptr++]= std::make_tuple(wset[hsize-1].key, Bdcsc->jc[i], mrhs) ;
+                    }
+                
+                }
+            
+                if( (++(colinds[locb].first)) != colinds[locb].second)	// current != end
                 {
-                    std::get<2>(tuplesC[curptr-1]) = SR::add(std::get<2>(tuplesC[curptr-1]), mrhs);
+                    // runr stays the same !
+                    wset[hsize-1].key = Adcsc->ir[colinds[locb].first];
+                    wset[hsize-1].num = Adcsc->numx[colinds[locb].first];
+                    std::push_heap(wset, wset+hsize);
                 }
                 else
                 {
-                    tuplesC[curptr++]= std::make_tuple(wset[hsize-1].key, Bdcsc->jc[i], mrhs) ;
+                    --hsize;
                 }
-                
-            }
-            
-            if( (++(colinds[locb].first)) != colinds[locb].second)	// current != end
-            {
-                // runr stays the same !
-                wset[hsize-1].key = Adcsc->ir[colinds[locb].first];
-                wset[hsize-1].num = Adcsc->numx[colinds[locb].first];
-                std::push_heap(wset, wset+hsize);
-            }
-            else
-            {
-                --hsize;
             }
         }
     }
@@ -203,18 +226,186 @@ SpTuples<IT, NTO> * LocalSpGEMM
 
 
 
+/**
+ * Upper triangle of the local product, only C(i,j) with i <= j, for the diagonal blocks of a symmetric product
+ * The heap hands out the rows of a column of C in increasing order, so the column is done as soon as the
+ * smallest row left passes the diagonal and the multiplications below the diagonal are never made
+ */
+template <typename SR, typename NTO, typename IT, typename NT1, typename NT2>
+SpTuples<IT, NTO> * LocalSpGEMMUpper
+(const SpDCCols<IT, NT1> & A,
+ const SpDCCols<IT, NT2> & B)
+{
+    IT mdim = A.getnrow();
+    IT ndim = B.getncol();
+    if(A.isZero() || B.isZero())
+    {
+        return new SpTuples<IT, NTO>(0, mdim, ndim);
+    }
+    Dcsc<IT,NT1>* Adcsc = A.GetDCSC();
+    Dcsc<IT,NT2>* Bdcsc = B.GetDCSC();
+    IT nA = A.getncol();
+    float cf  = static_cast<float>(nA+1) / static_cast<float>(Adcsc->nzc);
+    IT csize = static_cast<IT>(ceil(cf));   // chunk size
+    IT * aux;
+    Adcsc->ConstructAux(nA, aux);
+
+    int numThreads = 1;
+#ifdef THREADED
+#pragma omp parallel
+    {
+        numThreads = omp_get_num_threads();
+    }
+#endif
+    IT* flopC = estimateFLOP(A, B, aux);
+    IT* flopptr = prefixsum<IT>(flopC, Bdcsc->nzc, numThreads);
+    delete [] flopC;
+    int nchunks = (numThreads > 1) ? 4*numThreads : 1;
+    std::vector<IT> splitters = FlopBalancedSplitters<IT>(flopptr, Bdcsc->nzc, nchunks);
+    delete [] flopptr;
+    std::vector< std::vector< std::tuple<IT,IT,NTO> > > chunkC(nchunks);	// chunks are column ranges, concatenating them keeps C sorted
+
+#ifdef THREADED
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for(int c=0; c < nchunks; ++c)
+    {
+        ArenaScope scratch;
+        size_t maxnnzB = 0;
+        for(IT i=splitters[c]; i < splitters[c+1]; ++i)
+            maxnnzB = std::max(maxnnzB, static_cast<size_t>(Bdcsc->cp[i+1] - Bdcsc->cp[i]));
+        std::pair<IT,IT> * colinds = scratch.get().allocate< std::pair<IT,IT> >(maxnnzB);
+        HeapEntry<IT,NT1> * wset = scratch.get().allocate< HeapEntry<IT,NT1> >(maxnnzB);
+        std::vector< std::tuple<IT,IT,NTO> > & tuplesC = chunkC[c];
+
+        for(IT i=splitters[c]; i < splitters[c+1]; ++i)
+        {
+            size_t nnzcolB = Bdcsc->cp[i+1] - Bdcsc->cp[i];
+            Adcsc->FillColInds(Bdcsc->ir + Bdcsc->cp[i], nnzcolB, colinds, aux, csize);
+            IT hsize = 0;
+            for(size_t j = 0; j < nnzcolB; ++j)
+            {
+                if(colinds[j].first != colinds[j].second)
+                {
+                    wset[hsize++] = HeapEntry< IT,NT1 > (Adcsc->ir[colinds[j].first], j, Adcsc->numx[colinds[j].first]);
+                }
+            }
+            std::make_heap(wset, wset+hsize);
+
+            size_t colstart = tuplesC.size();
+            while(hsize > 0 && wset[0].key <= Bdcsc->jc[i])	// wset[0] holds the smallest row left
+            {
+                std::pop_heap(wset, wset + hsize);
+                IT locb = wset[hsize-1].runr;
+                NTO mrhs = SR::multiply(wset[hsize-1].num, Bdcsc->numx[Bdcsc->cp[i]+locb]);
+                if (!SR::returnedSAID())
+                {
+                    if( (tuplesC.size() > colstart) && std::get<0>(tuplesC.back()) == wset[hsize-1].key)
+                    {
+                        std::get<2>(tuplesC.back()) = SR::add(std::get<2>(tuplesC.back()), mrhs);
+                    }
+                    else
+                    {
+                        tuplesC.push_back(std::make_tuple(wset[hsize-1].key, Bdcsc->jc[i], mrhs));
+                    }
+                }
+                if( (++(colinds[locb].first)) != colinds[locb].second)
+                {
+                    wset[hsize-1].key = Adcsc->ir[colinds[locb].first];
+                    wset[hsize-1].num = Adcsc->numx[colinds[locb].first];
+                    std::push_heap(wset, wset+hsize);
+                }
+                else
+                {
+                    --hsize;
+                }
+            }
+        }
+    }
+    delete [] aux;
+
+    int64_t nnzc = 0;
+    for(int c=0; c < nchunks; ++c)
+        nnzc += chunkC[c].size();
+    std::tuple<IT,IT,NTO> * tuplesC = new std::tuple<IT,IT,NTO>[nnzc];
+    int64_t curptr = 0;
+    for(int c=0; c < nchunks; ++c)
+    {
+        std::copy(chunkC[c].begin(), chunkC[c].end(), tuplesC + curptr);
+        curptr += chunkC[c].size();
+        std::vector< std::tuple<IT,IT,NTO> >().swap(chunkC[c]);
+    }
+    return new SpTuples<IT, NTO> (nnzc, mdim, ndim, tuplesC, true);
+}
+
+
 template <typename IT, typename NT>
 bool sort_less(const std::pair<IT, NT> &left, const std::pair<IT, NT> &right)
 {
     return left.first < right.first;
 }
 
+/**
+ * The symbolic phase of LocalHybridSpGEMM, kept for later products of operands with the same sparsity patterns:
+ * the flop and output nonzero prefix sums over the nonzero columns of B.
+ * A checksum of both patterns, one pass over the indices, tells whether the plan still applies;
+ * when it does not, the symbolic phase is recomputed and the plan replaced
+ **/
+template <typename IT>
+class LocalSpGEMMPlan
+{
+public:
+	LocalSpGEMMPlan(): fingerprint(0), built(false), reuses(0) {}
+
+	template <typename NT1, typename NT2>
+	static uint64_t Fingerprint(const SpDCCols<IT,NT1> & A, const SpDCCols<IT,NT2> & B)
+	{
+		uint64_t h = 14695981039346656037ULL;	// FNV-1a over the dimensions and the index arrays
+		auto mix = [&h](uint64_t x) { h = (h ^ x) * 1099511628211ULL; };
+		auto pattern = [&mix](const auto * dcsc)
+		{
+			if(dcsc == NULL) { mix(0); return; }
+			mix(dcsc->nzc);
+			for(IT i = 0; i < dcsc->nzc; ++i)	{ mix(dcsc->jc[i]); mix(dcsc->cp[i+1]); }
+			for(IT i = 0; i < dcsc->nz; ++i)	mix(dcsc->ir[i]);
+		};
+		mix(A.getnrow()); mix(A.getncol()); mix(B.getncol());
+		pattern(A.GetDCSC());
+		pattern(B.GetDCSC());
+		return h;
+	}
+
+	bool Matches(uint64_t print) const { return built && fingerprint == print; }
+
+	void Record(uint64_t print, const IT * flopptr, const IT * colptrC, IT nzc)
+	{
+		fingerprint = print;
+		flops.assign(flopptr, flopptr + nzc + 1);
+		colptr.assign(colptrC, colptrC + nzc + 1);
+		built = true;
+	}
+
+	void Clear()
+	{
+		std::vector<IT>().swap(flops);
+		std::vector<IT>().swap(colptr);
+		built = false;
+	}
+
+	uint64_t fingerprint;
+	bool built;
+	int64_t reuses;			// number of products that skipped the symbolic phase
+	std::vector<IT> flops;		// prefix sum of flops, nzc(B)+1 entries
+	std::vector<IT> colptr;		// column pointers of the output, nzc(B)+1 entries
+};
+
 // Hybrid approach of multithreaded HeapSpGEMM and HashSpGEMM
+// With a plan, the symbolic phase (estimateFLOP and estimateNNZ_Hash) is skipped when the patterns of A and B match it
 template <typename SR, typename NTO, typename IT, typename NT1, typename NT2>
 SpTuples<IT, NTO> * LocalHybridSpGEMM
 (const SpDCCols<IT, NT1> & A,
  const SpDCCols<IT, NT2> & B,
- bool clearA, bool clearB, IT * aux = nullptr)
+ bool clearA, bool clearB, IT * aux = nullptr, LocalSpGEMMPlan<IT> * plan = nullptr)
 {
 
 
@@ -223,6 +414,10 @@ SpTuples<IT, NTO> * LocalHybridSpGEMM
     IT nnzA = A.getnnz();
     if(A.isZero() || B.isZero())
     {
+        if(clearA)
+            delete const_cast<SpDCCols<IT, NT1> *>(&A);
+        if(clearB)
+            delete const_cast<SpDCCols<IT, NT2> *>(&B);
         return new SpTuples<IT, NTO>(0, mdim, ndim);
     }
 	
@@ -250,18 +445,30 @@ SpTuples<IT, NTO> * LocalHybridSpGEMM
    
     // std::cout << "numThreads: " << numThreads << std::endl;
 
-    IT* flopC =  estimateFLOP(A, B, aux);
-    //IT* flopptr = prefixsum<IT>(flopC, Bdcsc->nzc, numThreads);
-    //IT flop = flopptr[Bdcsc->nzc];
-    // std::cout << "FLOP of A * B is " << flop << std::endl;
-
+    IT* flopptr;
+    IT* colptrC;
+    uint64_t print = (plan != nullptr) ? LocalSpGEMMPlan<IT>::Fingerprint(A, B) : 0;
+    bool planned = (plan != nullptr) && plan->Matches(print);
+    if(planned)
+    {
+        flopptr = plan->flops.data();
+        colptrC = plan->colptr.data();
+        ++(plan->reuses);
+    }
+    else
+    {
+        IT* flopC =  estimateFLOP(A, B, aux);
+        // std::cout << "FLOP of A * B is " << flop << std::endl;
 
-    IT* colnnzC = estimateNNZ_Hash(A, B, flopC, aux);
-    IT* flopptr = prefixsum<IT>(flopC, Bdcsc->nzc, numThreads);
+        IT* colnnzC = estimateNNZ_Hash(A, B, flopC, aux);
+        flopptr = prefixsum<IT>(flopC, Bdcsc->nzc, numThreads);
+        colptrC = prefixsum<IT>(colnnzC, Bdcsc->nzc, numThreads);
+        delete [] colnnzC;
+        delete [] flopC;
+        if(plan != nullptr)
+            plan->Record(print, flopptr, colptrC, Bdcsc->nzc);
+    }
     IT flop = flopptr[Bdcsc->nzc];
-    IT* colptrC = prefixsum<IT>(colnnzC, Bdcsc->nzc, numThreads);
-    delete [] colnnzC;
-    delete [] flopC;
     IT nnzc = colptrC[Bdcsc->nzc];
     //double compression_ratio = (double)flop / nnzc;
 
@@ -272,156 +479,238 @@ SpTuples<IT, NTO> * LocalHybridSpGEMM
     std::tuple<IT,IT,NTO> * tuplesC = static_cast<std::tuple<IT,IT,NTO> *> (::operator new (sizeof(std::tuple<IT,IT,NTO>[nnzc])));
    //std::tuple<IT,IT,NTO> * tuplesC = new std::tuple<IT,IT,NTO>[nnzc];
        
-    // thread private space for heap and colinds
-    std::vector<std::vector< std::pair<IT,IT>>> colindsVec(numThreads);
-   
-     std::vector<std::vector< std::pair<IT,NTO>>> globalHashVecAll(numThreads); 
-     std::vector<std::vector< HeapEntry<IT,NT1>>> globalHeapVecAll(numThreads);
-    /*
-    for(int i=0; i<numThreads; i++) //inital allocation per thread, may be an overestimate, but does not require more memoty than inputs
-    {
-        colindsVec[i].resize(nnzA/numThreads);
-    }*/
-
     // IT hashSelected = 0;
 
-
-#ifdef THREADED
-#pragma omp parallel for
-#endif
-    for(size_t i=0; i < Bdcsc->nzc; ++i)
+    const IT minHashTableSize = 16;
+    const IT hashScale = 107;
+
+    // Columns are processed in flop-balanced chunks rather than one column per iteration,
+    // otherwise a few heavy columns of a power-law matrix end up on the same thread.
+    // A single column with more than half of a thread's share of flops can not be balanced that way;
+    // such "hub" columns are skipped here and later multiplied by all threads together
+    int nchunks = (numThreads > 1) ? 4*numThreads : 1;
+    std::vector<IT> splitters = FlopBalancedSplitters<IT>(flopptr, Bdcsc->nzc, nchunks);
+    IT hubflop = (numThreads > 1) ? std::max(flop / (2*numThreads), static_cast<IT>(HUBCOLUMN_MINFLOP)) : flop;
+    std::vector<IT> hubcols;
+    for(IT i=0; i < Bdcsc->nzc; ++i)
     {
-        size_t nnzcolB = Bdcsc->cp[i+1] - Bdcsc->cp[i]; //nnz in the current column of B
-        int myThread = 0;
+        if(flopptr[i+1] - flopptr[i] > hubflop)
+            hubcols.push_back(i);
+    }
 
 #ifdef THREADED
-        myThread = omp_get_thread_num();
+#pragma omp parallel for schedule(dynamic)
 #endif
-        if(colindsVec[myThread].size() < nnzcolB) //resize thread private vectors if needed
+    for(int c=0; c < nchunks; ++c)
+    {
+        // thread private space for heap, hash table and colinds, drawn from the thread's arena and sized for the whole chunk
+        ArenaScope scratch;
+        size_t maxnnzB = 0;
+        size_t maxnnzC = 0;
+        for(IT i=splitters[c]; i < splitters[c+1]; ++i)
         {
-            colindsVec[myThread].resize(nnzcolB);
+            maxnnzB = std::max(maxnnzB, static_cast<size_t>(Bdcsc->cp[i+1] - Bdcsc->cp[i]));
+            maxnnzC = std::max(maxnnzC, static_cast<size_t>(colptrC[i+1] - colptrC[i]));
         }
-        
-        // colinds.first vector keeps indices to A.cp, i.e. it dereferences "colnums" vector (above),
-        // colinds.second vector keeps the end indices (i.e. it gives the index to the last valid element of A.cpnack)
-        Adcsc->FillColInds(Bdcsc->ir + Bdcsc->cp[i], nnzcolB, colindsVec[myThread], aux, csize);
-        std::pair<IT,IT> * colinds = colindsVec[myThread].data();
+        size_t maxht = minHashTableSize;
+        while(maxht < maxnnzC)
+        {
+            maxht <<= 1;
+        }
+        std::pair<IT,IT> * colinds = scratch.get().allocate< std::pair<IT,IT> >(maxnnzB);
+        HeapEntry<IT, NT1> * wset = scratch.get().allocate< HeapEntry<IT,NT1> >(maxnnzB);
+        std::pair<IT,NTO> * globalHashVec = scratch.get().allocate< std::pair<IT,NTO> >(maxht);
 
-        double cr = static_cast<double>(flopptr[i+1] - flopptr[i]) / (colptrC[i+1] - colptrC[i]);
-        if (cr < 2.0) // Heap Algorithm
+        for(IT i=splitters[c]; i < splitters[c+1]; ++i)
         {
-	    if(globalHeapVecAll[myThread].size() < nnzcolB)
-	    	globalHeapVecAll[myThread].resize(nnzcolB);	    
-            //std::vector<HeapEntry<IT,NT1>> globalheapVec(nnzcolB);
-            //HeapEntry<IT, NT1> * wset = globalheapVec.data();
-            HeapEntry<IT, NT1> * wset = globalHeapVecAll[myThread].data();
+            if(flopptr[i+1] - flopptr[i] > hubflop)
+                continue;   // hub column, multiplied below
 
-            IT hsize = 0;
+            size_t nnzcolB = Bdcsc->cp[i+1] - Bdcsc->cp[i]; //nnz in the current column of B
         
-            for(size_t j = 0; j < nnzcolB; ++j)		// create the initial heap
+            // colinds.first vector keeps indices to A.cp, i.e. it dereferences "colnums" vector (above),
+            // colinds.second vector keeps the end indices (i.e. it gives the index to the last valid element of A.cpnack)
+            Adcsc->FillColInds(Bdcsc->ir + Bdcsc->cp[i], nnzcolB, colinds, aux, csize);
+
+            double cr = static_cast<double>(flopptr[i+1] - flopptr[i]) / (colptrC[i+1] - colptrC[i]);
+            if (cr < 2.0) // Heap Algorithm
             {
-                if(colinds[j].first != colinds[j].second)	// current != end
+                IT hsize = 0;
+        
+                for(size_t j = 0; j < nnzcolB; ++j)		// create the initial heap
                 {
-                    wset[hsize++] = HeapEntry< IT,NT1 > (Adcsc->ir[colinds[j].first], j, Adcsc->numx[colinds[j].first]);
+                    if(colinds[j].first != colinds[j].second)	// current != end
+                    {
+                        wset[hsize++] = HeapEntry< IT,NT1 > (Adcsc->ir[colinds[j].first], j, Adcsc->numx[colinds[j].first]);
+                    }
                 }
-            }
-            std::make_heap(wset, wset+hsize);
+                std::make_heap(wset, wset+hsize);
         
-            IT curptr = colptrC[i];
-            while(hsize > 0)
-            {
-                std::pop_heap(wset, wset + hsize);         // result is stored in wset[hsize-1]
-                IT locb = wset[hsize-1].runr;	// relative location of the nonzero in B's current column
-            
-                NTO mrhs = SR::multiply(wset[hsize-1].num, Bdcsc->numx[Bdcsc->cp[i]+locb]);
-                if (!SR::returnedSAID())
+                IT curptr = colptrC[i];
+                while(hsize > 0)
                 {
-                    if( (curptr > colptrC[i]) && std::get<0>(tuplesC[curptr-1]) == wset[hsize-1].key)
+                    std::pop_heap(wset, wset + hsize);         // result is stored in wset[hsize-1]
+                    IT locb = wset[hsize-1].runr;	// relative location of the nonzero in B's current column
+            
+                    NTO mrhs = SR::multiply(wset[hsize-1].num, Bdcsc->numx[Bdcsc->cp[i]+locb]);
+                    if (!SR::returnedSAID())
                     {
-                        std::get<2>(tuplesC[curptr-1]) = SR::add(std::get<2>(tuplesC[curptr-1]), mrhs);
+                        if( (curptr > colptrC[i]) && std::get<0>(tuplesC[curptr-1]) == wset[hsize-1].key)
+                        {
+                            std::get<2>(tuplesC[curptr-1]) = SR::add(std::get<2>(tuplesC[curptr-1]), mrhs);
+                        }
+                        else
+                        {
+                            tuplesC[curptr++]= std::make_tuple(wset[hsize-1].key, Bdcsc->jc[i], mrhs) ;
+                        }
+                    }
+                    if( (++(colinds[locb].first)) != colinds[locb].second)	// current != end
+                    {
+                        // runr stays the same !
+                        wset[hsize-1].key = Adcsc->ir[colinds[locb].first];
+                        wset[hsize-1].num = Adcsc->numx[colinds[locb].first];
+                        std::push_heap(wset, wset+hsize);
                     }
                     else
                     {
-                        tuplesC[curptr++]= std::make_tuple(wset[hsize-1].key, Bdcsc->jc[i], mrhs) ;
+                        --hsize;
                     }
                 }
-                if( (++(colinds[locb].first)) != colinds[locb].second)	// current != end
+            } // Finish Heap
+        
+            else // Hash Algorithm
+            {
+                size_t nnzcolC = colptrC[i+1] - colptrC[i]; //nnz in the current column of C (=Output)
+
+                size_t ht_size = minHashTableSize;
+                while(ht_size < nnzcolC) //ht_size is set as 2^n
                 {
-                    // runr stays the same !
-                    wset[hsize-1].key = Adcsc->ir[colinds[locb].first];
-                    wset[hsize-1].num = Adcsc->numx[colinds[locb].first];
-                    std::push_heap(wset, wset+hsize);
+                    ht_size <<= 1;
                 }
-                else
+            
+                // Initialize hash tables
+                for(size_t j=0; j < ht_size; ++j)
                 {
-                    --hsize;
+                    globalHashVec[j].first = -1;
+                }
+            
+                // Multiply and add on Hash table
+                for (size_t j=0; j < nnzcolB; ++j)
+                {
+                    NT2 t_bval = Bdcsc->numx[Bdcsc->cp[i] + j];
+                    for (IT k = colinds[j].first; k < colinds[j].second; ++k)
+                    {
+                        NTO mrhs = SR::multiply(Adcsc->numx[k], t_bval);
+                        IT key = Adcsc->ir[k];
+                        IT hash = (key*hashScale) & (ht_size-1);
+                        while (1) //hash probing
+                        {
+                            if (globalHashVec[hash].first == key) //key is found in hash table
+                            {
+                                globalHashVec[hash].second = SR::add(mrhs, globalHashVec[hash].second);
+                                break;
+                            }
+                            else if (globalHashVec[hash].first == -1) //key is not registered yet
+                            {
+                                globalHashVec[hash].first = key;
+                                globalHashVec[hash].second = mrhs;
+                                break;
+                            }
+                            else //key is not found
+                            {
+                                hash = (hash+1) & (ht_size-1);
+                            }
+                        }
+                    }
+                }
+                // gather non-zero elements from hash table, and then sort them by row indices
+                size_t index = 0;
+                for (size_t j=0; j < ht_size; ++j)
+                {
+                    if (globalHashVec[j].first != -1)
+                    {
+                        globalHashVec[index++] = globalHashVec[j];
+                    }
+                }
+                std::sort(globalHashVec, globalHashVec + index, sort_less<IT, NTO>);
+                IT curptr = colptrC[i];
+                for (size_t j=0; j < index; ++j)
+                {
+                    tuplesC[curptr++]= std::make_tuple(globalHashVec[j].first, Bdcsc->jc[i], globalHashVec[j].second);
                 }
             }
-        } // Finish Heap
-        
-        else // Hash Algorithm
+        }
+    }
+
+    // Hub columns: every thread hashes the contributions that fall into its own range of output rows.
+    // Row indices within a column of A are sorted, so each thread finds its slice of every column of A by binary search.
+    // The row ranges are disjoint, hence the sorted partial results are written back to back without a merge
+    for(size_t h=0; h < hubcols.size(); ++h)
+    {
+        IT i = hubcols[h];
+        size_t nnzcolB = Bdcsc->cp[i+1] - Bdcsc->cp[i];
+        ArenaScope shared;     // the master thread's arena, read by all threads below
+        std::pair<IT,IT> * colinds = shared.get().allocate< std::pair<IT,IT> >(nnzcolB);
+        Adcsc->FillColInds(Bdcsc->ir + Bdcsc->cp[i], nnzcolB, colinds, aux, csize);
+        size_t nnzcolC = colptrC[i+1] - colptrC[i];
+        std::vector<IT> partcnt(numThreads+1, 0);
+
+#ifdef THREADED
+#pragma omp parallel
+#endif
         {
-	// #pragma omp atomic
-	// 	hashSelected++;
-            const IT minHashTableSize = 16;
-            const IT hashScale = 107;
-            size_t nnzcolC = colptrC[i+1] - colptrC[i]; //nnz in the current column of C (=Output)
+            int myThread = 0;
+            int nparts = 1;
+#ifdef THREADED
+            myThread = omp_get_thread_num();
+            nparts = omp_get_num_threads();
+#endif
+            IT rowbeg = static_cast<IT>((static_cast<double>(mdim) * myThread) / nparts);
+            IT rowend = static_cast<IT>((static_cast<double>(mdim) * (myThread+1)) / nparts);
+            if(myThread == nparts-1) rowend = mdim;
 
             size_t ht_size = minHashTableSize;
-            while(ht_size < nnzcolC) //ht_size is set as 2^n
+            while(ht_size < std::min(nnzcolC, static_cast<size_t>(rowend-rowbeg)))
             {
                 ht_size <<= 1;
             }
-            
-	    
-	    if(globalHashVecAll[myThread].size() < ht_size)
-                globalHashVecAll[myThread].resize(ht_size);
-            //std::vector<HeapEntry<IT,NT1>> globalheapVec(nnzcolB);
-            //HeapEntry<IT, NT1> * wset = globalheapVec.data();
-            //HeapEntry<IT, NT1> * wset = globalheapVecAll[myThread].data();
-
-	    //std::vector< std::pair<IT,NTO>> globalHashVec(ht_size);
-	    std::pair<IT,NTO>* globalHashVec =  globalHashVecAll[myThread].data();
-            // colinds.first vector keeps indices to A.cp, i.e. it dereferences "colnums" vector (above),
-            // colinds.second vector keeps the end indices (i.e. it gives the index to the last valid element of A.cpnack)
-            
-            // Initialize hash tables
+            ArenaScope scratch;
+            std::pair<IT,NTO>* globalHashVec = scratch.get().allocate< std::pair<IT,NTO> >(ht_size);
             for(size_t j=0; j < ht_size; ++j)
             {
                 globalHashVec[j].first = -1;
             }
-            
-            // Multiply and add on Hash table
+
             for (size_t j=0; j < nnzcolB; ++j)
             {
-                IT t_bcol = Bdcsc->ir[Bdcsc->cp[i] + j];
                 NT2 t_bval = Bdcsc->numx[Bdcsc->cp[i] + j];
-                for (IT k = colinds[j].first; k < colinds[j].second; ++k)
+                IT kbeg = std::lower_bound(Adcsc->ir + colinds[j].first, Adcsc->ir + colinds[j].second, rowbeg) - Adcsc->ir;
+                IT kend = std::lower_bound(Adcsc->ir + kbeg, Adcsc->ir + colinds[j].second, rowend) - Adcsc->ir;
+                for (IT k = kbeg; k < kend; ++k)
                 {
                     NTO mrhs = SR::multiply(Adcsc->numx[k], t_bval);
                     IT key = Adcsc->ir[k];
                     IT hash = (key*hashScale) & (ht_size-1);
                     while (1) //hash probing
                     {
-                        if (globalHashVec[hash].first == key) //key is found in hash table
+                        if (globalHashVec[hash].first == key)
                         {
                             globalHashVec[hash].second = SR::add(mrhs, globalHashVec[hash].second);
                             break;
                         }
-                        else if (globalHashVec[hash].first == -1) //key is not registered yet
+                        else if (globalHashVec[hash].first == -1)
                         {
                             globalHashVec[hash].first = key;
                             globalHashVec[hash].second = mrhs;
                             break;
                         }
-                        else //key is not found
+                        else
                         {
                             hash = (hash+1) & (ht_size-1);
                         }
                     }
                 }
             }
-            // gather non-zero elements from hash table, and then sort them by row indices
             size_t index = 0;
             for (size_t j=0; j < ht_size; ++j)
             {
@@ -430,9 +719,14 @@ SpTuples<IT, NTO> * LocalHybridSpGEMM
                     globalHashVec[index++] = globalHashVec[j];
                 }
             }
-            //std::sort(globalHashVec.begin(), globalHashVec.begin() + index, sort_less<IT, NTO>);
-	    std::sort(globalHashVecAll[myThread].begin(), globalHashVecAll[myThread].begin() + index, sort_less<IT, NTO>);
+            std::sort(globalHashVec, globalHashVec + index, sort_less<IT, NTO>);
+            partcnt[myThread+1] = index;
+#ifdef THREADED
+#pragma omp barrier
+#endif
             IT curptr = colptrC[i];
+            for(int t=0; t <= myThread; ++t)
+                curptr += partcnt[t];
             for (size_t j=0; j < index; ++j)
             {
                 tuplesC[curptr++]= std::make_tuple(globalHashVec[j].first, Bdcsc->jc[i], globalHashVec[j].second);
@@ -445,8 +739,11 @@ SpTuples<IT, NTO> * LocalHybridSpGEMM
     if(clearB)
         delete const_cast<SpDCCols<IT, NT2> *>(&B);
     
-    delete [] colptrC;
-    delete [] flopptr;
+    if(!planned)
+    {
+        delete [] colptrC;
+        delete [] flopptr;
+    }
     if(deleteAux)
     	delete [] aux;
     
@@ -515,14 +812,6 @@ SpTuples<IT, NTO> * LocalHybridSpGEMM
         // std::tuple<IT,IT,NTO> * tuplesC = static_cast<std::tuple<IT,IT,NTO> *> (::operator new (sizeof(std::tuple<IT,IT,NTO>[nnzc])));
         std::tuple<IT,IT,NTO> * tuplesC = new std::tuple<IT,IT,NTO>[nnzc];
 
-        // thread private space for heap and colinds
-        std::vector<std::vector< std::pair<IT,IT>>> colindsVec(numThreads);
-
-        for(int i=0; i<numThreads; i++) //inital allocation per thread, may be an overestimate, but does not require more memoty than inputs
-        {
-            colindsVec[i].resize(nnzA/numThreads);
-        }
-
         // IT hashSelected = 0;
 
 #ifdef THREADED
@@ -531,20 +820,12 @@ SpTuples<IT, NTO> * LocalHybridSpGEMM
         for(size_t i=0; i < Bdcsc->nzc; ++i)
         {
             size_t nnzcolB = Bdcsc->cp[i+1] - Bdcsc->cp[i]; //nnz in the current column of B
-            int myThread = 0;
-
-#ifdef THREADED
-            myThread = omp_get_thread_num();
-#endif
-            if(colindsVec[myThread].size() < nnzcolB) //resize thread private vectors if needed
-            {
-                colindsVec[myThread].resize(nnzcolB);
-            }
+            ArenaScope scratch;     // thread private space for colinds and the hash table
 
             // colinds.first vector keeps indices to A.cp, i.e. it dereferences "colnums" vector (above),
             // colinds.second vector keeps the end indices (i.e. it gives the index to the last valid element of A.cpnack)
-            Adcsc->FillColInds(Bdcsc->ir + Bdcsc->cp[i], nnzcolB, colindsVec[myThread], aux, csize);
-            std::pair<IT,IT> * colinds = colindsVec[myThread].data();
+            std::pair<IT,IT> * colinds = scratch.get().allocate< std::pair<IT,IT> >(nnzcolB);
+            Adcsc->FillColInds(Bdcsc->ir + Bdcsc->cp[i], nnzcolB, colinds, aux, csize);
 
 
 
@@ -560,7 +841,7 @@ SpTuples<IT, NTO> * LocalHybridSpGEMM
             {
                 ht_size <<= 1;
             }
-            std::vector< std::pair<IT,NTO>> globalHashVec(ht_size);
+            std::pair<IT,NTO> * globalHashVec = scratch.get().allocate< std::pair<IT,NTO> >(ht_size);
 
             // colinds.first vector keeps indices to A.cp, i.e. it dereferences "colnums" vector (above),
             // colinds.second vector keeps the end indices (i.e. it gives the index to the last valid element of A.cpnack)
@@ -613,7 +894,7 @@ SpTuples<IT, NTO> * LocalHybridSpGEMM
                     globalHashVec[index++] = globalHashVec[j];
                 }
             }
-            std::sort(globalHashVec.begin(), globalHashVec.begin() + index, sort_less<IT, NTO>);
+            std::sort(globalHashVec, globalHashVec + index, sort_less<IT, NTO>);
 
             IT curptr = colptrC[i];
             for (size_t j=0; j < index; ++j)
@@ -27,6 +27,7 @@
  */
 
 #include <memory>
+#include <vector>
 #include "CombBLAS/CommGrid.h"
 #include "CombBLAS/SpDefs.h"
 
@@ -43,16 +44,21 @@ CommGrid::CommGrid(MPI_Comm world, int nrowproc, int ncolproc): grrows(nrowproc)
 
 	if(grrows == 0 && grcols == 0)
 	{
+		// the most square pr x pc factorization with pr <= pc (1 x p if p is prime)
 		grrows = (int)std::sqrt((float)nproc);
-		grcols = grrows;
+		while(nproc % grrows != 0)	--grrows;
+		grcols = nproc / grrows;
+	}
+	else if(grrows == 0)
+		grrows = nproc / grcols;
+	else if(grcols == 0)
+		grcols = nproc / grrows;
 
-		if(grcols * grrows != nproc)
-		{
-			cerr << "This version of the Combinatorial BLAS only works on a square logical processor grid" << endl;
-			MPI_Abort(MPI_COMM_WORLD,NOTSQUARE);
-		}
+	if(grrows * grcols != nproc)
+	{
+		cerr << "The processor grid " << grrows << " x " << grcols << " does not match the number of processes " << nproc << endl;
+		MPI_Abort(MPI_COMM_WORLD,NOTSQUARE);
 	}
-	assert((nproc == (grrows*grcols)));
 
 	myproccol =  (int) (myrank % grcols);
 	myprocrow =  (int) (myrank / grcols);
@@ -76,11 +82,9 @@ CommGrid::CommGrid(MPI_Comm world, int nrowproc, int ncolproc): grrows(nrowproc)
 
 void CommGrid::CreateDiagWorld()
 {
-	if(grrows != grcols)	
+	if(grrows != grcols)	// there is no processor diagonal to speak of; callers check for MPI_COMM_NULL
 	{
-		cout << "The grid is not square... !" << endl;
-		cout << "Returning diagworld to everyone instead of the diagonal" << endl;
-		diagWorld = commWorld;
+		diagWorld = MPI_COMM_NULL;
 		return;
 	}
 	int * process_ranks = new int[grcols];
@@ -136,6 +140,16 @@ int CommGrid::GetDiagOfProcCol( )
 	return myproccol;
 }
 
+int CommGrid::GetComplementRank()
+{
+	if(grrows != grcols)
+	{
+		cerr << "P(i,j) <-> P(j,i) exchanges need a square processor grid, this one is " << grrows << " x " << grcols << endl;
+		MPI_Abort(MPI_COMM_WORLD,GRIDMISMATCH);
+	}
+	return ((grcols * myproccol) + myprocrow);
+}
+
 bool CommGrid::operator== (const CommGrid & rhs) const
 {
         int result;
@@ -161,6 +175,61 @@ void CommGrid::OpenDebugFile(string prefix, ofstream & output) const
 	output.open(ofilename.c_str(), ios_base::app );
 }
 
+shared_ptr<CommGrid> NodeAwareGrid(MPI_Comm world, int nrowproc, int ncolproc)
+{
+	int myrank, nproc;
+	MPI_Comm_rank(world, &myrank);
+	MPI_Comm_size(world, &nproc);
+
+	MPI_Comm nodeWorld;
+	MPI_Comm_split_type(world, MPI_COMM_TYPE_SHARED, myrank, MPI_INFO_NULL, &nodeWorld);
+	int noderank, nodesize, leader, minsize, maxsize;
+	MPI_Comm_rank(nodeWorld, &noderank);
+	MPI_Comm_size(nodeWorld, &nodesize);
+	MPI_Allreduce(&myrank, &leader, 1, MPI_INT, MPI_MIN, nodeWorld);	// a node is identified by its smallest rank
+	MPI_Comm_free(&nodeWorld);
+	MPI_Allreduce(&nodesize, &minsize, 1, MPI_INT, MPI_MIN, world);
+	MPI_Allreduce(&nodesize, &maxsize, 1, MPI_INT, MPI_MAX, world);
+
+	if(nrowproc == 0 && ncolproc == 0 && minsize == maxsize && nodesize > 1)
+	{
+		int bestcols = 0;
+		double bestratio = 0;
+		for(int cols = 2; cols <= nodesize; ++cols)
+		{
+			if(nodesize % cols != 0 || nproc % cols != 0) continue;
+			double ratio = std::fabs(std::log(static_cast<double>(cols) * cols / nproc));	// 0 for a square grid
+			if(bestcols == 0 || ratio < bestratio)
+			{
+				bestcols = cols;
+				bestratio = ratio;
+			}
+		}
+		if(bestcols > 0)
+		{
+			ncolproc = bestcols;
+			nrowproc = nproc / bestcols;
+		}
+	}
+
+	// new rank: nodes in the order of their leaders, ranks within a node in their original order
+	vector<int> keys(2*nproc);
+	keys[2*myrank] = leader;
+	keys[2*myrank+1] = noderank;
+	MPI_Allgather(MPI_IN_PLACE, 2, MPI_INT, keys.data(), 2, MPI_INT, world);
+	int newrank = 0;
+	for(int i=0; i< nproc; ++i)
+	{
+		if(keys[2*i] < leader || (keys[2*i] == leader && keys[2*i+1] < noderank))
+			++newrank;
+	}
+	MPI_Comm nodeOrdered;
+	MPI_Comm_split(world, 0, newrank, &nodeOrdered);
+	shared_ptr<CommGrid> grid(new CommGrid(nodeOrdered, nrowproc, ncolproc));	// CommGrid keeps its own duplicate
+	MPI_Comm_free(&nodeOrdered);
+	return grid;
+}
+
 shared_ptr<CommGrid> ProductGrid(CommGrid * gridA, CommGrid * gridB, int & innerdim, int & Aoffset, int & Boffset)
 {
     if(*gridA != *gridB)
@@ -28,6 +28,9 @@
 
 
 #include "CombBLAS/MemoryPool.h"
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
 
 using namespace std;
 
@@ -148,4 +151,89 @@ ofstream& operator<< (ofstream& outfile, const MemoryPool & mpool)
 	return outfile;
 }
 
+
+ScratchArena::ScratchArena(size_t m_blocksize): cur(0), offset(0), blocksize(m_blocksize)
+{
+}
+
+ScratchArena::~ScratchArena()
+{
+	release();
+}
+
+void * ScratchArena::alloc(size_t size, size_t align)
+{
+	while(cur < blocks.size())
+	{
+		uintptr_t base = reinterpret_cast<uintptr_t>(blocks[cur].begin);
+		size_t aligned = ((base + offset + align - 1) & ~(static_cast<uintptr_t>(align) - 1)) - base;
+		if(aligned + size <= blocks[cur].size)
+		{
+			offset = aligned + size;
+			return blocks[cur].begin + aligned;
+		}
+		++cur;		// the tail of this block stays unused until the next rewind
+		offset = 0;
+	}
+	NewBlock(size + align);
+	return alloc(size, align);
+}
+
+//! Blocks grow geometrically so that a kernel needs O(log n) of them
+//! Pages are touched here by the calling (owning) thread, so that a first-touch policy places them locally
+void ScratchArena::NewBlock(size_t minsize)
+{
+	size_t size = std::max(blocksize, minsize);
+	if(!blocks.empty())
+		size = std::max(size, 2 * blocks.back().size);
+
+	Block b;
+	b.begin = static_cast<char *>(::operator new(size));
+	b.size = size;
+	const size_t pagesize = 4096;
+	for(size_t i = 0; i < size; i += pagesize)
+		b.begin[i] = 0;
+
+	blocks.push_back(b);
+	cur = blocks.size() - 1;
+	offset = 0;
+}
+
+void ScratchArena::rewind(const Mark & m)
+{
+	cur = m.block;
+	offset = m.offset;
+	if(cur == 0 && offset == 0 && blocks.size() > 1)
+	{
+		// nothing is live: replace the chain by a single block of the same capacity, so the next
+		// round of allocations with the same footprint is served from one block without skipped tails
+		size_t total = capacity();
+		release();
+		NewBlock(total);
+	}
+}
+
+void ScratchArena::release()
+{
+	for(size_t i = 0; i < blocks.size(); ++i)
+		::operator delete(blocks[i].begin);
+	blocks.clear();
+	cur = 0;
+	offset = 0;
+}
+
+size_t ScratchArena::capacity() const
+{
+	size_t total = 0;
+	for(size_t i = 0; i < blocks.size(); ++i)
+		total += blocks[i].size;
+	return total;
+}
+
+ScratchArena & ScratchArena::Local()
+{
+	static thread_local ScratchArena arena;
+	return arena;
+}
+
 }